@@ -0,0 +1,816 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include <emmintrin.h>
+#include "art_index.h"
+#include "filescan.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/scan_not_initialized_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/end_of_file_exception.h"
+
+
+namespace badgerdb
+{
+    static const char ARTMAGIC[8] = "BDBART1";
+
+    static void copyHeader(ArtNode* to, const ArtNode* from)
+    {
+        to->numChildren = from->numChildren;
+        to->prefixLength = from->prefixLength;
+        memcpy(to->prefix, from->prefix, ARTMAXPREFIX);
+    }
+
+    static ArtNode4* newNode4()
+    {
+        ArtNode4 * node = new ArtNode4();
+        node->type = ARTNODE4;
+        node->numChildren = 0;
+        node->prefixLength = 0;
+        return node;
+    }
+
+    static ArtLeaf* newLeaf(const unsigned char* key, const int keyLength, const RecordId rid)
+    {
+        ArtLeaf * leaf = new ArtLeaf();
+        leaf->type = ARTLEAF;
+        leaf->numChildren = 0;
+        leaf->prefixLength = 0;
+        memcpy(leaf->key, key, keyLength);
+        leaf->rids.push_back(rid);
+        return leaf;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::ArtIndex -- Constructor
+    // -----------------------------------------------------------------------------
+
+    ArtIndex::ArtIndex(const std::string & relationName,
+                       std::string & outIndexName,
+                       BufMgr *bufMgrIn,
+                       const int attrByteOffset,
+                       const Datatype attrType)
+    {
+        this->relationName = relationName;
+        this->attributeType = attrType;
+        this->attrByteOffset = attrByteOffset;
+        this->root = NULL;
+        this->numKeys = 0;
+        this->numEntries = 0;
+        this->scanExecuting = false;
+        this->currentLeaf = NULL;
+        this->nextRid = 0;
+
+        if (attrType == INTEGER)
+        {
+            keyLength = normalizedSize<int>();
+        }
+        else if (attrType == DOUBLE)
+        {
+            keyLength = normalizedSize<double>();
+        }
+        else if (attrType == STRING)
+        {
+            keyLength = normalizedSize<StringKey>();
+        }
+        else
+        {
+            throw BadIndexInfoException("Datatype must equal INTEGER(0) DOUBLE(1) STRING(2)");
+        }
+
+        std::ostringstream idxStr;
+        idxStr << relationName << '.' << attrByteOffset << ".art";
+        outIndexName = idxStr.str();
+        fileName = outIndexName;
+
+        //Snapshot does exist, rebuild the tree from its keys, which come in order
+        if (File::exists(fileName))
+        {
+            BlobFile file(fileName, false);
+            Page metaPage = file.readPage(1);
+            const ArtSnapshotMetaInfo * meta = (const ArtSnapshotMetaInfo *) &metaPage;
+            if (memcmp(meta->magic, ARTMAGIC, sizeof(ARTMAGIC)) != 0
+                || strncmp(meta->relationName, relationName.c_str(), sizeof(meta->relationName)) != 0
+                || meta->attrByteOffset != attrByteOffset
+                || meta->attrType != attrType)
+            {
+                throw BadIndexInfoException(fileName);
+            }
+            std::uint64_t keysLeft = meta->numKeys;
+            std::uint32_t numPages = meta->numPages;
+
+            //The stream runs on from page to page, read into pages as needed
+            Page page;
+            PageId pageNo = 1;
+            size_t used = Page::SIZE;
+            unsigned char key[STRINGSIZE];
+            for (; keysLeft > 0; keysLeft--)
+            {
+                std::uint32_t count;
+                unsigned char * fields[2] = {key, (unsigned char *) &count};
+                size_t sizes[2] = {(size_t) keyLength, sizeof(count)};
+                for (int f = 0; f < 2; f++)
+                {
+                    for (size_t n = 0; n < sizes[f]; n++)
+                    {
+                        if (used == Page::SIZE)
+                        {
+                            pageNo++;
+                            page = file.readPage(pageNo);
+                            used = 0;
+                        }
+                        fields[f][n] = ((const unsigned char *) &page)[used++];
+                    }
+                }
+                for (std::uint32_t r = 0; r < count; r++)
+                {
+                    RecordId rid;
+                    for (size_t n = 0; n < sizeof(RecordId); n++)
+                    {
+                        if (used == Page::SIZE)
+                        {
+                            pageNo++;
+                            page = file.readPage(pageNo);
+                            used = 0;
+                        }
+                        ((unsigned char *) &rid)[n] = ((const unsigned char *) &page)[used++];
+                    }
+                    insertKey(root, key, 0, rid);
+                    numEntries++;
+                }
+            }
+            if (pageNo != numPages + 1)
+            {
+                clear();
+                throw BadIndexInfoException(fileName);
+            }
+            return;
+        }
+
+        //Snapshot does not exist, build the tree from the relation
+        FileScan scan(relationName, bufMgrIn);
+        RecordId scanID;
+        try
+        {
+            while (true)
+            {
+                scan.scanNext(scanID);
+                std::string recordStr = scan.getRecord();
+                insertEntry(recordStr.c_str() + attrByteOffset, scanID);
+            }
+        }
+        catch (EndOfFileException e)
+        {
+            // Index has completed
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::~ArtIndex -- destructor
+    // -----------------------------------------------------------------------------
+
+    ArtIndex::~ArtIndex()
+    {
+        clear();
+    }
+
+    void ArtIndex::clear()
+    {
+        destroy(root);
+        root = NULL;
+        numKeys = 0;
+        numEntries = 0;
+        scanExecuting = false;
+        scanPath.clear();
+        currentLeaf = NULL;
+    }
+
+    void ArtIndex::destroy(ArtNode* node)
+    {
+        if (node == NULL)
+        {
+            return;
+        }
+        int byte;
+        for (ArtNode * child = childAtOrAfter(node, 0, byte); child != NULL; child = childAtOrAfter(node, byte + 1, byte))
+        {
+            destroy(child);
+        }
+        switch (node->type)
+        {
+            case ARTNODE4: delete (ArtNode4 *) node; break;
+            case ARTNODE16: delete (ArtNode16 *) node; break;
+            case ARTNODE48: delete (ArtNode48 *) node; break;
+            case ARTNODE256: delete (ArtNode256 *) node; break;
+            default: delete (ArtLeaf *) node; break;
+        }
+    }
+
+    void ArtIndex::normalize(const void* key, unsigned char* out) const
+    {
+        if (attributeType == INTEGER)
+        {
+            normalizeKey(keyFromPtr<int>(key), out);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            normalizeKey(keyFromPtr<double>(key), out);
+        }
+        else
+        {
+            normalizeKey(keyFromPtr<StringKey>(key), out);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // Node operations
+    // -----------------------------------------------------------------------------
+
+    ArtLeaf* ArtIndex::minimumLeaf(ArtNode* node)
+    {
+        int byte;
+        while (node->type != ARTLEAF)
+        {
+            node = childAtOrAfter(node, 0, byte);
+        }
+        return (ArtLeaf *) node;
+    }
+
+    int ArtIndex::prefixMismatch(ArtNode* node, const unsigned char* key, const int depth) const
+    {
+        int kept = std::min<int>(node->prefixLength, ARTMAXPREFIX);
+        for (int i = 0; i < kept; i++)
+        {
+            if (node->prefix[i] != key[depth + i])
+            {
+                return i;
+            }
+        }
+        //Every leaf below the node shares the whole prefix
+        if ((int) node->prefixLength > kept)
+        {
+            const unsigned char * full = minimumLeaf(node)->key;
+            for (int i = kept; i < (int) node->prefixLength; i++)
+            {
+                if (full[depth + i] != key[depth + i])
+                {
+                    return i;
+                }
+            }
+        }
+        return node->prefixLength;
+    }
+
+    ArtNode** ArtIndex::findChild(ArtNode* node, const unsigned char byte)
+    {
+        switch (node->type)
+        {
+            case ARTNODE4:
+            {
+                ArtNode4 * n = (ArtNode4 *) node;
+                for (int i = 0; i < n->numChildren; i++)
+                {
+                    if (n->keys[i] == byte)
+                    {
+                        return &n->children[i];
+                    }
+                }
+                return NULL;
+            }
+            case ARTNODE16:
+            {
+                //One comparison of the byte against all 16 keys
+                ArtNode16 * n = (ArtNode16 *) node;
+                __m128i equal = _mm_cmpeq_epi8(_mm_set1_epi8((char) byte), _mm_loadu_si128((const __m128i *) n->keys));
+                int mask = _mm_movemask_epi8(equal) & ((1 << n->numChildren) - 1);
+                return mask != 0 ? &n->children[__builtin_ctz(mask)] : NULL;
+            }
+            case ARTNODE48:
+            {
+                ArtNode48 * n = (ArtNode48 *) node;
+                return n->childIndex[byte] != 0 ? &n->children[n->childIndex[byte] - 1] : NULL;
+            }
+            default:
+            {
+                ArtNode256 * n = (ArtNode256 *) node;
+                return n->children[byte] != NULL ? &n->children[byte] : NULL;
+            }
+        }
+    }
+
+    ArtNode* ArtIndex::childAtOrAfter(ArtNode* node, const int byte, int& outByte)
+    {
+        switch (node->type)
+        {
+            case ARTNODE4:
+            case ARTNODE16:
+            {
+                //keys and children sit at the same offsets in both
+                const unsigned char * keys = node->type == ARTNODE4 ? ((ArtNode4 *) node)->keys : ((ArtNode16 *) node)->keys;
+                ArtNode * const * children = node->type == ARTNODE4 ? ((ArtNode4 *) node)->children : ((ArtNode16 *) node)->children;
+                for (int i = 0; i < node->numChildren; i++)
+                {
+                    if (keys[i] >= byte)
+                    {
+                        outByte = keys[i];
+                        return children[i];
+                    }
+                }
+                return NULL;
+            }
+            case ARTNODE48:
+            {
+                ArtNode48 * n = (ArtNode48 *) node;
+                for (int b = byte; b < 256; b++)
+                {
+                    if (n->childIndex[b] != 0)
+                    {
+                        outByte = b;
+                        return n->children[n->childIndex[b] - 1];
+                    }
+                }
+                return NULL;
+            }
+            case ARTNODE256:
+            {
+                ArtNode256 * n = (ArtNode256 *) node;
+                for (int b = byte; b < 256; b++)
+                {
+                    if (n->children[b] != NULL)
+                    {
+                        outByte = b;
+                        return n->children[b];
+                    }
+                }
+                return NULL;
+            }
+            default:
+                return NULL;
+        }
+    }
+
+    void ArtIndex::addChild(ArtNode*& ref, const unsigned char byte, ArtNode* child)
+    {
+        switch (ref->type)
+        {
+            case ARTNODE4:
+            {
+                ArtNode4 * n = (ArtNode4 *) ref;
+                if (n->numChildren < 4)
+                {
+                    int i = 0;
+                    while (i < n->numChildren && n->keys[i] < byte)
+                    {
+                        i++;
+                    }
+                    memmove(n->keys + i + 1, n->keys + i, n->numChildren - i);
+                    memmove(n->children + i + 1, n->children + i, (n->numChildren - i) * sizeof(ArtNode *));
+                    n->keys[i] = byte;
+                    n->children[i] = child;
+                    n->numChildren++;
+                    return;
+                }
+                ArtNode16 * grown = new ArtNode16();
+                grown->type = ARTNODE16;
+                copyHeader(grown, n);
+                memcpy(grown->keys, n->keys, 4);
+                memcpy(grown->children, n->children, 4 * sizeof(ArtNode *));
+                delete n;
+                ref = grown;
+                addChild(ref, byte, child);
+                return;
+            }
+            case ARTNODE16:
+            {
+                ArtNode16 * n = (ArtNode16 *) ref;
+                if (n->numChildren < 16)
+                {
+                    int i = 0;
+                    while (i < n->numChildren && n->keys[i] < byte)
+                    {
+                        i++;
+                    }
+                    memmove(n->keys + i + 1, n->keys + i, n->numChildren - i);
+                    memmove(n->children + i + 1, n->children + i, (n->numChildren - i) * sizeof(ArtNode *));
+                    n->keys[i] = byte;
+                    n->children[i] = child;
+                    n->numChildren++;
+                    return;
+                }
+                ArtNode48 * grown = new ArtNode48();
+                grown->type = ARTNODE48;
+                copyHeader(grown, n);
+                memset(grown->childIndex, 0, sizeof(grown->childIndex));
+                for (int i = 0; i < 16; i++)
+                {
+                    grown->childIndex[n->keys[i]] = i + 1;
+                    grown->children[i] = n->children[i];
+                }
+                delete n;
+                ref = grown;
+                addChild(ref, byte, child);
+                return;
+            }
+            case ARTNODE48:
+            {
+                //Children are never removed, so the slots in use are the first numChildren
+                ArtNode48 * n = (ArtNode48 *) ref;
+                if (n->numChildren < 48)
+                {
+                    n->children[n->numChildren] = child;
+                    n->childIndex[byte] = n->numChildren + 1;
+                    n->numChildren++;
+                    return;
+                }
+                ArtNode256 * grown = new ArtNode256();
+                grown->type = ARTNODE256;
+                copyHeader(grown, n);
+                memset(grown->children, 0, sizeof(grown->children));
+                for (int b = 0; b < 256; b++)
+                {
+                    if (n->childIndex[b] != 0)
+                    {
+                        grown->children[b] = n->children[n->childIndex[b] - 1];
+                    }
+                }
+                delete n;
+                ref = grown;
+                addChild(ref, byte, child);
+                return;
+            }
+            default:
+            {
+                ArtNode256 * n = (ArtNode256 *) ref;
+                n->children[byte] = child;
+                n->numChildren++;
+                return;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::insertEntry
+    // -----------------------------------------------------------------------------
+
+    const void ArtIndex::insertEntry(const void* key, const RecordId rid)
+    {
+        unsigned char normalized[STRINGSIZE];
+        normalize(key, normalized);
+        insertKey(root, normalized, 0, rid);
+        numEntries++;
+    }
+
+    void ArtIndex::insertKey(ArtNode*& ref, const unsigned char* key, const int depth, const RecordId rid)
+    {
+        if (ref == NULL)
+        {
+            ref = newLeaf(key, keyLength, rid);
+            numKeys++;
+            return;
+        }
+
+        //A leaf left high up by lazy expansion: equal keys share it, otherwise a node branches where they differ
+        if (ref->type == ARTLEAF)
+        {
+            ArtLeaf * leaf = (ArtLeaf *) ref;
+            if (memcmp(leaf->key + depth, key + depth, keyLength - depth) == 0)
+            {
+                leaf->rids.push_back(rid);
+                return;
+            }
+            int differ = depth;
+            while (leaf->key[differ] == key[differ])
+            {
+                differ++;
+            }
+            ArtNode4 * node = newNode4();
+            node->prefixLength = differ - depth;
+            memcpy(node->prefix, key + depth, std::min<int>(node->prefixLength, ARTMAXPREFIX));
+            ArtNode * branch = node;
+            addChild(branch, leaf->key[differ], leaf);
+            addChild(branch, key[differ], newLeaf(key, keyLength, rid));
+            numKeys++;
+            ref = branch;
+            return;
+        }
+
+        //The key leaves the prefix: a new node branches at the first differing byte
+        int matched = prefixMismatch(ref, key, depth);
+        if (matched < (int) ref->prefixLength)
+        {
+            ArtNode4 * node = newNode4();
+            node->prefixLength = matched;
+            memcpy(node->prefix, ref->prefix, std::min<int>(matched, ARTMAXPREFIX));
+            unsigned char oldByte;
+            if (ref->prefixLength <= (std::uint32_t) ARTMAXPREFIX)
+            {
+                oldByte = ref->prefix[matched];
+                ref->prefixLength -= matched + 1;
+                memmove(ref->prefix, ref->prefix + matched + 1, ref->prefixLength);
+            }
+            else
+            {
+                const unsigned char * full = minimumLeaf(ref)->key;
+                oldByte = full[depth + matched];
+                ref->prefixLength -= matched + 1;
+                memcpy(ref->prefix, full + depth + matched + 1, std::min<int>(ref->prefixLength, ARTMAXPREFIX));
+            }
+            ArtNode * branch = node;
+            addChild(branch, oldByte, ref);
+            addChild(branch, key[depth + matched], newLeaf(key, keyLength, rid));
+            numKeys++;
+            ref = branch;
+            return;
+        }
+
+        int next = depth + ref->prefixLength;
+        ArtNode ** child = findChild(ref, key[next]);
+        if (child != NULL)
+        {
+            insertKey(*child, key, next + 1, rid);
+            return;
+        }
+        addChild(ref, key[next], newLeaf(key, keyLength, rid));
+        numKeys++;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::startScan
+    // -----------------------------------------------------------------------------
+
+    const void ArtIndex::startScan(const void* lowValParm,
+                                   const Operator lowOpParm,
+                                   const void* highValParm,
+                                   const Operator highOpParm)
+    {
+        if((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+
+        if (scanExecuting)
+        {
+            endScan();
+        }
+
+        unsigned char lowKey[STRINGSIZE];
+        normalize(lowValParm, lowKey);
+        normalize(highValParm, highKey);
+        if (memcmp(lowKey, highKey, keyLength) > 0)
+        {
+            throw BadScanrangeException();
+        }
+        highInclusive = highOpParm == LTE;
+
+        scanExecuting = true;
+        seek(lowKey, lowOpParm == GT);
+        if (currentLeaf == NULL)
+        {
+            endScan();
+            throw NoSuchKeyFoundException();
+        }
+        int c = memcmp(currentLeaf->key, highKey, keyLength);
+        if (c > 0 || (c == 0 && !highInclusive))
+        {
+            endScan();
+            throw NoSuchKeyFoundException();
+        }
+    }
+
+    void ArtIndex::seek(const unsigned char* key, const bool strict)
+    {
+        scanPath.clear();
+        currentLeaf = NULL;
+        nextRid = 0;
+        ArtNode * node = root;
+        int depth = 0;
+        if (node == NULL)
+        {
+            return;
+        }
+        while (true)
+        {
+            if (node->type == ARTLEAF)
+            {
+                ArtLeaf * leaf = (ArtLeaf *) node;
+                int c = memcmp(leaf->key, key, keyLength);
+                if (c > 0 || (c == 0 && !strict))
+                {
+                    currentLeaf = leaf;
+                    return;
+                }
+                advanceLeaf();
+                return;
+            }
+
+            //A prefix above the key's bytes puts the whole subtree after it, one below before it
+            int matched = prefixMismatch(node, key, depth);
+            if (matched < (int) node->prefixLength)
+            {
+                unsigned char nodeByte = (std::uint32_t) matched < (std::uint32_t) ARTMAXPREFIX
+                    ? node->prefix[matched] : minimumLeaf(node)->key[depth + matched];
+                if (nodeByte > key[depth + matched])
+                {
+                    descendToMinimum(node);
+                }
+                else
+                {
+                    advanceLeaf();
+                }
+                return;
+            }
+            depth += node->prefixLength;
+
+            int byte;
+            ArtNode * child = childAtOrAfter(node, key[depth], byte);
+            if (child == NULL)
+            {
+                advanceLeaf();
+                return;
+            }
+            ScanFrame frame = {node, byte};
+            scanPath.push_back(frame);
+            if (byte > key[depth])
+            {
+                descendToMinimum(child);
+                return;
+            }
+            node = child;
+            depth++;
+        }
+    }
+
+    void ArtIndex::descendToMinimum(ArtNode* node)
+    {
+        int byte;
+        while (node->type != ARTLEAF)
+        {
+            ArtNode * child = childAtOrAfter(node, 0, byte);
+            ScanFrame frame = {node, byte};
+            scanPath.push_back(frame);
+            node = child;
+        }
+        currentLeaf = (ArtLeaf *) node;
+        nextRid = 0;
+    }
+
+    void ArtIndex::advanceLeaf()
+    {
+        //The subtree below the last frame is done, move to the next child of the deepest node that has one
+        while (!scanPath.empty())
+        {
+            ScanFrame & frame = scanPath.back();
+            int byte;
+            ArtNode * next = childAtOrAfter(frame.node, frame.byte + 1, byte);
+            if (next != NULL)
+            {
+                frame.byte = byte;
+                descendToMinimum(next);
+                return;
+            }
+            scanPath.pop_back();
+        }
+        currentLeaf = NULL;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::scanNext
+    // -----------------------------------------------------------------------------
+
+    const void ArtIndex::scanNext(RecordId& outRid)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        if (currentLeaf != NULL && nextRid == currentLeaf->rids.size())
+        {
+            advanceLeaf();
+            if (currentLeaf != NULL)
+            {
+                int c = memcmp(currentLeaf->key, highKey, keyLength);
+                if (c > 0 || (c == 0 && !highInclusive))
+                {
+                    currentLeaf = NULL;
+                }
+            }
+        }
+        if (currentLeaf == NULL)
+        {
+            throw IndexScanCompletedException();
+        }
+        outRid = currentLeaf->rids[nextRid];
+        nextRid++;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::endScan
+    // -----------------------------------------------------------------------------
+
+    const void ArtIndex::endScan()
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        scanExecuting = false;
+        scanPath.clear();
+        currentLeaf = NULL;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ArtIndex::snapshot
+    // -----------------------------------------------------------------------------
+
+    //Appends bytes to the stream, writing page out to file whenever it fills up
+    static void putBytes(BlobFile& file, Page& page, size_t& used, std::uint32_t& numPages,
+                         const void* bytes, const size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (used == Page::SIZE)
+            {
+                PageId pageNo;
+                file.allocatePage(pageNo);
+                file.writePage(pageNo, page);
+                numPages++;
+                used = 0;
+            }
+            ((unsigned char *) &page)[used++] = ((const unsigned char *) bytes)[i];
+        }
+    }
+
+    const void ArtIndex::snapshot()
+    {
+        if (File::exists(fileName))
+        {
+            File::remove(fileName);
+        }
+        BlobFile file(fileName, true);
+        PageId metaPageNo;
+        Page metaPage = file.allocatePage(metaPageNo);
+        memset((void *) &metaPage, 0, Page::SIZE);
+        ArtSnapshotMetaInfo * meta = (ArtSnapshotMetaInfo *) &metaPage;
+        memcpy(meta->magic, ARTMAGIC, sizeof(ARTMAGIC));
+        strncpy(meta->relationName, relationName.c_str(), sizeof(meta->relationName) - 1);
+        meta->attrByteOffset = attrByteOffset;
+        meta->attrType = attributeType;
+        meta->numKeys = numKeys;
+        meta->numEntries = numEntries;
+
+        //Every leaf in key order, walked with a path of its own so a scan in progress is left alone
+        Page page;
+        memset((void *) &page, 0, Page::SIZE);
+        size_t used = 0;
+        std::uint32_t numPages = 0;
+        std::vector<ScanFrame> path;
+        ArtNode * node = root;
+        while (node != NULL)
+        {
+            int byte;
+            while (node->type != ARTLEAF)
+            {
+                ArtNode * child = childAtOrAfter(node, 0, byte);
+                ScanFrame frame = {node, byte};
+                path.push_back(frame);
+                node = child;
+            }
+            ArtLeaf * leaf = (ArtLeaf *) node;
+            std::uint32_t count = leaf->rids.size();
+            putBytes(file, page, used, numPages, leaf->key, keyLength);
+            putBytes(file, page, used, numPages, &count, sizeof(count));
+            putBytes(file, page, used, numPages, &leaf->rids[0], count * sizeof(RecordId));
+
+            node = NULL;
+            while (!path.empty() && node == NULL)
+            {
+                node = childAtOrAfter(path.back().node, path.back().byte + 1, byte);
+                if (node != NULL)
+                {
+                    path.back().byte = byte;
+                }
+                else
+                {
+                    path.pop_back();
+                }
+            }
+        }
+        if (used > 0)
+        {
+            PageId pageNo;
+            file.allocatePage(pageNo);
+            file.writePage(pageNo, page);
+            numPages++;
+        }
+        meta->numPages = numPages;
+        file.writePage(metaPageNo, metaPage);
+    }
+
+}
@@ -0,0 +1,351 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "string.h"
+#include <sstream>
+#include <cstdint>
+
+#include "types.h"
+#include "page.h"
+#include "file.h"
+#include "buffer.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Prefix bytes a node of an ArtIndex keeps itself. Longer prefixes are checked against the key of a leaf
+ * below the node.
+ */
+const  int ARTMAXPREFIX = 8;
+
+/**
+ * @brief Kinds of ArtIndex nodes, by the number of children they can hold.
+ */
+enum ArtNodeType
+{
+	ARTNODE4,
+	ARTNODE16,
+	ARTNODE48,
+	ARTNODE256,
+	ARTLEAF
+};
+
+/**
+ * @brief Header shared by every node of an ArtIndex. A node stands for all the keys starting with the bytes on
+ * the path from the root to it, followed by its prefix, which path compression collapsed into it. The node then
+ * branches on the next key byte.
+*/
+struct ArtNode{
+  /**
+   * Kind of the node, an ArtNodeType.
+   */
+	std::uint8_t type;
+
+  /**
+   * Number of children in use.
+   */
+	std::uint16_t numChildren;
+
+  /**
+   * Length of the prefix, of which the first ARTMAXPREFIX bytes at most are kept in prefix.
+   */
+	std::uint32_t prefixLength;
+	unsigned char prefix[ ARTMAXPREFIX ];
+};
+
+/**
+ * @brief Node with up to 4 children, the key bytes kept sorted.
+*/
+struct ArtNode4 : ArtNode{
+	unsigned char keys[ 4 ];
+	ArtNode* children[ 4 ];
+};
+
+/**
+ * @brief Node with up to 16 children, the key bytes kept sorted and searched with SSE2.
+*/
+struct ArtNode16 : ArtNode{
+	unsigned char keys[ 16 ];
+	ArtNode* children[ 16 ];
+};
+
+/**
+ * @brief Node with up to 48 children. childIndex maps a key byte to its slot in children plus one, 0 if none.
+*/
+struct ArtNode48 : ArtNode{
+	unsigned char childIndex[ 256 ];
+	ArtNode* children[ 48 ];
+};
+
+/**
+ * @brief Node with a child for every key byte, NULL if none.
+*/
+struct ArtNode256 : ArtNode{
+	ArtNode* children[ 256 ];
+};
+
+/**
+ * @brief Leaf of an ArtIndex: a key in normalized form, see normalizeKey(), and the RecordIds inserted with it in
+ * insertion order.
+*/
+struct ArtLeaf : ArtNode{
+	unsigned char key[ STRINGSIZE ];
+	std::vector<RecordId> rids;
+};
+
+/**
+ * @brief The meta page of an ArtIndex snapshot file, its first page. The pages after it hold every key in order,
+ * each as its normalized bytes, the number of its RecordIds as a std::uint32_t, then the RecordIds, written as one
+ * stream that runs on from page to page.
+*/
+struct ArtSnapshotMetaInfo{
+  /**
+   * Always "BDBART1", checked on open.
+   */
+	char magic[8];
+
+  /**
+   * Name of base relation.
+   */
+	char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored in pages.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+	Datatype attrType;
+
+  /**
+   * Number of distinct keys, of entries and of stream pages.
+   */
+	std::uint64_t numKeys;
+	std::uint64_t numEntries;
+	std::uint32_t numPages;
+};
+
+/**
+ * @brief ArtIndex class. An Adaptive Radix Tree on a single attribute, held in memory, for hot lookup tables.
+ * Keys are compared through their normalized bytes, see normalizeKey(), one byte per level; inner nodes grow from
+ * 4 to 16, 48 and 256 children as needed and collapse single child paths into a prefix, so a point lookup costs a
+ * few pointer hops whatever the number of keys. Offers the insert and scan interface of BTreeIndex, one scan at a
+ * time. The tree lives only in memory: snapshot() writes it to a BlobFile, which the constructor reads back.
+*/
+class ArtIndex {
+
+ private:
+
+  /**
+   * Name of the snapshot file.
+   */
+	std::string	fileName;
+
+  /**
+   * Name of base relation.
+   */
+	std::string	relationName;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+	Datatype	attributeType;
+
+  /**
+   * Offset of attribute, over which index is built, inside records.
+   */
+	int 		attrByteOffset;
+
+  /**
+   * Bytes of every key, normalizedSize() of the attribute type.
+   */
+	int			keyLength;
+
+  /**
+   * Root of the tree, NULL while it is empty.
+   */
+	ArtNode	*root;
+
+  /**
+   * Number of distinct keys and of entries.
+   */
+	std::uint64_t	numKeys;
+	std::uint64_t	numEntries;
+
+
+	// MEMBERS SPECIFIC TO SCANNING
+
+  /**
+   * A node on the path to the current leaf and the key byte of the child the path goes through.
+   */
+	struct ScanFrame{
+		ArtNode* node;
+		int byte;
+	};
+
+  /**
+   * True if an index scan has been started.
+   */
+	bool		scanExecuting;
+
+  /**
+   * Path from the root to the current leaf.
+   */
+	std::vector<ScanFrame>	scanPath;
+
+  /**
+   * Leaf holding the next entry, NULL once the scan has run out of entries, and the index of that entry.
+   */
+	ArtLeaf	*currentLeaf;
+	size_t	nextRid;
+
+  /**
+   * Normalized high bound of the scan, and whether a key equal to it is in range.
+   */
+	unsigned char	highKey[ STRINGSIZE ];
+	bool		highInclusive;
+
+
+  /**
+   * Normalized key of a pointer to integer / double / char string.
+   */
+	void normalize(const void* key, unsigned char* out) const;
+
+  /**
+   * Any leaf below node, used to read prefix bytes beyond ARTMAXPREFIX.
+   */
+	static ArtLeaf* minimumLeaf(ArtNode* node);
+
+  /**
+   * Number of leading prefix bytes of node, which sits at depth, that equal those of key.
+   */
+	int prefixMismatch(ArtNode* node, const unsigned char* key, const int depth) const;
+
+  /**
+   * Slot of the child of node for key byte, NULL if none.
+   */
+	static ArtNode** findChild(ArtNode* node, const unsigned char byte);
+
+  /**
+   * Child of node with the smallest key byte at or after byte, NULL if none, and that key byte.
+   */
+	static ArtNode* childAtOrAfter(ArtNode* node, const int byte, int& outByte);
+
+  /**
+   * Adds child to node for key byte, replacing node in ref by a larger node when it is full.
+   */
+	static void addChild(ArtNode*& ref, const unsigned char byte, ArtNode* child);
+
+	void insertKey(ArtNode*& ref, const unsigned char* key, const int depth, const RecordId rid);
+
+  /**
+   * Frees node and everything below it.
+   */
+	static void destroy(ArtNode* node);
+
+  /**
+   * Positions the scan on the first leaf at or after key, or after it when strict. Leaves currentLeaf NULL
+   * if there is none.
+   */
+	void seek(const unsigned char* key, const bool strict);
+
+  /**
+   * Descends from node, pushed on scanPath by the caller or the root, to its smallest leaf.
+   */
+	void descendToMinimum(ArtNode* node);
+
+  /**
+   * Moves the scan to the leaf after the current one.
+   */
+	void advanceLeaf();
+
+  /**
+   * Empties the tree.
+   */
+	void clear();
+
+ public:
+
+  /**
+   * ArtIndex Constructor.
+	 * If the snapshot file of the attribute exists the tree is rebuilt from it, otherwise it is built by inserting
+	 * an entry for every tuple in the base relation using FileScan class. Nothing is written until snapshot().
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of the snapshot file.
+   * @param bufMgrIn						Buffer Manager Instance, used to read the relation
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built
+   * @throws  BadIndexInfoException     If the snapshot file exists but is not a snapshot of this attribute.
+   */
+	ArtIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
+
+  /**
+   * ArtIndex Destructor. Frees the tree without writing it, see snapshot().
+	 * */
+	~ArtIndex();
+
+  /**
+	 * Insert a new entry using the pair <value,rid>.
+   * @param key			Key to insert, pointer to integer/double/char string
+   * @param rid			Record ID of a record whose entry is getting inserted into the index.
+	**/
+	const void insertEntry(const void* key, const RecordId rid);
+
+  /**
+	 * Begin a filtered scan of the index, see BTreeIndex::startScan().
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the index that satisfies the scan criteria.
+	**/
+	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  /**
+	 * Fetch the record id of the next index entry that matches the scan, in key order.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNext(RecordId& outRid);
+
+  /**
+	 * Terminate the current scan.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	**/
+	const void endScan();
+
+  /**
+   * Writes the tree to the snapshot file, replacing it, in one pass over the keys in order.
+   */
+	const void snapshot();
+
+  /**
+   * Number of entries in the index.
+   */
+	std::uint64_t getNumEntries() const { return numEntries; }
+
+  /**
+   * Number of distinct keys in the index.
+   */
+	std::uint64_t getNumKeys() const { return numKeys; }
+};
+
+}
@@ -0,0 +1,1536 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include "btree.h"
+#include "hash_index.h"
+#include "frozen_index.h"
+#include "parallel_scan.h"
+#include "index_join.h"
+#include "merge_join.h"
+#include "rid_merge.h"
+#include "heap_fetch.h"
+#include "clustered_index.h"
+#include "art_index.h"
+#include "filescan.h"
+#include "page.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/end_of_file_exception.h"
+
+using namespace badgerdb;
+
+// -----------------------------------------------------------------------------
+// Globals
+// -----------------------------------------------------------------------------
+const std::string relationName = "benchRel";
+int relationSize = 100000;
+int numLookups = 20000;
+int numBufs = 64;
+
+typedef struct tuple {
+	int i;
+	double d;
+	char s[64];
+} RECORD;
+
+BufMgr * bufMgr;
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static double elapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void removeFile(const std::string& name)
+{
+	try
+	{
+		File::remove(name);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Writes a record for each key, in the order given
+static void writeRelation(const std::string& name, const std::vector<int>& keys)
+{
+	removeFile(name);
+	PageFile file(name, true);
+
+	RECORD record;
+	memset(&record, ' ', sizeof(record));
+	PageId pageNo;
+	Page page = file.allocatePage(pageNo);
+	for(size_t i = 0; i < keys.size(); i++)
+	{
+		sprintf(record.s, "%05d string record", keys[i]);
+		record.i = keys[i];
+		record.d = keys[i];
+		std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+		while(1)
+		{
+			try
+			{
+				page.insertRecord(data);
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+				file.writePage(pageNo, page);
+				page = file.allocatePage(pageNo);
+			}
+		}
+	}
+	file.writePage(pageNo, page);
+}
+
+// Writes relationSize records with keys 0..relationSize-1 in random order
+static void createRelation()
+{
+	std::vector<int> keys(relationSize);
+	for(int i = 0; i < relationSize; i++)
+	{
+		keys[i] = i;
+	}
+	srandom(1);
+	for(int i = relationSize - 1; i > 0; i--)
+	{
+		std::swap(keys[i], keys[random() % (i + 1)]);
+	}
+	writeRelation(relationName, keys);
+}
+
+// Runs the same point lookups against any index with the startScan/scanNext/endScan interface
+template <class Index>
+static void pointLookups(Index& index, const char* name, const std::vector<int>& probes)
+{
+	bufMgr->clearBufStats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int found = 0;
+	for(size_t i = 0; i < probes.size(); i++)
+	{
+		int key = probes[i];
+		try
+		{
+			index.startScan(&key, GTE, &key, LTE);
+		}
+		catch(NoSuchKeyFoundException e)
+		{
+			continue;
+		}
+		try
+		{
+			RecordId rid;
+			while(1)
+			{
+				index.scanNext(rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		index.endScan();
+	}
+	double ms = elapsedMs(start);
+	std::cout << name << ": " << probes.size() << " lookups, " << found << " found, "
+		<< ms << " ms, " << (ms * 1000.0 / probes.size()) << " us/lookup, "
+		<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+}
+
+// -----------------------------------------------------------------------------
+// hashVsBTree -- point lookups on the integer field
+// -----------------------------------------------------------------------------
+
+void hashVsBTree()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Point lookups, HashIndex vs BTreeIndex" << std::endl;
+
+	std::vector<int> probes(numLookups);
+	srandom(2);
+	for(int i = 0; i < numLookups; i++)
+	{
+		probes[i] = random() % relationSize;
+	}
+
+	std::string btreeName, hashName;
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "BTreeIndex build: " << elapsedMs(start) << " ms" << std::endl;
+		pointLookups(btree, "BTreeIndex", probes);
+	}
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		HashIndex hash(relationName, hashName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "HashIndex build: " << elapsedMs(start) << " ms, global depth " << hash.getGlobalDepth() << std::endl;
+		pointLookups(hash, "HashIndex", probes);
+	}
+	removeFile(btreeName);
+	removeFile(hashName);
+}
+
+// -----------------------------------------------------------------------------
+// frozenVsBTree -- point lookups on a frozen snapshot of the integer index
+// -----------------------------------------------------------------------------
+
+void frozenVsBTree()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Point lookups, FrozenIndex vs BTreeIndex" << std::endl;
+
+	std::vector<int> probes(numLookups);
+	srandom(3);
+	for(int i = 0; i < numLookups; i++)
+	{
+		probes[i] = random() % relationSize;
+	}
+
+	std::string btreeName, frozenName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		pointLookups(btree, "BTreeIndex", probes);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		btree.freeze(frozenName);
+		std::cout << "freeze: " << elapsedMs(start) << " ms" << std::endl;
+	}
+	{
+		FrozenIndex frozen(frozenName);
+		std::cout << "FrozenIndex file: " << frozen.getFileSize() << " bytes" << std::endl;
+		pointLookups(frozen, "FrozenIndex", probes);
+	}
+	removeFile(btreeName);
+	removeFile(frozenName);
+}
+
+// Scans every entry of index and reports the disk reads it took
+static void fullScan(BTreeIndex& index, const char* name)
+{
+	int low = 0;
+	int high = relationSize;
+	bufMgr->clearBufStats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int found = 0;
+	index.startScan(&low, GTE, &high, LT);
+	try
+	{
+		RecordId rid;
+		while(1)
+		{
+			index.scanNext(rid);
+			found++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	index.endScan();
+	std::cout << name << ": " << found << " entries, " << elapsedMs(start) << " ms, "
+		<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+}
+
+// -----------------------------------------------------------------------------
+// compactScan -- full range scans before and after compact()
+// -----------------------------------------------------------------------------
+
+void compactScan()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Range scan, random insert order vs compacted" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		IndexStats stats;
+		btree.collectStats(stats);
+		std::cout << "stats: " << stats.toJson() << std::endl;
+		fullScan(btree, "before compact");
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		btree.compact();
+		std::cout << "compact: " << elapsedMs(start) << " ms" << std::endl;
+		fullScan(btree, "after compact");
+		btree.collectStats(stats);
+		std::cout << "stats: " << stats.toJson() << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// inListScan -- an IN-list as separate scans vs one multi-range scan
+// -----------------------------------------------------------------------------
+
+void inListScan()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "IN-list of " << numLookups << " values, one scan each vs startMultiRangeScan" << std::endl;
+
+	std::vector<int> probes(numLookups);
+	srandom(4);
+	for(int i = 0; i < numLookups; i++)
+	{
+		probes[i] = random() % relationSize;
+	}
+	std::vector<ScanRange> ranges(numLookups);
+	for(int i = 0; i < numLookups; i++)
+	{
+		ranges[i].lowVal = &probes[i];
+		ranges[i].lowOp = GTE;
+		ranges[i].highVal = &probes[i];
+		ranges[i].highOp = LTE;
+	}
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		btree.compact();
+		pointLookups(btree, "startScan per value", probes);
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int found = 0;
+		btree.startMultiRangeScan(ranges.data(), numLookups);
+		try
+		{
+			RecordId rid;
+			while(1)
+			{
+				btree.scanNext(rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "startMultiRangeScan: " << found << " found, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// distinctKeys -- DISTINCT over heavy duplicates, scanNext vs nextDistinctKey
+// -----------------------------------------------------------------------------
+
+void distinctKeys()
+{
+	const int numKeys = 50;
+	const int dupsPerKey = 4000;
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Distinct keys of [0," << numKeys << ") with " << dupsPerKey << " extra duplicates each" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		RecordId rid;
+		rid.page_number = 1;
+		rid.slot_number = 1;
+		for(int key = 0; key < numKeys; key++)
+		{
+			for(int i = 0; i < dupsPerKey; i++)
+			{
+				btree.insertEntry(&key, rid);
+			}
+		}
+
+		int low = 0;
+		int high = numKeys;
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int distinct = 0;
+		int entries = 0;
+		int last = -1;
+		btree.startScan(&low, GTE, &high, LT);
+		try
+		{
+			while(1)
+			{
+				btree.scanNext(rid);
+				entries++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "scanNext: " << entries << " entries, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		btree.startScan(&low, GTE, &high, LT);
+		try
+		{
+			while(1)
+			{
+				int key;
+				btree.nextDistinctKey(rid, &key);
+				if(key != last)
+				{
+					distinct++;
+					last = key;
+				}
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "nextDistinctKey: " << distinct << " distinct keys, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// lowCardinality -- a column with few distinct values, whose RecordIds go to posting lists
+// -----------------------------------------------------------------------------
+
+void lowCardinality()
+{
+	const int numKeys = 16;
+	const int numRids = 2 * relationSize;
+	std::cout << "---------------------" << std::endl;
+	std::cout << numRids << " entries over " << numKeys << " keys, inserted in RecordId order" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		IndexStats before;
+		btree.collectStats(before);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(int n = 0; n < numRids; n++)
+		{
+			int key = relationSize + n % numKeys;
+			RecordId rid;
+			rid.page_number = 1 + n / 40;
+			rid.slot_number = 1 + n % 40;
+			btree.insertEntry(&key, rid);
+		}
+		std::cout << "insert: " << elapsedMs(start) << " ms" << std::endl;
+
+		IndexStats stats;
+		btree.collectStats(stats);
+		int leafPages = stats.numLeafPages - before.numLeafPages;
+		//entries of a leaf of these keys without posting lists, packed in one byte each
+		int plainEntries = (Page::SIZE - offsetof(LeafNodeInt, ridArray)) / (sizeof(RecordId) + 1);
+		std::cout << "pages: " << leafPages << " leaf + " << stats.numPostingPages << " posting for "
+			<< stats.numPostingLists << " lists, " << (double)stats.numPostingPages * Page::SIZE / numRids
+			<< " bytes per RecordId (plain leaves: " << numRids / plainEntries + 1 << " pages, "
+			<< (double)Page::SIZE / plainEntries << " bytes per entry)" << std::endl;
+
+		int key = relationSize;
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		int found = 0;
+		btree.startScan(&key, GTE, &key, LTE);
+		try
+		{
+			RecordId rid;
+			while(1)
+			{
+				btree.scanNext(rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "one key: " << found << " entries, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// latestN -- the 50 largest keys, by a full forward scan vs a BACKWARD scan with a limit
+// -----------------------------------------------------------------------------
+
+void latestN()
+{
+	const int limit = 50;
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Latest " << limit << " keys, full forward scan vs BACKWARD with limit" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		int low = 0;
+		int high = relationSize;
+		RecordId rid;
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<RecordId> latest;
+		btree.startScan(&low, GTE, &high, LT);
+		try
+		{
+			while(1)
+			{
+				btree.scanNext(rid);
+				latest.push_back(rid);
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "forward scan: kept " << std::min<size_t>(limit, latest.size()) << ", " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		int found = 0;
+		btree.startScan(&low, GTE, &high, LT, BACKWARD, limit);
+		try
+		{
+			while(1)
+			{
+				btree.scanNext(rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "BACKWARD limit " << limit << ": " << found << " found, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// rangeCount -- COUNT(*) over a range and OFFSET k, by scanning vs subtree counts
+// -----------------------------------------------------------------------------
+
+void rangeCount()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Range count and OFFSET, scan vs subtree counts" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		btree.enableCounts();
+		int low = relationSize / 10;
+		int high = relationSize - relationSize / 10;
+		int offset = relationSize / 2;
+		RecordId rid;
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int counted = 0;
+		btree.startScan(&low, GTE, &high, LT);
+		try
+		{
+			while(1)
+			{
+				btree.scanNext(rid);
+				counted++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "count by scan: " << counted << ", " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		std::uint64_t total = btree.countRange(&low, GTE, &high, LT);
+		std::cout << "countRange: " << total << ", " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		btree.startScan(&low, GTE, &high, LT);
+		for(int i = 0; i < offset; i++)
+		{
+			btree.scanNext(rid);
+		}
+		btree.scanNext(rid);
+		btree.endScan();
+		std::cout << "OFFSET " << offset << " by scan: " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		btree.startScan(&low, GTE, &high, LT);
+		btree.seekToRank(offset);
+		btree.scanNext(rid);
+		btree.endScan();
+		std::cout << "OFFSET " << offset << " by seekToRank: " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// rangeEstimates -- estimateRange from the meta page histogram vs counting by a scan
+// -----------------------------------------------------------------------------
+
+void rangeEstimates()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Range estimates from the key histogram vs counting by scan" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		int widths[] = {10, relationSize / 100, relationSize / 10, relationSize / 2};
+		for(int w = 0; w < 4; w++)
+		{
+			int low = relationSize / 3;
+			int high = low + widths[w];
+			RecordId rid;
+
+			bufMgr->clearBufStats();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			int counted = 0;
+			btree.startScan(&low, GTE, &high, LT);
+			try
+			{
+				while(1)
+				{
+					btree.scanNext(rid);
+					counted++;
+				}
+			}
+			catch(IndexScanCompletedException e)
+			{
+			}
+			btree.endScan();
+			double scanMs = elapsedMs(start);
+			int scanReads = bufMgr->getBufStats().diskreads;
+
+			bufMgr->clearBufStats();
+			start = std::chrono::steady_clock::now();
+			double estimate = btree.estimateRange(&low, GTE, &high, LT);
+			std::cout << "width " << widths[w] << ": scan " << counted << " (" << scanMs << " ms, " << scanReads
+				<< " disk reads), estimate " << estimate << " (" << elapsedMs(start) << " ms, "
+				<< bufMgr->getBufStats().diskreads << " disk reads)" << std::endl;
+		}
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// parallelRangeScan -- one large range scanned by 1, 2, 4 and 8 threads
+// -----------------------------------------------------------------------------
+
+void parallelRangeScan()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Full range scan, scanNext vs ParallelIndexScan" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		int low = 0;
+		int high = relationSize;
+		fullScan(btree, "scanNext");
+
+		int workers[] = {1, 2, 4, 8};
+		for(int w = 0; w < 4; w++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ParallelIndexScan scan(&btree, &low, GTE, &high, LT, workers[w]);
+			std::uint64_t found = 0;
+			std::uint64_t checksum = 0;
+			std::vector<RecordId> batch;
+			while(scan.nextBatch(batch))
+			{
+				found += batch.size();
+				for(size_t i = 0; i < batch.size(); i++)
+				{
+					checksum += batch[i].page_number;
+				}
+			}
+			std::cout << workers[w] << " threads, " << scan.getNumPartitions() << " partitions: " << found
+				<< " found, " << elapsedMs(start) << " ms (checksum " << checksum << ")" << std::endl;
+		}
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// indexJoin -- self join of the relation, one probe per outer tuple vs IndexNestedLoopJoin
+// -----------------------------------------------------------------------------
+
+void indexJoin()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Index nested loop join, probe per tuple vs sorted batches" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int pairs = 0;
+		{
+			FileScan outer(relationName, bufMgr);
+			RecordId outerRid;
+			RecordId innerRid;
+			try
+			{
+				while(1)
+				{
+					outer.scanNext(outerRid);
+					int key = reinterpret_cast<const RECORD*>(outer.getRecord().data())->i;
+					try
+					{
+						btree.startScan(&key, GTE, &key, LTE);
+					}
+					catch(NoSuchKeyFoundException e)
+					{
+						continue;
+					}
+					try
+					{
+						while(1)
+						{
+							btree.scanNext(innerRid);
+							pairs++;
+						}
+					}
+					catch(IndexScanCompletedException e)
+					{
+					}
+					btree.endScan();
+				}
+			}
+			catch(EndOfFileException e)
+			{
+			}
+		}
+		std::cout << "probe per tuple: " << pairs << " pairs, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		int batchSizes[] = {64, 1024, JOINBATCHSIZE};
+		for(int b = 0; b < 3; b++)
+		{
+			bufMgr->clearBufStats();
+			start = std::chrono::steady_clock::now();
+			pairs = 0;
+			{
+				IndexNestedLoopJoin join(relationName, offsetof(tuple,i), &btree, bufMgr, batchSizes[b]);
+				RecordId outerRid;
+				RecordId innerRid;
+				while(join.next(outerRid, innerRid))
+				{
+					pairs++;
+				}
+			}
+			std::cout << "batches of " << batchSizes[b] << ": " << pairs << " pairs, " << elapsedMs(start) << " ms, "
+				<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+		}
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// mergeJoin -- self join of the relation, IndexNestedLoopJoin vs MergeJoin over the leaf chains
+// -----------------------------------------------------------------------------
+
+void mergeJoin()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Equi-join, IndexNestedLoopJoin vs MergeJoin" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		RecordId leftRid;
+		RecordId rightRid;
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int pairs = 0;
+		{
+			IndexNestedLoopJoin join(relationName, offsetof(tuple,i), &btree, bufMgr);
+			while(join.next(leftRid, rightRid))
+			{
+				pairs++;
+			}
+		}
+		std::cout << "IndexNestedLoopJoin: " << pairs << " pairs, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		pairs = 0;
+		{
+			MergeJoin join(&btree, &btree);
+			while(join.next(leftRid, rightRid))
+			{
+				pairs++;
+			}
+		}
+		std::cout << "MergeJoin: " << pairs << " pairs, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// indexIntersection -- i in a wide range AND d in a narrow one: one index and the heap vs IndexRidMerge
+// -----------------------------------------------------------------------------
+
+void indexIntersection()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Two predicates, one index plus heap filter vs intersection of two indexes" << std::endl;
+
+	std::string intIndexName;
+	std::string doubleIndexName;
+	{
+		BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		BTreeIndex doubleIndex(relationName, doubleIndexName, bufMgr, offsetof(tuple,d), DOUBLE);
+		PageFile heap = PageFile::open(relationName);
+		int intLow = 0;
+		int intHigh = relationSize / 2;
+		double doubleLow = relationSize / 4;
+		double doubleHigh = doubleLow + relationSize / 50;
+		RecordId rid;
+		Page *page;
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int found = 0;
+		intIndex.startScan(&intLow, GTE, &intHigh, LT);
+		try
+		{
+			while(1)
+			{
+				intIndex.scanNext(rid);
+				bufMgr->readPage(&heap, rid.page_number, page);
+				double d = reinterpret_cast<const RECORD*>(page->getRecord(rid).data())->d;
+				bufMgr->unPinPage(&heap, rid.page_number, false);
+				if(d >= doubleLow && d < doubleHigh)
+				{
+					found++;
+				}
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		intIndex.endScan();
+		std::cout << "int index + heap filter: " << found << " found, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		IndexPredicate predicates[2] = {
+			{&intIndex, &intLow, GTE, &intHigh, LT},
+			{&doubleIndex, &doubleLow, GTE, &doubleHigh, LT}
+		};
+		int thresholds[2] = {1 << 30, 0};
+		for(int t = 0; t < 2; t++)
+		{
+			bufMgr->clearBufStats();
+			start = std::chrono::steady_clock::now();
+			found = 0;
+			IndexRidMerge merge(predicates, 2, RID_INTERSECT, thresholds[t]);
+			while(merge.next(rid))
+			{
+				bufMgr->readPage(&heap, rid.page_number, page);
+				bufMgr->unPinPage(&heap, rid.page_number, false);
+				found++;
+			}
+			std::cout << "IndexRidMerge, " << (merge.usedBitmap() ? "bitmaps" : "sorted lists") << ": " << found
+				<< " found, " << elapsedMs(start) << " ms, " << bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+		}
+		bufMgr->flushFile(&heap);
+	}
+	removeFile(intIndexName);
+	removeFile(doubleIndexName);
+}
+
+// -----------------------------------------------------------------------------
+// heapFetch -- records of a fifth of the keys on an uncorrelated column: index order vs page order vs FileScan
+// -----------------------------------------------------------------------------
+
+void heapFetch()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Fetching records for an index range, index order vs BitmapHeapFetch vs FileScan" << std::endl;
+
+	std::string btreeName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		int low = relationSize / 5;
+		int high = low + relationSize / 5;
+		RecordId rid;
+		std::uint64_t checksum = 0;
+
+		bufMgr->clearBufStats();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		{
+			PageFile heap = PageFile::open(relationName);
+			Page *page;
+			btree.startScan(&low, GTE, &high, LT);
+			try
+			{
+				while(1)
+				{
+					btree.scanNext(rid);
+					bufMgr->readPage(&heap, rid.page_number, page);
+					checksum += reinterpret_cast<const RECORD*>(page->getRecord(rid).data())->i;
+					bufMgr->unPinPage(&heap, rid.page_number, false);
+				}
+			}
+			catch(IndexScanCompletedException e)
+			{
+			}
+			btree.endScan();
+			bufMgr->flushFile(&heap);
+		}
+		std::cout << "index order: " << elapsedMs(start) << " ms, " << bufMgr->getBufStats().diskreads
+			<< " disk reads (checksum " << checksum << ")" << std::endl;
+
+		int batchSizes[] = {256, HEAPFETCHBATCHSIZE, relationSize};
+		for(int b = 0; b < 3; b++)
+		{
+			checksum = 0;
+			bufMgr->clearBufStats();
+			start = std::chrono::steady_clock::now();
+			{
+				BitmapHeapFetch fetch(relationName, bufMgr);
+				RecordView view;
+				btree.startScan(&low, GTE, &high, LT);
+				int taken;
+				do
+				{
+					taken = fetch.fetchFromScan(&btree, batchSizes[b]);
+					while(fetch.next(view))
+					{
+						checksum += reinterpret_cast<const RECORD*>(view.data)->i;
+					}
+				}
+				while(taken == batchSizes[b]);
+				btree.endScan();
+			}
+			std::cout << "BitmapHeapFetch, batches of " << batchSizes[b] << ": " << elapsedMs(start) << " ms, "
+				<< bufMgr->getBufStats().diskreads << " disk reads (checksum " << checksum << ")" << std::endl;
+		}
+
+		checksum = 0;
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		{
+			FileScan scan(relationName, bufMgr);
+			try
+			{
+				while(1)
+				{
+					scan.scanNext(rid);
+					int key = reinterpret_cast<const RECORD*>(scan.getRecord().data())->i;
+					if(key >= low && key < high)
+					{
+						checksum += key;
+					}
+				}
+			}
+			catch(EndOfFileException e)
+			{
+			}
+		}
+		std::cout << "FileScan: " << elapsedMs(start) << " ms, " << bufMgr->getBufStats().diskreads
+			<< " disk reads (checksum " << checksum << ")" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// stringKeys -- shape of a STRING index with keys stored at their own length
+// -----------------------------------------------------------------------------
+
+//Children per non-leaf node, against the separators of whole STRINGSIZE byte keys a fixed layout would hold
+static void printNonLeafFanout(const IndexStats& stats)
+{
+	std::cout << "non-leaf: " << stats.numNonLeafPages << " pages, "
+		<< (double)(stats.numLeafPages + stats.numNonLeafPages - 1) / stats.numNonLeafPages << " children per node (whole "
+		<< STRINGSIZE << " byte separators: " << (Page::SIZE - sizeof(int)) / (STRINGSIZE + sizeof(PageId) + sizeof(std::uint32_t)) + 1
+		<< ")" << std::endl;
+}
+
+void stringKeys()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "STRING index, variable-length keys in slotted leaves" << std::endl;
+
+	std::string btreeName;
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,s), STRING);
+		std::cout << "build: " << elapsedMs(start) << " ms" << std::endl;
+		btree.compact();
+		IndexStats stats;
+		btree.collectStats(stats);
+		std::cout << "compacted: height " << stats.height << ", " << stats.numLeafPages << " leaf pages, "
+			<< (double)stats.numEntries / stats.numLeafPages << " entries per leaf (fixed " << STRINGSIZE
+			<< " byte keys: " << Page::SIZE / (STRINGSIZE + sizeof(RecordId)) << ")" << std::endl;
+		printNonLeafFanout(stats);
+
+		char low[STRINGSIZE + 1], high[STRINGSIZE + 1];
+		sprintf(low, "%05d string record", 0);
+		sprintf(high, "%05d string record", relationSize - 1);
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		int found = 0;
+		btree.startScan(low, GTE, high, LTE);
+		try
+		{
+			RecordId rid;
+			while(1)
+			{
+				btree.scanNext(rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		btree.endScan();
+		std::cout << "full scan: " << found << " entries, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// prefixKeys -- STRING index on path-like keys with long shared prefixes
+// -----------------------------------------------------------------------------
+
+static void pathKey(char* out, const int i)
+{
+	sprintf(out, "tenant-%04d/orders/2024/%08d", i % 10, i);
+}
+
+void prefixKeys()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "STRING index on keys sharing long prefixes, prefix compressed leaves" << std::endl;
+
+	const std::string pathsName = "benchPaths";
+	removeFile(pathsName);
+	{
+		PageFile file(pathsName, true);
+		RECORD record;
+		memset(&record, ' ', sizeof(record));
+		PageId pageNo;
+		Page page = file.allocatePage(pageNo);
+		for(int i = 0; i < relationSize; i++)
+		{
+			pathKey(record.s, i);
+			record.i = i;
+			record.d = i;
+			std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+			while(1)
+			{
+				try
+				{
+					page.insertRecord(data);
+					break;
+				}
+				catch(InsufficientSpaceException e)
+				{
+					file.writePage(pageNo, page);
+					page = file.allocatePage(pageNo);
+				}
+			}
+		}
+		file.writePage(pageNo, page);
+	}
+
+	std::string btreeName;
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex btree(pathsName, btreeName, bufMgr, offsetof(tuple,s), STRING);
+		std::cout << "build: " << elapsedMs(start) << " ms" << std::endl;
+		char key[STRINGSIZE + 1];
+		pathKey(key, 0);
+		IndexStats stats;
+		btree.collectStats(stats);
+		std::cout << "height " << stats.height << ", " << stats.numLeafPages << " leaf pages, "
+			<< (double)stats.numEntries / stats.numLeafPages << " entries per leaf (whole " << strlen(key)
+			<< " byte keys: " << (Page::SIZE - offsetof(LeafNodeString, slotArray)) / (sizeof(StringSlot) + strlen(key)) << ")" << std::endl;
+		btree.compact();
+		btree.collectStats(stats);
+		std::cout << "compacted: height " << stats.height << ", " << stats.numLeafPages << " leaf pages, "
+			<< (double)stats.numEntries / stats.numLeafPages << " entries per leaf" << std::endl;
+		printNonLeafFanout(stats);
+
+		srandom(9);
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		int found = 0;
+		for(int i = 0; i < numLookups; i++)
+		{
+			pathKey(key, random() % relationSize);
+			try
+			{
+				btree.startScan(key, GTE, key, LTE);
+				RecordId rid;
+				btree.scanNext(rid);
+				found++;
+				btree.endScan();
+			}
+			catch(NoSuchKeyFoundException e)
+			{
+			}
+		}
+		double ms = elapsedMs(start);
+		std::cout << "point lookups: " << numLookups << " lookups, " << found << " found, " << ms << " ms, "
+			<< (ms * 1000.0 / numLookups) << " us/lookup, " << bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+	}
+	removeFile(btreeName);
+	removeFile(pathsName);
+}
+
+// -----------------------------------------------------------------------------
+// packedIntKeys -- shape of an INTEGER index with frame-of-reference packed keys
+// -----------------------------------------------------------------------------
+
+void packedIntKeys()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "INTEGER index, keys packed over a per-node base" << std::endl;
+
+	std::vector<int> probes(numLookups);
+	srandom(10);
+	for(int i = 0; i < numLookups; i++)
+	{
+		probes[i] = random() % relationSize;
+	}
+
+	std::string btreeName;
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "build: " << elapsedMs(start) << " ms" << std::endl;
+		btree.compact();
+		IndexStats stats;
+		btree.collectStats(stats);
+		//what the same page holds with whole 4 byte keys
+		int wholeLeaf = (Page::SIZE - 2 * sizeof(PageId)) / (sizeof(int) + sizeof(RecordId));
+		int wholeNonLeaf = (Page::SIZE - sizeof(int) - sizeof(NonLeafChild)) / (sizeof(int) + sizeof(NonLeafChild)) + 1;
+		std::cout << "compacted: height " << stats.height << ", " << stats.numLeafPages << " leaf pages, "
+			<< (double)stats.numEntries / stats.numLeafPages << " entries per leaf (whole keys: " << wholeLeaf << ")" << std::endl;
+		std::cout << "non-leaf: " << stats.numNonLeafPages << " pages, "
+			<< (double)(stats.numLeafPages + stats.numNonLeafPages - 1) / stats.numNonLeafPages << " children per node (whole keys: "
+			<< wholeNonLeaf << ")" << std::endl;
+		pointLookups(btree, "point lookups", probes);
+		fullScan(btree, "full scan");
+	}
+	removeFile(btreeName);
+}
+
+// -----------------------------------------------------------------------------
+// compositeKeys -- (tenant, timestamp) range: tenant index plus heap filter vs one composite index scan,
+// then vs a covering composite index that also holds the projected string
+// -----------------------------------------------------------------------------
+
+// Reads the record of rid and returns its timestamp
+static double fetchTimestamp(PageFile& heap, const RecordId& rid)
+{
+	Page *page;
+	bufMgr->readPage(&heap, rid.page_number, page);
+	double d = reinterpret_cast<const RECORD*>(page->getRecord(rid).data())->d;
+	bufMgr->unPinPage(&heap, rid.page_number, false);
+	return d;
+}
+
+void compositeKeys()
+{
+	const int numTenants = 100;
+	std::cout << "---------------------" << std::endl;
+	std::cout << "One tenant, a tenth of the time range: tenant index + heap filter vs composite (tenant, time) index" << std::endl;
+	std::cout << "vs composite (tenant, time) index including the string" << std::endl;
+
+	//rows arrive in time order, each from one of the tenants in turn
+	const std::string eventsName = "benchEvents";
+	removeFile(eventsName);
+	{
+		PageFile file(eventsName, true);
+		RECORD record;
+		memset(&record, ' ', sizeof(record));
+		PageId pageNo;
+		Page page = file.allocatePage(pageNo);
+		for(int n = 0; n < relationSize; n++)
+		{
+			sprintf(record.s, "%05d string record", n);
+			record.i = n % numTenants;
+			record.d = n;
+			std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+			while(1)
+			{
+				try
+				{
+					page.insertRecord(data);
+					break;
+				}
+				catch(InsufficientSpaceException e)
+				{
+					file.writePage(pageNo, page);
+					page = file.allocatePage(pageNo);
+				}
+			}
+		}
+		file.writePage(pageNo, page);
+	}
+
+	std::vector<KeyColumn> columns(2);
+	columns[0].attrByteOffset = offsetof(tuple,i);
+	columns[0].attrType = INTEGER;
+	columns[1].attrByteOffset = offsetof(tuple,d);
+	columns[1].attrType = DOUBLE;
+	int tenant = 42;
+	double from = relationSize / 2;
+	double to = from + relationSize / 10;
+
+	std::vector<KeyColumn> includes(1);
+	includes[0].attrByteOffset = offsetof(tuple,s);
+	includes[0].attrType = STRING;
+
+	std::string tenantName, compositeName, coveringName;
+	{
+		BTreeIndex tenantIndex(eventsName, tenantName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex composite(eventsName, compositeName, bufMgr, columns);
+		std::cout << "composite build: " << elapsedMs(start) << " ms" << std::endl;
+		BTreeIndex covering(eventsName, coveringName, bufMgr, columns, includes);
+		PageFile heap = PageFile::open(eventsName);
+		RecordId rid;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		int found = 0;
+		tenantIndex.startScan(&tenant, GTE, &tenant, LTE);
+		try
+		{
+			while(1)
+			{
+				tenantIndex.scanNext(rid);
+				double d = fetchTimestamp(heap, rid);
+				if(d >= from && d < to)
+				{
+					found++;
+				}
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		tenantIndex.endScan();
+		std::cout << "tenant index + heap filter: " << found << " found, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		found = 0;
+		const void *low[] = {&tenant, &from};
+		const void *high[] = {&tenant, &to};
+		composite.startCompositeScan(low, 2, GTE, high, 2, LT);
+		try
+		{
+			while(1)
+			{
+				composite.scanNext(rid);
+				fetchTimestamp(heap, rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		composite.endScan();
+		std::cout << "composite index: " << found << " found, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+
+		//the string comes from the index entry, the relation is never read
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		found = 0;
+		covering.startCompositeScan(low, 2, GTE, high, 2, LT);
+		try
+		{
+			while(1)
+			{
+				RECORD record;
+				covering.scanNextCovered(rid, &record);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		covering.endScan();
+		std::cout << "covering index: " << found << " found, " << elapsedMs(start) << " ms, "
+			<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+		bufMgr->flushFile(&heap);
+	}
+	removeFile(tenantName);
+	removeFile(compositeName);
+	removeFile(coveringName);
+	removeFile(eventsName);
+}
+
+// -----------------------------------------------------------------------------
+// clusteredRange -- primary key range: index + heap fetch vs records read from the leaves of a ClusteredIndex
+// -----------------------------------------------------------------------------
+
+void clusteredRange()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Records of a key range: index + heap fetch in index order vs clustered index" << std::endl;
+
+	std::string btreeName, clusteredName;
+	{
+		BTreeIndex btree(relationName, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		ClusteredIndex clustered(relationName, clusteredName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "clustered build: " << elapsedMs(start) << " ms, height " << clustered.getHeight() << std::endl;
+		int low = relationSize / 5;
+		int high = low + relationSize / 5;
+		RecordId rid;
+		std::uint64_t checksum = 0;
+
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		{
+			PageFile heap = PageFile::open(relationName);
+			Page *page;
+			btree.startScan(&low, GTE, &high, LT);
+			try
+			{
+				while(1)
+				{
+					btree.scanNext(rid);
+					bufMgr->readPage(&heap, rid.page_number, page);
+					checksum += reinterpret_cast<const RECORD*>(page->getRecord(rid).data())->i;
+					bufMgr->unPinPage(&heap, rid.page_number, false);
+				}
+			}
+			catch(IndexScanCompletedException e)
+			{
+			}
+			btree.endScan();
+			bufMgr->flushFile(&heap);
+		}
+		std::cout << "index + heap: " << elapsedMs(start) << " ms, " << bufMgr->getBufStats().diskreads
+			<< " disk reads (checksum " << checksum << ")" << std::endl;
+
+		checksum = 0;
+		bufMgr->clearBufStats();
+		start = std::chrono::steady_clock::now();
+		RecordView view;
+		clustered.startScan(&low, GTE, &high, LT);
+		try
+		{
+			while(1)
+			{
+				clustered.scanNext(view);
+				checksum += reinterpret_cast<const RECORD*>(view.data)->i;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		clustered.endScan();
+		std::cout << "clustered: " << elapsedMs(start) << " ms, " << bufMgr->getBufStats().diskreads
+			<< " disk reads (checksum " << checksum << ")" << std::endl;
+	}
+	removeFile(btreeName);
+	removeFile(clusteredName);
+}
+
+// -----------------------------------------------------------------------------
+// artVsBTree -- in-memory adaptive radix tree vs BTreeIndex, on relations written in forward, backward and random
+// key order like those of main.cpp
+// -----------------------------------------------------------------------------
+
+template <class Index>
+static void rangeScan(Index& index, const char* name, int low, int high)
+{
+	bufMgr->clearBufStats();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int found = 0;
+	index.startScan(&low, GTE, &high, LT);
+	try
+	{
+		RecordId rid;
+		while(1)
+		{
+			index.scanNext(rid);
+			found++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	index.endScan();
+	std::cout << name << ": range of " << found << " entries, " << elapsedMs(start) << " ms, "
+		<< bufMgr->getBufStats().diskreads << " disk reads" << std::endl;
+}
+
+void artVsBTree()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Build, point lookups and range scan, ArtIndex vs BTreeIndex" << std::endl;
+
+	const char * orders[3] = {"forward", "backward", "random"};
+	const std::string artRelation = "benchArtRel";
+	std::vector<int> probes(numLookups);
+	srandom(17);
+	for(int i = 0; i < numLookups; i++)
+	{
+		probes[i] = random() % relationSize;
+	}
+
+	for(int order = 0; order < 3; order++)
+	{
+		std::vector<int> keys(relationSize);
+		for(int i = 0; i < relationSize; i++)
+		{
+			keys[i] = order == 1 ? relationSize - 1 - i : i;
+		}
+		if(order == 2)
+		{
+			srandom(18);
+			for(int i = relationSize - 1; i > 0; i--)
+			{
+				std::swap(keys[i], keys[random() % (i + 1)]);
+			}
+		}
+		writeRelation(artRelation, keys);
+		std::cout << orders[order] << " keys" << std::endl;
+
+		std::string btreeName, artName;
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			BTreeIndex btree(artRelation, btreeName, bufMgr, offsetof(tuple,i), INTEGER);
+			std::cout << "BTreeIndex build: " << elapsedMs(start) << " ms" << std::endl;
+			pointLookups(btree, "BTreeIndex", probes);
+			rangeScan(btree, "BTreeIndex", relationSize / 4, relationSize / 2);
+		}
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ArtIndex art(artRelation, artName, bufMgr, offsetof(tuple,i), INTEGER);
+			std::cout << "ArtIndex build: " << elapsedMs(start) << " ms, " << art.getNumKeys() << " keys" << std::endl;
+			pointLookups(art, "ArtIndex", probes);
+			rangeScan(art, "ArtIndex", relationSize / 4, relationSize / 2);
+			start = std::chrono::steady_clock::now();
+			art.snapshot();
+			std::cout << "ArtIndex snapshot: " << elapsedMs(start) << " ms" << std::endl;
+		}
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ArtIndex art(artRelation, artName, bufMgr, offsetof(tuple,i), INTEGER);
+			std::cout << "ArtIndex load from snapshot: " << elapsedMs(start) << " ms" << std::endl;
+		}
+		removeFile(btreeName);
+		removeFile(artName);
+	}
+	removeFile(artRelation);
+}
+
+// -----------------------------------------------------------------------------
+// residentIndex -- memory resident BTreeIndex vs the same index through the buffer pool
+// -----------------------------------------------------------------------------
+
+void residentIndex()
+{
+	std::cout << "---------------------" << std::endl;
+	std::cout << "Point lookups and range scan, resident BTreeIndex vs buffered BTreeIndex" << std::endl;
+
+	std::vector<int> probes(numLookups);
+	srandom(19);
+	for(int i = 0; i < numLookups; i++)
+	{
+		probes[i] = random() % relationSize;
+	}
+
+	std::string indexName;
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex resident(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER, true);
+		std::cout << "resident build: " << elapsedMs(start) << " ms" << std::endl;
+		pointLookups(resident, "resident", probes);
+		rangeScan(resident, "resident", relationSize / 4, relationSize / 2);
+		start = std::chrono::steady_clock::now();
+		resident.flush();
+		std::cout << "resident checkpoint: " << elapsedMs(start) << " ms" << std::endl;
+	}
+	{
+		BTreeIndex buffered(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER);
+		pointLookups(buffered, "buffered", probes);
+		rangeScan(buffered, "buffered", relationSize / 4, relationSize / 2);
+	}
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BTreeIndex resident(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER, true);
+		std::cout << "resident load: " << elapsedMs(start) << " ms" << std::endl;
+		pointLookups(resident, "resident", probes);
+	}
+	removeFile(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// main -- badgerdb_bench [relationSize [numLookups [numBufs]]]
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+	if(argc > 1) relationSize = atoi(argv[1]);
+	if(argc > 2) numLookups = atoi(argv[2]);
+	if(argc > 3) numBufs = atoi(argv[3]);
+	bufMgr = new BufMgr(numBufs);
+
+	std::cout << "relation size:" << relationSize << " lookups:" << numLookups << " buffers:" << numBufs << std::endl;
+	createRelation();
+
+	hashVsBTree();
+	frozenVsBTree();
+	compactScan();
+	inListScan();
+	distinctKeys();
+	lowCardinality();
+	latestN();
+	rangeCount();
+	rangeEstimates();
+	parallelRangeScan();
+	indexJoin();
+	mergeJoin();
+	indexIntersection();
+	heapFetch();
+	stringKeys();
+	prefixKeys();
+	packedIntKeys();
+	compositeKeys();
+	clusteredRange();
+	artVsBTree();
+	residentIndex();
+
+	removeFile(relationName);
+	delete bufMgr;
+	return 0;
+}
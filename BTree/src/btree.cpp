@@ -6,10 +6,13 @@
  * @section LICENSE
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
-#include <stack>
+#include <algorithm>
+#include <numeric>
+#include <set>
 #include <stdlib.h>
 #include "btree.h"
 #include "filescan.h"
+#include "frozen_index.h"
 #include "exceptions/bad_index_info_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
@@ -18,709 +21,4084 @@
 #include "exceptions/index_scan_completed_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/end_of_file_exception.h"
+#include "exceptions/bad_index_structure_exception.h"
+#include "exceptions/bad_scan_param_exception.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
+//#define DEBUG
+
+namespace badgerdb
+{
+    // -----------------------------------------------------------------------------
+    // INTEGER node layout
+    // -----------------------------------------------------------------------------
+
+    //Packed keys a search counts at once instead of halving the range further, a few vectors of them
+    static const int PACKEDSCANBYTES = 64;
+
+    void packKeys(unsigned char* out, const int width, const int base, const int* keys, const int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            std::uint32_t delta = (std::uint32_t) keys[i] - (std::uint32_t) base;
+            if (width == 1)
+            {
+                out[i] = delta;
+            }
+            else if (width == 2)
+            {
+                ((std::uint16_t *) out)[i] = delta;
+            }
+            else if (width == 4)
+            {
+                ((std::uint32_t *) out)[i] = delta;
+            }
+        }
+    }
+
+#ifdef __SSE2__
+    static __m128i splatLane(const std::uint8_t value)
+    {
+        return _mm_set1_epi8((char) value);
+    }
+
+    static __m128i splatLane(const std::uint16_t value)
+    {
+        return _mm_set1_epi16((short) value);
+    }
+
+    static __m128i splatLane(const std::uint32_t value)
+    {
+        return _mm_set1_epi32((int) value);
+    }
+
+    static __m128i lanesBelow(const __m128i a, const __m128i b, const std::uint8_t)
+    {
+        return _mm_cmplt_epi8(a, b);
+    }
+
+    static __m128i lanesBelow(const __m128i a, const __m128i b, const std::uint16_t)
+    {
+        return _mm_cmplt_epi16(a, b);
+    }
+
+    static __m128i lanesBelow(const __m128i a, const __m128i b, const std::uint32_t)
+    {
+        return _mm_cmplt_epi32(a, b);
+    }
+#endif
+
+    //Number of the n lanes at lanes that are less than delta
+    template <class Lane>
+    static int countBelow(const Lane* lanes, const int n, const Lane delta)
+    {
+        int below = 0;
+        int i = 0;
+#ifdef __SSE2__
+        //SSE2 only compares signed lanes, flipping the top bit of both sides keeps the unsigned order
+        const int perVector = sizeof(__m128i) / sizeof(Lane);
+        const __m128i flip = splatLane((Lane) (1u << (8 * sizeof(Lane) - 1)));
+        const __m128i target = _mm_xor_si128(splatLane(delta), flip);
+        for (; i + perVector <= n; i += perVector)
+        {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (lanes + i)), flip);
+            //every lane sets one bit of the mask per byte
+            below += __builtin_popcount(_mm_movemask_epi8(lanesBelow(v, target, delta))) / sizeof(Lane);
+        }
+#endif
+        for (; i < n; i++)
+        {
+            below += lanes[i] < delta;
+        }
+        return below;
+    }
+
+    template <class Lane>
+    static int laneLowerBound(const Lane* lanes, int low, int high, const Lane delta)
+    {
+        //The lanes are sorted: halve the range until a few vectors are left, then count what is below delta in them
+        while (high - low > PACKEDSCANBYTES / (int) sizeof(Lane))
+        {
+            int mid = (low + high) / 2;
+            if (lanes[mid] < delta)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return low + countBelow(lanes + low, high - low, delta);
+    }
+
+    int packedLowerBound(const unsigned char* keys, const int width, const int base, const int from, const int count, const int key)
+    {
+        //Keys outside the range the packed keys cover go before or after all of them
+        if (from >= count || key <= base)
+        {
+            return from;
+        }
+        std::uint32_t delta = (std::uint32_t) key - (std::uint32_t) base;
+        if (delta > packedMax(width))
+        {
+            return count;
+        }
+        if (width == 1)
+        {
+            return laneLowerBound(keys, from, count, (std::uint8_t) delta);
+        }
+        if (width == 2)
+        {
+            return laneLowerBound((const std::uint16_t *) keys, from, count, (std::uint16_t) delta);
+        }
+        return laneLowerBound((const std::uint32_t *) keys, from, count, delta);
+    }
+
+    bool leafFill(LeafNodeInt* leaf, const int* keys, const RecordId* rids, const int n, const int capacity)
+    {
+        //The keys are in order, so the first is the base and the last sets the width
+        int width = n > 0 ? packedWidth(keys[0], keys[n - 1]) : 0;
+        if (offsetof(LeafNodeInt, ridArray) + n * (sizeof(RecordId) + width) > Page::SIZE)
+        {
+            return false;
+        }
+        leaf->numEntries = n;
+        leaf->keyWidth = width;
+        leaf->baseKey = n > 0 ? keys[0] : 0;
+        std::copy(rids, rids + n, leaf->ridArray);
+        packKeys((unsigned char *) leaf + Page::SIZE - n * width, width, leaf->baseKey, keys, n);
+        return true;
+    }
+
+    bool leafInsert(LeafNodeInt* leaf, const int count, const int capacity, const int pos, const int& key, const RecordId& rid)
+    {
+        //Keys the packed width of the leaf still holds go in place as long as there is room
+        int width = leaf->keyWidth;
+        std::uint32_t delta = (std::uint32_t) key - (std::uint32_t) leaf->baseKey;
+        if (count > 0 && key >= leaf->baseKey && delta <= packedMax(width)
+            && offsetof(LeafNodeInt, ridArray) + (count + 1) * (sizeof(RecordId) + width) <= Page::SIZE)
+        {
+            //The keys before pos move down to make room, the ones after it stay at the end of the page
+            unsigned char * keys = (unsigned char *) leaf + Page::SIZE - (count + 1) * width;
+            memmove(keys, keys + width, pos * width);
+            packKeys(keys + pos * width, width, leaf->baseKey, &key, 1);
+            memmove(leaf->ridArray + pos + 1, leaf->ridArray + pos, (count - pos) * sizeof(RecordId));
+            leaf->ridArray[pos] = rid;
+            leaf->numEntries++;
+            return true;
+        }
+
+        //Otherwise lay the leaf out again with a base and width that cover the new key
+        std::vector<int> keys(count + 1);
+        std::vector<RecordId> rids(count + 1);
+        for (int i = 0; i < count; i++)
+        {
+            keys[i + (i >= pos)] = leafKey(leaf, i);
+            rids[i + (i >= pos)] = leafRid(leaf, i);
+        }
+        keys[pos] = key;
+        rids[pos] = rid;
+        return leafFill(leaf, keys.data(), rids.data(), count + 1, capacity);
+    }
+
+    bool nonLeafFits(const int* keys, const int n, const int capacity)
+    {
+        int width = n > 0 ? packedWidth(keys[0], keys[n - 1]) : 0;
+        return offsetof(NonLeafNodeInt, childArray) + (n + 1) * sizeof(NonLeafChild) + n * width <= Page::SIZE;
+    }
+
+    bool nonLeafFill(NonLeafNodeInt* node, const int* keys, const PageId* pages, const std::uint32_t* counts, const int n, const int capacity)
+    {
+        if (!nonLeafFits(keys, n, capacity))
+        {
+            return false;
+        }
+        int width = n > 0 ? packedWidth(keys[0], keys[n - 1]) : 0;
+        node->numChildren = n + 1;
+        node->keyWidth = width;
+        node->baseKey = n > 0 ? keys[0] : 0;
+        for (int i = 0; i <= n; i++)
+        {
+            node->childArray[i].pageNo = pages[i];
+            node->childArray[i].count = counts[i];
+        }
+        packKeys((unsigned char *) node + Page::SIZE - n * width, width, node->baseKey, keys, n);
+        return true;
+    }
+
+    bool nonLeafInsert(NonLeafNodeInt* node, const int count, const int capacity, const int i, const int& key, const PageId pageNo)
+    {
+        int width = node->keyWidth;
+        std::uint32_t delta = (std::uint32_t) key - (std::uint32_t) node->baseKey;
+        if (count > 0 && key >= node->baseKey && delta <= packedMax(width)
+            && offsetof(NonLeafNodeInt, childArray) + (count + 2) * sizeof(NonLeafChild) + (count + 1) * width <= Page::SIZE)
+        {
+            unsigned char * keys = (unsigned char *) node + Page::SIZE - (count + 1) * width;
+            memmove(keys, keys + width, i * width);
+            packKeys(keys + i * width, width, node->baseKey, &key, 1);
+            memmove(node->childArray + i + 2, node->childArray + i + 1, (count - i) * sizeof(NonLeafChild));
+            node->childArray[i + 1].pageNo = pageNo;
+            node->childArray[i + 1].count = 0;
+            node->numChildren++;
+            return true;
+        }
+
+        std::vector<int> keys(count + 1);
+        std::vector<PageId> pages(count + 2);
+        std::vector<std::uint32_t> counts(count + 2);
+        for (int j = 0; j <= count; j++)
+        {
+            pages[j + (j > i)] = childPage(node, j);
+            counts[j + (j > i)] = childCount(node, j);
+            if (j < count)
+            {
+                keys[j + (j >= i)] = nonLeafKey(node, j);
+            }
+        }
+        keys[i] = key;
+        pages[i + 1] = pageNo;
+        counts[i + 1] = 0;
+        return nonLeafFill(node, keys.data(), pages.data(), counts.data(), count + 1, capacity);
+    }
+
+    // -----------------------------------------------------------------------------
+    // STRING node layout
+    // -----------------------------------------------------------------------------
+
+    //Length of the prefix shared by two keys
+    static int sharedPrefix(const StringKey& a, const StringKey& b)
+    {
+        int i = 0;
+        while (i < STRINGSIZE && a.data[i] != '\0' && a.data[i] == b.data[i])
+        {
+            i++;
+        }
+        return i;
+    }
+
+    bool leafFill(LeafNodeString* leaf, const StringKey* keys, const RecordId* rids, const int n, const int capacity)
+    {
+        //The keys are in order, so what the first and the last share all of them share
+        int prefixLength = n > 0 ? sharedPrefix(keys[0], keys[n - 1]) : 0;
+        size_t keyBytes = prefixLength;
+        for (int i = 0; i < n; i++)
+        {
+            keyBytes += strnlen(keys[i].data, STRINGSIZE) - prefixLength;
+        }
+        if (offsetof(LeafNodeString, slotArray) + n * sizeof(StringSlot) + keyBytes > Page::SIZE)
+        {
+            return false;
+        }
+
+        std::uint64_t buffer[Page::SIZE / sizeof(std::uint64_t)];
+        memset(buffer, 0, Page::SIZE);
+        char * bytes = (char *) buffer;
+        LeafNodeString * node = (LeafNodeString *) buffer;
+        node->numEntries = n;
+        node->keyBytes = keyBytes;
+        node->prefixLength = prefixLength;
+        node->prefixOffset = Page::SIZE - prefixLength;
+        node->rightSibPageNo = leaf->rightSibPageNo;
+        node->leftSibPageNo = leaf->leftSibPageNo;
+        if (n > 0)
+        {
+            memcpy(bytes + node->prefixOffset, keys[0].data, prefixLength);
+        }
+        int offset = node->prefixOffset;
+        for (int i = 0; i < n; i++)
+        {
+            int length = strnlen(keys[i].data, STRINGSIZE) - prefixLength;
+            offset -= length;
+            StringSlot& slot = node->slotArray[i];
+            slot.rid = rids[i];
+            slot.keyOffset = offset;
+            slot.keyLength = length;
+            memcpy(bytes + offset, keys[i].data + prefixLength, length);
+        }
+        memcpy((void *) leaf, buffer, Page::SIZE);
+        return true;
+    }
+
+    bool leafInsert(LeafNodeString* leaf, const int count, const int capacity, const int pos, const StringKey& key, const RecordId& rid)
+    {
+        //Keys with the prefix of the leaf go in place as long as there is room
+        int length = strnlen(key.data, STRINGSIZE);
+        size_t slotsEnd = offsetof(LeafNodeString, slotArray) + (count + 1) * sizeof(StringSlot);
+        if (compareLeafPrefix(leaf, key.data, length) == 0
+            && slotsEnd + leaf->keyBytes + length - leaf->prefixLength <= Page::SIZE)
+        {
+            int suffixLength = length - leaf->prefixLength;
+            memmove(leaf->slotArray + pos + 1, leaf->slotArray + pos, (count - pos) * sizeof(StringSlot));
+            leaf->keyBytes += suffixLength;
+            StringSlot& slot = leaf->slotArray[pos];
+            slot.rid = rid;
+            slot.keyOffset = Page::SIZE - leaf->keyBytes;
+            slot.keyLength = suffixLength;
+            memcpy((char *) leaf + slot.keyOffset, key.data + leaf->prefixLength, suffixLength);
+            leaf->numEntries++;
+            return true;
+        }
+
+        //Otherwise lay the leaf out again with the prefix its keys share now, which may also free some room
+        std::vector<StringKey> keys(count + 1);
+        std::vector<RecordId> rids(count + 1);
+        for (int i = 0; i < count; i++)
+        {
+            keys[i + (i >= pos)] = leafKey(leaf, i);
+            rids[i + (i >= pos)] = leafRid(leaf, i);
+        }
+        keys[pos] = key;
+        rids[pos] = rid;
+        return leafFill(leaf, keys.data(), rids.data(), count + 1, capacity);
+    }
+
+    int leafSplitPoint(const StringKey* keys, const int total)
+    {
+        //m entries taking b bytes with their whole keys take b - (m - 1) * p with a shared prefix of p bytes
+        std::vector<int> bytes(total + 1, 0);
+        for (int i = 0; i < total; i++)
+        {
+            bytes[i + 1] = bytes[i] + sizeof(StringSlot) + strnlen(keys[i].data, STRINGSIZE);
+        }
+        int best = total / 2;
+        int bestSize = -1;
+        for (int k = 1; k < total; k++)
+        {
+            int left = bytes[k] - (k - 1) * sharedPrefix(keys[0], keys[k - 1]);
+            int right = bytes[total] - bytes[k] - (total - k - 1) * sharedPrefix(keys[k], keys[total - 1]);
+            if (bestSize < 0 || std::max(left, right) < bestSize)
+            {
+                best = k;
+                bestSize = std::max(left, right);
+            }
+        }
+        return best;
+    }
+
+    bool nonLeafFits(const StringKey* keys, const int n, const int capacity)
+    {
+        size_t bytes = offsetof(NonLeafNodeString, slotArray) + n * sizeof(NonLeafSlot);
+        for (int i = 0; i < n; i++)
+        {
+            bytes += strnlen(keys[i].data, STRINGSIZE);
+        }
+        return bytes <= Page::SIZE;
+    }
+
+    bool nonLeafFill(NonLeafNodeString* node, const StringKey* keys, const PageId* pages, const std::uint32_t* counts, const int n, const int capacity)
+    {
+        if (!nonLeafFits(keys, n, capacity))
+        {
+            return false;
+        }
+        node->numChildren = n + 1;
+        node->keyBytes = 0;
+        node->firstPageNo = pages[0];
+        node->firstCount = counts[0];
+        for (int i = 0; i < n; i++)
+        {
+            int length = strnlen(keys[i].data, STRINGSIZE);
+            node->keyBytes += length;
+            NonLeafSlot& slot = node->slotArray[i];
+            slot.pageNo = pages[i + 1];
+            slot.count = counts[i + 1];
+            slot.keyOffset = Page::SIZE - node->keyBytes;
+            slot.keyLength = length;
+            memcpy((char *) node + slot.keyOffset, keys[i].data, length);
+        }
+        return true;
+    }
+
+    bool nonLeafInsert(NonLeafNodeString* node, const int count, const int capacity, const int i, const StringKey& key, const PageId pageNo)
+    {
+        //Separators are never taken out again, so the key bytes stay packed
+        int length = strnlen(key.data, STRINGSIZE);
+        size_t slotsEnd = offsetof(NonLeafNodeString, slotArray) + (count + 1) * sizeof(NonLeafSlot);
+        if (slotsEnd + node->keyBytes + length > Page::SIZE)
+        {
+            return false;
+        }
+        memmove(node->slotArray + i + 1, node->slotArray + i, (count - i) * sizeof(NonLeafSlot));
+        node->keyBytes += length;
+        NonLeafSlot& slot = node->slotArray[i];
+        slot.pageNo = pageNo;
+        slot.count = 0;
+        slot.keyOffset = Page::SIZE - node->keyBytes;
+        slot.keyLength = length;
+        memcpy((char *) node + slot.keyOffset, key.data, length);
+        node->numChildren++;
+        return true;
+    }
+
+    int nonLeafSplitPoint(const StringKey* keys, const int total)
+    {
+        std::vector<int> bytes(total + 1, 0);
+        for (int i = 0; i < total; i++)
+        {
+            bytes[i + 1] = bytes[i] + sizeof(NonLeafSlot) + strnlen(keys[i].data, STRINGSIZE);
+        }
+        //Separator k moves up, the ones before it stay and the ones after it move
+        int best = total / 2;
+        int bestSize = -1;
+        for (int k = 1; k < total - 1; k++)
+        {
+            int size = std::max(bytes[k], bytes[total] - bytes[k + 1]);
+            if (bestSize < 0 || size < bestSize)
+            {
+                best = k;
+                bestSize = size;
+            }
+        }
+        return best;
+    }
+
+    // -----------------------------------------------------------------------------
+    // Posting lists
+    // -----------------------------------------------------------------------------
+
+    //Writes value as a varint, 7 bits a byte with the high bit set on all but the last. Returns the bytes written.
+    static int putVarint(std::uint32_t value, unsigned char* out)
+    {
+        int n = 0;
+        while (value >= 0x80)
+        {
+            out[n++] = (unsigned char) (value | 0x80);
+            value >>= 7;
+        }
+        out[n++] = (unsigned char) value;
+        return n;
+    }
+
+    static std::uint32_t getVarint(const unsigned char*& in)
+    {
+        std::uint32_t value = 0;
+        int shift = 0;
+        while (*in & 0x80)
+        {
+            value |= (std::uint32_t) (*in++ & 0x7F) << shift;
+            shift += 7;
+        }
+        value |= (std::uint32_t) *in++ << shift;
+        return value;
+    }
+
+    bool postingAppend(PostingPage* page, const RecordId& rid)
+    {
+        RecordId prev = {0, 0};
+        if (page->numRids > 0)
+        {
+            prev = page->lastRid;
+        }
+        unsigned char bytes[10];
+        std::uint32_t pageDelta = rid.page_number - prev.page_number;
+        int n = putVarint(pageDelta, bytes);
+        n += putVarint(pageDelta == 0 ? rid.slot_number - prev.slot_number : rid.slot_number, bytes + n);
+        if (page->numBytes + n > POSTINGDATASIZE)
+        {
+            return false;
+        }
+        memcpy(page->data + page->numBytes, bytes, n);
+        page->numBytes += n;
+        page->numRids++;
+        page->lastRid = rid;
+        return true;
+    }
+
+    void postingDecode(const PostingPage* page, std::vector<RecordId>& rids)
+    {
+        const unsigned char* in = page->data;
+        RecordId rid = {0, 0};
+        for (int i = 0; i < page->numRids; i++)
+        {
+            std::uint32_t pageDelta = getVarint(in);
+            std::uint32_t slot = getVarint(in);
+            rid.page_number += pageDelta;
+            rid.slot_number = pageDelta == 0 ? rid.slot_number + slot : slot;
+            rids.push_back(rid);
+        }
+    }
+
+    void readPosting(BufMgr* bufMgr, File* file, const PageId headPageNo, std::vector<RecordId>& rids)
+    {
+        rids.clear();
+        PageId pageNo = headPageNo;
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            Page * page;
+            bufMgr->readPage(file, pageNo, page);
+            PostingPage * posting = (PostingPage *) page;
+            if (pageNo == headPageNo)
+            {
+                rids.reserve(posting->totalRids);
+            }
+            postingDecode(posting, rids);
+            PageId next = posting->nextPageNo;
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = next;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // Composite keys
+    // -----------------------------------------------------------------------------
+
+    //Writes the 8 * n bits of bytes 7 at a time, plus 1 so no byte is 0 or PASTPREFIX. Returns the bytes written.
+    static int putDigits(const unsigned char* bytes, const int n, unsigned char* out)
+    {
+        int bits = 8 * n;
+        int digits = (bits + 6) / 7;
+        //the first digit is padded with zeros at the top
+        int bit = bits - 7 * digits;
+        for (int d = 0; d < digits; d++)
+        {
+            int value = 0;
+            for (int b = 0; b < 7; b++, bit++)
+            {
+                value <<= 1;
+                if (bit >= 0)
+                {
+                    value |= (bytes[bit / 8] >> (7 - bit % 8)) & 1;
+                }
+            }
+            out[d] = value + 1;
+        }
+        return digits;
+    }
+
+    int encodeKeyColumn(const void* value, const Datatype type, unsigned char* out)
+    {
+        unsigned char bytes[8];
+        if (type == INTEGER)
+        {
+            normalizeKey(keyFromPtr<int>(value), bytes);
+            return putDigits(bytes, sizeof(int), out);
+        }
+        if (type == DOUBLE)
+        {
+            normalizeKey(keyFromPtr<double>(value), bytes);
+            return putDigits(bytes, sizeof(double), out);
+        }
+        //0x01 to 0xFC go up by one, 0xFD to 0xFF become 0xFE followed by 0x02 to 0x04
+        const unsigned char * str = (const unsigned char *) value;
+        int length = strnlen((const char *) value, STRINGSIZE);
+        int n = 0;
+        for (int i = 0; i < length; i++)
+        {
+            if (str[i] < 0xFD)
+            {
+                out[n++] = str[i] + 1;
+            }
+            else
+            {
+                out[n++] = 0xFE;
+                out[n++] = str[i] - 0xFB;
+            }
+        }
+        out[n++] = 0x01;
+        return n;
+    }
+
+    //Reads the 8 * n bits written by putDigits to bytes. Returns the bytes read.
+    static int getDigits(const unsigned char* in, const int n, unsigned char* bytes)
+    {
+        int bits = 8 * n;
+        int digits = (bits + 6) / 7;
+        int bit = bits - 7 * digits;
+        memset(bytes, 0, n);
+        for (int d = 0; d < digits; d++)
+        {
+            int value = in[d] - 1;
+            for (int b = 6; b >= 0; b--, bit++)
+            {
+                if (bit >= 0 && ((value >> b) & 1))
+                {
+                    bytes[bit / 8] |= 0x80 >> (bit % 8);
+                }
+            }
+        }
+        return digits;
+    }
+
+    int decodeKeyColumn(const unsigned char* in, const Datatype type, void* out)
+    {
+        unsigned char bytes[8];
+        if (type == INTEGER)
+        {
+            int n = getDigits(in, sizeof(int), bytes);
+            std::uint32_t bits = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                bits = (bits << 8) | bytes[i];
+            }
+            int value = (int) (bits ^ 0x80000000u);
+            memcpy(out, &value, sizeof(int));
+            return n;
+        }
+        if (type == DOUBLE)
+        {
+            int n = getDigits(in, sizeof(double), bytes);
+            std::uint64_t bits = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                bits = (bits << 8) | bytes[i];
+            }
+            bits = (bits >> 63) ? bits ^ 0x8000000000000000ull : ~bits;
+            memcpy(out, &bits, sizeof(double));
+            return n;
+        }
+        char * str = (char *) out;
+        int n = 0;
+        int length = 0;
+        while (in[n] != 0x01)
+        {
+            if (in[n] == 0xFE)
+            {
+                str[length++] = in[n + 1] + 0xFB;
+                n += 2;
+            }
+            else
+            {
+                str[length++] = in[n] - 1;
+                n++;
+            }
+        }
+        if (length < STRINGSIZE)
+        {
+            str[length] = '\0';
+        }
+        return n + 1;
+    }
+
+    //Encoded key of the values of the first n columns, which may be longer than COMPOSITEKEYSIZE
+    static std::string encodeColumns(const std::vector<KeyColumn>& columns, const void* const* values, const int n)
+    {
+        std::string key;
+        unsigned char column[2 * STRINGSIZE + 1];
+        for (int i = 0; i < n; i++)
+        {
+            int length = encodeKeyColumn(values[i], columns[i].attrType, column);
+            key.append((const char *) column, length);
+        }
+        return key;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::BTreeIndex -- Constructor
+    // -----------------------------------------------------------------------------
+
+    BTreeIndex::BTreeIndex(const std::string & relationName,
+                           std::string & indexName,
+                           BufMgr *bufMgrIn,
+                           const int attrByteOffset,
+                           const Datatype attrType,
+                           const bool resident)
+    {
+        std::ostringstream idxStr;
+        idxStr << relationName << '.' << attrByteOffset;
+        indexName = idxStr.str(); // indexName is the name of the index file
+        openIndex(relationName, indexName, bufMgrIn, attrByteOffset, attrType, resident);
+    }
+
+    BTreeIndex::BTreeIndex(const std::string & relationName,
+                           std::string & indexName,
+                           BufMgr *bufMgrIn,
+                           const std::vector<KeyColumn>& columns,
+                           const std::vector<KeyColumn>& includeColumns)
+    {
+        if (columns.empty() || columns.size() > (size_t) MAXKEYCOLUMNS)
+        {
+            throw BadIndexInfoException("A composite key must have 1 to MAXKEYCOLUMNS columns");
+        }
+        if (includeColumns.size() > (size_t) MAXKEYCOLUMNS)
+        {
+            throw BadIndexInfoException("A covering index can include at most MAXKEYCOLUMNS columns");
+        }
+        std::vector<KeyColumn> allColumns(columns);
+        allColumns.insert(allColumns.end(), includeColumns.begin(), includeColumns.end());
+        std::ostringstream idxStr;
+        idxStr << relationName;
+        for (size_t i = 0; i < allColumns.size(); i++)
+        {
+            if (allColumns[i].attrType != INTEGER && allColumns[i].attrType != DOUBLE && allColumns[i].attrType != STRING)
+            {
+                throw BadIndexInfoException("Datatype must equal INTEGER(0) DOUBLE(1) STRING(2)");
+            }
+            idxStr << (i < columns.size() ? '.' : '+') << allColumns[i].attrByteOffset;
+        }
+        indexName = idxStr.str();
+        //The tree holds the encoded columns, include columns last, as STRING keys
+        this->keyColumns = columns;
+        this->includeColumns = includeColumns;
+        openIndex(relationName, indexName, bufMgrIn, columns[0].attrByteOffset, STRING, false);
+    }
+
+    void BTreeIndex::openIndex(const std::string & relationName,
+                               const std::string & indexName,
+                               BufMgr *bufMgrIn,
+                               const int attrByteOffset,
+                               const Datatype attrType,
+                               const bool resident)
+    {
+        this->bufMgr = bufMgrIn;
+        this->resident = resident;
+        this->attributeType = attrType;
+        this->attrByteOffset = attrByteOffset;
+        this->headerPageNum = 1;
+        this->freePageNum = Page::INVALID_NUMBER;
+        this->numSplits = 0;
+        this->countsKept = false;
+        this->histogramStale = false;
+        this->postingGrown = false;
+        this->scanExecuting = false;
+        this->currentPageNum = Page::INVALID_NUMBER;
+        this->currentPageData = NULL;
+        this->nextRange = 0;
+        this->scanReturnedEntry = false;
+        this->scanDirection = FORWARD;
+        this->scanRemaining = -1;
+        this->postingNext = 0;
+
+        //INTEGER
+        if (this->attributeType == INTEGER)
+        {
+            this->leafOccupancy = INTARRAYLEAFSIZE;
+            this->nodeOccupancy = INTARRAYNONLEAFSIZE;
+        }
+        //DOUBLE
+        else if (this->attributeType == DOUBLE)
+        {
+            this->leafOccupancy = DOUBLEARRAYLEAFSIZE;
+            this->nodeOccupancy = DOUBLEARRAYNONLEAFSIZE;
+        }
+        //STRING
+        else if (this->attributeType == STRING)
+        {
+            this->leafOccupancy = STRINGARRAYLEAFSIZE;
+            this->nodeOccupancy = STRINGARRAYNONLEAFSIZE;
+        }
+        //ERROR
+        else
+        {
+            throw BadIndexInfoException("Datatype must equal INTEGER(0) DOUBLE(1) STRING(2)");
+        }
+
+        //File does exist, check that the meta page matches what we were asked for
+        if (File::exists(indexName))
+        {
+            this->file = new BlobFile(indexName, false);
+            if (resident)
+            {
+                loadResident();
+            }
+            Page * page;
+            readNode(headerPageNum, page);
+            IndexMetaInfo * meta = (IndexMetaInfo *) page;
+            bool matches = strncmp(meta->relationName, relationName.c_str(), sizeof(meta->relationName)) == 0
+                && meta->attrByteOffset == attrByteOffset
+                && meta->attrType == attrType
+                && meta->numKeyColumns == (int) keyColumns.size()
+                && meta->numIncludeColumns == (int) includeColumns.size();
+            for (int i = 0; matches && i < meta->numKeyColumns; i++)
+            {
+                matches = meta->keyColumns[i].attrByteOffset == keyColumns[i].attrByteOffset
+                    && meta->keyColumns[i].attrType == keyColumns[i].attrType;
+            }
+            for (int i = 0; matches && i < meta->numIncludeColumns; i++)
+            {
+                matches = meta->includeColumns[i].attrByteOffset == includeColumns[i].attrByteOffset
+                    && meta->includeColumns[i].attrType == includeColumns[i].attrType;
+            }
+            this->rootPageNum = meta->rootPageNo;
+            this->freePageNum = meta->freePageNo;
+            this->numSplits = meta->numSplits;
+            this->countsKept = meta->countsKept != 0;
+            unPinNode(headerPageNum, false);
+            if (!matches)
+            {
+                //Drop the frames of this file so a later File object at the same address cannot see them
+                releaseNodes();
+                delete this->file;
+                throw BadIndexInfoException(indexName);
+            }
+            return;
+        }
+
+        //File does not exist, create it and build the index from the relation
+        this->file = new BlobFile(indexName, true);
+        residentPages.assign(1, (Page *) NULL);
+
+        //SET UP THE META INFO PAGE
+        Page * metaPage;
+        appendNode(headerPageNum, metaPage);
+        IndexMetaInfo * metaInfo = (IndexMetaInfo *) metaPage;
+        strncpy(metaInfo->relationName, relationName.c_str(), sizeof(metaInfo->relationName) - 1);
+        metaInfo->attrByteOffset = attrByteOffset;
+        metaInfo->attrType = attrType;
+        metaInfo->numKeyColumns = keyColumns.size();
+        std::copy(keyColumns.begin(), keyColumns.end(), metaInfo->keyColumns);
+        metaInfo->numIncludeColumns = includeColumns.size();
+        std::copy(includeColumns.begin(), includeColumns.end(), metaInfo->includeColumns);
+        metaInfo->rootPageNo = Page::INVALID_NUMBER;
+        metaInfo->freePageNo = Page::INVALID_NUMBER;
+        //a root over a single leaf
+        metaInfo->height = 2;
+        unPinNode(headerPageNum, true);
+
+        //SET UP THE ROOT PAGE
+        if (this->attributeType == INTEGER)
+        {
+            initTree<int>();
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            initTree<double>();
+        }
+        else
+        {
+            initTree<StringKey>();
+        }
+
+        std::vector<KeyColumn> storedColumns(keyColumns);
+        storedColumns.insert(storedColumns.end(), includeColumns.begin(), includeColumns.end());
+        FileScan scan(relationName, bufMgr);
+        RecordId scanID;
+        try
+        {
+            while (true)
+            {
+                scan.scanNext(scanID);
+                std::string recordStr = scan.getRecord();
+                const char *record = recordStr.c_str();
+                if (keyColumns.empty())
+                {
+                    insertEntry(record + attrByteOffset, scanID);
+                    continue;
+                }
+                const void * values[2 * MAXKEYCOLUMNS];
+                for (size_t i = 0; i < storedColumns.size(); i++)
+                {
+                    values[i] = record + storedColumns[i].attrByteOffset;
+                }
+                std::string key = encodeColumns(storedColumns, values, storedColumns.size());
+                if (key.size() > (size_t) COMPOSITEKEYSIZE)
+                {
+                    throw BadIndexInfoException("Composite key longer than COMPOSITEKEYSIZE in " + indexName);
+                }
+                insertEntry(key.c_str(), scanID);
+            }
+        }
+        catch (EndOfFileException e)
+        {
+            // Index has completed
+        }
+        catch (BadIndexInfoException e)
+        {
+            //A key the index cannot hold, leave no partial index behind to be opened later
+            releaseNodes();
+            delete file;
+            File::remove(indexName);
+            throw;
+        }
+    }
+
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::~BTreeIndex -- destructor
+    // -----------------------------------------------------------------------------
+
+    BTreeIndex::~BTreeIndex()
+    {
+        try
+        {
+            if(this->scanExecuting == true)
+            {
+                this->endScan();
+            }
+            this->flush();
+        }
+        catch (BadgerDbException e)
+        {
+
+        }
+        if (resident)
+        {
+            releaseNodes();
+        }
+        delete this->file;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::readNode
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::readNode(const PageId pageNo, Page*& page)
+    {
+        if (resident)
+        {
+            page = residentPages[pageNo];
+            return;
+        }
+        bufMgr->readPage(file, pageNo, page);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::unPinNode
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::unPinNode(const PageId pageNo, const bool dirty)
+    {
+        if (!resident)
+        {
+            bufMgr->unPinPage(file, pageNo, dirty);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::readPostingRids
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::readPostingRids(const PageId headPageNo, std::vector<RecordId>& rids)
+    {
+        if (!resident)
+        {
+            readPosting(bufMgr, file, headPageNo, rids);
+            return;
+        }
+        rids.clear();
+        rids.reserve(((PostingPage *) residentPages[headPageNo])->totalRids);
+        for (PageId pageNo = headPageNo; pageNo != Page::INVALID_NUMBER; pageNo = ((PostingPage *) residentPages[pageNo])->nextPageNo)
+        {
+            postingDecode((PostingPage *) residentPages[pageNo], rids);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::loadResident
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::loadResident()
+    {
+        BlobFile * blob = (BlobFile *) file;
+        PageId numPages = blob->getNumPages();
+        residentImage.resize(numPages);
+        if (numPages > 0)
+        {
+            blob->readPages(1, numPages, &residentImage[0]);
+        }
+        residentPages.assign(1, (Page *) NULL);
+        for (PageId i = 0; i < numPages; i++)
+        {
+            residentPages.push_back(&residentImage[i]);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::releaseNodes
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::releaseNodes()
+    {
+        if (!resident)
+        {
+            bufMgr->flushFile(file);
+            return;
+        }
+        for (size_t i = residentImage.size() + 1; i < residentPages.size(); i++)
+        {
+            delete residentPages[i];
+        }
+        residentPages.clear();
+        residentImage.clear();
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::allocNode
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::allocNode(PageId& pageNo, Page*& page)
+    {
+        if (freePageNum == Page::INVALID_NUMBER)
+        {
+            appendNode(pageNo, page);
+            return;
+        }
+        //Reuse the first free page
+        pageNo = freePageNum;
+        readNode(pageNo, page);
+        PageId next = *(PageId *) page;
+        memset((void *) page, 0, Page::SIZE);
+        setFreePageNo(next);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::appendNode
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::appendNode(PageId& pageNo, Page*& page)
+    {
+        if (resident)
+        {
+            //Numbered like BlobFile::allocatePage() would, the file catches up on flush()
+            pageNo = residentPages.size();
+            residentPages.push_back(new Page());
+            page = residentPages.back();
+        }
+        else
+        {
+            bufMgr->allocPage(file, pageNo, page);
+        }
+        memset((void *) page, 0, Page::SIZE);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::freeNode
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::freeNode(const PageId pageNo)
+    {
+        Page * page;
+        readNode(pageNo, page);
+        memset((void *) page, 0, Page::SIZE);
+        *(PageId *) page = freePageNum;
+        unPinNode(pageNo, true);
+        setFreePageNo(pageNo);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::setRootPageNo
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::setRootPageNo(const PageId pageNo)
+    {
+        Page * page;
+        readNode(headerPageNum, page);
+        ((IndexMetaInfo *) page)->rootPageNo = pageNo;
+        unPinNode(headerPageNum, true);
+        this->rootPageNum = pageNo;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::setFreePageNo
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::setFreePageNo(const PageId pageNo)
+    {
+        Page * page;
+        readNode(headerPageNum, page);
+        ((IndexMetaInfo *) page)->freePageNo = pageNo;
+        unPinNode(headerPageNum, true);
+        this->freePageNum = pageNo;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::writePosting
+    // -----------------------------------------------------------------------------
+
+    PageId BTreeIndex::writePosting(const std::vector<RecordId>& rids)
+    {
+        PageId headPageNo;
+        Page * headPage;
+        allocNode(headPageNo, headPage);
+        PostingPage * head = (PostingPage *) headPage;
+        head->nextPageNo = Page::INVALID_NUMBER;
+        head->totalRids = rids.size();
+
+        PageId pageNo = headPageNo;
+        PostingPage * posting = head;
+        for (size_t i = 0; i < rids.size(); i++)
+        {
+            if (postingAppend(posting, rids[i]))
+            {
+                continue;
+            }
+            PageId nextPageNo;
+            Page * nextPage;
+            allocNode(nextPageNo, nextPage);
+            posting->nextPageNo = nextPageNo;
+            if (pageNo != headPageNo)
+            {
+                unPinNode(pageNo, true);
+            }
+            pageNo = nextPageNo;
+            posting = (PostingPage *) nextPage;
+            posting->nextPageNo = Page::INVALID_NUMBER;
+            postingAppend(posting, rids[i]);
+        }
+        head->tailPageNo = pageNo;
+        if (pageNo != headPageNo)
+        {
+            unPinNode(pageNo, true);
+        }
+        unPinNode(headPageNo, true);
+        return headPageNo;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::postingInsert
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::postingInsert(RecordId& entryRid, const RecordId& rid)
+    {
+        PageId headPageNo = entryRid.page_number;
+        Page * headPage;
+        readNode(headPageNo, headPage);
+        PostingPage * head = (PostingPage *) headPage;
+        PageId tailPageNo = head->tailPageNo;
+        Page * tailPage;
+        readNode(tailPageNo, tailPage);
+        PostingPage * tail = (PostingPage *) tailPage;
+
+        //RecordIds mostly come in relation order, so they go at the end of the list
+        if (!ridBefore(rid, tail->lastRid))
+        {
+            if (!postingAppend(tail, rid))
+            {
+                PageId newPageNo;
+                Page * newPage;
+                allocNode(newPageNo, newPage);
+                PostingPage * posting = (PostingPage *) newPage;
+                posting->nextPageNo = Page::INVALID_NUMBER;
+                postingAppend(posting, rid);
+                unPinNode(newPageNo, true);
+                tail->nextPageNo = newPageNo;
+                head->tailPageNo = newPageNo;
+            }
+            head->totalRids++;
+            unPinNode(tailPageNo, true);
+            unPinNode(headPageNo, true);
+            return;
+        }
+        unPinNode(tailPageNo, false);
+        unPinNode(headPageNo, false);
+
+        //Anywhere else the deltas after it change, write the list again
+        std::vector<RecordId> rids;
+        readPostingRids(headPageNo, rids);
+        rids.insert(std::upper_bound(rids.begin(), rids.end(), rid, ridBefore), rid);
+        freePosting(headPageNo);
+        entryRid.page_number = writePosting(rids);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::freePosting
+    // -----------------------------------------------------------------------------
+
+    void BTreeIndex::freePosting(const PageId headPageNo)
+    {
+        PageId pageNo = headPageNo;
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            PageId next = ((PostingPage *) page)->nextPageNo;
+            unPinNode(pageNo, false);
+            freeNode(pageNo);
+            pageNo = next;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::ridWeight
+    // -----------------------------------------------------------------------------
+
+    std::uint64_t BTreeIndex::ridWeight(const RecordId& rid)
+    {
+        if (!isPostingRid(rid))
+        {
+            return 1;
+        }
+        Page * page;
+        readNode(rid.page_number, page);
+        std::uint64_t total = ((PostingPage *) page)->totalRids;
+        unPinNode(rid.page_number, false);
+        return total;
+    }
+
+    template <class Leaf>
+    std::uint64_t BTreeIndex::leafWeight(Leaf* leaf, const int from, const int to)
+    {
+        std::uint64_t total = 0;
+        for (int i = from; i < to; i++)
+        {
+            total += ridWeight(leafRid(leaf, i));
+        }
+        return total;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::takeRid
+    // -----------------------------------------------------------------------------
+
+    bool BTreeIndex::takeRid(const RecordId& entryRid, RecordId& outRid)
+    {
+        if (!isPostingRid(entryRid))
+        {
+            outRid = entryRid;
+            return true;
+        }
+        //First RecordId of the list, load all of it
+        if (postingRids.empty())
+        {
+            readPostingRids(entryRid.page_number, postingRids);
+            postingNext = scanDirection == FORWARD ? 0 : postingRids.size();
+        }
+        outRid = scanDirection == FORWARD ? postingRids[postingNext++] : postingRids[--postingNext];
+        bool done = scanDirection == FORWARD ? postingNext == postingRids.size() : postingNext == 0;
+        if (done)
+        {
+            postingRids.clear();
+        }
+        return done;
+    }
+
+    int BTreeIndex::returnedEntry() const
+    {
+        //The scan stays on a posting list until it has returned all of it
+        if (!postingRids.empty())
+        {
+            return nextEntry;
+        }
+        return scanDirection == FORWARD ? nextEntry - 1 : nextEntry + 1;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::initTree
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void BTreeIndex::initTree()
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        //The root is always a non leaf node, starting at level 1 with a single empty leaf
+        PageId rootId;
+        Page * rootPage;
+        allocNode(rootId, rootPage);
+        PageId leafId;
+        Page * leafPage;
+        allocNode(leafId, leafPage);
+
+        NonLeaf * root = (NonLeaf *) rootPage;
+        root->level = 1;
+        std::uint32_t leafCount = 0;
+        nonLeafFill(root, (const T *) NULL, &leafId, &leafCount, 0, NodeTraits<T>::NONLEAFSIZE);
+
+        unPinNode(leafId, true);
+        unPinNode(rootId, true);
+        setRootPageNo(rootId);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::insertEntry
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::insertEntry(const void *key, const RecordId rid)
+    {
+        if (this->attributeType == INTEGER)
+        {
+            insertTyped<int>(key, rid);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            insertTyped<double>(key, rid);
+        }
+        else
+        {
+            insertTyped<StringKey>(key, rid);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::insertTyped(const void* key, const RecordId rid)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        RIDKeyPair<T> entry;
+        entry.set(rid, keyFromPtr<T>(key));
+
+        bool split = false;
+        PageKeyPair<T> newChild;
+        std::uint64_t splitsBefore = numSplits;
+        postingGrown = false;
+        std::uint32_t leftCount, rightCount;
+        insertRecursive<T>(rootPageNum, false, entry, split, newChild, leftCount, rightCount);
+
+        Page * metaPage;
+        readNode(headerPageNum, metaPage);
+        IndexMetaInfo * meta = (IndexMetaInfo *) metaPage;
+        meta->numSplits = numSplits;
+        meta->height += split ? 1 : 0;
+        histogramInsert<T>(meta, entry.key);
+        bool rebuild = (numSplits != splitsBefore && (meta->histogramBuckets < HISTOGRAMBUCKETS || histogramStale))
+                       || (postingGrown && histogramStale);
+        unPinNode(headerPageNum, true);
+
+        //Root was split, grow the tree by one level
+        if (split)
+        {
+            PageId newRootId;
+            Page * newRootPage;
+            allocNode(newRootId, newRootPage);
+            NonLeaf * newRoot = (NonLeaf *) newRootPage;
+            //level 1 only for nodes right above the leaves
+            newRoot->level = 0;
+            PageId children[2] = {rootPageNum, newChild.pageNo};
+            std::uint32_t counts[2] = {leftCount, rightCount};
+            nonLeafFill(newRoot, &newChild.key, children, counts, 1, NodeTraits<T>::NONLEAFSIZE);
+            unPinNode(newRootId, true);
+            setRootPageNo(newRootId);
+        }
+
+        //A split added a separator, refresh the histogram while it is still filling up or has gone lopsided.
+        //A posting list that made it lopsided gets a bucket of its own.
+        if (rebuild)
+        {
+            rebuildHistogram<T>();
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::insertRecursive(const PageId pageNo, const bool isLeaf, const RIDKeyPair<T>& entry,
+                                     bool& split, PageKeyPair<T>& newChild, std::uint32_t& leftCount, std::uint32_t& rightCount)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+        const int leafSize = NodeTraits<T>::LEAFSIZE;
+        const int nonLeafSize = NodeTraits<T>::NONLEAFSIZE;
+
+        split = false;
+        Page * page;
+
+        //LEAF
+        if (isLeaf)
+        {
+            readNode(pageNo, page);
+            Leaf * leaf = (Leaf *) page;
+            int count = leafEntryCount(leaf, leafSize);
+            //Duplicates go after the existing equal keys
+            int pos = leafUpperBound(leaf, 0, count, entry.key);
+
+            //the key already has a posting list, add to it
+            if (pos > 0 && isPostingRid(leafRid(leaf, pos - 1)) && leafKey(leaf, pos - 1) == entry.key)
+            {
+                postingInsert(leafRid(leaf, pos - 1), entry.rid);
+                postingGrown = true;
+                unPinNode(pageNo, true);
+                return;
+            }
+
+            //room left, shift the larger entries right and insert
+            if (leafInsert(leaf, count, leafSize, pos, entry.key, entry.rid))
+            {
+                unPinNode(pageNo, true);
+                return;
+            }
+
+            //full, and at least half of it is this key: move its RecordIds to a posting list instead of
+            //splitting. A shorter run takes less room in the leaf than in a page of its own.
+            int first = leafLowerBound(leaf, 0, pos, entry.key);
+            if (pos > first && 2 * (pos - first + 1) >= count + 1)
+            {
+                std::vector<RecordId> postings;
+                for (int i = first; i < pos; i++)
+                {
+                    std::vector<RecordId> rids(1, leafRid(leaf, i));
+                    if (isPostingRid(rids[0]))
+                    {
+                        readPostingRids(rids[0].page_number, rids);
+                        freePosting(leafRid(leaf, i).page_number);
+                    }
+                    postings.insert(postings.end(), rids.begin(), rids.end());
+                }
+                postings.push_back(entry.rid);
+                std::sort(postings.begin(), postings.end(), ridBefore);
+
+                RecordId postingRid;
+                postingRid.page_number = writePosting(postings);
+                postingRid.slot_number = POSTINGSLOT;
+                std::vector<T> keys;
+                std::vector<RecordId> rids;
+                for (int i = 0; i < count; i++)
+                {
+                    if (i == first)
+                    {
+                        keys.push_back(entry.key);
+                        rids.push_back(postingRid);
+                    }
+                    if (i < first || i >= pos)
+                    {
+                        keys.push_back(leafKey(leaf, i));
+                        rids.push_back(leafRid(leaf, i));
+                    }
+                }
+                PageId rightSibPageNo = leaf->rightSibPageNo;
+                PageId leftSibPageNo = leaf->leftSibPageNo;
+                memset((void *) leaf, 0, Page::SIZE);
+                leafFill(leaf, keys.data(), rids.data(), keys.size(), leafSize);
+                leaf->rightSibPageNo = rightSibPageNo;
+                leaf->leftSibPageNo = leftSibPageNo;
+                postingGrown = true;
+                unPinNode(pageNo, true);
+                return;
+            }
+
+            //full, split the leaf in half and copy the first key of the right half up
+            int total = count + 1;
+            std::vector<T> allKeys(total);
+            std::vector<RecordId> allRids(total);
+            for (int i = 0; i < count; i++)
+            {
+                allKeys[i + (i >= pos)] = leafKey(leaf, i);
+                allRids[i + (i >= pos)] = leafRid(leaf, i);
+            }
+            allKeys[pos] = entry.key;
+            allRids[pos] = entry.rid;
+
+            PageId newPageNo;
+            Page * newPage;
+            allocNode(newPageNo, newPage);
+            Leaf * newLeaf = (Leaf *) newPage;
+
+            int leftEntries = leafSplitPoint(allKeys.data(), total);
+            int rightEntries = total - leftEntries;
+            PageId rightSibPageNo = leaf->rightSibPageNo;
+            PageId leftSibPageNo = leaf->leftSibPageNo;
+            memset((void *) leaf, 0, Page::SIZE);
+            leafFill(leaf, allKeys.data(), allRids.data(), leftEntries, leafSize);
+            leafFill(newLeaf, allKeys.data() + leftEntries, allRids.data() + leftEntries, rightEntries, leafSize);
+            //the parent counts RecordIds, which a posting list holds many of
+            leftCount = leafWeight(leaf, 0, leftEntries);
+            rightCount = leafWeight(newLeaf, 0, rightEntries);
+
+            newLeaf->rightSibPageNo = rightSibPageNo;
+            newLeaf->leftSibPageNo = pageNo;
+            leaf->rightSibPageNo = newPageNo;
+            leaf->leftSibPageNo = leftSibPageNo;
+            if (rightSibPageNo != Page::INVALID_NUMBER)
+            {
+                Page * rightPage;
+                readNode(rightSibPageNo, rightPage);
+                ((Leaf *) rightPage)->leftSibPageNo = newPageNo;
+                unPinNode(rightSibPageNo, true);
+            }
+
+            //The parent only has to tell the two leaves apart
+            newChild.set(newPageNo, separatorKey(allKeys[leftEntries - 1], allKeys[leftEntries]));
+            split = true;
+            numSplits++;
+            unPinNode(newPageNo, true);
+            unPinNode(pageNo, true);
+            return;
+        }
+
+        //NON LEAF, find the child to descend into
+        readNode(pageNo, page);
+        NonLeaf * node = (NonLeaf *) page;
+        int count = nonLeafKeyCount(node, nonLeafSize);
+        int childIndex = nonLeafUpperBound(node, count, entry.key);
+        PageId childPageNo = childPage(node, childIndex);
+        bool childIsLeaf = node->level == 1;
+        //Every insert lands in exactly one child, count it on the way down
+        if (countsKept)
+        {
+            childCount(node, childIndex)++;
+        }
+        unPinNode(pageNo, countsKept);
+
+        bool childSplit = false;
+        PageKeyPair<T> pushUp;
+        std::uint32_t childLeft, childRight;
+        insertRecursive<T>(childPageNo, childIsLeaf, entry, childSplit, pushUp, childLeft, childRight);
+        if (!childSplit)
+        {
+            return;
+        }
+
+        //child was split, add the new separator right after childIndex
+        readNode(pageNo, page);
+        node = (NonLeaf *) page;
+
+        //room left
+        if (nonLeafInsert(node, count, nonLeafSize, childIndex, pushUp.key, pushUp.pageNo))
+        {
+            childCount(node, childIndex) = countsKept ? childLeft : 0;
+            childCount(node, childIndex + 1) = countsKept ? childRight : 0;
+            unPinNode(pageNo, true);
+            return;
+        }
+
+        //full, split the node and push the middle key up
+        int total = count + 1;
+        std::vector<T> allKeys(total);
+        std::vector<PageId> allPages(total + 1);
+        std::vector<std::uint32_t> allCounts(total + 1);
+        for (int i = 0; i <= count; i++)
+        {
+            allPages[i + (i > childIndex)] = childPage(node, i);
+            allCounts[i + (i > childIndex)] = childCount(node, i);
+            if (i < count)
+            {
+                allKeys[i + (i >= childIndex)] = nonLeafKey(node, i);
+            }
+        }
+        allKeys[childIndex] = pushUp.key;
+        allPages[childIndex + 1] = pushUp.pageNo;
+        allCounts[childIndex] = countsKept ? childLeft : 0;
+        allCounts[childIndex + 1] = countsKept ? childRight : 0;
+
+        PageId newPageNo;
+        Page * newPage;
+        allocNode(newPageNo, newPage);
+        NonLeaf * newNode = (NonLeaf *) newPage;
+        newNode->level = node->level;
+
+        int mid = nonLeafSplitPoint(allKeys.data(), total);
+        int level = node->level;
+        memset((void *) node, 0, Page::SIZE);
+        node->level = level;
+        nonLeafFill(node, allKeys.data(), allPages.data(), allCounts.data(), mid, nonLeafSize);
+        nonLeafFill(newNode, allKeys.data() + mid + 1, allPages.data() + mid + 1, allCounts.data() + mid + 1, total - mid - 1, nonLeafSize);
+        leftCount = std::accumulate(allCounts.begin(), allCounts.begin() + mid + 1, 0u);
+        rightCount = std::accumulate(allCounts.begin() + mid + 1, allCounts.end(), 0u);
+
+        newChild.set(newPageNo, allKeys[mid]);
+        split = true;
+        numSplits++;
+        unPinNode(newPageNo, true);
+        unPinNode(pageNo, true);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::findLeaf
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    PageId BTreeIndex::findLeaf(const T& key)
+    {
+        scanPath.clear();
+        return descend<T>(rootPageNum, key, false);
+    }
+
+    template <class T>
+    PageId BTreeIndex::descend(const PageId startPageNo, const T& key, const bool strict)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        PageId pageNo = startPageNo;
+        while (true)
+        {
+            scanPath.push_back(pageNo);
+            Page * page;
+            readNode(pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+            //Equal keys may sit on both sides of a separator, so take the leftmost candidate,
+            //or the rightmost one when looking for the first larger key
+            int childIndex = strict ? nonLeafUpperBound(node, count, key) : nonLeafLowerBound(node, count, key);
+            PageId childPageNo = childPage(node, childIndex);
+            bool childIsLeaf = node->level == 1;
+            unPinNode(pageNo, false);
+            pageNo = childPageNo;
+            if (childIsLeaf)
+            {
+                return pageNo;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::seekLeaf
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    PageId BTreeIndex::seekLeaf(const T& key, const bool strict)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        //The root always covers key, so stop below it
+        while (scanPath.size() > 1)
+        {
+            PageId pageNo = scanPath.back();
+            scanPath.pop_back();
+            Page * page;
+            readNode(pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+            bool covers = count > 0 && (strict ? key < nonLeafKey(node, count - 1) : !(nonLeafKey(node, count - 1) < key));
+            unPinNode(pageNo, false);
+            if (covers)
+            {
+                return descend<T>(pageNo, key, strict);
+            }
+        }
+        scanPath.clear();
+        return descend<T>(rootPageNum, key, strict);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::startScan
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::startScan(const void* lowValParm,
+                                     const Operator lowOpParm,
+                                     const void* highValParm,
+                                     const Operator highOpParm)
+    {
+        startScan(lowValParm, lowOpParm, highValParm, highOpParm, FORWARD, 0);
+    }
+
+    const void BTreeIndex::startScan(const void* lowValParm,
+                                     const Operator lowOpParm,
+                                     const void* highValParm,
+                                     const Operator highOpParm,
+                                     const ScanDirection direction,
+                                     const int limit)
+    {
+        if((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+
+        if(scanExecuting)
+        {
+            endScan();
+        }
+        scanRanges.clear();
+        nextRange = 0;
+        lowOp = lowOpParm;
+        highOp = highOpParm;
+        scanDirection = direction;
+        scanRemaining = limit > 0 ? limit : -1;
+
+        //INTEGER
+        if (this->attributeType == INTEGER)
+        {
+            lowValInt = *(int *)lowValParm;
+            highValInt = *(int *)highValParm;
+            if (lowValInt > highValInt)
+            {
+                throw BadScanrangeException();
+            }
+            if (direction == FORWARD)
+            {
+                startScanTyped<int>();
+            }
+            else
+            {
+                startScanBackwardTyped<int>();
+            }
+        }
+        //DOUBLE
+        else if (this->attributeType == DOUBLE)
+        {
+            lowValDouble = *(double *)lowValParm;
+            highValDouble = *(double *)highValParm;
+            if (lowValDouble > highValDouble)
+            {
+                throw BadScanrangeException();
+            }
+            if (direction == FORWARD)
+            {
+                startScanTyped<double>();
+            }
+            else
+            {
+                startScanBackwardTyped<double>();
+            }
+        }
+        //STRING
+        else
+        {
+            StringKey low = keyFromPtr<StringKey>(lowValParm);
+            StringKey high = keyFromPtr<StringKey>(highValParm);
+            lowValString = std::string(low.data, strnlen(low.data, STRINGSIZE));
+            highValString = std::string(high.data, strnlen(high.data, STRINGSIZE));
+            if (low > high)
+            {
+                throw BadScanrangeException();
+            }
+            if (direction == FORWARD)
+            {
+                startScanTyped<StringKey>();
+            }
+            else
+            {
+                startScanBackwardTyped<StringKey>();
+            }
+        }
+    }
+
+    template <> int BTreeIndex::lowKey<int>() const { return lowValInt; }
+    template <> int BTreeIndex::highKey<int>() const { return highValInt; }
+    template <> double BTreeIndex::lowKey<double>() const { return lowValDouble; }
+    template <> double BTreeIndex::highKey<double>() const { return highValDouble; }
+    template <> StringKey BTreeIndex::lowKey<StringKey>() const { return keyFromPtr<StringKey>(lowValString.c_str()); }
+    template <> StringKey BTreeIndex::highKey<StringKey>() const { return keyFromPtr<StringKey>(highValString.c_str()); }
+
+    template <class T>
+    bool BTreeIndex::aboveLow(const T& key) const
+    {
+        return lowOp == GTE ? key >= lowKey<T>() : key > lowKey<T>();
+    }
+
+    template <class T>
+    bool BTreeIndex::belowHigh(const T& key) const
+    {
+        return highOp == LTE ? key <= highKey<T>() : key < highKey<T>();
+    }
+
+    template <class T>
+    void BTreeIndex::startScanTyped()
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        T low = lowKey<T>();
+        currentPageNum = findLeaf<T>(low);
+        readNode(currentPageNum, currentPageData);
+
+        //Find the first entry satisfying the low bound, moving right if this leaf has none
+        while (true)
+        {
+            Leaf * leaf = (Leaf *) currentPageData;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            int i = lowOp == GTE ? leafLowerBound(leaf, 0, count, low) : leafUpperBound(leaf, 0, count, low);
+            if (i < count)
+            {
+                if (!belowHigh<T>(leafKey(leaf, i)))
+                {
+                    break;
+                }
+                nextEntry = i;
+                scanExecuting = true;
+                scanReturnedEntry = false;
+                return;
+            }
+            PageId sibling = leaf->rightSibPageNo;
+            unPinNode(currentPageNum, false);
+            currentPageNum = sibling;
+            currentPageData = NULL;
+            if (sibling == Page::INVALID_NUMBER)
+            {
+                throw NoSuchKeyFoundException();
+            }
+            readNode(currentPageNum, currentPageData);
+        }
+
+        unPinNode(currentPageNum, false);
+        currentPageNum = Page::INVALID_NUMBER;
+        currentPageData = NULL;
+        throw NoSuchKeyFoundException();
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::compositeKey
+    // -----------------------------------------------------------------------------
+
+    std::string BTreeIndex::compositeKey(const void* const* values, const int numValues) const
+    {
+        if (keyColumns.empty() || numValues < 0 || numValues > (int) (keyColumns.size() + includeColumns.size()))
+        {
+            throw BadScanParamException();
+        }
+        std::vector<KeyColumn> columns(keyColumns);
+        columns.insert(columns.end(), includeColumns.begin(), includeColumns.end());
+        std::string key = encodeColumns(columns, values, numValues);
+        if (key.size() > (size_t) COMPOSITEKEYSIZE)
+        {
+            throw BadScanParamException();
+        }
+        return key;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::startCompositeScan
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::startCompositeScan(const void* const* lowValues,
+                                              const int numLow,
+                                              const Operator lowOpParm,
+                                              const void* const* highValues,
+                                              const int numHigh,
+                                              const Operator highOpParm)
+    {
+        if((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+        //The include columns order entries but are not part of the key
+        if (numLow > (int) keyColumns.size() || numHigh > (int) keyColumns.size())
+        {
+            throw BadScanParamException();
+        }
+        std::string low = compositeKey(lowValues, numLow);
+        std::string high = compositeKey(highValues, numHigh);
+
+        //Every key with the low columns is less than them followed by PASTPREFIX, every key with greater ones more
+        if (lowOpParm == GT && numLow > 0)
+        {
+            low += (char) PASTPREFIX;
+        }
+        //An open high side is PASTPREFIX alone, above every key
+        if (highOpParm == LTE || numHigh == 0)
+        {
+            high += (char) PASTPREFIX;
+        }
+        startScan(low.c_str(), GTE, high.c_str(), LT);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::scanNext
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::scanNext(RecordId& outRid)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        //Limit reached
+        if (scanRemaining == 0)
+        {
+            releaseScanPage();
+            throw IndexScanCompletedException();
+        }
+        if (this->attributeType == INTEGER)
+        {
+            scanNextTyped<int>(outRid);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            scanNextTyped<double>(outRid);
+        }
+        else
+        {
+            scanNextTyped<StringKey>(outRid);
+        }
+        if (scanRemaining > 0)
+        {
+            scanRemaining--;
+        }
+    }
+
+    const void BTreeIndex::scanNext(RecordId& outRid, void* outKey)
+    {
+        scanNext(outRid);
+        if (this->attributeType == INTEGER)
+        {
+            copyReturnedKey<int>(outKey);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            copyReturnedKey<double>(outKey);
+        }
+        else
+        {
+            copyReturnedKey<StringKey>(outKey);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::scanNextCovered
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::scanNextCovered(RecordId& outRid, void* outRecord)
+    {
+        if (keyColumns.empty())
+        {
+            throw BadScanParamException();
+        }
+        StringKey key;
+        scanNext(outRid, &key);
+        //The columns follow one another in the key, include columns last
+        const unsigned char * in = (const unsigned char *) key.data;
+        char * record = (char *) outRecord;
+        for (size_t i = 0; i < keyColumns.size(); i++)
+        {
+            in += decodeKeyColumn(in, keyColumns[i].attrType, record + keyColumns[i].attrByteOffset);
+        }
+        for (size_t i = 0; i < includeColumns.size(); i++)
+        {
+            in += decodeKeyColumn(in, includeColumns[i].attrType, record + includeColumns[i].attrByteOffset);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::copyReturnedKey(void* outKey)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        //The leaf of the entry stays pinned until the next call moves on
+        T key = leafKey((Leaf *) currentPageData, returnedEntry());
+        memcpy(outKey, (const void *) &key, sizeof(T));
+    }
+
+    void BTreeIndex::releaseScanPage()
+    {
+        if (currentPageData != NULL)
+        {
+            unPinNode(currentPageNum, false);
+        }
+        currentPageNum = Page::INVALID_NUMBER;
+        currentPageData = NULL;
+    }
+
+    template <class T>
+    void BTreeIndex::scanNextTyped(RecordId& outRid)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        if (scanDirection == BACKWARD)
+        {
+            scanPrevTyped<T>(outRid);
+            return;
+        }
+
+        while (true)
+        {
+            //Scan already ran off the end of the leaf chain
+            if (currentPageData == NULL)
+            {
+                throw IndexScanCompletedException();
+            }
+
+            Leaf * leaf = (Leaf *) currentPageData;
+            //Current leaf is used up, move on to the right sibling
+            while (!leafHasEntry(leaf, nextEntry, NodeTraits<T>::LEAFSIZE))
+            {
+                PageId sibling = leaf->rightSibPageNo;
+                unPinNode(currentPageNum, false);
+                currentPageNum = sibling;
+                currentPageData = NULL;
+                if (sibling == Page::INVALID_NUMBER)
+                {
+                    throw IndexScanCompletedException();
+                }
+                readNode(currentPageNum, currentPageData);
+                leaf = (Leaf *) currentPageData;
+                nextEntry = 0;
+            }
+
+            if (belowHigh<T>(leafKey(leaf, nextEntry)))
+            {
+                //a posting list is left once all of its RecordIds are returned
+                if (takeRid(leafRid(leaf, nextEntry), outRid))
+                {
+                    nextEntry++;
+                }
+                scanReturnedEntry = true;
+                return;
+            }
+            //Past the current range, go on with the next one of a multi-range scan
+            if (!advanceRange<T>())
+            {
+                releaseScanPage();
+                throw IndexScanCompletedException();
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::startScanBackwardTyped
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void BTreeIndex::startScanBackwardTyped()
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        //Descend to the leaf where the entries past the high bound begin
+        T high = highKey<T>();
+        scanPath.clear();
+        currentPageNum = descend<T>(rootPageNum, high, highOp == LTE);
+        readNode(currentPageNum, currentPageData);
+
+        //Find the last entry satisfying the high bound, moving left if this leaf has none
+        while (true)
+        {
+            Leaf * leaf = (Leaf *) currentPageData;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            int i = (highOp == LTE ? leafUpperBound(leaf, 0, count, high) : leafLowerBound(leaf, 0, count, high)) - 1;
+            if (i >= 0)
+            {
+                if (!aboveLow<T>(leafKey(leaf, i)))
+                {
+                    break;
+                }
+                nextEntry = i;
+                scanExecuting = true;
+                scanReturnedEntry = false;
+                return;
+            }
+            PageId sibling = leaf->leftSibPageNo;
+            unPinNode(currentPageNum, false);
+            currentPageNum = sibling;
+            currentPageData = NULL;
+            if (sibling == Page::INVALID_NUMBER)
+            {
+                throw NoSuchKeyFoundException();
+            }
+            readNode(currentPageNum, currentPageData);
+        }
+
+        releaseScanPage();
+        throw NoSuchKeyFoundException();
+    }
+
+    template <class T>
+    void BTreeIndex::scanPrevTyped(RecordId& outRid)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        if (currentPageData == NULL)
+        {
+            throw IndexScanCompletedException();
+        }
+
+        Leaf * leaf = (Leaf *) currentPageData;
+        //Current leaf is used up, move on to the left sibling
+        while (nextEntry < 0)
+        {
+            PageId sibling = leaf->leftSibPageNo;
+            unPinNode(currentPageNum, false);
+            currentPageNum = sibling;
+            currentPageData = NULL;
+            if (sibling == Page::INVALID_NUMBER)
+            {
+                throw IndexScanCompletedException();
+            }
+            readNode(currentPageNum, currentPageData);
+            leaf = (Leaf *) currentPageData;
+            nextEntry = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE) - 1;
+        }
+
+        if (!aboveLow<T>(leafKey(leaf, nextEntry)))
+        {
+            releaseScanPage();
+            throw IndexScanCompletedException();
+        }
+        if (takeRid(leafRid(leaf, nextEntry), outRid))
+        {
+            nextEntry--;
+        }
+        scanReturnedEntry = true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::nextDistinctKey
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::nextDistinctKey(RecordId& outRid, void* outKey)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        if (scanDirection != FORWARD)
+        {
+            throw BadScanParamException();
+        }
+        if (scanRemaining == 0)
+        {
+            releaseScanPage();
+            throw IndexScanCompletedException();
+        }
+        if (this->attributeType == INTEGER)
+        {
+            nextDistinctKeyTyped<int>(outRid, outKey);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            nextDistinctKeyTyped<double>(outRid, outKey);
+        }
+        else
+        {
+            nextDistinctKeyTyped<StringKey>(outRid, outKey);
+        }
+        if (scanRemaining > 0)
+        {
+            scanRemaining--;
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::nextDistinctKeyTyped(RecordId& outRid, void* outKey)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        if (currentPageData == NULL)
+        {
+            throw IndexScanCompletedException();
+        }
+
+        if (scanReturnedEntry)
+        {
+            Leaf * leaf = (Leaf *) currentPageData;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            int returned = returnedEntry();
+            T last = leafKey(leaf, returned);
+            int i = leafUpperBound(leaf, returned + 1, count, last);
+            //the rest of a posting list is skipped along with the other duplicates
+            postingRids.clear();
+            PageId sibling = leaf->rightSibPageNo;
+            if (i < count)
+            {
+                nextEntry = i;
+            }
+            else
+            {
+                //The duplicates reach the end of the leaf. Step to the sibling if they stop there,
+                //otherwise they span several leaves and the separators lead past them.
+                unPinNode(currentPageNum, false);
+                currentPageData = NULL;
+                bool pastLast = false;
+                if (sibling != Page::INVALID_NUMBER)
+                {
+                    currentPageNum = sibling;
+                    readNode(currentPageNum, currentPageData);
+                    Leaf * next = (Leaf *) currentPageData;
+                    pastLast = leafEntryCount(next, NodeTraits<T>::LEAFSIZE) > 0 && last < leafKey(next, 0);
+                    if (!pastLast)
+                    {
+                        unPinNode(currentPageNum, false);
+                        currentPageData = NULL;
+                    }
+                }
+                if (sibling != Page::INVALID_NUMBER && !pastLast)
+                {
+                    currentPageNum = seekLeaf<T>(last, true);
+                    readNode(currentPageNum, currentPageData);
+                }
+                nextEntry = 0;
+
+                //Walk right to the first larger key, in case the leaf reached holds only duplicates
+                while (currentPageData != NULL)
+                {
+                    leaf = (Leaf *) currentPageData;
+                    count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+                    i = leafUpperBound(leaf, 0, count, last);
+                    if (i < count)
+                    {
+                        nextEntry = i;
+                        break;
+                    }
+                    sibling = leaf->rightSibPageNo;
+                    unPinNode(currentPageNum, false);
+                    currentPageData = NULL;
+                    if (sibling != Page::INVALID_NUMBER)
+                    {
+                        currentPageNum = sibling;
+                        readNode(currentPageNum, currentPageData);
+                    }
+                }
+                if (currentPageData == NULL)
+                {
+                    currentPageNum = Page::INVALID_NUMBER;
+                    throw IndexScanCompletedException();
+                }
+            }
+        }
+
+        scanNextTyped<T>(outRid);
+        if (outKey != NULL)
+        {
+            T key = leafKey((Leaf *) currentPageData, returnedEntry());
+            memcpy(outKey, (const void *) &key, sizeof(T));
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::startMultiRangeScan
+    // -----------------------------------------------------------------------------
+
+    //A range of a multi-range scan as the key type stored in the nodes
+    template <class T>
+    struct TypedRange
+    {
+        T low;
+        Operator lowOp;
+        T high;
+        Operator highOp;
+    };
+
+    //Orders ranges by where they start, inclusive before exclusive
+    template <class T>
+    static bool startsBefore(const TypedRange<T>& a, const TypedRange<T>& b)
+    {
+        if (a.low != b.low)
+        {
+            return a.low < b.low;
+        }
+        return a.lowOp == GTE && b.lowOp == GT;
+    }
+
+    template <class T>
+    static std::string keyBytes(const T& key)
+    {
+        return std::string((const char *) &key, sizeof(T));
+    }
+
+    template <class T>
+    static T bytesKey(const std::string& bytes)
+    {
+        T key;
+        memcpy((void *) &key, bytes.data(), sizeof(T));
+        return key;
+    }
+
+    template <> void BTreeIndex::setBounds<int>(const ScanBounds& bounds)
+    {
+        lowValInt = bytesKey<int>(bounds.lowKey);
+        highValInt = bytesKey<int>(bounds.highKey);
+        lowOp = bounds.lowOp;
+        highOp = bounds.highOp;
+    }
+
+    template <> void BTreeIndex::setBounds<double>(const ScanBounds& bounds)
+    {
+        lowValDouble = bytesKey<double>(bounds.lowKey);
+        highValDouble = bytesKey<double>(bounds.highKey);
+        lowOp = bounds.lowOp;
+        highOp = bounds.highOp;
+    }
+
+    template <> void BTreeIndex::setBounds<StringKey>(const ScanBounds& bounds)
+    {
+        lowValString = std::string(bounds.lowKey.data(), strnlen(bounds.lowKey.data(), STRINGSIZE));
+        highValString = std::string(bounds.highKey.data(), strnlen(bounds.highKey.data(), STRINGSIZE));
+        lowOp = bounds.lowOp;
+        highOp = bounds.highOp;
+    }
+
+    const void BTreeIndex::startMultiRangeScan(const ScanRange* ranges, const int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if ((ranges[i].highOp != LT && ranges[i].highOp != LTE) || (ranges[i].lowOp != GT && ranges[i].lowOp != GTE))
+            {
+                throw BadOpcodesException();
+            }
+        }
+
+        if (scanExecuting)
+        {
+            endScan();
+        }
+
+        if (this->attributeType == INTEGER)
+        {
+            startMultiRangeScanTyped<int>(ranges, n);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            startMultiRangeScanTyped<double>(ranges, n);
+        }
+        else
+        {
+            startMultiRangeScanTyped<StringKey>(ranges, n);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::startMultiRangeScanTyped(const ScanRange* ranges, const int n)
+    {
+        std::vector< TypedRange<T> > sorted;
+        for (int i = 0; i < n; i++)
+        {
+            TypedRange<T> range;
+            range.low = keyFromPtr<T>(ranges[i].lowVal);
+            range.lowOp = ranges[i].lowOp;
+            range.high = keyFromPtr<T>(ranges[i].highVal);
+            range.highOp = ranges[i].highOp;
+            if (range.high < range.low)
+            {
+                throw BadScanrangeException();
+            }
+            //(v,GT,v,LT) and the like hold no key at all
+            if (range.low == range.high && (range.lowOp == GT || range.highOp == LT))
+            {
+                continue;
+            }
+            sorted.push_back(range);
+        }
+        std::sort(sorted.begin(), sorted.end(), startsBefore<T>);
+
+        //Merge ranges that overlap or touch so that every entry is returned once
+        scanRanges.clear();
+        nextRange = 0;
+        std::vector< TypedRange<T> > merged;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const TypedRange<T>& range = sorted[i];
+            if (!merged.empty())
+            {
+                TypedRange<T>& last = merged.back();
+                bool touches = range.low < last.high
+                    || (range.low == last.high && (last.highOp == LTE || range.lowOp == GTE));
+                if (touches)
+                {
+                    if (last.high < range.high)
+                    {
+                        last.high = range.high;
+                        last.highOp = range.highOp;
+                    }
+                    else if (last.high == range.high && range.highOp == LTE)
+                    {
+                        last.highOp = LTE;
+                    }
+                    continue;
+                }
+            }
+            merged.push_back(range);
+        }
+        for (size_t i = 0; i < merged.size(); i++)
+        {
+            ScanBounds bounds;
+            bounds.lowKey = keyBytes<T>(merged[i].low);
+            bounds.lowOp = merged[i].lowOp;
+            bounds.highKey = keyBytes<T>(merged[i].high);
+            bounds.highOp = merged[i].highOp;
+            scanRanges.push_back(bounds);
+        }
+
+        currentPageNum = Page::INVALID_NUMBER;
+        currentPageData = NULL;
+        scanPath.clear();
+        scanDirection = FORWARD;
+        scanRemaining = -1;
+        if (!advanceRange<T>())
+        {
+            if (currentPageData != NULL)
+            {
+                unPinNode(currentPageNum, false);
+            }
+            currentPageNum = Page::INVALID_NUMBER;
+            currentPageData = NULL;
+            scanRanges.clear();
+            throw NoSuchKeyFoundException();
+        }
+        scanExecuting = true;
+        scanReturnedEntry = false;
+    }
+
+    template <class T>
+    bool BTreeIndex::advanceRange()
+    {
+        while (nextRange < scanRanges.size())
+        {
+            setBounds<T>(scanRanges[nextRange]);
+            nextRange++;
+            //Ranges already started were all ahead of this one, so an exhausted chain stays exhausted
+            if (nextRange > 1 && currentPageData == NULL)
+            {
+                return false;
+            }
+            if (seekRange<T>())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <class T>
+    bool BTreeIndex::seekRange()
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        T low = lowKey<T>();
+        //Leave the current leaf only if the range starts past its last entry
+        if (currentPageData != NULL)
+        {
+            Leaf * leaf = (Leaf *) currentPageData;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            if (count == 0 || !aboveLow<T>(leafKey(leaf, count - 1)))
+            {
+                unPinNode(currentPageNum, false);
+                currentPageData = NULL;
+            }
+        }
+        if (currentPageData == NULL)
+        {
+            currentPageNum = seekLeaf<T>(low, false);
+            readNode(currentPageNum, currentPageData);
+            nextEntry = 0;
+        }
+
+        //Find the first entry satisfying the low bound, moving right if this leaf has none
+        while (true)
+        {
+            Leaf * leaf = (Leaf *) currentPageData;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            int from = std::min(nextEntry, count);
+            int i = lowOp == GTE ? leafLowerBound(leaf, from, count, low) : leafUpperBound(leaf, from, count, low);
+            if (i < count)
+            {
+                nextEntry = i;
+                return belowHigh<T>(leafKey(leaf, i));
+            }
+            PageId sibling = leaf->rightSibPageNo;
+            unPinNode(currentPageNum, false);
+            currentPageData = NULL;
+            if (sibling == Page::INVALID_NUMBER)
+            {
+                currentPageNum = Page::INVALID_NUMBER;
+                return false;
+            }
+            currentPageNum = sibling;
+            readNode(currentPageNum, currentPageData);
+            nextEntry = 0;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::endScan
+    // -----------------------------------------------------------------------------
+    //
+    const void BTreeIndex::endScan()
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        scanExecuting = false;
+        if (currentPageData != NULL)
+        {
+            unPinNode(currentPageNum, false);
+        }
+        currentPageNum = Page::INVALID_NUMBER;
+        currentPageData = NULL;
+        scanRanges.clear();
+        nextRange = 0;
+        scanPath.clear();
+        postingRids.clear();
+
+        //Nothing reads the tree compact() replaced any more
+        for (size_t i = 0; i < retiredPages.size(); i++)
+        {
+            freeNode(retiredPages[i]);
+        }
+        retiredPages.clear();
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::freeze
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::freeze(std::string & outFrozenName)
+    {
+        outFrozenName = file->filename() + ".frozen";
+        if (this->attributeType == INTEGER)
+        {
+            freezeTyped<int>(outFrozenName);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            freezeTyped<double>(outFrozenName);
+        }
+        else
+        {
+            freezeTyped<StringKey>(outFrozenName);
+        }
+    }
+
+    template <class T>
+    PageId BTreeIndex::firstLeaf()
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        PageId pageNo = rootPageNum;
+        while (true)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            PageId childPageNo = childPage(node, 0);
+            bool childIsLeaf = node->level == 1;
+            unPinNode(pageNo, false);
+            pageNo = childPageNo;
+            if (childIsLeaf)
+            {
+                return pageNo;
+            }
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::freezeTyped(const std::string& frozenName)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        std::vector<T> keys;
+        std::vector<RecordId> rids;
+        PageId pageNo = firstLeaf<T>();
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            Leaf * leaf = (Leaf *) page;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            for (int i = 0; i < count; i++)
+            {
+                //the frozen file keeps one entry per RecordId
+                std::vector<RecordId> entryRids(1, leafRid(leaf, i));
+                if (isPostingRid(entryRids[0]))
+                {
+                    readPostingRids(entryRids[0].page_number, entryRids);
+                }
+                keys.insert(keys.end(), entryRids.size(), leafKey(leaf, i));
+                rids.insert(rids.end(), entryRids.begin(), entryRids.end());
+            }
+            PageId next = leaf->rightSibPageNo;
+            unPinNode(pageNo, false);
+            pageNo = next;
+        }
+
+        Page * metaPage;
+        readNode(headerPageNum, metaPage);
+        std::string relationName(((IndexMetaInfo *) metaPage)->relationName);
+        unPinNode(headerPageNum, false);
+
+        FrozenIndex::write<T>(frozenName, relationName, attrByteOffset, keys, rids);
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::compact
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::compact()
+    {
+        if (this->attributeType == INTEGER)
+        {
+            compactTyped<int>();
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            compactTyped<double>();
+        }
+        else
+        {
+            compactTyped<StringKey>();
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::collectPages(const PageId pageNo, std::vector<PageId>& pages)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        Page * page;
+        readNode(pageNo, page);
+        NonLeaf * node = (NonLeaf *) page;
+        int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+        std::vector<PageId> children;
+        appendChildren(node, 0, count + 1, children);
+        bool childIsLeaf = node->level == 1;
+        unPinNode(pageNo, false);
+
+        pages.push_back(pageNo);
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (childIsLeaf)
+            {
+                pages.push_back(children[i]);
+            }
+            else
+            {
+                collectPages<T>(children[i], pages);
+            }
+        }
+    }
+
+    //True if children with the given keys, spread evenly over numNodes non-leaf nodes, fit in them
+    template <class T>
+    static bool spreadFits(const std::vector<T>& keys, const size_t numNodes, const int capacity)
+    {
+        size_t next = 0;
+        for (size_t j = 0; j < numNodes; j++)
+        {
+            size_t take = keys.size() / numNodes + (j < keys.size() % numNodes ? 1 : 0);
+            //the first child of a node needs no separator
+            if (!nonLeafFits(keys.data() + next + 1, take - 1, capacity))
+            {
+                return false;
+            }
+            next += take;
+        }
+        return true;
+    }
+
+    template <class T>
+    void BTreeIndex::compactTyped()
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+        const int leafSize = NodeTraits<T>::LEAFSIZE;
+        const int nonLeafSize = NodeTraits<T>::NONLEAFSIZE;
+
+        std::vector<PageId> oldPages;
+        collectPages<T>(rootPageNum, oldPages);
+
+        //LEAVES, copy the old leaf chain into full leaves on consecutive pages
+        std::vector< PageKeyPair<T> > level;
+        std::vector<std::uint32_t> counts;
+        PageId newPageNo;
+        Page * newPage;
+        appendNode(newPageNo, newPage);
+        Leaf * newLeaf = (Leaf *) newPage;
+        int newCount = 0;
+        std::uint32_t newWeight = 0;
+        //Key the parent tells the current leaf apart from the one before it by
+        T separator = T();
+
+        PageId pageNo = firstLeaf<T>();
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            Leaf * leaf = (Leaf *) page;
+            int count = leafEntryCount(leaf, leafSize);
+            for (int i = 0; i < count; i++)
+            {
+                T key = leafKey(leaf, i);
+                //only start another leaf once there is an entry that does not fit
+                if (!leafInsert(newLeaf, newCount, leafSize, newCount, key, leafRid(leaf, i)))
+                {
+                    PageKeyPair<T> done;
+                    done.set(newPageNo, level.empty() ? leafKey(newLeaf, 0) : separator);
+                    level.push_back(done);
+                    counts.push_back(newWeight);
+                    separator = separatorKey(leafKey(newLeaf, newCount - 1), key);
+                    PageId nextPageNo;
+                    Page * nextPage;
+                    appendNode(nextPageNo, nextPage);
+                    newLeaf->rightSibPageNo = nextPageNo;
+                    ((Leaf *) nextPage)->leftSibPageNo = newPageNo;
+                    unPinNode(newPageNo, true);
+                    newPageNo = nextPageNo;
+                    newLeaf = (Leaf *) nextPage;
+                    newCount = 0;
+                    newWeight = 0;
+                    leafInsert(newLeaf, newCount, leafSize, newCount, key, leafRid(leaf, i));
+                }
+                newCount++;
+                //posting lists are taken over as they are, only their entry moves
+                newWeight += ridWeight(leafRid(leaf, i));
+            }
+            PageId next = leaf->rightSibPageNo;
+            unPinNode(pageNo, false);
+            pageNo = next;
+        }
+        PageKeyPair<T> last;
+        last.set(newPageNo, level.empty() ? leafKey(newLeaf, 0) : separator);
+        level.push_back(last);
+        counts.push_back(newWeight);
+        unPinNode(newPageNo, true);
+
+        //NON LEAVES, one level at a time with the children spread evenly over the nodes
+        int nodeLevel = 1;
+        int height = 1;
+        do
+        {
+            std::vector< PageKeyPair<T> > parents;
+            std::vector<std::uint32_t> parentCounts;
+            std::vector<T> keys;
+            std::vector<PageId> pages;
+            for (size_t i = 0; i < level.size(); i++)
+            {
+                keys.push_back(level[i].key);
+                pages.push_back(level[i].pageNo);
+            }
+            //as few nodes as the slots allow, more while the STRING separators of one do not fit in its page
+            size_t numNodes = (level.size() + nonLeafSize) / (nonLeafSize + 1);
+            while (!spreadFits(keys, numNodes, nonLeafSize))
+            {
+                numNodes++;
+            }
+            size_t next = 0;
+            for (size_t j = 0; j < numNodes; j++)
+            {
+                size_t take = level.size() / numNodes + (j < level.size() % numNodes ? 1 : 0);
+                appendNode(newPageNo, newPage);
+                NonLeaf * node = (NonLeaf *) newPage;
+                node->level = nodeLevel;
+                nonLeafFill(node, keys.data() + next + 1, pages.data() + next, counts.data() + next, take - 1, nonLeafSize);
+                PageKeyPair<T> parent;
+                parent.set(newPageNo, level[next].key);
+                parents.push_back(parent);
+                parentCounts.push_back(std::accumulate(counts.begin() + next, counts.begin() + next + take, 0u));
+                unPinNode(newPageNo, true);
+                next += take;
+            }
+            level.swap(parents);
+            counts.swap(parentCounts);
+            nodeLevel = 0;
+            height++;
+        }
+        while (level.size() > 1);
+
+        //Switch over to the new tree
+        setRootPageNo(level[0].pageNo);
+        Page * metaPage;
+        readNode(headerPageNum, metaPage);
+        ((IndexMetaInfo *) metaPage)->height = height;
+        unPinNode(headerPageNum, true);
+        rebuildHistogram<T>();
+
+        //Free the old pages highest first so that later splits take them lowest first
+        std::sort(oldPages.begin(), oldPages.end());
+        if (scanExecuting)
+        {
+            retiredPages.insert(retiredPages.end(), oldPages.rbegin(), oldPages.rend());
+            return;
+        }
+        for (size_t i = oldPages.size(); i > 0; i--)
+        {
+            freeNode(oldPages[i - 1]);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexStats::toJson
+    // -----------------------------------------------------------------------------
+
+    static std::string jsonString(const std::string& str)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (size_t i = 0; i < str.size(); i++)
+        {
+            unsigned char c = str[i];
+            if (c == '"' || c == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (c < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out << escaped;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << '"';
+        return out.str();
+    }
+
+    std::string IndexStats::toJson() const
+    {
+        std::ostringstream out;
+        out << "{\"height\":" << height
+            << ",\"numEntries\":" << numEntries
+            << ",\"numLeafPages\":" << numLeafPages
+            << ",\"numNonLeafPages\":" << numNonLeafPages
+            << ",\"numFreePages\":" << numFreePages
+            << ",\"numPostingPages\":" << numPostingPages
+            << ",\"numPostingLists\":" << numPostingLists
+            << ",\"numSplits\":" << numSplits
+            << ",\"leafChainBreaks\":" << leafChainBreaks
+            << ",\"leafChainBackward\":" << leafChainBackward
+            << ",\"minKey\":" << jsonString(minKey)
+            << ",\"maxKey\":" << jsonString(maxKey)
+            << ",\"levels\":[";
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            const IndexLevelStats& level = levels[i];
+            out << (i == 0 ? "" : ",")
+                << "{\"level\":" << i
+                << ",\"numNodes\":" << level.numNodes
+                << ",\"numEntries\":" << level.numEntries
+                << ",\"minEntries\":" << level.minEntries
+                << ",\"maxEntries\":" << level.maxEntries
+                << ",\"fill\":" << level.fill
+                << ",\"fillHistogram\":[";
+            for (int j = 0; j < 10; j++)
+            {
+                out << (j == 0 ? "" : ",") << level.fillHistogram[j];
+            }
+            out << "]}";
+        }
+        out << "]}";
+        return out.str();
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::collectStats
+    // -----------------------------------------------------------------------------
+
+    static std::string keyString(const int key)
+    {
+        std::ostringstream out;
+        out << key;
+        return out.str();
+    }
+
+    static std::string keyString(const double key)
+    {
+        std::ostringstream out;
+        out.precision(17);
+        out << key;
+        return out.str();
+    }
+
+    static std::string keyString(const StringKey& key)
+    {
+        return std::string(key.data, strnlen(key.data, STRINGSIZE));
+    }
+
+    static void addNode(IndexLevelStats& level, const int entries, const int capacity)
+    {
+        if (level.numNodes == 0 || entries < level.minEntries)
+        {
+            level.minEntries = entries;
+        }
+        if (level.numNodes == 0 || entries > level.maxEntries)
+        {
+            level.maxEntries = entries;
+        }
+        level.numNodes++;
+        level.numEntries += entries;
+        level.fillHistogram[std::min(9, entries * 10 / capacity)]++;
+        level.fill = (double) level.numEntries / ((double) level.numNodes * capacity);
+    }
+
+    const void BTreeIndex::collectStats(IndexStats & outStats)
+    {
+        if (this->attributeType == INTEGER)
+        {
+            collectStatsTyped<int>(outStats);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            collectStatsTyped<double>(outStats);
+        }
+        else
+        {
+            collectStatsTyped<StringKey>(outStats);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::collectStatsTyped(IndexStats& stats)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        IndexLevelStats empty;
+        memset(&empty, 0, sizeof(empty));
+        stats.numEntries = 0;
+        stats.numLeafPages = 0;
+        stats.numNonLeafPages = 0;
+        stats.numFreePages = 0;
+        stats.numPostingPages = 0;
+        stats.numPostingLists = 0;
+        stats.numSplits = numSplits;
+        stats.leafChainBreaks = 0;
+        stats.leafChainBackward = 0;
+        stats.minKey.clear();
+        stats.maxKey.clear();
+        stats.levels.clear();
+
+        //NON LEAVES, one level at a time from the root down
+        std::vector<IndexLevelStats> nonLeafLevels;
+        std::vector<PageId> levelPages(1, rootPageNum);
+        while (true)
+        {
+            IndexLevelStats level = empty;
+            std::vector<PageId> children;
+            bool childIsLeaf = false;
+            for (size_t i = 0; i < levelPages.size(); i++)
+            {
+                Page * page;
+                readNode(levelPages[i], page);
+                NonLeaf * node = (NonLeaf *) page;
+                int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE) + 1;
+                addNode(level, count, NodeTraits<T>::NONLEAFSIZE + 1);
+                appendChildren(node, 0, count, children);
+                childIsLeaf = node->level == 1;
+                unPinNode(levelPages[i], false);
+            }
+            stats.numNonLeafPages += level.numNodes;
+            nonLeafLevels.push_back(level);
+            levelPages.swap(children);
+            if (childIsLeaf)
+            {
+                break;
+            }
+        }
+
+        //LEAVES, in key order
+        IndexLevelStats leafLevel = empty;
+        for (size_t i = 0; i < levelPages.size(); i++)
+        {
+            Page * page;
+            readNode(levelPages[i], page);
+            Leaf * leaf = (Leaf *) page;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            addNode(leafLevel, count, NodeTraits<T>::LEAFSIZE);
+            for (int j = 0; j < count; j++)
+            {
+                RecordId rid = leafRid(leaf, j);
+                if (!isPostingRid(rid))
+                {
+                    stats.numEntries++;
+                    continue;
+                }
+                stats.numPostingLists++;
+                PageId postingPageNo = rid.page_number;
+                while (postingPageNo != Page::INVALID_NUMBER)
+                {
+                    Page * postingPage;
+                    readNode(postingPageNo, postingPage);
+                    PostingPage * posting = (PostingPage *) postingPage;
+                    if (postingPageNo == rid.page_number)
+                    {
+                        stats.numEntries += posting->totalRids;
+                    }
+                    PageId next = posting->nextPageNo;
+                    unPinNode(postingPageNo, false);
+                    stats.numPostingPages++;
+                    postingPageNo = next;
+                }
+            }
+            if (count > 0)
+            {
+                if (leafLevel.numEntries == (std::uint64_t) count)
+                {
+                    stats.minKey = keyString(leafKey(leaf, 0));
+                }
+                stats.maxKey = keyString(leafKey(leaf, count - 1));
+            }
+            PageId sibling = leaf->rightSibPageNo;
+            if (sibling != Page::INVALID_NUMBER && sibling != levelPages[i] + 1)
+            {
+                stats.leafChainBreaks++;
+                if (sibling < levelPages[i])
+                {
+                    stats.leafChainBackward++;
+                }
+            }
+            unPinNode(levelPages[i], false);
+        }
+        stats.numLeafPages = leafLevel.numNodes;
+        stats.levels.push_back(leafLevel);
+        stats.levels.insert(stats.levels.end(), nonLeafLevels.rbegin(), nonLeafLevels.rend());
+        stats.height = stats.levels.size();
+
+        //FREE LIST
+        PageId pageNo = freePageNum;
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            PageId next = *(PageId *) page;
+            unPinNode(pageNo, false);
+            stats.numFreePages++;
+            pageNo = next;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::verify
+    // -----------------------------------------------------------------------------
+
+    static void structureError(const char* kind, const PageId pageNo, const std::string& problem)
+    {
+        std::ostringstream out;
+        out << kind << " page " << pageNo << ": " << problem;
+        throw BadIndexStructureException(out.str());
+    }
+
+    const void BTreeIndex::verify()
+    {
+        if (this->attributeType == INTEGER)
+        {
+            verifyTyped<int>();
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            verifyTyped<double>();
+        }
+        else
+        {
+            verifyTyped<StringKey>();
+        }
+    }
+
+    //Checks the slots of a leaf, returns the first problem found or an empty string
+    template <class Leaf>
+    static std::string leafSlotProblem(const Leaf* leaf, const int capacity)
+    {
+        bool ended = false;
+        for (int i = 0; i < capacity; i++)
+        {
+            bool used = leaf->ridArray[i].page_number != Page::INVALID_NUMBER;
+            if (ended && used)
+            {
+                return "entry " + keyString(i) + " follows an empty slot";
+            }
+            ended = !used;
+        }
+        return "";
+    }
+
+    static std::string leafSlotProblem(const LeafNodeInt* leaf, const int capacity)
+    {
+        if (leaf->keyWidth != 0 && leaf->keyWidth != 1 && leaf->keyWidth != 2 && leaf->keyWidth != 4)
+        {
+            return "key width " + keyString(leaf->keyWidth) + " is not 0, 1, 2 or 4";
+        }
+        if (offsetof(LeafNodeInt, ridArray) + leaf->numEntries * (sizeof(RecordId) + leaf->keyWidth) > Page::SIZE)
+        {
+            return "record ids run into the key bytes";
+        }
+        for (int i = 0; i < leaf->numEntries; i++)
+        {
+            if (leaf->ridArray[i].page_number == Page::INVALID_NUMBER)
+            {
+                return "entry " + keyString(i) + " has no record";
+            }
+        }
+        return "";
+    }
 
+    static std::string leafSlotProblem(const LeafNodeString* leaf, const int capacity)
+    {
+        if (offsetof(LeafNodeString, slotArray) + leaf->numEntries * sizeof(StringSlot) + leaf->keyBytes > Page::SIZE)
+        {
+            return "slots run into the key bytes";
+        }
+        if (leaf->prefixLength > 0
+            && (leaf->prefixOffset + leaf->prefixLength > Page::SIZE || leaf->prefixOffset < Page::SIZE - leaf->keyBytes))
+        {
+            return "prefix is outside the key bytes";
+        }
+        for (int i = 0; i < leaf->numEntries; i++)
+        {
+            const StringSlot& slot = leaf->slotArray[i];
+            if (slot.rid.page_number == Page::INVALID_NUMBER)
+            {
+                return "entry " + keyString(i) + " has no record";
+            }
+            if (leaf->prefixLength + slot.keyLength > STRINGSIZE || slot.keyOffset < Page::SIZE - leaf->keyBytes
+                || slot.keyOffset + slot.keyLength > Page::SIZE)
+            {
+                return "key " + keyString(i) + " is outside the key bytes";
+            }
+        }
+        return "";
+    }
 
+    //Checks the slots of a non-leaf, returns the first problem found or an empty string
+    template <class NonLeaf>
+    static std::string nonLeafSlotProblem(const NonLeaf* node, const int count, const int capacity)
+    {
+        for (int i = count + 1; i <= capacity; i++)
+        {
+            if (node->pageNoArray[i] != Page::INVALID_NUMBER)
+            {
+                return "has a child after an empty slot";
+            }
+        }
+        return "";
+    }
 
-//#define DEBUG
+    static std::string nonLeafSlotProblem(const NonLeafNodeInt* node, const int count, const int capacity)
+    {
+        if (node->keyWidth != 0 && node->keyWidth != 1 && node->keyWidth != 2 && node->keyWidth != 4)
+        {
+            return "key width " + keyString(node->keyWidth) + " is not 0, 1, 2 or 4";
+        }
+        if (offsetof(NonLeafNodeInt, childArray) + (count + 1) * sizeof(NonLeafChild) + std::max(count, 0) * node->keyWidth > Page::SIZE)
+        {
+            return "children run into the key bytes";
+        }
+        return "";
+    }
 
-namespace badgerdb
-{
-    int compareInt (const void * a, const void * b)
+    static std::string nonLeafSlotProblem(const NonLeafNodeString* node, const int count, const int capacity)
+    {
+        if (offsetof(NonLeafNodeString, slotArray) + std::max(count, 0) * sizeof(NonLeafSlot) + node->keyBytes > Page::SIZE)
+        {
+            return "slots run into the key bytes";
+        }
+        for (int i = 0; i < count; i++)
+        {
+            const NonLeafSlot& slot = node->slotArray[i];
+            if (slot.keyLength > STRINGSIZE || slot.keyOffset < Page::SIZE - node->keyBytes
+                || slot.keyOffset + slot.keyLength > Page::SIZE)
+            {
+                return "key " + keyString(i) + " is outside the key bytes";
+            }
+        }
+        return "";
+    }
+
+    template <class T>
+    std::uint64_t BTreeIndex::verifyNode(const PageId pageNo, const bool isLeaf, const int depth, const T* low, const T* high,
+                                int& leafDepth, std::vector<PageId>& leaves)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        Page * page;
+        readNode(pageNo, page);
+
+        //LEAF
+        if (isLeaf)
+        {
+            Leaf * leaf = (Leaf *) page;
+            std::vector<T> entries;
+            std::uint64_t weight = 0;
+            std::string problem = leafSlotProblem(leaf, NodeTraits<T>::LEAFSIZE);
+            if (problem.empty())
+            {
+                int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+                for (int i = 0; i < count; i++)
+                {
+                    entries.push_back(leafKey(leaf, i));
+                }
+                weight = leafWeight(leaf, 0, count);
+            }
+            unPinNode(pageNo, false);
+            if (!problem.empty())
+            {
+                structureError("leaf", pageNo, problem);
+            }
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                if (i > 0 && entries[i] < entries[i - 1])
+                {
+                    structureError("leaf", pageNo, "key " + keyString((int) i) + " is smaller than the key before it");
+                }
+                if ((low != NULL && entries[i] < *low) || (high != NULL && entries[i] > *high))
+                {
+                    structureError("leaf", pageNo, "key " + keyString(entries[i]) + " is outside the range of its parent separators");
+                }
+            }
+            if (leafDepth == -1)
+            {
+                leafDepth = depth;
+            }
+            else if (leafDepth != depth)
+            {
+                structureError("leaf", pageNo, "is at depth " + keyString(depth) + ", other leaves at " + keyString(leafDepth));
+            }
+            leaves.push_back(pageNo);
+            return weight;
+        }
+
+        //NON LEAF
+        NonLeaf * node = (NonLeaf *) page;
+        int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+        std::string problem = nonLeafSlotProblem(node, count, NodeTraits<T>::NONLEAFSIZE);
+        std::vector<T> keys;
+        std::vector<PageId> children;
+        std::vector<std::uint32_t> counts;
+        if (problem.empty())
+        {
+            for (int i = 0; i <= count; i++)
+            {
+                children.push_back(childPage(node, i));
+                counts.push_back(childCount(node, i));
+                if (i < count)
+                {
+                    keys.push_back(nonLeafKey(node, i));
+                }
+            }
+        }
+        bool childIsLeaf = node->level == 1;
+        int level = node->level;
+        unPinNode(pageNo, false);
+
+        if (count < 0)
+        {
+            structureError("non-leaf", pageNo, "has no children");
+        }
+        if (!problem.empty())
+        {
+            structureError("non-leaf", pageNo, problem);
+        }
+        if (level != 0 && level != 1)
+        {
+            structureError("non-leaf", pageNo, "has level " + keyString(level));
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if (i > 0 && keys[i] < keys[i - 1])
+            {
+                structureError("non-leaf", pageNo, "key " + keyString(i) + " is smaller than the key before it");
+            }
+            if ((low != NULL && keys[i] < *low) || (high != NULL && keys[i] > *high))
+            {
+                structureError("non-leaf", pageNo, "key " + keyString(keys[i]) + " is outside the range of its parent separators");
+            }
+        }
+
+        std::uint64_t total = 0;
+        for (int i = 0; i <= count; i++)
+        {
+            const T * childLow = i == 0 ? low : &keys[i - 1];
+            const T * childHigh = i == count ? high : &keys[i];
+            std::uint64_t childTotal = verifyNode<T>(children[i], childIsLeaf, depth + 1, childLow, childHigh, leafDepth, leaves);
+            if (countsKept && counts[i] != childTotal)
+            {
+                structureError("non-leaf", pageNo, "count " + keyString(i) + " is " + keyString((int) counts[i])
+                               + ", its subtree holds " + keyString((int) childTotal));
+            }
+            total += childTotal;
+        }
+        return total;
+    }
+
+    std::uint64_t BTreeIndex::verifyPosting(const PageId headPageNo, std::vector<PageId>& pages)
+    {
+        std::vector<RecordId> rids;
+        std::uint32_t totalRids = 0;
+        PageId tailPageNo = Page::INVALID_NUMBER;
+        PageId pageNo = headPageNo;
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            PostingPage * posting = (PostingPage *) page;
+            if (pageNo == headPageNo)
+            {
+                totalRids = posting->totalRids;
+                tailPageNo = posting->tailPageNo;
+            }
+            size_t before = rids.size();
+            bool fits = posting->numBytes <= POSTINGDATASIZE;
+            if (fits)
+            {
+                postingDecode(posting, rids);
+            }
+            int numRids = posting->numRids;
+            RecordId lastRid = posting->lastRid;
+            PageId next = posting->nextPageNo;
+            unPinNode(pageNo, false);
+            pages.push_back(pageNo);
+
+            if (!fits || numRids == 0)
+            {
+                structureError("posting", pageNo, fits ? "holds no RecordIds" : "has more bytes than fit in the page");
+            }
+            if (rids.size() - before != (size_t) numRids || rids.back() != lastRid)
+            {
+                structureError("posting", pageNo, "does not decode to its count and last RecordId");
+            }
+            for (size_t i = std::max(before, (size_t) 1); i < rids.size(); i++)
+            {
+                if (ridBefore(rids[i], rids[i - 1]))
+                {
+                    structureError("posting", pageNo, "RecordId " + keyString((int) (i - before)) + " comes before the one before it");
+                }
+            }
+            if (next == Page::INVALID_NUMBER && pageNo != tailPageNo)
+            {
+                structureError("posting", headPageNo, "last page is " + keyString((int) pageNo) + ", the list says " + keyString((int) tailPageNo));
+            }
+            pageNo = next;
+        }
+        if (rids.size() != totalRids)
+        {
+            structureError("posting", headPageNo, "holds " + keyString((int) rids.size()) + " RecordIds, the list says " + keyString((int) totalRids));
+        }
+        return rids.size();
+    }
+
+    template <class T>
+    void BTreeIndex::verifyTyped()
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        int leafDepth = -1;
+        std::vector<PageId> leaves;
+        std::vector<PageId> postingPages;
+        verifyNode<T>(rootPageNum, false, 0, (const T *) NULL, (const T *) NULL, leafDepth, leaves);
+
+        //The leaf chain must visit exactly the leaves of the tree, in key order
+        for (size_t i = 0; i < leaves.size(); i++)
+        {
+            Page * page;
+            readNode(leaves[i], page);
+            Leaf * leaf = (Leaf *) page;
+            PageId sibling = leaf->rightSibPageNo;
+            PageId leftSibling = leaf->leftSibPageNo;
+            bool empty = !leafHasEntry(leaf, 0, NodeTraits<T>::LEAFSIZE);
+            std::vector<PageId> postingHeads;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            for (int j = 0; j < count; j++)
+            {
+                if (isPostingRid(leafRid(leaf, j)))
+                {
+                    postingHeads.push_back(leafRid(leaf, j).page_number);
+                }
+            }
+            unPinNode(leaves[i], false);
+            for (size_t j = 0; j < postingHeads.size(); j++)
+            {
+                verifyPosting(postingHeads[j], postingPages);
+            }
+            PageId expected = i + 1 < leaves.size() ? leaves[i + 1] : Page::INVALID_NUMBER;
+            if (sibling != expected)
+            {
+                structureError("leaf", leaves[i], "right sibling is page " + keyString((int) sibling) + ", expected " + keyString((int) expected));
+            }
+            expected = i > 0 ? leaves[i - 1] : Page::INVALID_NUMBER;
+            if (leftSibling != expected)
+            {
+                structureError("leaf", leaves[i], "left sibling is page " + keyString((int) leftSibling) + ", expected " + keyString((int) expected));
+            }
+            if (empty && leaves.size() > 1)
+            {
+                structureError("leaf", leaves[i], "is empty but not the only leaf");
+            }
+        }
+
+        //No page may be used twice, or be both in the tree and on the free list
+        std::vector<PageId> pages;
+        collectPages<T>(rootPageNum, pages);
+        pages.insert(pages.end(), postingPages.begin(), postingPages.end());
+        std::sort(pages.begin(), pages.end());
+        for (size_t i = 1; i < pages.size(); i++)
+        {
+            if (pages[i] == pages[i - 1])
+            {
+                structureError("tree", pages[i], "is referenced twice");
+            }
+        }
+        std::set<PageId> freePages;
+        PageId pageNo = freePageNum;
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            if (std::binary_search(pages.begin(), pages.end(), pageNo))
+            {
+                structureError("free", pageNo, "is also part of the tree");
+            }
+            if (!freePages.insert(pageNo).second)
+            {
+                structureError("free", pageNo, "appears twice on the free list");
+            }
+            Page * page;
+            readNode(pageNo, page);
+            PageId next = *(PageId *) page;
+            unPinNode(pageNo, false);
+            pageNo = next;
+        }
+    }
+
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::enableCounts
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::enableCounts()
+    {
+        if (countsKept)
+        {
+            return;
+        }
+        if (this->attributeType == INTEGER)
+        {
+            computeCounts<int>(rootPageNum, false);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            computeCounts<double>(rootPageNum, false);
+        }
+        else
+        {
+            computeCounts<StringKey>(rootPageNum, false);
+        }
+        Page * page;
+        readNode(headerPageNum, page);
+        ((IndexMetaInfo *) page)->countsKept = 1;
+        unPinNode(headerPageNum, true);
+        countsKept = true;
+    }
+
+    template <class T>
+    std::uint64_t BTreeIndex::computeCounts(const PageId pageNo, const bool isLeaf)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        Page * page;
+        readNode(pageNo, page);
+        if (isLeaf)
+        {
+            Leaf * leaf = (Leaf *) page;
+            std::uint64_t weight = leafWeight(leaf, 0, leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE));
+            unPinNode(pageNo, false);
+            return weight;
+        }
+
+        NonLeaf * node = (NonLeaf *) page;
+        int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+        std::vector<PageId> children;
+        appendChildren(node, 0, count + 1, children);
+        bool childIsLeaf = node->level == 1;
+        unPinNode(pageNo, false);
+
+        std::vector<std::uint32_t> counts;
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            counts.push_back(computeCounts<T>(children[i], childIsLeaf));
+            total += counts.back();
+        }
+
+        readNode(pageNo, page);
+        node = (NonLeaf *) page;
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            childCount(node, i) = counts[i];
+        }
+        unPinNode(pageNo, true);
+        return total;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::countRange
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    std::uint64_t BTreeIndex::rankOf(const T& key, const bool inclusive)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        //Every child left of the one descended into lies entirely below key (or at key, with inclusive set)
+        std::uint64_t rank = 0;
+        PageId pageNo = rootPageNum;
+        bool isLeaf = false;
+        while (!isLeaf)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+            int childIndex = inclusive ? nonLeafUpperBound(node, count, key) : nonLeafLowerBound(node, count, key);
+            for (int i = 0; i < childIndex; i++)
+            {
+                rank += childCount(node, i);
+            }
+            PageId childPageNo = childPage(node, childIndex);
+            isLeaf = node->level == 1;
+            unPinNode(pageNo, false);
+            pageNo = childPageNo;
+        }
+
+        Page * page;
+        readNode(pageNo, page);
+        Leaf * leaf = (Leaf *) page;
+        int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+        int pos = inclusive ? leafUpperBound(leaf, 0, count, key) : leafLowerBound(leaf, 0, count, key);
+        rank += leafWeight(leaf, 0, pos);
+        unPinNode(pageNo, false);
+        return rank;
+    }
+
+    std::uint64_t BTreeIndex::countRange(const void* lowValParm,
+                                         const Operator lowOpParm,
+                                         const void* highValParm,
+                                         const Operator highOpParm)
+    {
+        if ((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+        if (!countsKept)
+        {
+            throw BadIndexInfoException("subtree counts are not kept, call enableCounts() first");
+        }
+        if (this->attributeType == INTEGER)
+        {
+            return countRangeTyped<int>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            return countRangeTyped<double>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+        else
+        {
+            return countRangeTyped<StringKey>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+    }
+
+    template <class T>
+    std::uint64_t BTreeIndex::countRangeTyped(const void* lowValParm, const Operator lowOpParm,
+                                              const void* highValParm, const Operator highOpParm)
+    {
+        T low = keyFromPtr<T>(lowValParm);
+        T high = keyFromPtr<T>(highValParm);
+        if (high < low)
+        {
+            throw BadScanrangeException();
+        }
+        std::uint64_t first = rankOf<T>(low, lowOpParm == GT);
+        std::uint64_t last = rankOf<T>(high, highOpParm == LTE);
+        return last > first ? last - first : 0;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::seekToRank
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::seekToRank(const std::uint64_t k)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        if (!scanRanges.empty())
+        {
+            throw BadScanParamException();
+        }
+        if (!countsKept)
+        {
+            throw BadIndexInfoException("subtree counts are not kept, call enableCounts() first");
+        }
+        if (this->attributeType == INTEGER)
+        {
+            seekToRankTyped<int>(k);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            seekToRankTyped<double>(k);
+        }
+        else
+        {
+            seekToRankTyped<StringKey>(k);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::seekToRankTyped(const std::uint64_t k)
+    {
+        //The bounds of the scan still apply, scanNext() stops at them as usual
+        if (scanDirection == FORWARD)
+        {
+            seekRankTyped<T>(rankOf<T>(lowKey<T>(), lowOp == GT) + k);
+            return;
+        }
+        std::uint64_t end = rankOf<T>(highKey<T>(), highOp == LTE);
+        if (k >= end)
+        {
+            releaseScanPage();
+            return;
+        }
+        seekRankTyped<T>(end - 1 - k);
+    }
+
+    template <class T>
+    void BTreeIndex::seekRankTyped(const std::uint64_t rank)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        releaseScanPage();
+        postingRids.clear();
+        std::uint64_t remaining = rank;
+        PageId pageNo = rootPageNum;
+        bool isLeaf = false;
+        while (!isLeaf)
+        {
+            Page * page;
+            readNode(pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+            int childIndex = 0;
+            while (childIndex <= count && remaining >= childCount(node, childIndex))
+            {
+                remaining -= childCount(node, childIndex);
+                childIndex++;
+            }
+            PageId childPageNo = childIndex <= count ? childPage(node, childIndex) : Page::INVALID_NUMBER;
+            isLeaf = node->level == 1;
+            unPinNode(pageNo, false);
+            //Past the last entry
+            if (childPageNo == Page::INVALID_NUMBER)
+            {
+                return;
+            }
+            pageNo = childPageNo;
+        }
+
+        currentPageNum = pageNo;
+        readNode(currentPageNum, currentPageData);
+        Leaf * leaf = (Leaf *) currentPageData;
+        int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+        nextEntry = 0;
+        while (nextEntry < count && remaining >= ridWeight(leafRid(leaf, nextEntry)))
+        {
+            remaining -= ridWeight(leafRid(leaf, nextEntry));
+            nextEntry++;
+        }
+        //The rank falls inside a posting list, or a BACKWARD scan starts from its last RecordId
+        if (nextEntry < count && isPostingRid(leafRid(leaf, nextEntry)) && (remaining > 0 || scanDirection == BACKWARD))
+        {
+            readPostingRids(leafRid(leaf, nextEntry).page_number, postingRids);
+            postingNext = scanDirection == FORWARD ? remaining : remaining + 1;
+        }
+    }
+
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::histogramInsert
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    static T histogramKey(const IndexMetaInfo* meta, const int i)
     {
-        return ( *(int*)a - *(int*)b );
+        T key;
+        memcpy(&key, meta->histogramKeys[i], sizeof(T));
+        return key;
     }
-    
-    int compareRecordId (const void * a, const void * b)
+
+    template <class T>
+    static void setHistogramKey(IndexMetaInfo* meta, const int i, const T& key)
     {
-        RecordId c = *(RecordId *)a;
-        RecordId d = *(RecordId *)b;
-        int x = c.page_number;
-        int y = d.page_number;
-        return (x - y);
+        memcpy(meta->histogramKeys[i], &key, sizeof(T));
     }
-    
-    // -----------------------------------------------------------------------------
-    // BTreeIndex::BTreeIndex -- Constructor
-    // -----------------------------------------------------------------------------
-    
-    BTreeIndex::BTreeIndex(const std::string & relationName,
-                           std::string & outIndexName,
-                           BufMgr *bufMgrIn,
-                           const int attrByteOffset,
-                           const Datatype attrType)
+
+    template <class T>
+    void BTreeIndex::histogramInsert(IndexMetaInfo* meta, const T& key)
     {
-        this->bufMgr = bufMgrIn;
-        this->attributeType = attrType;
-        this->attrByteOffset = attrByteOffset;
-        
-        std::ostringstream idxStr;
-        idxStr << relationName << '.' << attrByteOffset;
-        std::string indexName = idxStr.str( ); // indexName is the name of the index file
-        outIndexName = indexName;
-        
-        //INTEGER
-        if (this->attributeType == 0)
+        meta->numEntries++;
+        if (meta->numEntries == 1 || key < histogramKey<T>(meta, 0))
         {
-            this->leafOccupancy = INTARRAYLEAFSIZE;
-            this->nodeOccupancy = INTARRAYNONLEAFSIZE;
+            setHistogramKey<T>(meta, 0, key);
         }
-        //DOUBLE
-        else if (this->attributeType == 1)
+        if (meta->numEntries == 1 || key > histogramKey<T>(meta, 1))
         {
-            this->leafOccupancy = DOUBLEARRAYLEAFSIZE;
-            this->nodeOccupancy = DOUBLEARRAYNONLEAFSIZE;
+            setHistogramKey<T>(meta, 1, key);
         }
-        //STRING
-        else if (this->attributeType == 2)
+        if (meta->histogramBuckets == 0)
         {
-            this->leafOccupancy = STRINGARRAYLEAFSIZE;
-            this->nodeOccupancy = STRINGARRAYNONLEAFSIZE;
+            return;
         }
-        //ERROR
-        else
+
+        //Last bucket whose smallest key is not above key, keys below all of them go to the first
+        int lo = 0;
+        int hi = meta->histogramBuckets;
+        while (lo < hi)
         {
-            std::cout << "ERROR in BTreeIndex constructor: Datatype must equal INTEGER(0) DOUBLE(1) STRING(2)\n";
+            int mid = (lo + hi) / 2;
+            if (key < histogramKey<T>(meta, 2 + mid))
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
         }
-        
-        try
+        int bucket = std::max(lo - 1, 0);
+        //A key with a bucket of its own is followed by a bucket starting at the same key, see collectSeparators()
+        if (bucket > 0 && key == histogramKey<T>(meta, 2 + bucket) && key == histogramKey<T>(meta, 1 + bucket))
         {
-            //Create blob file constructor will throw if file does not exist
-            this->file = new BlobFile(outIndexName, false);
-            
-            //File does exist
-            //Page 1 is meta data page
-            //Get page 1 for its indexMetaInfo
-            Page * page;
-            bufMgr->readPage(file, 1, page);
-            IndexMetaInfo * meta;
-            meta = (IndexMetaInfo *)page;
-            std::cout << "FILE EXISTS\n";
-            //Set rootPageNum
-            this->rootPageNum = meta->rootPageNo;
-            //Set IndexMetaInfo byte offset
-            meta->attrByteOffset = attrByteOffset;
-            //Set IndexMetaInfo relation name
-            strcpy(meta->relationName, relationName.c_str());
-            //Set IndexMetaInfo DataType (DO WE NEED THIS?)
-            meta->attrType = attrType;
-            //Unpin because if we construct to many pages in a row we would run out of buffer space
-            bufMgr->unPinPage(file, 1, false);
-            //No scan is executing
-            this->scanExecuting = false;
-        }
-        //File does not exist
-        catch (FileNotFoundException e)
-        {
-            std::cout << "FILE DOES NOT EXIST\n";
-            //Create new file
-            this->file = new BlobFile(outIndexName, true);
-            PageId rootId;
-            Page * rootPage;
-            bufMgr->allocPage(file, rootId, rootPage);
-            
-            //SET UP THE ROOT PAGE
-            //INTEGER
-            if (this->attributeType == 0)
-            {
-                NonLeafNodeInt * root = (NonLeafNodeInt *) rootPage;
-                root->level = 1;
-                for (int i = 0; i < INTARRAYNONLEAFSIZE; i++)
-                {
-                    root->keyArray[i] = 0;
-                }
-                Page* page;
-                PageId pageID;
-                LeafNodeInt* leaf;
-                bufMgr->allocPage(file, pageID, page);
-                root->pageNoArray[0] = pageID;
-                leaf = (LeafNodeInt*) page;
-                for(unsigned int i = 0; i < INTARRAYLEAFSIZE; i++)
-                {
-                    leaf->keyArray[i] = 0;
-                }
-                leaf->rightSibPageNo = 0;
-            }
-            //DOUBLE
-            else if (this->attributeType == 1)
+            bucket--;
+        }
+        meta->histogramCounts[bucket]++;
+        //A bucket of a single key is exact however deep it gets
+        bool singleKey = bucket + 1 < meta->histogramBuckets && histogramKey<T>(meta, 2 + bucket) == histogramKey<T>(meta, 3 + bucket);
+        if (!singleKey && meta->histogramCounts[bucket] > 2 * meta->numEntries / meta->histogramBuckets + NodeTraits<T>::LEAFSIZE)
+        {
+            histogramStale = true;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::rebuildHistogram
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void BTreeIndex::rebuildHistogram()
+    {
+        std::vector<T> separators;
+        std::vector<std::uint32_t> leafCounts;
+        collectSeparators<T>(rootPageNum, separators, leafCounts);
+
+        Page * page;
+        readNode(headerPageNum, page);
+        IndexMetaInfo * meta = (IndexMetaInfo *) page;
+        std::uint64_t numLeaves = separators.size() + 1;
+        int buckets = std::min<std::uint64_t>(HISTOGRAMBUCKETS, numLeaves);
+        //Entries not in the buckets before the current one
+        std::uint64_t left = std::accumulate(leafCounts.begin(), leafCounts.end(), (std::uint64_t) 0);
+        int b = 0;
+        setHistogramKey<T>(meta, 2, histogramKey<T>(meta, 0));
+        meta->histogramCounts[0] = 0;
+        for (std::uint64_t i = 0; i < numLeaves; i++)
+        {
+            //Start the next bucket before a leaf that would take this one past its share of the entries left,
+            //or when the leaves left are only just enough for the buckets left
+            bool full = meta->histogramCounts[b] + leafCounts[i] > left / (buckets - b);
+            if (i > 0 && b + 1 < buckets && (full || numLeaves - i <= (std::uint64_t) (buckets - 1 - b)))
             {
-                NonLeafNodeDouble * root = (NonLeafNodeDouble *) rootPage;
-                root->level = 1;
-                for (int i = 0; i < INTARRAYNONLEAFSIZE; i++)
-                {
-                    root->keyArray[i] = 0;
-                }
-                Page* temp;
-                PageId toAdd;
-                LeafNodeDouble* leaf;
-                bufMgr->allocPage(file, toAdd, temp);
-                root->pageNoArray[0] = toAdd;
-                leaf = (LeafNodeDouble*) temp;
-                for(unsigned int i = 0; i < INTARRAYLEAFSIZE; i++)
-                {
-                    leaf->keyArray[i] = 0;
-                }
-                leaf->rightSibPageNo = 0;
+                left -= meta->histogramCounts[b];
+                b++;
+                setHistogramKey<T>(meta, 2 + b, separators[i - 1]);
+                meta->histogramCounts[b] = 0;
             }
-            //STRING
-            else if (this->attributeType == 2)
+            meta->histogramCounts[b] += leafCounts[i];
+        }
+        meta->histogramBuckets = buckets;
+        unPinNode(headerPageNum, true);
+        histogramStale = false;
+    }
+
+    template <class T>
+    void BTreeIndex::collectSeparators(const PageId pageNo, std::vector<T>& separators, std::vector<std::uint32_t>& leafCounts)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        Page * page;
+        readNode(pageNo, page);
+        NonLeaf * node = (NonLeaf *) page;
+        int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+        std::vector<T> keys;
+        for (int i = 0; i < count; i++)
+        {
+            keys.push_back(nonLeafKey(node, i));
+        }
+        std::vector<PageId> children;
+        appendChildren(node, 0, count + 1, children);
+        bool childIsLeaf = node->level == 1;
+        unPinNode(pageNo, false);
+
+        for (int i = 0; i <= count; i++)
+        {
+            if (!childIsLeaf)
             {
-                
+                collectSeparators<T>(children[i], separators, leafCounts);
             }
-            //ERROR
             else
             {
-                
-            }
-            bufMgr->unPinPage(file, rootId, false);
-            
-            //SET UP THE META INFO PAGE
-            Page * metaPage;
-            PageId metaPageId = 1;
-            bufMgr->allocPage(file, metaPageId, metaPage);
-            IndexMetaInfo * metaInfo;
-            
-            metaInfo = (IndexMetaInfo *) metaPage;
-            strcpy(metaInfo->relationName, relationName.c_str());
-            metaInfo->attrByteOffset = attrByteOffset;
-            metaInfo->attrType = attrType;
-            metaInfo->rootPageNo = metaPageId;
-            
-            bufMgr->unPinPage(file, metaPageId, false);
-            
-            FileScan scan(relationName, bufMgr);
-            
-            RecordId scanID;
-            scanID.page_number = 0;
-            try {
-                while (true)
+                Page * page;
+                readNode(children[i], page);
+                Leaf * leaf = (Leaf *) page;
+                int leafCount = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+                int from = 0;
+                for (int j = 0; j < leafCount; j++)
                 {
-                    scan.scanNext(scanID);
-                    std::string recordStr = scan.getRecord();
-                    const char *record = recordStr.c_str();
-                    void* key = (void*)(record + attrByteOffset);
-                    insertEntry(key, scanID);
+                    if (isPostingRid(leafRid(leaf, j)))
+                    {
+                        leafCounts.push_back(leafWeight(leaf, from, j));
+                        separators.push_back(leafKey(leaf, j));
+                        leafCounts.push_back(ridWeight(leafRid(leaf, j)));
+                        separators.push_back(leafKey(leaf, j));
+                        from = j + 1;
+                    }
                 }
+                leafCounts.push_back(leafWeight(leaf, from, leafCount));
+                unPinNode(children[i], false);
             }
-            catch (EndOfFileException e)
+            if (i < count)
             {
-                // Index has completed
+                separators.push_back(keys[i]);
             }
         }
     }
-    
-    
+
     // -----------------------------------------------------------------------------
-    // BTreeIndex::~BTreeIndex -- destructor
+    // BTreeIndex::estimateRange
     // -----------------------------------------------------------------------------
-    
-    BTreeIndex::~BTreeIndex()
+
+    static double keyPosition(const int key)
+    {
+        return key;
+    }
+
+    static double keyPosition(const double key)
+    {
+        return key;
+    }
+
+    //Reads the key bytes as a base 256 number, enough to interpolate between two keys
+    static double keyPosition(const StringKey& key)
     {
-        if(this->scanExecuting == true)
+        double position = 0;
+        for (int i = 0; i < STRINGSIZE; i++)
         {
-            this->endScan();
+            position = position * 256 + (unsigned char) key.data[i];
         }
-        bufMgr->flushFile(this->file);
-        try
+        return position;
+    }
+
+    //Distance from a key to the next one, 0 where keys are not discrete
+    static double keyStep(const int)
+    {
+        return 1;
+    }
+
+    static double keyStep(const double)
+    {
+        return 0;
+    }
+
+    static double keyStep(const StringKey&)
+    {
+        return 0;
+    }
+
+    double BTreeIndex::estimateRange(const void* lowValParm,
+                                     const Operator lowOpParm,
+                                     const void* highValParm,
+                                     const Operator highOpParm)
+    {
+        if ((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+        if (countsKept)
+        {
+            return countRange(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+        if (this->attributeType == INTEGER)
+        {
+            return estimateRangeTyped<int>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+        else if (this->attributeType == DOUBLE)
         {
-            delete this->file;
+            return estimateRangeTyped<double>(lowValParm, lowOpParm, highValParm, highOpParm);
         }
-        catch (FileNotFoundException e)
+        else
         {
-            
+            return estimateRangeTyped<StringKey>(lowValParm, lowOpParm, highValParm, highOpParm);
         }
     }
-    
-    // -----------------------------------------------------------------------------
-    // BTreeIndex::insertEntry
-    // -----------------------------------------------------------------------------
-    
-    const void BTreeIndex::insertEntry(const void *key, const RecordId rid)
+
+    template <class T>
+    double BTreeIndex::estimateRangeTyped(const void* lowValParm, const Operator lowOpParm,
+                                          const void* highValParm, const Operator highOpParm)
     {
-        //INTEGER
-        if (this->attributeType == 0)
+        T low = keyFromPtr<T>(lowValParm);
+        T high = keyFromPtr<T>(highValParm);
+        if (high < low)
         {
-            //FIND THE FUCKING PAGEID
-            std::stack<PageId>stack;
-            int keyInt = *(int*)key;
-            PageId currentId = this->rootPageNum;
-            Page * page;
-            int saveIndex = 0;
-            bool done = false;
-            while (!done)
-            {
-                bufMgr->readPage(file, currentId, page);
-                bufMgr->unPinPage(file, currentId, false);
-                NonLeafNodeInt * node = (NonLeafNodeInt *) page;
-                bool found = false;
-                //Note the second else if may not be needed or could be made cleaner
-                for (int i = 0; i < INTARRAYNONLEAFSIZE && !found; i++)
-                {
-                    int currentKey = node->keyArray[i];
-                    if (currentKey == 0 || keyInt <= currentKey)
-                    {
-                        stack.push(currentId);
-
-                        found = true;
-                        currentId = node->pageNoArray[i];
-                        saveIndex = i;
-                    }
-                    else if (i == INTARRAYNONLEAFSIZE - 1)
-                    {
-                        stack.push(currentId);
+            throw BadScanrangeException();
+        }
 
-                        currentId = node->pageNoArray[INTARRAYNONLEAFSIZE];
-                        saveIndex = INTARRAYNONLEAFSIZE;
-                    }
-                }
-                if (node->level == 1)
-                {
-                    done = true;
-                }
-            }
-            
-            //find out if node is full
-            int freeIndex = -1;
-            bool full = true;
-            Page* temp;
-            bufMgr->readPage(file, this->rootPageNum, temp);
-            LeafNodeInt * node;
-            node = (LeafNodeInt *) temp;
-            for(int i = 0; i < leafOccupancy || !full; i++)
-            {
-                
-                if(node->ridArray[i].page_number == 0)
-                {
-                    full = false;
-                    freeIndex = i;
-                }
-            }
-            if(full)
+        Page * page;
+        readNode(headerPageNum, page);
+        IndexMetaInfo * meta = (IndexMetaInfo *) page;
+        std::uint64_t numEntries = meta->numEntries;
+        T maxKey = histogramKey<T>(meta, 1);
+        std::vector<T> bucketKeys(1, histogramKey<T>(meta, 0));
+        std::vector<std::uint64_t> bucketCounts(1, numEntries);
+        if (meta->histogramBuckets > 0)
+        {
+            bucketCounts.assign(meta->histogramCounts, meta->histogramCounts + meta->histogramBuckets);
+            for (int b = 1; b < meta->histogramBuckets; b++)
             {
-                freeIndex = -1;
+                bucketKeys.push_back(histogramKey<T>(meta, 2 + b));
             }
-            
-            //not full
-            if (freeIndex != -1)
+        }
+        unPinNode(headerPageNum, false);
+        if (numEntries == 0)
+        {
+            return 0;
+        }
+
+        //Take the range as [start, end) and each bucket as [its smallest key, the next one's)
+        double step = keyStep(low);
+        double start = keyPosition(low) + (lowOpParm == GT ? step : 0);
+        double end = keyPosition(high) + (highOpParm == LTE ? step : 0);
+        double estimate = 0;
+        for (size_t b = 0; b < bucketKeys.size(); b++)
+        {
+            double bucketStart = keyPosition(bucketKeys[b]);
+            double bucketEnd = b + 1 < bucketKeys.size() ? keyPosition(bucketKeys[b + 1]) : keyPosition(maxKey) + step;
+            //All keys of the bucket are equal, or too close together to tell apart
+            if (bucketEnd <= bucketStart)
             {
-                Page * page;
-                bufMgr->readPage(file, currentId, page);
-                LeafNodeInt * newNode;
-                newNode = (LeafNodeInt*) page;
-                for (int i = freeIndex-1; i >= 0 && !done; i++)
-                {
-                    if (newNode->keyArray[i] > keyInt)
-                    {
-                        newNode->keyArray[i+1] = newNode->keyArray[i];
-                        newNode->ridArray[i+1] = newNode->ridArray[i];
-                    }
-                    else
-                    {
-                        newNode->keyArray[i+1] = keyInt;
-                        newNode->ridArray[i+1] = rid;
-                    }
-                }
-                bufMgr->unPinPage(file, currentId, true);//page dirtied
+                const T& key = bucketKeys[b];
+                bool inside = (lowOpParm == GTE ? key >= low : key > low) && (highOpParm == LTE ? key <= high : key < high);
+                estimate += inside ? bucketCounts[b] : 0;
+                continue;
             }
-            //FUCK ITS FULL
-            else
+            double overlap = std::min(end, bucketEnd) - std::max(start, bucketStart);
+            if (overlap > 0)
             {
-                //create new node and split values, pushKeyUp is the key to insert into parent
-                
-                //current node is called node
-                Page * newPage;
-                LeafNodeInt * newLeafNode;
-                PageId newPageId;
-                bufMgr->allocPage(file, newPageId, newPage);
-                newLeafNode->rightSibPageNo = node->rightSibPageNo;
-                node->rightSibPageNo = newPageId;
-                RecordId blankRID;
-                blankRID.page_number = 0;
-                for(int i = 0; i < leafOccupancy; i++)
-                {
-                    newLeafNode->keyArray[i] = 0;
-                    newLeafNode->ridArray[i] = blankRID;
-                }
-                RecordId newRidArr [INTARRAYLEAFSIZE + 1];
-                int newKeyArr [INTARRAYLEAFSIZE + 1];
-                for (int i = 0; i < INTARRAYLEAFSIZE + 1; i++)
-                {
-                    if (i < INTARRAYLEAFSIZE) {
-                        newRidArr[i] = node->ridArray[i];
-                        newKeyArr[i] = node->keyArray[i];
-                    }
-                    else if (i == INTARRAYLEAFSIZE)
-                    {
-                        newRidArr[i] = rid;
-                        newKeyArr[i] = keyInt;
-                    }
-                }
-                
-                qsort(newKeyArr, INTARRAYLEAFSIZE + 1, sizeof(int), compareInt);
-                qsort(newRidArr, INTARRAYLEAFSIZE + 1, sizeof(RecordId), compareRecordId);
-                
-                int midIndex = (INTARRAYLEAFSIZE + 1) % 2;
-                if(midIndex == 0)
-                {
-                    midIndex = (INTARRAYLEAFSIZE + 1) / 2;
-                }
-                else
-                {
-                    midIndex = ((INTARRAYLEAFSIZE + 1) / 2) + 1;
-                }
-                
-                
-                int k = 0;
-                for (int i = midIndex; i < INTARRAYLEAFSIZE + 1; i++)
-                {
-                    if (i < INTARRAYLEAFSIZE)
-                    {
-                        node->keyArray[i] = 0;
-                        node->ridArray[i] = blankRID;
-                        newLeafNode->keyArray[k] = newKeyArr[i];
-                        newLeafNode->ridArray[k] = newRidArr[i];
-                    }
-                    else if (i == INTARRAYLEAFSIZE)
-                    {
-                        newLeafNode->keyArray[k] = newKeyArr[i];
-                        newLeafNode->ridArray[k] = newRidArr[i];
-                    }
-                    k++;
-                }
-                
-                int pushUpKey = newKeyArr[midIndex];
-                
-                bufMgr->unPinPage(file, newPageId, false);
-                bool done = false;
-                while (!done)
-                {
-                    PageId currentId = stack.top();
-                    //find out if node is full
-                    int freeIndex = -1;
-                    bool full = true;
-                    Page * temp;
-                    bufMgr->readPage(file, currentId, temp);
-                    LeafNodeInt * node;
-                    node = (LeafNodeInt *) temp;
-                    for(int i = 0; i < leafOccupancy || !full; i++)
-                    {
-                        
-                        if(node->ridArray[i].page_number == 0)
-                        {
-                            full = false;
-                            freeIndex = i;
-                        }
-                    }
-                    if(full)
-                    {
-                        freeIndex = -1;
-                    }
-                    //if not full
-                    if (!full)
-                    {
-                        Page* page;
-                        NonLeafNodeInt* parent;
-                        bufMgr->readPage(file, currentId, page);
-                        parent = (NonLeafNodeInt*) page;
-                        for (int i = freeIndex-1; i >= 0 && !done; i++)
-                        {
-                            if (parent->keyArray[i] > pushUpKey)
-                            {
-                                parent->keyArray[i+1] = parent->keyArray[i];
-                                parent->pageNoArray[i+1] = parent->pageNoArray[i];
-                            }
-                            else
-                            {
-                                parent->keyArray[i+1] = pushUpKey;
-                                parent->pageNoArray[i+1] = newPageId;
-                            }
-                        }
-                        bufMgr->unPinPage(file, currentId, true);
-                        done = true;
-                    }
-                    //else full
-                    else
-                    {
-                        Page * oldPage;
-                        bufMgr->readPage(file, currentId, oldPage);
-                        NonLeafNodeInt * node = (NonLeafNodeInt *)oldPage;
-                        Page * newPage;
-                        NonLeafNodeInt * newNonLeafNode;
-                        PageId newPageId;
-                        bufMgr->allocPage(file, newPageId, newPage);
-                        if (node->level == 1)
-                        {
-                            newNonLeafNode->level = 1;
-                        }
-                        else
-                        {
-                            newNonLeafNode->level = 0;
-                        }
-                        
-                        for(int i = 0; i < INTARRAYNONLEAFSIZE; i++)
-                        {
-                            newNonLeafNode->keyArray[i] = 0;
-                            newNonLeafNode->pageNoArray[i] = 0;
-                        }
-                        int newKeyArr [INTARRAYNONLEAFSIZE + 1];
-                        int newPageNoArray [INTARRAYNONLEAFSIZE + 2];
-                        for (int i = 0; i < INTARRAYNONLEAFSIZE + 1; i++)
-                        {
-                            if (i < INTARRAYNONLEAFSIZE) {
-                                newPageNoArray[i] = node->pageNoArray[i];
-                                newKeyArr[i] = node->keyArray[i];
-                            }
-                            else if (i == INTARRAYNONLEAFSIZE)
-                            {
-                                newPageNoArray[i] = newPageId;
-                                newKeyArr[i] = pushUpKey;
-                            }
-                        }
-                        
-                        qsort(newKeyArr, INTARRAYNONLEAFSIZE + 1, sizeof(int), compareInt);
-                        qsort(newPageNoArray, INTARRAYNONLEAFSIZE + 1, sizeof(PageId), compareInt);
-                        
-                        int midIndex = (INTARRAYNONLEAFSIZE + 1) % 2;
-                        if(midIndex == 0)
-                        {
-                            midIndex = (INTARRAYNONLEAFSIZE + 1) / 2;
-                        }
-                        else
-                        {
-                            midIndex = ((INTARRAYNONLEAFSIZE + 1) / 2) + 1;
-                        }
-                        
-                        
-                        int k = 0;
-                        for (int i = midIndex; i < INTARRAYNONLEAFSIZE + 1; i++)
-                        {
-                            if (i < INTARRAYNONLEAFSIZE)
-                            {
-                                node->keyArray[i] = 0;
-                                node->pageNoArray[i] = 0;
-                                newNonLeafNode->keyArray[k] = newKeyArr[i];
-                                newNonLeafNode->pageNoArray[k] = newPageNoArray[i];
-                            }
-                            else if (i == INTARRAYNONLEAFSIZE)
-                            {
-                                newNonLeafNode->keyArray[k] = newKeyArr[i];
-                                newNonLeafNode->pageNoArray[k] = newPageNoArray[i];
-                            }
-                            k++;
-                        }
-                        
-                        int pushUpKey = newKeyArr[midIndex];
-                        bufMgr->unPinPage(file, currentId, true);
-                        bufMgr->unPinPage(file, newPageId, true);
-                        
-                        if(stack.size() == 1)
-                        {
-                            Page * page;
-                            PageId pageId;
-                            NonLeafNodeInt* newNode;
-                            bufMgr->allocPage(file, pageId, page);
-                            newNode = (NonLeafNodeInt*) page;
-                            newNode->level = 0;
-                            newNode->keyArray[0] = pushUpKey;
-                            for(int i = 1; i < INTARRAYNONLEAFSIZE; i++)
-                            {
-                                newNode->keyArray[i] = 0;
-                            }
-                            newNode->pageNoArray[0] = currentId;
-                            newNode->pageNoArray[1] = newPageId;
-                            
-                            IndexMetaInfo* metaIndex;
-                            Page* meta;
-                            bufMgr->readPage(file, 1, meta);
-                            metaIndex = (IndexMetaInfo*) meta;
-                            metaIndex->rootPageNo = pageId;
-                            this->rootPageNum = pageId;
-                            bufMgr->unPinPage(file, 1, true);
-                        }
-                    }
-                    stack.pop();
-                }
-                
+                estimate += bucketCounts[b] * std::min(1.0, overlap / (bucketEnd - bucketStart));
             }
-            
         }
-        //DOUBLE
-        else if (this->attributeType == 1)
+        return estimate;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BTreeIndex::getKeyHistogram
+    // -----------------------------------------------------------------------------
+
+    const void BTreeIndex::getKeyHistogram(KeyHistogram & outHistogram)
+    {
+        if (this->attributeType == INTEGER)
         {
-            
+            getKeyHistogramTyped<int>(outHistogram);
         }
-        //STRING
-        else if (this->attributeType == 2)
+        else if (this->attributeType == DOUBLE)
         {
-            
+            getKeyHistogramTyped<double>(outHistogram);
         }
-        //ERROR
         else
         {
-            
+            getKeyHistogramTyped<StringKey>(outHistogram);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::getKeyHistogramTyped(KeyHistogram& outHistogram)
+    {
+        Page * page;
+        readNode(headerPageNum, page);
+        IndexMetaInfo * meta = (IndexMetaInfo *) page;
+        outHistogram.numEntries = meta->numEntries;
+        outHistogram.height = meta->height;
+        outHistogram.minKey.clear();
+        outHistogram.maxKey.clear();
+        outHistogram.bucketKeys.clear();
+        outHistogram.bucketCounts.clear();
+        if (meta->numEntries > 0)
+        {
+            outHistogram.minKey = keyString(histogramKey<T>(meta, 0));
+            outHistogram.maxKey = keyString(histogramKey<T>(meta, 1));
+        }
+        for (int b = 0; b < meta->histogramBuckets; b++)
+        {
+            outHistogram.bucketKeys.push_back(keyString(histogramKey<T>(meta, 2 + b)));
+            outHistogram.bucketCounts.push_back(meta->histogramCounts[b]);
         }
+        unPinNode(headerPageNum, false);
     }
-    
+
+
     // -----------------------------------------------------------------------------
-    // BTreeIndex::startScan
+    // BTreeIndex::partitionRange
     // -----------------------------------------------------------------------------
-    
-    const void BTreeIndex::startScan(const void* lowValParm,
-                                     const Operator lowOpParm,
-                                     const void* highValParm,
-                                     const Operator highOpParm)
+
+    const void BTreeIndex::partitionRange(const void* lowValParm,
+                                          const Operator lowOpParm,
+                                          const void* highValParm,
+                                          const Operator highOpParm,
+                                          const int n,
+                                          std::vector<ScanBounds>& outPartitions)
     {
-        std::cout << "HELLO THERE!\n";
-        if(scanExecuting)
+        if ((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
         {
-            endScan();
+            throw BadOpcodesException();
         }
-        lowOp = lowOpParm;
-        highOp = highOpParm;
-        
-        if((highOp != LT && highOp != LTE)|| (lowOp != GT && lowOp != GTE) )
+        if (n < 1)
         {
-            throw BadOpcodesException();
+            throw BadScanParamException();
         }
-        
-        scanExecuting = true;
-        nextEntry = 0;
-        currentPageNum = rootPageNum;
-        //INTEGER
-        
-        if (this->attributeType == 0)
+        if (this->attributeType == INTEGER)
         {
-            lowValInt = *(int *)lowValParm;
-            highValInt = *(int *)highValParm;
-            if (lowValInt > highValInt)
-            {
-                throw BadScanrangeException();
-            }
-            NonLeafNodeInt * node;
-            currentPageNum = rootPageNum;
-            bufMgr->readPage(file, currentPageNum, currentPageData);
-            bufMgr->unPinPage(file, currentPageNum, currentPageData);
-            node = (NonLeafNodeInt *) currentPageData;
-            while (node->level != 1)
-            {
-                bufMgr->readPage(file, currentPageNum, currentPageData);
-                bufMgr->unPinPage(file, currentPageNum, false);
-                NonLeafNodeInt * node = (NonLeafNodeInt *) currentPageData;
-                bool found = false;
-                std::cout << node->level << "\n";
-                //Note the second else if may not be needed or could be made cleaner
-                for (int i = 0; i < INTARRAYNONLEAFSIZE && !found; i++)
-                {
-                    std::cout << node->keyArray[i] << "\n";
-                    if (lowValInt <= node->keyArray[i])
-                    {
-                        currentPageNum = node->pageNoArray[i];
-                        found = true;
-                    }
-                    if(node->keyArray[i] == 0)
-                    {
-                        currentPageNum = node->pageNoArray[i + 1];
-                        found = true;
-                    }
-                    if (i == INTARRAYNONLEAFSIZE - 1)
-                    {
-                        currentPageNum = node->pageNoArray[INTARRAYNONLEAFSIZE];
-                        found = true;
-                    }
-                }
-            }
-            //REPIN IT
-            bufMgr->readPage(file, currentPageNum, currentPageData);
-            LeafNodeInt * leafNode = (LeafNodeInt *) currentPageData;
-            bool found = false;
-            while (!found)
+            partitionRangeTyped<int>(lowValParm, lowOpParm, highValParm, highOpParm, n, outPartitions);
+        }
+        else if (this->attributeType == DOUBLE)
+        {
+            partitionRangeTyped<double>(lowValParm, lowOpParm, highValParm, highOpParm, n, outPartitions);
+        }
+        else
+        {
+            partitionRangeTyped<StringKey>(lowValParm, lowOpParm, highValParm, highOpParm, n, outPartitions);
+        }
+    }
+
+    template <class T>
+    void BTreeIndex::partitionRangeTyped(const void* lowValParm, const Operator lowOpParm,
+                                         const void* highValParm, const Operator highOpParm,
+                                         const int n, std::vector<ScanBounds>& outPartitions)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        T low = keyFromPtr<T>(lowValParm);
+        T high = keyFromPtr<T>(highValParm);
+        if (high < low)
+        {
+            throw BadScanrangeException();
+        }
+
+        //Subtrees overlapping the range in key order, with the separator between each two of them
+        std::vector<PageId> subtrees(1, rootPageNum);
+        std::vector<T> separators;
+        bool leaves = false;
+        while (!leaves && subtrees.size() < 4 * (size_t) n)
+        {
+            std::vector<PageId> children;
+            std::vector<T> childSeparators;
+            for (size_t j = 0; j < subtrees.size(); j++)
             {
-                for(int i = 0; i < INTARRAYLEAFSIZE && !found; i++)
+                if (j > 0)
                 {
-                    if(leafNode->keyArray[i] == highValInt)
-                    {
-                        if(highOp != LTE)
-                        {
-                            throw NoSuchKeyFoundException();
-                        }
-                        else
-                        {
-                            found = true;
-                        }
-                    }
-                    if(leafNode->keyArray[i] == lowValInt)
-                    {
-                        if(lowOp != GTE)
-                        {
-                            throw NoSuchKeyFoundException();
-                        }
-                        else
-                        {
-                            found = true;
-                        }
-                    }
-                    if(leafNode->keyArray[i] < highValInt && leafNode->keyArray[i] > lowValInt)
-                    {
-                        found = true;
-                    }
-                    if(leafNode->keyArray[i] > highValInt)
-                    {
-                        throw NoSuchKeyFoundException();
-                    }
+                    childSeparators.push_back(separators[j - 1]);
                 }
-                if (!found)
+                Page * page;
+                readNode(subtrees[j], page);
+                NonLeaf * node = (NonLeaf *) page;
+                int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+                int first = lowOpParm == GTE ? nonLeafLowerBound(node, count, low) : nonLeafUpperBound(node, count, low);
+                int last = nonLeafUpperBound(node, count, high);
+                for (int i = first; i <= last; i++)
                 {
-                    bufMgr->unPinPage(file, currentPageNum, false);
-                    if (leafNode->rightSibPageNo == 0)
+                    children.push_back(childPage(node, i));
+                    if (i < last)
                     {
-                        throw NoSuchKeyFoundException();
+                        childSeparators.push_back(nonLeafKey(node, i));
                     }
-                    currentPageNum = leafNode->rightSibPageNo;
-                    bufMgr->readPage(file, currentPageNum, currentPageData);
                 }
+                leaves = node->level == 1;
+                unPinNode(subtrees[j], false);
             }
+            subtrees.swap(children);
+            separators.swap(childSeparators);
         }
-        //DOUBLE
-        else if (this->attributeType == 1)
-        {
-        
-        }
-        //STRING
-        else if (this->attributeType == 2)
+
+        //Cut into groups of consecutive subtrees, skipping cuts that would leave an empty sub-range
+        std::vector<T> cuts;
+        size_t groups = std::min(subtrees.size(), (size_t) n);
+        for (size_t g = 1; g < groups; g++)
         {
-        
+            const T& cut = separators[g * subtrees.size() / groups - 1];
+            if (low < cut && cut < high && (cuts.empty() || cuts.back() < cut))
+            {
+                cuts.push_back(cut);
+            }
         }
-        //ERROR
-        else
+
+        outPartitions.clear();
+        for (size_t p = 0; p <= cuts.size(); p++)
         {
-        
+            ScanBounds bounds;
+            bounds.lowKey = keyBytes<T>(p == 0 ? low : cuts[p - 1]);
+            bounds.lowOp = p == 0 ? lowOpParm : GTE;
+            bounds.highKey = keyBytes<T>(p == cuts.size() ? high : cuts[p]);
+            bounds.highOp = p == cuts.size() ? highOpParm : LT;
+            outPartitions.push_back(bounds);
         }
-    
     }
 
     // -----------------------------------------------------------------------------
-    // BTreeIndex::scanNext
-    // -----------------------------------------------------------------------------
-    
-    const void BTreeIndex::scanNext(RecordId& outRid)
-    {
-        
-    }
-    
-    // -----------------------------------------------------------------------------
-    // BTreeIndex::endScan
+    // BTreeIndex::flush
     // -----------------------------------------------------------------------------
-    //
-    const void BTreeIndex::endScan()
+
+    const void BTreeIndex::flush()
     {
-        
+        bufMgr->flushFile(file);
+        if (resident && residentPages.size() > 1)
+        {
+            ((BlobFile *) file)->writePages(1, residentPages.size() - 1, &residentPages[1]);
+        }
     }
-    
-    //SPLIT LEAF
-    
-    //SPLIT NONLEAF
-    //create new node and split values, pushKeyUp is the key to insert into parent
-    
 
 }
@@ -9,6 +9,10 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
 #include "string.h"
 #include <sstream>
 
@@ -16,6 +20,7 @@
 #include "page.h"
 #include "file.h"
 #include "buffer.h"
+#include "exceptions/bad_index_info_exception.h"
 
 namespace badgerdb
 {
@@ -42,45 +47,116 @@ enum Operator
 };
 
 /**
- * @brief Size of String key.
+ * @brief Scan directions. Passed to BTreeIndex::startScan() method.
  */
-const  int STRINGSIZE = 10;
+enum ScanDirection
+{
+	FORWARD,	/* Ascending key order */
+	BACKWARD	/* Descending key order */
+};
+
+/**
+ * @brief Largest size of a STRING key. Longer keys are refused with BadIndexInfoException, see keyFromPtr(),
+ * rather than cut short. Leaves store each key with its own length, so short keys take no more room than their bytes.
+ */
+const  int STRINGSIZE = 64;
+
+/**
+ * @brief Number of buckets in the key histogram kept in the meta page.
+ */
+const  int HISTOGRAMBUCKETS = 64;
+
+/**
+ * @brief Most columns in the key of a composite index.
+ */
+const  int MAXKEYCOLUMNS = 4;
+
+/**
+ * @brief Column of the key of a composite index: where the attribute is in the record, and its type.
+ */
+struct KeyColumn{
+	int attrByteOffset;
+	Datatype attrType;
+};
+
+/**
+ * @brief Largest size of an encoded composite key, see encodeKeyColumn(). One byte of a STRING key is left for
+ * the PASTPREFIX byte that bounds a scan on a prefix of the columns.
+ */
+const  int COMPOSITEKEYSIZE = STRINGSIZE - 1;
 
 /**
- * @brief Number of key slots in B+Tree leaf for INTEGER key.
+ * @brief Byte that no encoded column starts with. A prefix of the columns followed by it sorts after every key
+ * that starts with the prefix, and before every key with a greater prefix.
  */
-//                                                  sibling ptr             key               rid
-const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
+const  unsigned char PASTPREFIX = 0xFF;
+
+/**
+ * @brief Number of RecordIds in B+Tree leaf for INTEGER key, reached only when every key of the leaf is the same.
+ * Every key also takes the width of the packed keys of the leaf, 0 to 4 bytes, from the free space after them.
+ */
+//                                            entries, key width         base key       sibling ptrs                rid
+const  int INTARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( std::uint16_t ) - sizeof( int ) - 2 * sizeof( PageId ) ) / sizeof( RecordId );
 
 /**
  * @brief Number of key slots in B+Tree leaf for DOUBLE key.
  */
-//                                                     sibling ptr               key               rid
-const  int DOUBLEARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( double ) + sizeof( RecordId ) );
+//                                                     sibling ptrs                  key               rid
+const  int DOUBLEARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( PageId ) ) / ( sizeof( double ) + sizeof( RecordId ) );
+
+/**
+ * @brief Slot of a STRING leaf: the RecordId and where the bytes of its key are in the page.
+ */
+struct StringSlot{
+	RecordId rid;
+	std::uint16_t keyOffset;
+	std::uint16_t keyLength;
+};
+
+/**
+ * @brief Number of slots in B+Tree leaf for STRING key, reached only by empty keys. Every key also takes its
+ * length in bytes from the free space between the slots and the key bytes.
+ */
+//                                           entries, key bytes, prefix           sibling ptrs                slot
+const  int STRINGARRAYLEAFSIZE = ( Page::SIZE - 4 * sizeof( std::uint16_t ) - 2 * sizeof( PageId ) ) / sizeof( StringSlot );
 
 /**
- * @brief Number of key slots in B+Tree leaf for STRING key.
+ * @brief Child of an INTEGER non-leaf: its page number and the number of entries in its subtree.
  */
-//                                                    sibling ptr           key                      rid
-const  int STRINGARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( 10 * sizeof(char) + sizeof( RecordId ) );
+struct NonLeafChild{
+	PageId pageNo;
+	std::uint32_t count;
+};
 
 /**
- * @brief Number of key slots in B+Tree non-leaf for INTEGER key.
+ * @brief Number of key slots in B+Tree non-leaf for INTEGER key, reached only when every separator is the same.
+ * Every separator also takes the width of the packed keys of the node from the free space after the children.
  */
-//                                                     level     extra pageNo                  key       pageNo
-const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( PageId ) );
+//                                                  level      children, key width         base key                      child        -1 for the extra child
+const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - 2 * sizeof( std::uint16_t ) - sizeof( int ) ) / sizeof( NonLeafChild ) - 1;
 
 /**
  * @brief Number of key slots in B+Tree leaf for DOUBLE key.
  */
-//                                                        level        extra pageNo                 key            pageNo   -1 due to structure padding
-const  int DOUBLEARRAYNONLEAFSIZE = (( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( double ) + sizeof( PageId ) )) - 1;
+//                                                        level        extra pageNo, count                                 key            pageNo, count                  -1 due to structure padding
+const  int DOUBLEARRAYNONLEAFSIZE = (( Page::SIZE - sizeof( int ) - sizeof( PageId ) - sizeof( std::uint32_t ) ) / ( sizeof( double ) + sizeof( PageId ) + sizeof( std::uint32_t ) )) - 1;
+
+/**
+ * @brief Slot of a STRING non-leaf: a separator key, where its bytes are in the page, and the child to its right.
+ */
+struct NonLeafSlot{
+	PageId pageNo;
+	std::uint32_t count;
+	std::uint16_t keyOffset;
+	std::uint16_t keyLength;
+};
 
 /**
- * @brief Number of key slots in B+Tree leaf for STRING key.
+ * @brief Number of slots in B+Tree non-leaf for STRING key, reached only by empty keys. Every separator also takes
+ * its length in bytes from the free space between the slots and the key bytes.
  */
-//                                                        level        extra pageNo             key                   pageNo
-const  int STRINGARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( 10 * sizeof(char) + sizeof( PageId ) );
+//                                                        level       children, key bytes          first pageNo, count                            slot
+const  int STRINGARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - 2 * sizeof( std::uint16_t ) - sizeof( PageId ) - sizeof( std::uint32_t ) ) / sizeof( NonLeafSlot );
 
 /**
  * @brief Structure to store a key-rid pair. It is used to pass the pair to functions that 
@@ -148,14 +224,69 @@ struct IndexMetaInfo{
 	int attrByteOffset;
 
   /**
-   * Type of the attribute over which index is built.
+   * Type of the attribute over which index is built. STRING for a composite index.
    */
 	Datatype attrType;
 
+  /**
+   * Columns of the key of a composite index, 0 for an index over the single attribute above. The keys of a
+   * composite index are the encoded columns, see encodeKeyColumn(), stored as STRING keys.
+   */
+	int numKeyColumns;
+	KeyColumn keyColumns[ MAXKEYCOLUMNS ];
+
+  /**
+   * Columns a covering composite index copies into its entries after the key columns, 0 if none. They are
+   * encoded like key columns at the end of each key, see BTreeIndex::scanNextCovered().
+   */
+	int numIncludeColumns;
+	KeyColumn includeColumns[ MAXKEYCOLUMNS ];
+
   /**
    * Page number of root page of the B+ Tree inside the file index file.
    */
 	PageId rootPageNo;
+
+  /**
+   * Page number of the first free page, 0 if there is none. Pages left behind by compact() are
+   * kept on this list and handed out again by later splits. A free page stores the page number
+   * of the next free page in its first bytes.
+   */
+	PageId freePageNo;
+
+  /**
+   * Number of node splits since the index was created, leaf and non-leaf.
+   */
+	std::uint64_t numSplits;
+
+  /**
+   * Non zero once BTreeIndex::enableCounts() has been called. The countArray of every non-leaf
+   * node is then kept up to date by every change to the tree.
+   */
+	int countsKept;
+
+  /**
+   * Number of entries in the index and number of levels including the leaves.
+   */
+	std::uint64_t numEntries;
+	int height;
+
+  /**
+   * Number of histogram buckets in use, at most HISTOGRAMBUCKETS. 0 until the first split.
+   */
+	int histogramBuckets;
+
+  /**
+   * Entries in each histogram bucket.
+   */
+	std::uint64_t histogramCounts[ HISTOGRAMBUCKETS ];
+
+  /**
+   * Keys stored in the attribute type of the index: the smallest key, the largest key, then the
+   * smallest key of each histogram bucket. A bucket holds the keys from its own smallest key up to,
+   * not including, the smallest key of the next one. The buckets are equi-depth when rebuilt.
+   */
+	char histogramKeys[ HISTOGRAMBUCKETS + 2 ][ STRINGSIZE ];
 };
 
 /*
@@ -166,7 +297,11 @@ at this level are just above the leaf nodes. Otherwise set to 0.
 */
 
 /**
- * @brief Structure for all non-leaf nodes when the key is of INTEGER type.
+ * @brief Structure for all non-leaf nodes when the key is of INTEGER type. The separators are stored frame of
+ * reference: as their difference from the smallest one, baseKey, packed in keyWidth bytes each. The width is the
+ * fewest of 0, 1, 2 or 4 bytes that holds the largest difference, so separators that lie close together take a
+ * byte or two. The packed separators are in key order in the last bytes of the page, in the part of childArray that
+ * is not in use, and are searched without being decoded, see packedLowerBound(). A page of zeros has no children.
 */
 struct NonLeafNodeInt{
   /**
@@ -175,14 +310,25 @@ struct NonLeafNodeInt{
 	int level;
 
   /**
-   * Stores keys.
+   * Number of children, one more than the number of separators.
    */
-	int keyArray[ INTARRAYNONLEAFSIZE ];
+	std::uint16_t numChildren;
 
   /**
-   * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
+   * Bytes each separator takes, stored in the last ( numChildren - 1 ) * keyWidth bytes of the page.
+   */
+	std::uint16_t keyWidth;
+
+  /**
+   * Smallest separator, which the packed ones are added to.
+   */
+	int baseKey;
+
+  /**
+   * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree, and the number
+   * of entries in the subtree under each, kept only when IndexMetaInfo::countsKept is set.
    */
-	PageId pageNoArray[ INTARRAYNONLEAFSIZE + 1 ];
+	NonLeafChild childArray[ INTARRAYNONLEAFSIZE + 1 ];
 };
 
 /**
@@ -203,10 +349,18 @@ struct NonLeafNodeDouble{
    * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
    */
 	PageId pageNoArray[ DOUBLEARRAYNONLEAFSIZE + 1 ];
+
+  /**
+   * Number of entries in the subtree under each child, kept only when IndexMetaInfo::countsKept is set.
+   */
+	std::uint32_t countArray[ DOUBLEARRAYNONLEAFSIZE + 1 ];
 };
 
 /**
- * @brief Structure for all non-leaf nodes when the key is of STRING type.
+ * @brief Structure for all non-leaf nodes when the key is of STRING type. The node is slotted like LeafNodeString:
+ * slot i holds separator i and child i + 1 in key order, and the separator bytes are packed from the end of the
+ * page downwards. Separators are cut to the shortest prefix that still tells the two children apart, see
+ * separatorKey(), so a node fits many more of them than whole keys would allow. A page of zeros has no children.
 */
 struct NonLeafNodeString{
   /**
@@ -215,233 +369,1729 @@ struct NonLeafNodeString{
 	int level;
 
   /**
-   * Stores keys.
+   * Number of children, one more than the number of slots in use.
    */
-	char keyArray[ STRINGARRAYNONLEAFSIZE ][ STRINGSIZE ];
+	std::uint16_t numChildren;
 
   /**
-   * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
+   * Bytes of separators, stored in the last keyBytes bytes of the page.
+   */
+	std::uint16_t keyBytes;
+
+  /**
+   * Page number of the leftmost child, and the number of entries in its subtree when IndexMetaInfo::countsKept is set.
+   */
+	PageId firstPageNo;
+	std::uint32_t firstCount;
+
+  /**
+   * Stores the separators and the children to their right.
    */
-	PageId pageNoArray[ STRINGARRAYNONLEAFSIZE + 1 ];
+	NonLeafSlot slotArray[ STRINGARRAYNONLEAFSIZE ];
 };
 
 /**
- * @brief Structure for all leaf nodes when the key is of INTEGER type.
+ * @brief Structure for all leaf nodes when the key is of INTEGER type. The keys are packed like the separators of
+ * NonLeafNodeInt: baseKey is the smallest key, and every key is stored as its difference from it in keyWidth bytes,
+ * in key order in the last bytes of the page, in the part of ridArray that is not in use. The width is chosen again
+ * whenever the leaf is laid out again, see leafFill(). A page of zeros is an empty leaf.
 */
 struct LeafNodeInt{
   /**
-   * Stores keys.
+   * Number of entries.
    */
-	int keyArray[ INTARRAYLEAFSIZE ];
+	std::uint16_t numEntries;
 
   /**
-   * Stores RecordIds.
+   * Bytes each key takes, stored in the last numEntries * keyWidth bytes of the page.
    */
-	RecordId ridArray[ INTARRAYLEAFSIZE ];
+	std::uint16_t keyWidth;
+
+  /**
+   * Smallest key, which the packed ones are added to.
+   */
+	int baseKey;
 
   /**
    * Page number of the leaf on the right side.
 	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
    */
 	PageId rightSibPageNo;
-};
 
-/**
- * @brief Structure for all leaf nodes when the key is of DOUBLE type.
-*/
-struct LeafNodeDouble{
   /**
-   * Stores keys.
+   * Page number of the leaf on the left side, for scans in descending order.
    */
-	double keyArray[ DOUBLEARRAYLEAFSIZE ];
+	PageId leftSibPageNo;
 
   /**
    * Stores RecordIds.
    */
-	RecordId ridArray[ DOUBLEARRAYLEAFSIZE ];
-
-  /**
-   * Page number of the leaf on the right side.
-	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
-   */
-	PageId rightSibPageNo;
+	RecordId ridArray[ INTARRAYLEAFSIZE ];
 };
 
 /**
- * @brief Structure for all leaf nodes when the key is of STRING type.
+ * @brief Structure for all leaf nodes when the key is of DOUBLE type.
 */
-struct LeafNodeString{
+struct LeafNodeDouble{
   /**
    * Stores keys.
    */
-	char keyArray[ STRINGARRAYLEAFSIZE ][ STRINGSIZE ];
+	double keyArray[ DOUBLEARRAYLEAFSIZE ];
 
   /**
    * Stores RecordIds.
    */
-	RecordId ridArray[ STRINGARRAYLEAFSIZE ];
+	RecordId ridArray[ DOUBLEARRAYLEAFSIZE ];
 
   /**
    * Page number of the leaf on the right side.
 	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
    */
 	PageId rightSibPageNo;
-};
-
-/**
- * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
- * relation. This index supports only one scan at a time.
-*/
-class BTreeIndex {
-
- private:
-
-  /**
-   * File object for the index file.
-   */
-	File		*file;
 
   /**
-   * Buffer Manager Instance.
+   * Page number of the leaf on the left side, for scans in descending order.
    */
-	BufMgr	*bufMgr;
+	PageId leftSibPageNo;
+};
 
+/**
+ * @brief Structure for all leaf nodes when the key is of STRING type. The node is slotted: the slots are kept
+ * in key order from the start of slotArray, and the key bytes are packed from the end of the page downwards,
+ * into the part of slotArray that is not in use. A page of zeros is an empty leaf.
+ * Every key of the node starts with the same prefix, stored once among the key bytes; the slots only point
+ * at what follows it. The prefix is recomputed whenever the node is laid out again, see leafFill().
+*/
+struct LeafNodeString{
   /**
-   * Page number of meta page.
+   * Number of slots in use.
    */
-	PageId	headerPageNum;
+	std::uint16_t numEntries;
 
   /**
-   * page number of root page of B+ tree inside index file.
+   * Bytes of keys, stored in the last keyBytes bytes of the page.
    */
-	PageId	rootPageNum;
+	std::uint16_t keyBytes;
 
   /**
-   * Datatype of attribute over which index is built.
+   * Place and length of the prefix shared by all keys, counted in keyBytes.
    */
-	Datatype	attributeType;
+	std::uint16_t prefixOffset;
+	std::uint16_t prefixLength;
 
   /**
-   * Offset of attribute, over which index is built, inside records. 
+   * Page number of the leaf on the right side.
+	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
    */
-	int 		attrByteOffset;
+	PageId rightSibPageNo;
 
   /**
-   * Number of keys in leaf node, depending upon the type of key.
+   * Page number of the leaf on the left side, for scans in descending order.
    */
-	int			leafOccupancy;
+	PageId leftSibPageNo;
 
   /**
-   * Number of keys in non-leaf node, depending upon the type of key.
+   * Stores RecordIds and the place of the rest of their keys after the prefix.
    */
-	int			nodeOccupancy;
+	StringSlot slotArray[ STRINGARRAYLEAFSIZE ];
+};
 
+/**
+ * @brief Slot number that marks the RecordId of a leaf entry as a posting list. Its page number is then the
+ * first page of the list, which holds every RecordId of the key of the entry, see PostingPage.
+ */
+const  SlotId POSTINGSLOT = 0xFFFF;
 
-	// MEMBERS SPECIFIC TO SCANNING
+/**
+ * @brief Number of bytes of encoded RecordIds in a posting list page.
+ */
+const  int POSTINGDATASIZE = Page::SIZE - 3 * sizeof( PageId ) - 2 * sizeof( std::uint16_t ) - sizeof( RecordId );
 
+/**
+ * @brief Structure of the pages of a posting list. A key with many duplicates is stored once in its leaf, and
+ * its RecordIds go to a chain of these pages, sorted in (page_number, slot_number) order and delta encoded:
+ * each RecordId is a varint of the page number minus the one before it, followed by a varint of the slot
+ * number minus the one before it if the page is the same, or of the slot number itself if not. Every page
+ * starts again from (0, 0), so it can be decoded by itself.
+*/
+struct PostingPage{
   /**
-   * True if an index scan has been started.
+   * Page number of the next page of the list.
    */
-	bool		scanExecuting;
+	PageId nextPageNo;
 
   /**
-   * Index of next entry to be scanned in current leaf being scanned.
+   * Last page of the list and number of RecordIds in the whole list. Only kept up to date in the first page.
    */
-	int			nextEntry;
+	PageId tailPageNo;
+	std::uint32_t totalRids;
 
   /**
-   * Page number of current page being scanned.
+   * Number of RecordIds in this page and bytes of data they take.
    */
-	PageId	currentPageNum;
+	std::uint16_t numRids;
+	std::uint16_t numBytes;
 
   /**
-   * Current Page being scanned.
+   * Last RecordId of this page, which the next one appended is encoded against.
    */
-	Page		*currentPageData;
+	RecordId lastRid;
 
   /**
-   * Low INTEGER value for scan.
+   * Encoded RecordIds.
    */
-	int			lowValInt;
+	unsigned char data[ POSTINGDATASIZE ];
+};
 
+/**
+ * @brief STRING key as it is stored inside the non-leaf nodes and handled by the tree algorithms. Wraps the fixed
+ * size char array so that STRING keys can be copied, compared and passed around like INTEGER and DOUBLE keys.
+ * Keys shorter than STRINGSIZE are padded with '\0'.
+*/
+struct StringKey{
   /**
-   * Low DOUBLE value for scan.
+   * Key bytes, not necessarily null terminated.
    */
-	double	lowValDouble;
+	char data[ STRINGSIZE ];
+};
 
-  /**
-   * Low STRING value for scan.
-   */
-	std::string	lowValString;
+inline bool operator<( const StringKey& a, const StringKey& b )
+{
+	//Both are padded with '\0', so comparing every byte orders them like strncmp without looking for the end
+	return memcmp( a.data, b.data, STRINGSIZE ) < 0;
+}
 
-  /**
-   * High INTEGER value for scan.
-   */
-	int			highValInt;
+inline bool operator>( const StringKey& a, const StringKey& b )
+{
+	return b < a;
+}
 
-  /**
-   * High DOUBLE value for scan.
-   */
-	double	highValDouble;
+inline bool operator<=( const StringKey& a, const StringKey& b )
+{
+	return !( b < a );
+}
 
-  /**
-   * High STRING value for scan.
-   */
-	std::string highValString;
-	
-  /**
-   * Low Operator. Can only be GT(>) or GTE(>=).
-   */
-	Operator	lowOp;
+inline bool operator>=( const StringKey& a, const StringKey& b )
+{
+	return !( a < b );
+}
 
-  /**
-   * High Operator. Can only be LT(<) or LTE(<=).
-   */
-	Operator	highOp;
+inline bool operator==( const StringKey& a, const StringKey& b )
+{
+	return memcmp( a.data, b.data, STRINGSIZE ) == 0;
+}
 
-	
- public:
+inline bool operator!=( const StringKey& a, const StringKey& b )
+{
+	return !( a == b );
+}
 
-  /**
-   * BTreeIndex Constructor. 
-	 * Check to see if the corresponding index file exists. If so, open the file.
-	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
-   *
-   * @param relationName        Name of file.
-   * @param outIndexName        Return the name of index file.
-   * @param bufMgrIn						Buffer Manager Instance
-   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
-   * @param attrType						Datatype of attribute over which index is built
-   * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
-   */
-	BTreeIndex(const std::string & relationName, std::string & outIndexName,
-						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
-	
+/**
+ * @brief Maps a key type (int, double or StringKey) to the node structures and node
+ * capacities used for it, so the tree algorithms can be written once for all three types.
+*/
+template <class T>
+struct NodeTraits;
+
+template <>
+struct NodeTraits<int>{
+	typedef LeafNodeInt Leaf;
+	typedef NonLeafNodeInt NonLeaf;
+	static const int LEAFSIZE = INTARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = INTARRAYNONLEAFSIZE;
+	static const Datatype TYPE = INTEGER;
+};
 
-  /**
-   * BTreeIndex Destructor. 
-	 * End any initialized scan, flush index file, after unpinning any pinned pages, from the buffer manager
-	 * and delete file instance thereby closing the index file.
-	 * Destructor should not throw any exceptions. All exceptions should be caught in here itself. 
-	 * */
-	~BTreeIndex();
+template <>
+struct NodeTraits<double>{
+	typedef LeafNodeDouble Leaf;
+	typedef NonLeafNodeDouble NonLeaf;
+	static const int LEAFSIZE = DOUBLEARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = DOUBLEARRAYNONLEAFSIZE;
+	static const Datatype TYPE = DOUBLE;
+};
 
+template <>
+struct NodeTraits<StringKey>{
+	typedef LeafNodeString Leaf;
+	typedef NonLeafNodeString NonLeaf;
+	static const int LEAFSIZE = STRINGARRAYLEAFSIZE;
+	static const int NONLEAFSIZE = STRINGARRAYNONLEAFSIZE;
+	static const Datatype TYPE = STRING;
+};
 
-  /**
-	 * Insert a new entry using the pair <value,rid>. 
-	 * Start from root to recursively find out the leaf to insert the entry in. The insertion may cause splitting of leaf node.
-	 * This splitting will require addition of new leaf page number entry into the parent non-leaf, which may in-turn get split.
-	 * This may continue all the way upto the root causing the root to get split. If root gets split, metapage needs to be changed accordingly.
-	 * Make sure to unpin pages as soon as you can.
-   * @param key			Key to insert, pointer to integer/double/char string
-   * @param rid			Record ID of a record whose entry is getting inserted into the index.
-	**/
-	const void insertEntry(const void* key, const RecordId rid);
+/**
+ * @brief Returns the key array of a node with fixed-width keys viewed as an array of T.
+ * For STRING nodes the char[][STRINGSIZE] array is viewed as an array of StringKey. The tree nodes are reached
+ * through the leaf and non-leaf accessors below instead, since their STRING keys are variable-length.
+*/
+template <class T, class Node>
+inline T* nodeKeys( Node* node )
+{
+	return reinterpret_cast<T*>( node->keyArray );
+}
 
+/**
+ * @brief Bytes each packed key takes in an INTEGER node whose smallest and largest keys are low and high: the
+ * fewest of 0, 1, 2 or 4 bytes that hold their difference.
+*/
+inline int packedWidth( const int low, const int high )
+{
+	std::uint32_t range = (std::uint32_t)high - (std::uint32_t)low;
+	return range == 0 ? 0 : range <= 0xFF ? 1 : range <= 0xFFFF ? 2 : 4;
+}
 
-  /**
-	 * Begin a filtered scan of the index.  For instance, if the method is called 
-	 * using ("a",GT,"d",LTE) then we should seek all entries with a value 
+/**
+ * @brief Largest difference from the base key that a packed key of width bytes holds.
+*/
+inline std::uint32_t packedMax( const int width )
+{
+	return width == 4 ? 0xFFFFFFFFu : ( 1u << ( 8 * width ) ) - 1;
+}
+
+/**
+ * @brief Key i of the packed keys at keys, width bytes each, stored as their difference from base.
+*/
+inline int packedKey( const unsigned char* keys, const int width, const int base, const int i )
+{
+	std::uint32_t delta = 0;
+	if( width == 1 )
+	{
+		delta = keys[i];
+	}
+	else if( width == 2 )
+	{
+		delta = ( (const std::uint16_t*)keys )[i];
+	}
+	else if( width == 4 )
+	{
+		delta = ( (const std::uint32_t*)keys )[i];
+	}
+	return (int)( (std::uint32_t)base + delta );
+}
+
+/**
+ * @brief Writes the n keys at keys, in key order, to out as packed keys of width bytes, their difference from base.
+*/
+void packKeys( unsigned char* out, const int width, const int base, const int* keys, const int n );
+
+/**
+ * @brief Position of the first of the packed keys [from, count) at keys, width bytes each over base, that is not
+ * less than key. Runs on the packed bytes without decoding them: a binary search narrows the range down to a few
+ * vectors, whose keys below key are then counted with SSE2 compares where the compiler targets it.
+*/
+int packedLowerBound( const unsigned char* keys, const int width, const int base, const int from, const int count, const int key );
+
+/**
+ * @brief Position of the first of the packed keys [from, count) at keys that is greater than key.
+*/
+inline int packedUpperBound( const unsigned char* keys, const int width, const int base, const int from, const int count, const int key )
+{
+	return key == std::numeric_limits<int>::max() ? count : packedLowerBound( keys, width, base, from, count, key + 1 );
+}
+
+/**
+ * @brief Packed keys of an INTEGER leaf, resp. packed separators of an INTEGER non-leaf, at the end of its page.
+*/
+inline const unsigned char* leafKeyBytes( const LeafNodeInt* leaf )
+{
+	return (const unsigned char*)leaf + Page::SIZE - leaf->numEntries * leaf->keyWidth;
+}
+
+inline const unsigned char* nonLeafKeyBytes( const NonLeafNodeInt* node )
+{
+	return (const unsigned char*)node + Page::SIZE - std::max( node->numChildren - 1, 0 ) * node->keyWidth;
+}
+
+/**
+ * @brief Number of entries in a leaf. Leaf slots are filled from the left, an unused slot has rid page number 0.
+*/
+template <class Leaf>
+inline int leafEntryCount( const Leaf* leaf, const int capacity )
+{
+	int low = 0;
+	int high = capacity;
+	while( low < high )
+	{
+		int mid = ( low + high ) / 2;
+		if( leaf->ridArray[mid].page_number != Page::INVALID_NUMBER )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+inline int leafEntryCount( const LeafNodeInt* leaf, const int capacity )
+{
+	return leaf->numEntries;
+}
+
+inline int leafEntryCount( const LeafNodeString* leaf, const int capacity )
+{
+	return leaf->numEntries;
+}
+
+/**
+ * @brief True if a leaf holds an entry at position i. Used to walk a leaf without counting its entries first.
+*/
+template <class Leaf>
+inline bool leafHasEntry( const Leaf* leaf, const int i, const int capacity )
+{
+	return i < capacity && leaf->ridArray[i].page_number != Page::INVALID_NUMBER;
+}
+
+inline bool leafHasEntry( const LeafNodeInt* leaf, const int i, const int capacity )
+{
+	return i < leaf->numEntries;
+}
+
+inline bool leafHasEntry( const LeafNodeString* leaf, const int i, const int capacity )
+{
+	return i < leaf->numEntries;
+}
+
+/**
+ * @brief Key of entry i of a leaf. The INTEGER leaf unpacks the key, the STRING leaf copies the key out of the
+ * page and pads it with '\0'.
+*/
+inline int leafKey( const LeafNodeInt* leaf, const int i )
+{
+	return packedKey( leafKeyBytes( leaf ), leaf->keyWidth, leaf->baseKey, i );
+}
+
+inline double leafKey( const LeafNodeDouble* leaf, const int i )
+{
+	return leaf->keyArray[i];
+}
+
+inline StringKey leafKey( const LeafNodeString* leaf, const int i )
+{
+	StringKey k;
+	const StringSlot& slot = leaf->slotArray[i];
+	int length = leaf->prefixLength + slot.keyLength;
+	memcpy( k.data, (const char*)leaf + leaf->prefixOffset, leaf->prefixLength );
+	memcpy( k.data + leaf->prefixLength, (const char*)leaf + slot.keyOffset, slot.keyLength );
+	memset( k.data + length, 0, STRINGSIZE - length );
+	return k;
+}
+
+/**
+ * @brief RecordId of entry i of a leaf.
+*/
+template <class Leaf>
+inline RecordId& leafRid( Leaf* leaf, const int i )
+{
+	return leaf->ridArray[i];
+}
+
+inline RecordId& leafRid( LeafNodeString* leaf, const int i )
+{
+	return leaf->slotArray[i].rid;
+}
+
+/**
+ * @brief Compares the prefix of a STRING leaf with the first bytes of the length bytes at key, like memcmp.
+ * 0 if key starts with the prefix, otherwise the order of every key of the leaf relative to key.
+*/
+inline int compareLeafPrefix( const LeafNodeString* leaf, const char* key, const int length )
+{
+	int c = memcmp( (const char*)leaf + leaf->prefixOffset, key, std::min<int>( leaf->prefixLength, length ) );
+	return c != 0 ? c : ( length < leaf->prefixLength ? 1 : 0 );
+}
+
+/**
+ * @brief Compares the key of entry i of a STRING leaf, past the prefix, with the length bytes at suffix, like memcmp.
+ * A key that is a prefix of the other is the smaller one, as with the '\0' padded StringKey.
+*/
+inline int compareLeafSuffix( const LeafNodeString* leaf, const int i, const char* suffix, const int length )
+{
+	const StringSlot& slot = leaf->slotArray[i];
+	int c = memcmp( (const char*)leaf + slot.keyOffset, suffix, std::min<int>( slot.keyLength, length ) );
+	return c != 0 ? c : slot.keyLength - length;
+}
+
+/**
+ * @brief Position of the first entry among [from, count) of a leaf whose key is not less than key,
+ * resp. greater than key for leafUpperBound(). The INTEGER and STRING leaves compare in place, without
+ * copying keys out.
+*/
+template <class Leaf, class T>
+inline int leafLowerBound( const Leaf* leaf, const int from, const int count, const T& key )
+{
+	return std::lower_bound( leaf->keyArray + from, leaf->keyArray + count, key ) - leaf->keyArray;
+}
+
+template <class Leaf, class T>
+inline int leafUpperBound( const Leaf* leaf, const int from, const int count, const T& key )
+{
+	return std::upper_bound( leaf->keyArray + from, leaf->keyArray + count, key ) - leaf->keyArray;
+}
+
+inline int leafLowerBound( const LeafNodeInt* leaf, const int from, const int count, const int& key )
+{
+	return packedLowerBound( leafKeyBytes( leaf ), leaf->keyWidth, leaf->baseKey, from, count, key );
+}
+
+inline int leafUpperBound( const LeafNodeInt* leaf, const int from, const int count, const int& key )
+{
+	return packedUpperBound( leafKeyBytes( leaf ), leaf->keyWidth, leaf->baseKey, from, count, key );
+}
+
+inline int leafLowerBound( const LeafNodeString* leaf, const int from, const int count, const StringKey& key )
+{
+	int length = strnlen( key.data, STRINGSIZE );
+	//The prefix is compared once, a key without it goes before or after every entry
+	int c = compareLeafPrefix( leaf, key.data, length );
+	if( c != 0 )
+	{
+		return c > 0 ? from : count;
+	}
+	const char* suffix = key.data + leaf->prefixLength;
+	length -= leaf->prefixLength;
+	int low = from;
+	int high = count;
+	while( low < high )
+	{
+		int mid = ( low + high ) / 2;
+		if( compareLeafSuffix( leaf, mid, suffix, length ) < 0 )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+inline int leafUpperBound( const LeafNodeString* leaf, const int from, const int count, const StringKey& key )
+{
+	int length = strnlen( key.data, STRINGSIZE );
+	//The prefix is compared once, a key without it goes before or after every entry
+	int c = compareLeafPrefix( leaf, key.data, length );
+	if( c != 0 )
+	{
+		return c > 0 ? from : count;
+	}
+	const char* suffix = key.data + leaf->prefixLength;
+	length -= leaf->prefixLength;
+	int low = from;
+	int high = count;
+	while( low < high )
+	{
+		int mid = ( low + high ) / 2;
+		if( compareLeafSuffix( leaf, mid, suffix, length ) <= 0 )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/**
+ * @brief Inserts an entry at position pos of a leaf holding count entries, shifting the later entries right.
+ * @return false, leaving the leaf as it was, if the entry does not fit: the fixed-width leaves are full at
+ * capacity entries, the INTEGER and STRING leaves once their RecordIds or slots would run into their key bytes.
+ * An INTEGER key outside the range the packed keys of the leaf cover, or a STRING key that does not start with
+ * the prefix of the leaf, or one that finds no room, makes the leaf be laid out again with leafFill().
+*/
+template <class Leaf, class T>
+inline bool leafInsert( Leaf* leaf, const int count, const int capacity, const int pos, const T& key, const RecordId& rid )
+{
+	if( count >= capacity )
+	{
+		return false;
+	}
+	std::copy_backward( leaf->keyArray + pos, leaf->keyArray + count, leaf->keyArray + count + 1 );
+	std::copy_backward( leaf->ridArray + pos, leaf->ridArray + count, leaf->ridArray + count + 1 );
+	leaf->keyArray[pos] = key;
+	leaf->ridArray[pos] = rid;
+	return true;
+}
+
+bool leafInsert( LeafNodeInt* leaf, const int count, const int capacity, const int pos, const int& key, const RecordId& rid );
+
+bool leafInsert( LeafNodeString* leaf, const int count, const int capacity, const int pos, const StringKey& key, const RecordId& rid );
+
+/**
+ * @brief Fills an empty leaf with n entries in key order, keeping its sibling pointers.
+ * @return false if they do not fit, the leaf then being left as it was.
+*/
+template <class Leaf, class T>
+inline bool leafFill( Leaf* leaf, const T* keys, const RecordId* rids, const int n, const int capacity )
+{
+	if( n > capacity )
+	{
+		return false;
+	}
+	std::copy( keys, keys + n, leaf->keyArray );
+	std::copy( rids, rids + n, leaf->ridArray );
+	return true;
+}
+
+/**
+ * @brief Lays an INTEGER leaf out again from scratch with n entries in key order, their keys packed in the
+ * fewest bytes that hold the difference between the last key and the first.
+*/
+bool leafFill( LeafNodeInt* leaf, const int* keys, const RecordId* rids, const int n, const int capacity );
+
+/**
+ * @brief Lays a STRING leaf out again from scratch with n entries in key order. The longest prefix shared by
+ * all of them is stored once, and the slots point at the rest of each key.
+*/
+bool leafFill( LeafNodeString* leaf, const StringKey* keys, const RecordId* rids, const int n, const int capacity );
+
+/**
+ * @brief Number of the total sorted entries of an overflowing leaf that stay in it on a split, the rest moving
+ * to the new right sibling. Halves the entries, or for STRING keys the bytes the two leaves take with their
+ * prefixes stored once.
+*/
+template <class T>
+inline int leafSplitPoint( const T* keys, const int total )
+{
+	return total / 2;
+}
+
+int leafSplitPoint( const StringKey* keys, const int total );
+
+/**
+ * @brief Number of keys in a non-leaf node, -1 if it has no children. Child slots are filled from the left,
+ * an unused slot has page number 0, and a node with n children holds n - 1 keys.
+*/
+template <class NonLeaf>
+inline int nonLeafKeyCount( const NonLeaf* node, const int capacity )
+{
+	int low = 0;
+	int high = capacity + 1;
+	while( low < high )
+	{
+		int mid = ( low + high ) / 2;
+		if( node->pageNoArray[mid] != Page::INVALID_NUMBER )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low - 1;
+}
+
+inline int nonLeafKeyCount( const NonLeafNodeInt* node, const int capacity )
+{
+	return node->numChildren - 1;
+}
+
+inline int nonLeafKeyCount( const NonLeafNodeString* node, const int capacity )
+{
+	return node->numChildren - 1;
+}
+
+/**
+ * @brief Page number of child i of a non-leaf node.
+*/
+template <class NonLeaf>
+inline PageId& childPage( NonLeaf* node, const int i )
+{
+	return node->pageNoArray[i];
+}
+
+inline PageId& childPage( NonLeafNodeInt* node, const int i )
+{
+	return node->childArray[i].pageNo;
+}
+
+inline PageId& childPage( NonLeafNodeString* node, const int i )
+{
+	return i == 0 ? node->firstPageNo : node->slotArray[i - 1].pageNo;
+}
+
+/**
+ * @brief Number of entries in the subtree under child i of a non-leaf node, kept only when IndexMetaInfo::countsKept is set.
+*/
+template <class NonLeaf>
+inline std::uint32_t& childCount( NonLeaf* node, const int i )
+{
+	return node->countArray[i];
+}
+
+inline std::uint32_t& childCount( NonLeafNodeInt* node, const int i )
+{
+	return node->childArray[i].count;
+}
+
+inline std::uint32_t& childCount( NonLeafNodeString* node, const int i )
+{
+	return i == 0 ? node->firstCount : node->slotArray[i - 1].count;
+}
+
+/**
+ * @brief Appends the page numbers of children [from, to) of a non-leaf node to pages, a vector or a deque.
+*/
+template <class NonLeaf, class Pages>
+inline void appendChildren( NonLeaf* node, const int from, const int to, Pages& pages )
+{
+	for( int i = from; i < to; i++ )
+	{
+		pages.push_back( childPage( node, i ) );
+	}
+}
+
+/**
+ * @brief Separator key i of a non-leaf node. The INTEGER node unpacks the key, the STRING node copies the key out
+ * of the page and pads it with '\0'.
+*/
+inline int nonLeafKey( const NonLeafNodeInt* node, const int i )
+{
+	return packedKey( nonLeafKeyBytes( node ), node->keyWidth, node->baseKey, i );
+}
+
+inline double nonLeafKey( const NonLeafNodeDouble* node, const int i )
+{
+	return node->keyArray[i];
+}
+
+inline StringKey nonLeafKey( const NonLeafNodeString* node, const int i )
+{
+	StringKey k;
+	const NonLeafSlot& slot = node->slotArray[i];
+	memcpy( k.data, (const char*)node + slot.keyOffset, slot.keyLength );
+	memset( k.data + slot.keyLength, 0, STRINGSIZE - slot.keyLength );
+	return k;
+}
+
+/**
+ * @brief Compares separator i of a STRING non-leaf with the length bytes at key, like compareLeafSuffix().
+*/
+inline int compareNonLeafKey( const NonLeafNodeString* node, const int i, const char* key, const int length )
+{
+	const NonLeafSlot& slot = node->slotArray[i];
+	int c = memcmp( (const char*)node + slot.keyOffset, key, std::min<int>( slot.keyLength, length ) );
+	return c != 0 ? c : slot.keyLength - length;
+}
+
+/**
+ * @brief Index of the first of the count separators of a non-leaf node that is not less than key, resp. greater
+ * than key for nonLeafUpperBound(), which is also the index of the child to follow. The INTEGER and STRING nodes
+ * compare in place.
+*/
+template <class NonLeaf, class T>
+inline int nonLeafLowerBound( const NonLeaf* node, const int count, const T& key )
+{
+	return std::lower_bound( node->keyArray, node->keyArray + count, key ) - node->keyArray;
+}
+
+template <class NonLeaf, class T>
+inline int nonLeafUpperBound( const NonLeaf* node, const int count, const T& key )
+{
+	return std::upper_bound( node->keyArray, node->keyArray + count, key ) - node->keyArray;
+}
+
+inline int nonLeafLowerBound( const NonLeafNodeInt* node, const int count, const int& key )
+{
+	return packedLowerBound( nonLeafKeyBytes( node ), node->keyWidth, node->baseKey, 0, count, key );
+}
+
+inline int nonLeafUpperBound( const NonLeafNodeInt* node, const int count, const int& key )
+{
+	return packedUpperBound( nonLeafKeyBytes( node ), node->keyWidth, node->baseKey, 0, count, key );
+}
+
+inline int nonLeafLowerBound( const NonLeafNodeString* node, const int count, const StringKey& key )
+{
+	int length = strnlen( key.data, STRINGSIZE );
+	int low = 0;
+	int high = count;
+	while( low < high )
+	{
+		int mid = ( low + high ) / 2;
+		if( compareNonLeafKey( node, mid, key.data, length ) < 0 )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+inline int nonLeafUpperBound( const NonLeafNodeString* node, const int count, const StringKey& key )
+{
+	int length = strnlen( key.data, STRINGSIZE );
+	int low = 0;
+	int high = count;
+	while( low < high )
+	{
+		int mid = ( low + high ) / 2;
+		if( compareNonLeafKey( node, mid, key.data, length ) <= 0 )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/**
+ * @brief Inserts separator key at index i of a non-leaf node holding count separators, with child pageNo right
+ * after it, shifting the later separators and children right. The subtree count of the new child is 0.
+ * @return false, leaving the node as it was, if there is no room: the fixed-width nodes are full at capacity
+ * separators, the INTEGER and STRING nodes once their children or slots would run into their key bytes.
+*/
+template <class NonLeaf, class T>
+inline bool nonLeafInsert( NonLeaf* node, const int count, const int capacity, const int i, const T& key, const PageId pageNo )
+{
+	if( count >= capacity )
+	{
+		return false;
+	}
+	std::copy_backward( node->keyArray + i, node->keyArray + count, node->keyArray + count + 1 );
+	std::copy_backward( node->pageNoArray + i + 1, node->pageNoArray + count + 1, node->pageNoArray + count + 2 );
+	std::copy_backward( node->countArray + i + 1, node->countArray + count + 1, node->countArray + count + 2 );
+	node->keyArray[i] = key;
+	node->pageNoArray[i + 1] = pageNo;
+	node->countArray[i + 1] = 0;
+	return true;
+}
+
+bool nonLeafInsert( NonLeafNodeInt* node, const int count, const int capacity, const int i, const int& key, const PageId pageNo );
+
+bool nonLeafInsert( NonLeafNodeString* node, const int count, const int capacity, const int i, const StringKey& key, const PageId pageNo );
+
+/**
+ * @brief Fills a non-leaf node that has no children with n separators and the n + 1 children and subtree counts
+ * around them, keeping its level.
+ * @return false if they do not fit, the node then being left as it was.
+*/
+template <class NonLeaf, class T>
+inline bool nonLeafFill( NonLeaf* node, const T* keys, const PageId* pages, const std::uint32_t* counts, const int n, const int capacity )
+{
+	if( n > capacity )
+	{
+		return false;
+	}
+	std::copy( keys, keys + n, node->keyArray );
+	std::copy( pages, pages + n + 1, node->pageNoArray );
+	std::copy( counts, counts + n + 1, node->countArray );
+	return true;
+}
+
+bool nonLeafFill( NonLeafNodeInt* node, const int* keys, const PageId* pages, const std::uint32_t* counts, const int n, const int capacity );
+
+bool nonLeafFill( NonLeafNodeString* node, const StringKey* keys, const PageId* pages, const std::uint32_t* counts, const int n, const int capacity );
+
+/**
+ * @brief True if a non-leaf node has room for n separators.
+*/
+template <class T>
+inline bool nonLeafFits( const T* keys, const int n, const int capacity )
+{
+	return n <= capacity;
+}
+
+bool nonLeafFits( const int* keys, const int n, const int capacity );
+
+bool nonLeafFits( const StringKey* keys, const int n, const int capacity );
+
+/**
+ * @brief Index of the separator pushed up when a non-leaf node overflows with total separators. The ones before
+ * it stay in the node, the ones after it move to the new right sibling. Halves the separators, or for STRING keys
+ * the bytes the two nodes take.
+*/
+template <class T>
+inline int nonLeafSplitPoint( const T* keys, const int total )
+{
+	return total / 2;
+}
+
+int nonLeafSplitPoint( const StringKey* keys, const int total );
+
+/**
+ * @brief Key to put in the parent between two leaves whose last and first keys are left and right: any key
+ * not less than left and not greater than right does. A STRING separator is cut right after the first byte in
+ * which right differs from left, which is all it takes to tell them apart.
+*/
+template <class T>
+inline T separatorKey( const T& left, const T& right )
+{
+	return right;
+}
+
+inline StringKey separatorKey( const StringKey& left, const StringKey& right )
+{
+	int i = 0;
+	while( i < STRINGSIZE && left.data[i] == right.data[i] && right.data[i] != '\0' )
+	{
+		i++;
+	}
+	StringKey k;
+	int length = std::min( i + 1, STRINGSIZE );
+	memcpy( k.data, right.data, length );
+	memset( k.data + length, 0, STRINGSIZE - length );
+	return k;
+}
+
+/**
+ * @brief Converts a key passed through the void* API (pointer to integer / double / char string)
+ * into the key type stored in the nodes.
+ * @throws BadIndexInfoException If a char string is longer than STRINGSIZE bytes.
+*/
+template <class T>
+inline T keyFromPtr( const void* key )
+{
+	return *(const T*)key;
+}
+
+template <>
+inline StringKey keyFromPtr<StringKey>( const void* key )
+{
+	//a longer key cut to STRINGSIZE bytes would compare equal to other keys sharing those bytes
+	if( strnlen( (const char*)key, STRINGSIZE + 1 ) > (size_t)STRINGSIZE )
+	{
+		throw BadIndexInfoException( "STRING key longer than STRINGSIZE" );
+	}
+	StringKey k;
+	strncpy( k.data, (const char*)key, STRINGSIZE );
+	return k;
+}
+
+/**
+ * @brief Bytes of the normalized form of a key, see normalizeKey().
+*/
+template <class T>
+inline int normalizedSize()
+{
+	return sizeof( T );
+}
+
+template <>
+inline int normalizedSize<StringKey>()
+{
+	return STRINGSIZE;
+}
+
+/**
+ * @brief Writes key in its normalized form to out, normalizedSize() bytes whose memcmp order is the order of
+ * the keys, so one comparison serves every key type. INTEGER is stored big-endian with the sign bit flipped.
+ * DOUBLE is stored big-endian with the sign bit flipped for positive numbers and every bit flipped for negative
+ * ones, -0.0 being taken as 0.0. STRING is the key itself, already padded with '\0'.
+*/
+inline void normalizeKey( const int key, unsigned char* out )
+{
+	std::uint32_t bits = (std::uint32_t)key ^ 0x80000000u;
+	for( int i = 0; i < 4; i++ )
+	{
+		out[i] = bits >> ( 24 - 8 * i );
+	}
+}
+
+inline void normalizeKey( const double key, unsigned char* out )
+{
+	double value = key == 0.0 ? 0.0 : key;
+	std::uint64_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	bits = ( bits >> 63 ) ? ~bits : bits ^ 0x8000000000000000ull;
+	for( int i = 0; i < 8; i++ )
+	{
+		out[i] = bits >> ( 56 - 8 * i );
+	}
+}
+
+inline void normalizeKey( const StringKey& key, unsigned char* out )
+{
+	memcpy( out, key.data, STRINGSIZE );
+}
+
+/**
+ * @brief Writes the value of a column of a composite key, a pointer to integer / double / char string, to out in a
+ * form whose memcmp order is the order of the values and which holds neither '\0' nor PASTPREFIX, so the encoded
+ * columns of a key can follow one another in a STRING key and be compared as one. INTEGER and DOUBLE are their
+ * normalizeKey() bytes 7 bits at a time, plus 1: 5 and 10 bytes. STRING is its bytes plus 1, the three highest
+ * ones taking two bytes, closed by 0x01 so that a string sorts before the longer ones it starts.
+ * @return the number of bytes written, at most 2 * STRINGSIZE + 1
+*/
+int encodeKeyColumn( const void* value, const Datatype type, unsigned char* out );
+
+/**
+ * @brief Reads back a column written by encodeKeyColumn() to out, an integer / double / char string. A STRING is
+ * followed by a '\0' when shorter than STRINGSIZE.
+ * @return the number of bytes read from in
+*/
+int decodeKeyColumn( const unsigned char* in, const Datatype type, void* out );
+
+/**
+ * @brief Order of RecordIds in the relation, (page_number, slot_number).
+*/
+inline bool ridBefore( const RecordId& a, const RecordId& b )
+{
+	return a.page_number < b.page_number
+		|| ( a.page_number == b.page_number && a.slot_number < b.slot_number );
+}
+
+/**
+ * @brief True if rid is the RecordId of a leaf entry holding a posting list.
+*/
+inline bool isPostingRid( const RecordId& rid )
+{
+	return rid.slot_number == POSTINGSLOT;
+}
+
+/**
+ * @brief Appends rid, which must not come before page->lastRid if the page holds any, to a posting list page.
+ * Returns false if the page has no room left for it.
+*/
+bool postingAppend( PostingPage* page, const RecordId& rid );
+
+/**
+ * @brief Appends the RecordIds of a posting list page to rids.
+*/
+void postingDecode( const PostingPage* page, std::vector<RecordId>& rids );
+
+/**
+ * @brief Replaces the contents of rids with the RecordIds of the posting list whose first page is headPageNo.
+*/
+void readPosting( BufMgr* bufMgr, File* file, const PageId headPageNo, std::vector<RecordId>& rids );
+
+/**
+ * @brief One range of a multi-range scan, see BTreeIndex::startMultiRangeScan().
+ * The values point at integer / double / char string keys, as for BTreeIndex::startScan().
+ * An IN-list entry v is the range (v,GTE,v,LTE).
+*/
+struct ScanRange{
+  /**
+   * Low value of range and low operator (GT/GTE).
+   */
+	const void* lowVal;
+	Operator lowOp;
+
+  /**
+   * High value of range and high operator (LT/LTE).
+   */
+	const void* highVal;
+	Operator highOp;
+};
+
+/**
+ * @brief Bounds of a key range, one still to be scanned by a multi-range scan or one produced by
+ * BTreeIndex::partitionRange(). The keys are kept as the raw bytes of the key type stored in the nodes,
+ * since the caller's values may not outlive the call.
+*/
+struct ScanBounds{
+	std::string lowKey;
+	Operator lowOp;
+	std::string highKey;
+	Operator highOp;
+};
+
+/**
+ * @brief Shape of one level of the tree, filled in by BTreeIndex::collectStats().
+*/
+struct IndexLevelStats{
+  /**
+   * Number of nodes on the level.
+   */
+	int numNodes;
+
+  /**
+   * Entries held by the nodes on the level: RecordIds for leaves, child pointers for non-leaves.
+   */
+	std::uint64_t numEntries;
+
+  /**
+   * Fewest and most entries held by a node on the level.
+   */
+	int minEntries;
+	int maxEntries;
+
+  /**
+   * Average fill of the nodes, numEntries over the capacity of all of them.
+   */
+	double fill;
+
+  /**
+   * Number of nodes filled 0-10%, 10-20%, ... 90-100%.
+   */
+	int fillHistogram[ 10 ];
+};
+
+/**
+ * @brief Structural statistics of a B+ Tree index, filled in by BTreeIndex::collectStats().
+ * toJson() gives them as a single JSON object.
+*/
+struct IndexStats{
+  /**
+   * Number of levels including the leaves.
+   */
+	int height;
+
+  /**
+   * Number of entries in the index, counting every RecordId of a posting list.
+   */
+	std::uint64_t numEntries;
+
+  /**
+   * Pages used by leaves, by non-leaves and sitting on the free list. The meta page is not counted.
+   */
+	int numLeafPages;
+	int numNonLeafPages;
+	int numFreePages;
+
+  /**
+   * Pages holding the RecordIds of posting lists, and how many leaf entries point at such a list.
+   */
+	int numPostingPages;
+	int numPostingLists;
+
+  /**
+   * Node splits since the index was created.
+   */
+	std::uint64_t numSplits;
+
+  /**
+   * Steps along the leaf chain that do not go to the next page of the file, and how many
+   * of those go back to an earlier page. Both are 0 right after compact().
+   */
+	int leafChainBreaks;
+	int leafChainBackward;
+
+  /**
+   * Smallest and largest key in the index, empty if it has no entries.
+   */
+	std::string minKey;
+	std::string maxKey;
+
+  /**
+   * One entry per level, levels[0] being the leaves and the last one the root.
+   */
+	std::vector<IndexLevelStats> levels;
+
+  /**
+   * Returns the statistics as a JSON object.
+   */
+	std::string toJson() const;
+};
+
+/**
+ * @brief Key statistics kept in the meta page, returned by BTreeIndex::getKeyHistogram().
+ * Unlike IndexStats they are kept up to date by every insert and cost one page read to fetch.
+*/
+struct KeyHistogram{
+  /**
+   * Number of entries and number of levels including the leaves.
+   */
+	std::uint64_t numEntries;
+	int height;
+
+  /**
+   * Smallest and largest key, empty if the index has no entries.
+   */
+	std::string minKey;
+	std::string maxKey;
+
+  /**
+   * Smallest key and number of entries of each bucket, in key order.
+   */
+	std::vector<std::string> bucketKeys;
+	std::vector<std::uint64_t> bucketCounts;
+};
+
+/**
+ * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
+ * relation. This index supports only one scan at a time.
+*/
+class BTreeIndex {
+
+ private:
+
+  /**
+   * File object for the index file.
+   */
+	File		*file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+	BufMgr	*bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+	PageId	headerPageNum;
+
+  /**
+   * page number of root page of B+ tree inside index file.
+   */
+	PageId	rootPageNum;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+	Datatype	attributeType;
+
+  /**
+   * Offset of attribute, over which index is built, inside records. 
+   */
+	int 		attrByteOffset;
+
+  /**
+   * Columns of the key of a composite index, empty for an index over a single attribute.
+   */
+	std::vector<KeyColumn>	keyColumns;
+
+  /**
+   * Columns copied into the entries of a covering composite index after keyColumns, empty if none.
+   */
+	std::vector<KeyColumn>	includeColumns;
+
+  /**
+   * Head of the free page list, mirrors IndexMetaInfo::freePageNo.
+   */
+	PageId	freePageNum;
+
+  /**
+   * True if the index is memory resident: its pages are heap objects reached through residentPages instead of
+   * being pinned in the buffer pool, and the index file is only written by flush() and the destructor.
+   */
+	bool		resident;
+
+  /**
+   * Pages of a memory resident index by page number, entry 0 unused. The first residentImage.size() point into
+   * residentImage, the pages read from the file when it was opened; the ones allocated since are owned here.
+   */
+	std::vector<Page*>	residentPages;
+	std::vector<Page>	residentImage;
+
+  /**
+   * Node splits so far, mirrors IndexMetaInfo::numSplits.
+   */
+	std::uint64_t	numSplits;
+
+  /**
+   * True if non-leaf nodes keep subtree entry counts, mirrors IndexMetaInfo::countsKept.
+   */
+	bool		countsKept;
+
+  /**
+   * Set once an insert has made one histogram bucket much deeper than the others.
+   * The histogram is rebuilt at the next split, or the next insert into a posting list.
+   */
+	bool		histogramStale;
+
+  /**
+   * Set by an insert whose RecordId went to a posting list.
+   */
+	bool		postingGrown;
+
+  /**
+   * Pages of a tree replaced by compact() while a scan was still reading it.
+   * They go on the free list once the scan ends.
+   */
+	std::vector<PageId>	retiredPages;
+
+  /**
+   * Number of keys in leaf node, depending upon the type of key.
+   */
+	int			leafOccupancy;
+
+  /**
+   * Number of keys in non-leaf node, depending upon the type of key.
+   */
+	int			nodeOccupancy;
+
+
+	// MEMBERS SPECIFIC TO SCANNING
+
+  /**
+   * True if an index scan has been started.
+   */
+	bool		scanExecuting;
+
+  /**
+   * Index of next entry to be scanned in current leaf being scanned.
+   */
+	int			nextEntry;
+
+  /**
+   * Page number of current page being scanned.
+   */
+	PageId	currentPageNum;
+
+  /**
+   * Current Page being scanned.
+   */
+	Page		*currentPageData;
+
+  /**
+   * Low INTEGER value for scan.
+   */
+	int			lowValInt;
+
+  /**
+   * Low DOUBLE value for scan.
+   */
+	double	lowValDouble;
+
+  /**
+   * Low STRING value for scan.
+   */
+	std::string	lowValString;
+
+  /**
+   * High INTEGER value for scan.
+   */
+	int			highValInt;
+
+  /**
+   * High DOUBLE value for scan.
+   */
+	double	highValDouble;
+
+  /**
+   * High STRING value for scan.
+   */
+	std::string highValString;
+	
+  /**
+   * Low Operator. Can only be GT(>) or GTE(>=).
+   */
+	Operator	lowOp;
+
+  /**
+   * High Operator. Can only be LT(<) or LTE(<=).
+   */
+	Operator	highOp;
+
+  /**
+   * Ranges of a multi-range scan, sorted and merged, and the index of the next one to start.
+   * Empty for a scan started with startScan().
+   */
+	std::vector<ScanBounds>	scanRanges;
+	size_t	nextRange;
+
+  /**
+   * Non-leaf pages on the way from the root to the current leaf, root first. A multi-range scan
+   * descends again from the deepest of them that still covers the next range instead of from the root.
+   */
+	std::vector<PageId>	scanPath;
+
+  /**
+   * True once the current scan has returned an entry, which is then the entry right before nextEntry.
+   */
+	bool		scanReturnedEntry;
+
+  /**
+   * Direction of the current scan. A BACKWARD scan returns the entry at nextEntry and then moves left.
+   */
+	ScanDirection	scanDirection;
+
+  /**
+   * Number of entries the current scan may still return, -1 if it has no limit.
+   */
+	int			scanRemaining;
+
+  /**
+   * RecordIds of the posting list at nextEntry while the scan is returning them, and the index of the next one
+   * to return, or one past it for a BACKWARD scan. Empty while the scan is between entries.
+   */
+	std::vector<RecordId>	postingRids;
+	size_t	postingNext;
+
+
+	// TYPED HELPERS, instantiated for int, double and StringKey
+
+  /**
+   * Reads the page pageNo of the index file, pinning it in the buffer pool unless the index is resident.
+   */
+	void readNode(const PageId pageNo, Page*& page);
+
+  /**
+   * Unpins the page pageNo read by readNode(), nothing to do if the index is resident.
+   */
+	void unPinNode(const PageId pageNo, const bool dirty);
+
+  /**
+   * Replaces the contents of rids with the RecordIds of the posting list whose first page is headPageNo,
+   * read through readNode().
+   */
+	void readPostingRids(const PageId headPageNo, std::vector<RecordId>& rids);
+
+  /**
+   * Reads every page of the index file into residentImage with a single read.
+   */
+	void loadResident();
+
+  /**
+   * Drops the pages of the index: frees them if the index is resident, flushes them from the buffer pool otherwise.
+   */
+	void releaseNodes();
+
+  /**
+   * Allocates a page in the index file and zeroes it so it can be used as an empty node.
+   * The page is returned pinned.
+   */
+	void allocNode(PageId& pageNo, Page*& page);
+
+  /**
+   * Allocates a zeroed page at the end of the index file, ignoring the free list, so that
+   * consecutive calls return consecutive page numbers. The page is returned pinned.
+   */
+	void appendNode(PageId& pageNo, Page*& page);
+
+  /**
+   * Puts pageNo on the free list.
+   */
+	void freeNode(const PageId pageNo);
+
+  /**
+   * Writes rids, in (page_number, slot_number) order, to a new posting list. Returns its first page.
+   */
+	PageId writePosting(const std::vector<RecordId>& rids);
+
+  /**
+   * Adds rid to the posting list of the leaf entry whose RecordId is entryRid. A rid that sorts after the
+   * whole list is appended to its last page; any other rewrites the list and moves entryRid to the new one.
+   */
+	void postingInsert(RecordId& entryRid, const RecordId& rid);
+
+  /**
+   * Puts every page of the posting list starting at headPageNo on the free list.
+   */
+	void freePosting(const PageId headPageNo);
+
+  /**
+   * Number of RecordIds a leaf entry stands for: the size of its posting list, 1 for a plain entry.
+   */
+	std::uint64_t ridWeight(const RecordId& rid);
+
+  /**
+   * Number of RecordIds the leaf entries [from, to) stand for.
+   */
+	template <class Leaf>
+	std::uint64_t leafWeight(Leaf* leaf, const int from, const int to);
+
+  /**
+   * Checks the posting list starting at headPageNo and appends its pages to pages. Returns its size.
+   * @throws  BadIndexStructureException	On the first problem found.
+   */
+	std::uint64_t verifyPosting(const PageId headPageNo, std::vector<PageId>& pages);
+
+  /**
+   * Sets outRid to the next RecordId of the leaf entry with RecordId entryRid in the direction of the scan.
+   * Returns true once the entry has nothing more to return, which for a plain entry is right away.
+   */
+	bool takeRid(const RecordId& entryRid, RecordId& outRid);
+
+  /**
+   * Index in the current leaf of the entry the scan returned last.
+   */
+	int returnedEntry() const;
+
+  /**
+   * Writes the root page number into the meta page.
+   */
+	void setRootPageNo(const PageId pageNo);
+
+  /**
+   * Writes the head of the free page list into the meta page.
+   */
+	void setFreePageNo(const PageId pageNo);
+
+  /**
+   * Creates the empty tree: a level 1 root with a single empty leaf child.
+   */
+	template <class T>
+	void initTree();
+
+  /**
+   * Inserts entry into the subtree rooted at pageNo. If the node at pageNo had to be split
+   * split is set to true and newChild holds the separator key and page of the new right node,
+   * while leftCount and rightCount hold the number of entries left under the two nodes.
+   */
+	template <class T>
+	void insertRecursive(const PageId pageNo, const bool isLeaf, const RIDKeyPair<T>& entry,
+						bool& split, PageKeyPair<T>& newChild, std::uint32_t& leftCount, std::uint32_t& rightCount);
+
+	template <class T>
+	void insertTyped(const void* key, const RecordId rid);
+
+  /**
+   * Descends from the root to the leftmost leaf that may contain key. Returns the leaf page number.
+   * The non-leaf pages passed on the way are left in scanPath.
+   */
+	template <class T>
+	PageId findLeaf(const T& key);
+
+  /**
+   * Descends from the non-leaf pageNo to the leftmost leaf that may contain key, appending the
+   * non-leaf pages passed to scanPath. With strict set it descends to the leftmost leaf that may
+   * contain a key greater than key instead.
+   */
+	template <class T>
+	PageId descend(const PageId pageNo, const T& key, const bool strict);
+
+  /**
+   * Like findLeaf() for a key not smaller than the one scanPath was built for, but starts from the
+   * deepest page on scanPath whose keys reach key. Any such page lies on the root path of key too.
+   * strict is passed on to descend().
+   */
+	template <class T>
+	PageId seekLeaf(const T& key, const bool strict);
+
+  /**
+   * Makes bounds the bounds of the current scan.
+   */
+	template <class T>
+	void setBounds(const ScanBounds& bounds);
+
+  /**
+   * Moves the scan to the first entry satisfying the low bound of the current scan, staying on the current
+   * leaf if the bound falls inside it. Returns true if that entry also satisfies the high bound.
+   * Returns false with currentPageData NULL if the leaf chain ran out first.
+   */
+	template <class T>
+	bool seekRange();
+
+  /**
+   * Starts the next range of a multi-range scan that has any entry. Returns false if none is left.
+   */
+	template <class T>
+	bool advanceRange();
+
+	template <class T>
+	void startMultiRangeScanTyped(const ScanRange* ranges, const int n);
+
+	template <class T>
+	void nextDistinctKeyTyped(RecordId& outRid, void* outKey);
+
+  /**
+   * Writes the subtree entry counts of every non-leaf node under pageNo. Returns the entry count of the subtree.
+   */
+	template <class T>
+	std::uint64_t computeCounts(const PageId pageNo, const bool isLeaf);
+
+  /**
+   * Number of entries smaller than key, or smaller or equal to it with inclusive set, read off the subtree counts.
+   */
+	template <class T>
+	std::uint64_t rankOf(const T& key, const bool inclusive);
+
+	template <class T>
+	std::uint64_t countRangeTyped(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  /**
+   * Positions the scan on the entry with the given rank, descending by the subtree counts.
+   * Leaves currentPageData NULL if rank is past the last entry.
+   */
+	template <class T>
+	void seekRankTyped(const std::uint64_t rank);
+
+	template <class T>
+	void seekToRankTyped(const std::uint64_t k);
+
+  /**
+   * Adds key to the entry count, the smallest and largest key and the histogram in meta.
+   */
+	template <class T>
+	void histogramInsert(IndexMetaInfo* meta, const T& key);
+
+  /**
+   * Rebuilds the histogram from the separator keys of the non-leaf nodes, which are the smallest
+   * keys of all leaves but the first, and the number of entries in each leaf. STRING leaves hold
+   * more entries the shorter their keys and the longer their shared prefix, and a posting list
+   * can hold more than all the other leaves, so the buckets are cut by entries rather than by leaves.
+   */
+	template <class T>
+	void rebuildHistogram();
+
+  /**
+   * Appends the separator keys of the subtree under pageNo, in key order, and the number of entries of its leaves.
+   * A leaf holding posting lists is cut into pieces around each of them: the posting list and the entries after
+   * it are counted separately, both as starting at its key, so that the list can get a bucket of its own.
+   */
+	template <class T>
+	void collectSeparators(const PageId pageNo, std::vector<T>& separators, std::vector<std::uint32_t>& leafCounts);
+
+	template <class T>
+	double estimateRangeTyped(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+	template <class T>
+	void getKeyHistogramTyped(KeyHistogram& outHistogram);
+
+	template <class T>
+	void partitionRangeTyped(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+							const int n, std::vector<ScanBounds>& outPartitions);
+
+	template <class T>
+	void startScanTyped();
+
+	template <class T>
+	void scanNextTyped(RecordId& outRid);
+
+  /**
+   * Copies the key of the entry the scan returned last to outKey.
+   */
+	template <class T>
+	void copyReturnedKey(void* outKey);
+
+	template <class T>
+	void startScanBackwardTyped();
+
+	template <class T>
+	void scanPrevTyped(RecordId& outRid);
+
+  /**
+   * Unpins the leaf the scan is on, if any, once the scan has nothing more to return.
+   */
+	void releaseScanPage();
+
+  /**
+   * Low and high value of the current scan as the key type stored in the nodes.
+   */
+	template <class T>
+	T lowKey() const;
+
+	template <class T>
+	T highKey() const;
+
+  /**
+   * Page number of the leftmost leaf, the start of the leaf chain.
+   */
+	template <class T>
+	PageId firstLeaf();
+
+	template <class T>
+	void freezeTyped(const std::string& frozenName);
+
+  /**
+   * Appends the page numbers of every node in the subtree rooted at the non-leaf pageNo to pages.
+   */
+	template <class T>
+	void collectPages(const PageId pageNo, std::vector<PageId>& pages);
+
+	template <class T>
+	void compactTyped();
+
+	template <class T>
+	void collectStatsTyped(IndexStats& stats);
+
+  /**
+   * Checks the subtree rooted at pageNo, whose keys must lie within [low, high] where given.
+   * Appends the leaves it reaches to leaves, in key order, and records the depth they are found at.
+   * Returns the number of entries in the subtree.
+   * @throws  BadIndexStructureException	On the first problem found.
+   */
+	template <class T>
+	std::uint64_t verifyNode(const PageId pageNo, const bool isLeaf, const int depth, const T* low, const T* high,
+					int& leafDepth, std::vector<PageId>& leaves);
+
+	template <class T>
+	void verifyTyped();
+
+  /**
+   * True if key satisfies the low bound of the current scan.
+   */
+	template <class T>
+	bool aboveLow(const T& key) const;
+
+  /**
+   * True if key satisfies the high bound of the current scan.
+   */
+	template <class T>
+	bool belowHigh(const T& key) const;
+
+  /**
+   * Opens the index file, or creates it and inserts an entry for every record of the relation.
+   * Called by the constructors once they have set keyColumns.
+   */
+	void openIndex(const std::string & relationName, const std::string & indexName, BufMgr *bufMgrIn,
+						const int attrByteOffset, const Datatype attrType, const bool resident);
+
+
+ public:
+
+  /**
+   * BTreeIndex Constructor. 
+	 * Check to see if the corresponding index file exists. If so, open the file.
+	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built
+   * @param resident						Keep the whole index in memory, for indexes that fit in RAM. An existing index file is
+   * read in one sequential read; from then on nodes are plain heap pages reached by page number without going
+   * through bufMgrIn, and the file, in the same format, is rewritten only by flush() and the destructor.
+   * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
+   * @throws  BadIndexInfoException     If a STRING value of the relation is longer than STRINGSIZE. No index file is left behind.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType,
+						const bool resident = false);
+
+
+  /**
+   * BTreeIndex Constructor for a composite index, whose key is several attributes compared one after another,
+   * like (tenant_id, timestamp). Entries are ordered by the first column, then by the second among equal first
+   * columns and so on, so a scan can fix a prefix of the columns, see startCompositeScan(). The keys are stored
+   * as STRING keys of the encoded columns, see encodeKeyColumn(). The index file is named after every offset.
+   * With include columns the index is covering: their values are copied into every entry after the key columns,
+   * so scanNextCovered() can return them without reading the relation. They come last in the key, so they only
+   * order entries whose key columns are all equal, and are named after a '+' in the index file name.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param columns							Columns of the key in the order they are compared, 1 to MAXKEYCOLUMNS of them
+   * @param includeColumns			Columns copied into the entries, at most MAXKEYCOLUMNS of them
+   * @throws  BadIndexInfoException     If there are no columns or too many, if the index file already exists with other
+   * columns, or if the encoded key of a record, include columns and all, is longer than COMPOSITEKEYSIZE bytes.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const std::vector<KeyColumn>& columns,
+						const std::vector<KeyColumn>& includeColumns = std::vector<KeyColumn>());
+	
+
+  /**
+   * BTreeIndex Destructor. 
+	 * End any initialized scan, flush index file, after unpinning any pinned pages, from the buffer manager
+	 * and delete file instance thereby closing the index file.
+	 * Destructor should not throw any exceptions. All exceptions should be caught in here itself. 
+	 * */
+	~BTreeIndex();
+
+
+  /**
+	 * Insert a new entry using the pair <value,rid>. 
+	 * Start from root to recursively find out the leaf to insert the entry in. The insertion may cause splitting of leaf node.
+	 * This splitting will require addition of new leaf page number entry into the parent non-leaf, which may in-turn get split.
+	 * This may continue all the way upto the root causing the root to get split. If root gets split, metapage needs to be changed accordingly.
+	 * Make sure to unpin pages as soon as you can.
+   * @param key			Key to insert, pointer to integer/double/char string
+   * @param rid			Record ID of a record whose entry is getting inserted into the index.
+	**/
+	const void insertEntry(const void* key, const RecordId rid);
+
+
+  /**
+	 * Begin a filtered scan of the index.  For instance, if the method is called 
+	 * using ("a",GT,"d",LTE) then we should seek all entries with a value 
 	 * greater than "a" and less than or equal to "d".
 	 * If another scan is already executing, that needs to be ended here.
 	 * Set up all the variables for scan. Start from root to find out the leaf page that contains the first RecordID
@@ -457,6 +2107,74 @@ class BTreeIndex {
 	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
 
 
+  /**
+	 * Encode the values of the first numValues columns of a composite index into a key, for insertEntry() with every
+	 * column or for startScan() and the other scans with any of them. The include columns of a covering index
+	 * follow the key columns, and insertEntry() needs them too.
+   * @param values		Values of the columns, pointers to integer / double / char string
+   * @param numValues	Number of values, at most the number of key and include columns
+   * @return the key, a char string
+   * @throws  BadScanParamException If the index is not composite, there are too many values, or the key is longer
+   * than COMPOSITEKEYSIZE bytes
+	**/
+	std::string compositeKey(const void* const* values, const int numValues) const;
+
+
+  /**
+	 * Begin a scan of a composite index bounded on prefixes of its columns. An entry is in the range if its first
+	 * numLow columns compare to lowValues as lowOp asks, and its first numHigh columns to highValues as highOp asks,
+	 * the columns being compared one after another. For instance ({5}, 1, GTE, {5}, 1, LTE) returns every entry of
+	 * tenant 5 and ({5, t1}, 2, GTE, {5, t2}, 2, LT) the entries of tenant 5 from timestamp t1 up to t2, in key order.
+	 * No values on a side leaves it open. Continue with scanNext() and endScan().
+   * @param lowValues	Values of the first columns for the low bound
+   * @param numLow		Number of low values
+   * @param lowOp			Low operator (GT/GTE)
+   * @param highValues	Values of the first columns for the high bound
+   * @param numHigh		Number of high values
+   * @param highOp		High operator (LT/LTE)
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanParamException If the index is not composite, a side has more values than key columns, or
+   * compositeKey() rejects the values
+   * @throws  BadScanrangeException If the low bound is above the high bound
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	const void startCompositeScan(const void* const* lowValues, const int numLow, const Operator lowOp,
+						const void* const* highValues, const int numHigh, const Operator highOp);
+
+
+  /**
+	 * Begin a filtered scan of the index in the given direction that ends after at most limit entries.
+	 * A BACKWARD scan starts at the last entry satisfying the high bound and follows the left sibling links,
+	 * so "last N" queries read only the leaves holding those N entries.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @param direction	FORWARD for ascending, BACKWARD for descending key order
+   * @param limit		Maximum number of entries scanNext() returns, 0 or less for no limit
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+						const ScanDirection direction, const int limit);
+
+
+  /**
+	 * Begin a scan of the union of several ranges, returning each matching entry once and in key order.
+	 * The ranges are sorted and overlapping ones merged. Each range continues from the position the previous
+	 * one stopped at: on the same leaf if it starts there, otherwise by descending from the lowest non-leaf
+	 * node on the current path that covers it, so a long IN-list costs about one pass over the leaves it touches.
+	 * If another scan is already executing, that needs to be ended here. Continue with scanNext() and endScan().
+   * @param ranges	Ranges to scan
+   * @param n				Number of ranges
+   * @throws  BadOpcodesException If any range has an operator other than GT/GTE for low or LT/LTE for high
+   * @throws  BadScanrangeException If any range has lowVal > highVal
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies any range.
+	**/
+	const void startMultiRangeScan(const ScanRange* ranges, const int n);
+
+
   /**
 	 * Fetch the record id of the next index entry that matches the scan.
 	 * Return the next record from current page being scanned. If current page has been scanned to its entirety, move on to the right sibling of current page, if any exists, to start scanning that page. Make sure to unpin any pages that are no longer required.
@@ -467,11 +2185,187 @@ class BTreeIndex {
 	const void scanNext(RecordId& outRid);  // returned record id
 
 
+  /**
+	 * Fetch the record id and the key of the next index entry that matches the scan, see scanNext().
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+   * @param outKey	The key is copied here: an integer, a double or STRINGSIZE chars not necessarily null terminated
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNext(RecordId& outRid, void* outKey);
+
+
+  /**
+	 * Fetch the record id of the next entry of a composite index that matches the scan, see scanNext(), and write
+	 * the value of each key and include column to outRecord at its attribute byte offset. The values come from the
+	 * index entry, so a query needing only these columns never reads the relation. Other bytes are left alone.
+   * @param outRid			RecordId of next record found that satisfies the scan criteria returned in this
+   * @param outRecord	Record the columns are written to
+	 * @throws BadScanParamException If the index is not composite.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNextCovered(RecordId& outRid, void* outRecord);
+
+
+  /**
+	 * Fetch the record id of the first entry of the scan whose key is greater than the key of the entry returned last,
+	 * skipping its remaining duplicates, or the first entry of the scan if none has been returned yet.
+	 * Duplicates ending in the current leaf or its right sibling are skipped there; longer runs are skipped by
+	 * descending through the non-leaf separators, so enumerating the distinct keys of a range costs
+	 * O(distinct keys x height) page reads rather than O(entries). scanNext() can be mixed in to read the rest of a group.
+   * @param outRid	RecordId of the first entry with the next distinct key returned in this
+   * @param outKey	If not NULL, the key is copied here: an integer, a double or STRINGSIZE chars not necessarily null terminated
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadScanParamException If the scan runs BACKWARD.
+	 * @throws IndexScanCompletedException If no larger key satisfying the scan criteria is left.
+	**/
+	const void nextDistinctKey(RecordId& outRid, void* outKey);
+
+
   /**
 	 * Terminate the current scan. Unpin any pinned pages. Reset scan specific variables.
 	 * @throws ScanNotInitializedException If no scan has been initialized.
 	**/
 	const void endScan();
+
+
+  /**
+	 * Write a read only snapshot of the index to a new file, see FrozenIndex.
+	 * Walks the leaf chain once and packs every entry in key order with no free space. The
+	 * snapshot is independent of this index; later inserts are not reflected in it.
+   * @param outFrozenName	Return the name of the frozen index file, the index file name with ".frozen" appended.
+	**/
+	const void freeze(std::string & outFrozenName);
+
+
+  /**
+	 * Rebuild the tree with full nodes and its leaves on consecutive pages in key order.
+	 * The new tree is written to fresh pages at the end of the file while the old one stays intact,
+	 * then the root page number in the meta page is switched over in one write. A scan executing
+	 * across the call keeps reading the old leaves; they are only put on the free list once it ends.
+	**/
+	const void compact();
+
+
+  /**
+	 * Walk the whole tree and the leaf chain and report its shape: height, nodes and fill per level,
+	 * entry count, key range, free pages, splits and how far the leaf chain is from physical page order.
+	 * Reads every page of the index once; pages are unpinned as soon as they are read.
+   * @param outStats	Statistics returned in this
+	**/
+	const void collectStats(IndexStats & outStats);
+
+
+  /**
+	 * Check the structure of the tree: keys sorted within each node and within the bounds set by
+	 * the parent, leaves packed from the left and all at the same depth, the leaf chain visiting
+	 * the leaves in key order in both directions, the free list sharing no page with the tree, and
+	 * every subtree count matching its subtree when counts are kept.
+	 * @throws  BadIndexStructureException	Describing the first problem found.
+	**/
+	const void verify();
+
+
+  /**
+	 * Start keeping the number of entries under every child of every non-leaf node. The counts are computed
+	 * once by walking the tree and from then on kept up to date by inserts, splits and compact(); the choice is
+	 * stored in the meta page. Counting costs every insert a write to each non-leaf node on its path.
+	**/
+	const void enableCounts();
+
+
+  /**
+	 * Count the entries in a range in O(height) page reads, by descending to both ends of the range and adding up
+	 * the subtree counts to their left.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   * @throws  BadIndexInfoException If enableCounts() has not been called on the index.
+	**/
+	std::uint64_t countRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+
+  /**
+	 * Skip the current scan to its k-th entry, counting from 0 in the direction of the scan, so that scanNext()
+	 * returns it next. This is OFFSET k in O(height) page reads. The limit of the scan is not changed.
+   * @param k				Number of entries of the scan to skip from its start
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws BadScanParamException If the scan is a multi-range scan.
+   * @throws  BadIndexInfoException If enableCounts() has not been called on the index.
+	**/
+	const void seekToRank(const std::uint64_t k);
+
+
+  /**
+	 * Estimate the number of entries in a range from the key histogram in the meta page, interpolating
+	 * linearly inside the buckets at the ends of the range. Costs one page read, or the exact countRange()
+	 * if enableCounts() has been called.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	**/
+	double estimateRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+
+  /**
+	 * Read the key statistics kept in the meta page.
+   * @param outHistogram	Filled in with the entry count, height, smallest and largest key and the histogram
+	**/
+	const void getKeyHistogram(KeyHistogram & outHistogram);
+
+
+  /**
+	 * Split a range into at most n consecutive key sub-ranges holding about the same number of leaves, see
+	 * ParallelIndexScan. Walks down from the root only as far as it takes to find 4n subtrees overlapping the
+	 * range, or to the level above the leaves, and cuts between subtrees at their separator keys. Every sub-range
+	 * after the first starts GTE the separator before it and every one before the last ends LT the next, so
+	 * duplicates of a separator all fall into the same sub-range.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @param n				Number of sub-ranges wanted, at least 1
+   * @param outPartitions	Filled in with the sub-ranges in key order, keys as raw bytes of the key type
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   * @throws  BadScanParamException If n is less than 1
+	**/
+	const void partitionRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+							const int n, std::vector<ScanBounds>& outPartitions);
+
+
+  /**
+	 * Write every dirty page of the index to its file and drop its pages from the buffer pool, so that
+	 * the file can be read directly. For a resident index this is the checkpoint: every page is written
+	 * to the file in one sequential pass.
+	 * @throws PagePinnedException If a page of the index is pinned, as it is during a scan.
+	**/
+	const void flush();
+
+  /**
+   * Name of the index file, page number of the root and type of the indexed attribute.
+   */
+	const std::string& getFileName() const { return file->filename(); }
+	PageId getRootPageNo() const { return rootPageNum; }
+	Datatype getAttrType() const { return attributeType; }
+
+  /**
+   * File and buffer manager the nodes of the index are read through.
+   */
+	File* getFile() const { return file; }
+	BufMgr* getBufMgr() const { return bufMgr; }
+
+  /**
+   * True if the index is memory resident, in which case its file is current only after flush().
+   */
+	bool isResident() const { return resident; }
 	
 };
 
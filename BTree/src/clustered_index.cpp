@@ -0,0 +1,669 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include "clustered_index.h"
+#include "filescan.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/scan_not_initialized_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/end_of_file_exception.h"
+
+
+namespace badgerdb
+{
+    //Page number of the leaf to the right, held by the first record of a leaf
+    static PageId nextLeaf(Page* leaf)
+    {
+        std::uint16_t length;
+        PageId next;
+        memcpy(&next, leaf->getRecordData(leaf->begin().getCurrentRecord(), length), sizeof(PageId));
+        return next;
+    }
+
+    //Position of the first record of the relation in a leaf, past the link to the next leaf
+    static PageIterator firstRecord(Page* leaf)
+    {
+        PageIterator it = leaf->begin();
+        return ++it;
+    }
+
+    //Key of the type stored in the nodes from its raw bytes
+    template <class T>
+    static T keyOf(const std::string& bytes)
+    {
+        T key;
+        memcpy((void *) &key, bytes.data(), sizeof(T));
+        return key;
+    }
+
+    template <class T>
+    static std::string bytesOf(const T& key)
+    {
+        return std::string((const char *) &key, sizeof(T));
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::ClusteredIndex -- Constructor
+    // -----------------------------------------------------------------------------
+
+    ClusteredIndex::ClusteredIndex(const std::string & relationName,
+                                   std::string & outIndexName,
+                                   BufMgr *bufMgrIn,
+                                   const int attrByteOffset,
+                                   const Datatype attrType)
+    {
+        this->bufMgr = bufMgrIn;
+        this->attributeType = attrType;
+        this->attrByteOffset = attrByteOffset;
+        this->headerPageNum = 1;
+        this->scanExecuting = false;
+        this->currentPageNum = Page::INVALID_NUMBER;
+        this->currentPageData = NULL;
+
+        if (attrType != INTEGER && attrType != DOUBLE && attrType != STRING)
+        {
+            throw BadIndexInfoException("Datatype must equal INTEGER(0) DOUBLE(1) STRING(2)");
+        }
+
+        std::ostringstream idxStr;
+        idxStr << relationName << '.' << attrByteOffset << ".clustered";
+        outIndexName = idxStr.str();
+
+        //File does exist, check that the meta page matches what we were asked for
+        if (File::exists(outIndexName))
+        {
+            this->file = new BlobFile(outIndexName, false);
+            Page * page;
+            bufMgr->readPage(file, headerPageNum, page);
+            ClusteredIndexMetaInfo * meta = (ClusteredIndexMetaInfo *) page;
+            bool matches = strncmp(meta->relationName, relationName.c_str(), sizeof(meta->relationName)) == 0
+                && meta->attrByteOffset == attrByteOffset
+                && meta->attrType == attrType;
+            rootPageNum = meta->rootPageNo;
+            bufMgr->unPinPage(file, headerPageNum, false);
+            if (!matches)
+            {
+                //Drop the frames of this file so a later File object at the same address cannot see them
+                bufMgr->flushFile(file);
+                delete this->file;
+                throw BadIndexInfoException(outIndexName);
+            }
+            return;
+        }
+
+        //File does not exist, create it and copy the relation into it
+        this->file = new BlobFile(outIndexName, true);
+
+        Page * metaPage;
+        allocNode(headerPageNum, metaPage);
+        ClusteredIndexMetaInfo * metaInfo = (ClusteredIndexMetaInfo *) metaPage;
+        strncpy(metaInfo->relationName, relationName.c_str(), sizeof(metaInfo->relationName) - 1);
+        metaInfo->attrByteOffset = attrByteOffset;
+        metaInfo->attrType = attrType;
+        //a root over a single leaf
+        metaInfo->height = 2;
+        bufMgr->unPinPage(file, headerPageNum, true);
+
+        if (attributeType == INTEGER)
+        {
+            initTree<int>();
+        }
+        else if (attributeType == DOUBLE)
+        {
+            initTree<double>();
+        }
+        else
+        {
+            initTree<StringKey>();
+        }
+
+        FileScan scan(relationName, bufMgr);
+        RecordId scanID;
+        try
+        {
+            while (true)
+            {
+                scan.scanNext(scanID);
+                insertRecord(scan.getRecord());
+            }
+        }
+        catch (EndOfFileException e)
+        {
+            // Index has completed
+        }
+        catch (BadIndexInfoException e)
+        {
+            //A key the index cannot hold
+            discardFile(outIndexName);
+            throw;
+        }
+        catch (InsufficientSpaceException e)
+        {
+            //A record no leaf can hold
+            discardFile(outIndexName);
+            throw;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::~ClusteredIndex -- destructor
+    // -----------------------------------------------------------------------------
+
+    ClusteredIndex::~ClusteredIndex()
+    {
+        try
+        {
+            if (scanExecuting)
+            {
+                endScan();
+            }
+            bufMgr->flushFile(file);
+        }
+        catch (BadgerDbException e)
+        {
+
+        }
+        delete file;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::allocNode
+    // -----------------------------------------------------------------------------
+
+    void ClusteredIndex::allocNode(PageId& pageNo, Page*& page)
+    {
+        bufMgr->allocPage(file, pageNo, page);
+        memset((void *) page, 0, Page::SIZE);
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::discardFile
+    // -----------------------------------------------------------------------------
+
+    void ClusteredIndex::discardFile(const std::string& indexName)
+    {
+        bufMgr->flushFile(file);
+        delete file;
+        File::remove(indexName);
+    }
+
+    template <class T>
+    T ClusteredIndex::recordKey(const char* record) const
+    {
+        return keyFromPtr<T>(record + attrByteOffset);
+    }
+
+    template <class T>
+    void ClusteredIndex::initTree()
+    {
+        typedef ClusteredNonLeafNode<T> NonLeaf;
+
+        PageId leafNo;
+        Page * leaf;
+        allocNode(leafNo, leaf);
+        fillLeaf(leaf, Page::INVALID_NUMBER, std::vector<std::string>());
+        bufMgr->unPinPage(file, leafNo, true);
+
+        Page * rootPage;
+        allocNode(rootPageNum, rootPage);
+        NonLeaf * root = (NonLeaf *) rootPage;
+        root->level = 1;
+        root->numKeys = 0;
+        root->pageNoArray[0] = leafNo;
+        bufMgr->unPinPage(file, rootPageNum, true);
+
+        Page * metaPage;
+        bufMgr->readPage(file, headerPageNum, metaPage);
+        ((ClusteredIndexMetaInfo *) metaPage)->rootPageNo = rootPageNum;
+        bufMgr->unPinPage(file, headerPageNum, true);
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::insertRecord
+    // -----------------------------------------------------------------------------
+
+    const void ClusteredIndex::insertRecord(const std::string& record)
+    {
+        //A record that cannot go into an empty leaf would split leaves forever
+        Page empty;
+        fillLeaf(&empty, Page::INVALID_NUMBER, std::vector<std::string>());
+        if (!empty.hasSpaceForRecord(record))
+        {
+            throw InsufficientSpaceException(Page::INVALID_NUMBER, record.length(), empty.getFreeSpace());
+        }
+        if (attributeType == INTEGER)
+        {
+            insertTyped<int>(record);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            insertTyped<double>(record);
+        }
+        else
+        {
+            insertTyped<StringKey>(record);
+        }
+
+        Page * metaPage;
+        bufMgr->readPage(file, headerPageNum, metaPage);
+        ((ClusteredIndexMetaInfo *) metaPage)->numRecords++;
+        bufMgr->unPinPage(file, headerPageNum, true);
+    }
+
+    bool ClusteredIndex::fillLeaf(Page* leaf, const PageId next, const std::vector<std::string>& records)
+    {
+        Page filled;
+        filled.insertRecord(std::string((const char *) &next, sizeof(PageId)));
+        for (size_t i = 0; i < records.size(); i++)
+        {
+            if (!filled.hasSpaceForRecord(records[i]))
+            {
+                return false;
+            }
+            filled.insertRecord(records[i]);
+        }
+        *leaf = filled;
+        return true;
+    }
+
+    template <class T>
+    void ClusteredIndex::insertTyped(const std::string& record)
+    {
+        typedef ClusteredNonLeafNode<T> NonLeaf;
+
+        T key = recordKey<T>(record.data());
+
+        //Go down to the leaf, records with an equal key going after those already there
+        std::vector<PageId> path;
+        PageId pageNo = rootPageNum;
+        while (true)
+        {
+            Page * page;
+            bufMgr->readPage(file, pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int i = std::upper_bound(node->keyArray, node->keyArray + node->numKeys, key) - node->keyArray;
+            PageId child = node->pageNoArray[i];
+            int level = node->level;
+            bufMgr->unPinPage(file, pageNo, false);
+            path.push_back(pageNo);
+            pageNo = child;
+            if (level == 1)
+            {
+                break;
+            }
+        }
+
+        Page * leaf;
+        bufMgr->readPage(file, pageNo, leaf);
+        PageId next = nextLeaf(leaf);
+        std::vector<std::string> records;
+        size_t position = std::string::npos;
+        for (PageIterator it = firstRecord(leaf); it != leaf->end(); ++it)
+        {
+            std::uint16_t length;
+            const char * data = leaf->getRecordData(it.getCurrentRecord(), length);
+            if (position == std::string::npos && key < recordKey<T>(data))
+            {
+                position = records.size();
+            }
+            records.push_back(std::string(data, length));
+        }
+        if (position == std::string::npos)
+        {
+            position = records.size();
+        }
+        records.insert(records.begin() + position, record);
+        if (fillLeaf(leaf, next, records))
+        {
+            bufMgr->unPinPage(file, pageNo, true);
+            return;
+        }
+
+        //Split where the two halves hold about as many bytes
+        size_t total = 0;
+        for (size_t i = 0; i < records.size(); i++)
+        {
+            total += records[i].size();
+        }
+        size_t split = 1;
+        size_t leftBytes = records[0].size();
+        while (split < records.size() - 1 && 2 * (leftBytes + records[split].size()) <= total)
+        {
+            leftBytes += records[split].size();
+            split++;
+        }
+        std::vector<std::string> left(records.begin(), records.begin() + split);
+        std::vector<std::string> right(records.begin() + split, records.end());
+
+        Page probe;
+        if (!fillLeaf(&probe, next, left) || !fillLeaf(&probe, next, right))
+        {
+            bufMgr->unPinPage(file, pageNo, false);
+            throw InsufficientSpaceException(pageNo, record.length(), leaf->getFreeSpace());
+        }
+
+        PageId rightNo;
+        Page * rightPage;
+        allocNode(rightNo, rightPage);
+        fillLeaf(rightPage, next, right);
+        fillLeaf(leaf, rightNo, left);
+        T separator = recordKey<T>(right[0].data());
+        bufMgr->unPinPage(file, rightNo, true);
+        bufMgr->unPinPage(file, pageNo, true);
+
+        insertSeparator<T>(path, path.size() - 1, pageNo, separator, rightNo);
+    }
+
+    template <class T>
+    void ClusteredIndex::insertSeparator(const std::vector<PageId>& path, const int depth, const PageId splitNo,
+                                         const T& key, const PageId pageNo)
+    {
+        typedef ClusteredNonLeafNode<T> NonLeaf;
+
+        //The new page goes right after the child that was split, which a search on key
+        //could miss among equal separators
+        Page * page;
+        bufMgr->readPage(file, path[depth], page);
+        NonLeaf * node = (NonLeaf *) page;
+        int child = 0;
+        while (node->pageNoArray[child] != splitNo)
+        {
+            child++;
+        }
+
+        if (node->numKeys < NonLeaf::SIZE)
+        {
+            std::copy_backward(node->keyArray + child, node->keyArray + node->numKeys, node->keyArray + node->numKeys + 1);
+            std::copy_backward(node->pageNoArray + child + 1, node->pageNoArray + node->numKeys + 1,
+                node->pageNoArray + node->numKeys + 2);
+            node->keyArray[child] = key;
+            node->pageNoArray[child + 1] = pageNo;
+            node->numKeys++;
+            bufMgr->unPinPage(file, path[depth], true);
+            return;
+        }
+
+        //Full: half the keys move to a new right sibling and the middle one goes up
+        std::vector<T> keys(node->keyArray, node->keyArray + node->numKeys);
+        std::vector<PageId> children(node->pageNoArray, node->pageNoArray + node->numKeys + 1);
+        keys.insert(keys.begin() + child, key);
+        children.insert(children.begin() + child + 1, pageNo);
+        int middle = keys.size() / 2;
+
+        PageId rightNo;
+        Page * rightPage;
+        allocNode(rightNo, rightPage);
+        NonLeaf * rightNode = (NonLeaf *) rightPage;
+        rightNode->level = node->level;
+        rightNode->numKeys = keys.size() - middle - 1;
+        std::copy(keys.begin() + middle + 1, keys.end(), rightNode->keyArray);
+        std::copy(children.begin() + middle + 1, children.end(), rightNode->pageNoArray);
+        node->numKeys = middle;
+        std::copy(keys.begin(), keys.begin() + middle, node->keyArray);
+        std::copy(children.begin(), children.begin() + middle + 1, node->pageNoArray);
+        T up = keys[middle];
+        int level = node->level;
+        bufMgr->unPinPage(file, rightNo, true);
+        bufMgr->unPinPage(file, path[depth], true);
+
+        if (depth > 0)
+        {
+            insertSeparator<T>(path, depth - 1, path[depth], up, rightNo);
+            return;
+        }
+
+        //The root was split, the tree grows a level
+        PageId newRootNo;
+        Page * newRootPage;
+        allocNode(newRootNo, newRootPage);
+        NonLeaf * newRoot = (NonLeaf *) newRootPage;
+        newRoot->level = level + 1;
+        newRoot->numKeys = 1;
+        newRoot->keyArray[0] = up;
+        newRoot->pageNoArray[0] = rootPageNum;
+        newRoot->pageNoArray[1] = rightNo;
+        bufMgr->unPinPage(file, newRootNo, true);
+        rootPageNum = newRootNo;
+
+        Page * metaPage;
+        bufMgr->readPage(file, headerPageNum, metaPage);
+        ClusteredIndexMetaInfo * meta = (ClusteredIndexMetaInfo *) metaPage;
+        meta->rootPageNo = rootPageNum;
+        meta->height++;
+        bufMgr->unPinPage(file, headerPageNum, true);
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::startScan
+    // -----------------------------------------------------------------------------
+
+    const void ClusteredIndex::startScan(const void* lowValParm,
+                                         const Operator lowOpParm,
+                                         const void* highValParm,
+                                         const Operator highOpParm)
+    {
+        if((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+
+        if (scanExecuting)
+        {
+            endScan();
+        }
+
+        lowOp = lowOpParm;
+        highOp = highOpParm;
+        bool inverted;
+        if (attributeType == INTEGER)
+        {
+            lowKey = bytesOf(keyFromPtr<int>(lowValParm));
+            highKey = bytesOf(keyFromPtr<int>(highValParm));
+            inverted = keyOf<int>(lowKey) > keyOf<int>(highKey);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            lowKey = bytesOf(keyFromPtr<double>(lowValParm));
+            highKey = bytesOf(keyFromPtr<double>(highValParm));
+            inverted = keyOf<double>(lowKey) > keyOf<double>(highKey);
+        }
+        else
+        {
+            lowKey = bytesOf(keyFromPtr<StringKey>(lowValParm));
+            highKey = bytesOf(keyFromPtr<StringKey>(highValParm));
+            inverted = keyOf<StringKey>(lowKey) > keyOf<StringKey>(highKey);
+        }
+        if (inverted)
+        {
+            throw BadScanrangeException();
+        }
+
+        if (attributeType == INTEGER)
+        {
+            startScanTyped<int>();
+        }
+        else if (attributeType == DOUBLE)
+        {
+            startScanTyped<double>();
+        }
+        else
+        {
+            startScanTyped<StringKey>();
+        }
+    }
+
+    template <class T>
+    void ClusteredIndex::startScanTyped()
+    {
+        typedef ClusteredNonLeafNode<T> NonLeaf;
+
+        //Go down to the leftmost leaf that may hold a record above the low bound
+        T low = keyOf<T>(lowKey);
+        PageId pageNo = rootPageNum;
+        while (true)
+        {
+            Page * page;
+            bufMgr->readPage(file, pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int i = lowOp == GTE
+                ? std::lower_bound(node->keyArray, node->keyArray + node->numKeys, low) - node->keyArray
+                : std::upper_bound(node->keyArray, node->keyArray + node->numKeys, low) - node->keyArray;
+            PageId child = node->pageNoArray[i];
+            int level = node->level;
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = child;
+            if (level == 1)
+            {
+                break;
+            }
+        }
+
+        currentPageNum = pageNo;
+        bufMgr->readPage(file, currentPageNum, currentPageData);
+        nextRecord = firstRecord(currentPageData);
+        scanExecuting = true;
+
+        //Skip the records below the low bound, moving right past leaves holding none above it
+        T high = keyOf<T>(highKey);
+        while (true)
+        {
+            if (nextRecord == currentPageData->end())
+            {
+                PageId next = nextLeaf(currentPageData);
+                bufMgr->unPinPage(file, currentPageNum, false);
+                currentPageData = NULL;
+                if (next == Page::INVALID_NUMBER)
+                {
+                    endScan();
+                    throw NoSuchKeyFoundException();
+                }
+                currentPageNum = next;
+                bufMgr->readPage(file, currentPageNum, currentPageData);
+                nextRecord = firstRecord(currentPageData);
+                continue;
+            }
+            std::uint16_t length;
+            const char * data = currentPageData->getRecordData(nextRecord.getCurrentRecord(), length);
+            T key = recordKey<T>(data);
+            if (lowOp == GTE ? key >= low : key > low)
+            {
+                if (highOp == LTE ? key <= high : key < high)
+                {
+                    return;
+                }
+                endScan();
+                throw NoSuchKeyFoundException();
+            }
+            ++nextRecord;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::scanNext
+    // -----------------------------------------------------------------------------
+
+    const void ClusteredIndex::scanNext(RecordView& outView)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        if (attributeType == INTEGER)
+        {
+            scanNextTyped<int>(outView);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            scanNextTyped<double>(outView);
+        }
+        else
+        {
+            scanNextTyped<StringKey>(outView);
+        }
+    }
+
+    template <class T>
+    void ClusteredIndex::scanNextTyped(RecordView& outView)
+    {
+        //Every record from here on is above the low bound, since leaves are in key order
+        while (currentPageData != NULL)
+        {
+            if (nextRecord == currentPageData->end())
+            {
+                PageId next = nextLeaf(currentPageData);
+                bufMgr->unPinPage(file, currentPageNum, false);
+                currentPageData = NULL;
+                currentPageNum = next;
+                if (next != Page::INVALID_NUMBER)
+                {
+                    bufMgr->readPage(file, currentPageNum, currentPageData);
+                    nextRecord = firstRecord(currentPageData);
+                }
+                continue;
+            }
+            RecordId rid = {currentPageNum, nextRecord.getCurrentRecord().slot_number};
+            outView.data = currentPageData->getRecordData(nextRecord.getCurrentRecord(), outView.length);
+            T key = recordKey<T>(outView.data);
+            if (highOp == LTE ? key > keyOf<T>(highKey) : key >= keyOf<T>(highKey))
+            {
+                bufMgr->unPinPage(file, currentPageNum, false);
+                currentPageData = NULL;
+                break;
+            }
+            outView.rid = rid;
+            ++nextRecord;
+            return;
+        }
+        throw IndexScanCompletedException();
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::endScan
+    // -----------------------------------------------------------------------------
+
+    const void ClusteredIndex::endScan()
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        scanExecuting = false;
+        if (currentPageData != NULL)
+        {
+            bufMgr->unPinPage(file, currentPageNum, false);
+        }
+        currentPageNum = Page::INVALID_NUMBER;
+        currentPageData = NULL;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ClusteredIndex::getNumRecords
+    // -----------------------------------------------------------------------------
+
+    std::uint64_t ClusteredIndex::getNumRecords()
+    {
+        Page * metaPage;
+        bufMgr->readPage(file, headerPageNum, metaPage);
+        std::uint64_t numRecords = ((ClusteredIndexMetaInfo *) metaPage)->numRecords;
+        bufMgr->unPinPage(file, headerPageNum, false);
+        return numRecords;
+    }
+
+    int ClusteredIndex::getHeight()
+    {
+        Page * metaPage;
+        bufMgr->readPage(file, headerPageNum, metaPage);
+        int height = ((ClusteredIndexMetaInfo *) metaPage)->height;
+        bufMgr->unPinPage(file, headerPageNum, false);
+        return height;
+    }
+
+}
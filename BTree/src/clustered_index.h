@@ -0,0 +1,299 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "string.h"
+#include <sstream>
+
+#include "types.h"
+#include "page.h"
+#include "page_iterator.h"
+#include "file.h"
+#include "buffer.h"
+#include "btree.h"
+#include "heap_fetch.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief The meta page of a clustered index file. Like IndexMetaInfo it is always the first page of the file.
+*/
+struct ClusteredIndexMetaInfo{
+  /**
+   * Name of base relation.
+   */
+	char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored in pages.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+	Datatype attrType;
+
+  /**
+   * Page number of the root page.
+   */
+	PageId rootPageNo;
+
+  /**
+   * Number of records in the index and number of levels including the record pages.
+   */
+	std::uint64_t numRecords;
+	int height;
+};
+
+/*
+The leaves of a clustered index are slotted Pages holding the records themselves, in key order after a first
+record that holds the page number of the leaf to the right, chaining the leaves left to right. Records with equal
+keys keep the order they were inserted in. Leaves are walked with a PageIterator like any other page. A leaf is rewritten in key order whenever a record goes into it,
+and split in two halves of about the same number of bytes when it has no room left. The non-leaf nodes above
+them are cast to the structure below.
+*/
+
+/**
+ * @brief Structure for the non-leaf nodes of a clustered index, T being int, double or StringKey.
+ * The level member is 1 if the children are leaves, like in the nodes of BTreeIndex.
+*/
+template <class T>
+struct ClusteredNonLeafNode{
+  /**
+   * Number of separator keys that fit in a node.
+   */
+	//                                              level, numKeys   extra pageNo              key          pageNo
+	static const int SIZE = ( Page::SIZE - 2 * sizeof( int ) - sizeof( PageId ) ) / ( sizeof( T ) + sizeof( PageId ) );
+
+  /**
+   * Level of the node in the tree.
+   */
+	int level;
+
+  /**
+   * Number of separator keys in use, one less than the number of children.
+   */
+	int numKeys;
+
+  /**
+   * Stores keys. keyArray[i] is the smallest key of the subtree pageNoArray[i + 1], except that
+   * records with that key may also end the subtree pageNoArray[i].
+   */
+	T keyArray[ SIZE ];
+
+  /**
+   * Stores page numbers of child pages.
+   */
+	PageId pageNoArray[ SIZE + 1 ];
+};
+
+/**
+ * @brief ClusteredIndex class. An index-organized table: a B+ tree on a single attribute whose leaves hold the
+ * records of the relation instead of RecordIds, so a range scan reads the bytes of each record once, from pages
+ * holding neighbouring keys, and never goes back to the relation. The records are copied from the relation when
+ * the index file is created; records inserted afterwards live in the index only.
+ * This index supports only one scan at a time.
+*/
+class ClusteredIndex {
+
+ private:
+
+  /**
+   * File object for the index file.
+   */
+	File		*file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+	BufMgr	*bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+	PageId	headerPageNum;
+
+  /**
+   * Page number of the root page, always a non-leaf node.
+   */
+	PageId	rootPageNum;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+	Datatype	attributeType;
+
+  /**
+   * Offset of attribute, over which index is built, inside records.
+   */
+	int 		attrByteOffset;
+
+
+	// MEMBERS SPECIFIC TO SCANNING
+
+  /**
+   * True if an index scan has been started.
+   */
+	bool		scanExecuting;
+
+  /**
+   * Position of the next record to be looked at in the current leaf.
+   */
+	PageIterator	nextRecord;
+
+  /**
+   * Page number of the current leaf being scanned.
+   */
+	PageId	currentPageNum;
+
+  /**
+   * Current leaf being scanned, pinned until the scan moves on.
+   */
+	Page		*currentPageData;
+
+  /**
+   * Bounds of the scan, as the raw bytes of the key type.
+   */
+	std::string	lowKey;
+	std::string	highKey;
+
+  /**
+   * Low Operator. Can only be GT(>) or GTE(>=).
+   */
+	Operator	lowOp;
+
+  /**
+   * High Operator. Can only be LT(<) or LTE(<=).
+   */
+	Operator	highOp;
+
+
+  /**
+   * Allocates a page in the index file. The page is returned pinned.
+   */
+	void allocNode(PageId& pageNo, Page*& page);
+
+  /**
+   * Drops the frames of a half-built index file, closes it and removes it, so no partial index is left to be opened later.
+   */
+	void discardFile(const std::string& indexName);
+
+  /**
+   * Key of a record.
+   */
+	template <class T>
+	T recordKey(const char* record) const;
+
+  /**
+   * Creates the empty index: a root over a single empty leaf.
+   */
+	template <class T>
+	void initTree();
+
+	template <class T>
+	void insertTyped(const std::string& record);
+
+  /**
+   * Rewrites leaf with the link to the leaf next and records, in their order. Returns false, leaving the leaf
+   * as it was, if they do not fit.
+   */
+	bool fillLeaf(Page* leaf, const PageId next, const std::vector<std::string>& records);
+
+  /**
+   * Inserts the separator key and the page number of the new right sibling of its child splitNo into the
+   * non-leaf node path[depth], splitting it, and its parents, when it is full.
+   */
+	template <class T>
+	void insertSeparator(const std::vector<PageId>& path, const int depth, const PageId splitNo,
+						const T& key, const PageId pageNo);
+
+	template <class T>
+	void startScanTyped();
+
+	template <class T>
+	void scanNextTyped(RecordView& outView);
+
+ public:
+
+  /**
+   * ClusteredIndex Constructor.
+	 * Check to see if the corresponding index file exists. If so, open the file.
+	 * If not, create it and copy every tuple of the base relation into it using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built
+   * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
+   * @throws  BadIndexInfoException     If a STRING value of the relation is longer than STRINGSIZE. No index file is left behind.
+   * @throws  InsufficientSpaceException If a record of the relation does not fit in an empty leaf. No index file is left behind.
+   */
+	ClusteredIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
+
+  /**
+   * ClusteredIndex Destructor.
+	 * End any initialized scan, flush index file and close it. Does not throw.
+	 * */
+	~ClusteredIndex();
+
+  /**
+	 * Insert a record. Its key is read at the attribute byte offset. The leaf it goes into is split
+	 * when full, which may in turn split the non-leaf nodes up to the root.
+   * @param record	Bytes of the record
+   * @throws  InsufficientSpaceException If the record does not fit in an empty page.
+	**/
+	const void insertRecord(const std::string& record);
+
+  /**
+	 * Begin a filtered scan of the index, see BTreeIndex::startScan().
+	 * The leaf holding the first record is kept pinned.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the index that satisfies the scan criteria.
+	**/
+	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  /**
+	 * Fetch the next record that matches the scan, in key order. The record is returned in place on its leaf,
+	 * which stays pinned until the next call moves on or the scan ends. The RecordId of the view is the position
+	 * of the record in the index file, which changes as records are inserted.
+   * @param outView	Record found that satisfies the scan criteria returned in this
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNext(RecordView& outView);
+
+  /**
+	 * Terminate the current scan. Unpin any pinned pages. Reset scan specific variables.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	**/
+	const void endScan();
+
+  /**
+   * Number of records in the index.
+   */
+	std::uint64_t getNumRecords();
+
+  /**
+   * Number of levels of the tree, the leaves included.
+   */
+	int getHeight();
+};
+
+}
@@ -0,0 +1,41 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when BTreeIndex::verify() finds an index
+ *        page that breaks the structure of the tree.
+ */
+class BadIndexStructureException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a bad index structure exception.
+   *
+   * @param reason  What is wrong and on which page.
+   */
+  explicit BadIndexStructureException(const std::string& reason);
+
+  /**
+   * Returns what is wrong and on which page.
+   */
+  virtual const std::string& reason() const { return reason_; }
+
+ protected:
+  /**
+   * What is wrong and on which page.
+   */
+  const std::string reason_;
+};
+
+}
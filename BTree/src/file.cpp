@@ -392,6 +392,32 @@ void BlobFile::writePage(const PageId new_page_number, const Page& new_page) {
 	stream_->flush();
 }
 
+void BlobFile::readPages(const PageId first, const PageId count, Page* out) const {
+	stream_->seekg(pagePosition(first), std::ios::beg);
+	stream_->read(reinterpret_cast<char*>(out), (std::streamsize) count * Page::SIZE);
+}
+
+void BlobFile::writePages(const PageId first, const PageId count, Page* const* pages) {
+	stream_->seekp(pagePosition(first), std::ios::beg);
+	for (PageId i = 0; i < count; ++i) {
+		stream_->write(reinterpret_cast<const char*>(pages[i]), Page::SIZE);
+	}
+	stream_->flush();
+
+	FileHeader header = readHeader();
+	if (first + count > header.num_pages) {
+		if (header.first_used_page == Page::INVALID_NUMBER) {
+			header.first_used_page = first;
+		}
+		header.num_pages = first + count;
+		writeHeader(header);
+	}
+}
+
+PageId BlobFile::getNumPages() const {
+	return readHeader().num_pages - 1;
+}
+
 //delePage should not be called for a blob_file, not supported
 void BlobFile::deletePage(const PageId page_number) {
 	throw InvalidPageException(page_number, filename_);
@@ -467,6 +467,31 @@ class BlobFile : public File {
    */
   void writePage(const PageId page_number, const Page& new_page);
 
+  /**
+   * Reads count consecutive pages starting at first with a single read.
+   * No bounds checking is performed.
+   *
+   * @param first   Number of first page to read.
+   * @param count   Number of pages to read.
+   * @param out     Array of count pages to read into.
+   */
+  void readPages(const PageId first, const PageId count, Page* out) const;
+
+  /**
+   * Writes count consecutive pages starting at first in one pass, allocating
+   * the pages past the end of the file.
+   *
+   * @param first   Number of first page to write.
+   * @param count   Number of pages to write.
+   * @param pages   Array of count pointers to the pages to write.
+   */
+  void writePages(const PageId first, const PageId count, Page* const* pages);
+
+  /**
+   * Returns the number of pages allocated in the file, numbered from 1.
+   */
+  PageId getNumPages() const;
+
   /**
    * Deletes a page from the file.
    *
@@ -7,6 +7,7 @@
 
 #include "filescan.h"
 #include "exceptions/end_of_file_exception.h"
+#include "exceptions/badgerdb_exception.h"
 
 namespace badgerdb { 
 
@@ -29,6 +30,15 @@ FileScan::~FileScan()
 		curDirtyFlag = false;
     filePageIter = file->begin();
   }
+  // drop this file's frames so a later File object reusing the address cannot see them.
+  // a destructor must not throw, so a frame still pinned by someone else is left alone
+  try
+  {
+    bufMgr->flushFile(file);
+  }
+  catch (BadgerDbException e)
+  {
+  }
   delete file;
 }
 
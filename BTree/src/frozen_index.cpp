@@ -0,0 +1,344 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <fstream>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "frozen_index.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/scan_not_initialized_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+
+namespace badgerdb
+{
+    static const char FROZENMAGIC[8] = "BDBFRZ2";
+
+    static std::uint64_t alignUp(const std::uint64_t offset)
+    {
+        return (offset + FROZENALIGN - 1) / FROZENALIGN * FROZENALIGN;
+    }
+
+    //Lays sorted[0..n) out in Eytzinger order in tree[1..n], recording where each one came from
+    template <class T>
+    static void eytzinger(const std::vector<T>& sorted, std::vector<T>& tree,
+                          std::vector<std::uint32_t>& blocks, size_t& next, const size_t k)
+    {
+        if (k <= sorted.size())
+        {
+            eytzinger(sorted, tree, blocks, next, 2 * k);
+            tree[k] = sorted[next];
+            blocks[k] = next;
+            next++;
+            eytzinger(sorted, tree, blocks, next, 2 * k + 1);
+        }
+    }
+
+    //Bytes each normalized key takes in the file, the longest key for STRING
+    template <class T>
+    static std::uint32_t keyWidth(const std::vector<T>& keys)
+    {
+        return normalizedSize<T>();
+    }
+
+    static std::uint32_t keyWidth(const std::vector<StringKey>& keys)
+    {
+        size_t width = 1;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            width = std::max(width, strnlen(keys[i].data, STRINGSIZE));
+        }
+        return width;
+    }
+
+    template <class T>
+    static void writeKeys(std::ofstream& out, const std::vector<T>& keys, const std::uint32_t width)
+    {
+        std::vector<unsigned char> normalized(normalizedSize<T>());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            normalizeKey(keys[i], normalized.data());
+            out.write((const char *) normalized.data(), width);
+        }
+    }
+
+    static void writePadding(std::ofstream& out, const std::uint64_t offset)
+    {
+        static const char zeros[FROZENALIGN] = { 0 };
+        std::uint64_t pos = out.tellp();
+        out.write(zeros, offset - pos);
+    }
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::write
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void FrozenIndex::write(const std::string& name, const std::string& relationName, const int attrByteOffset,
+                            const std::vector<T>& keys, const std::vector<RecordId>& rids)
+    {
+        FrozenIndexHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, FROZENMAGIC, sizeof(header.magic));
+        strncpy(header.relationName, relationName.c_str(), sizeof(header.relationName) - 1);
+        header.attrByteOffset = attrByteOffset;
+        header.attrType = NodeTraits<T>::TYPE;
+        header.keyWidth = keyWidth(keys);
+        header.numEntries = keys.size();
+        header.numBlocks = (keys.size() + FROZENBLOCKSIZE - 1) / FROZENBLOCKSIZE;
+
+        header.treeKeyOffset = alignUp(sizeof(header));
+        header.treeBlockOffset = alignUp(header.treeKeyOffset + (header.numBlocks + 1) * header.keyWidth);
+        header.keyOffset = alignUp(header.treeBlockOffset + (header.numBlocks + 1) * sizeof(std::uint32_t));
+        header.pageOffset = alignUp(header.keyOffset + header.numEntries * header.keyWidth);
+        header.slotOffset = alignUp(header.pageOffset + header.numEntries * sizeof(PageId));
+        header.fileSize = alignUp(header.slotOffset + header.numEntries * sizeof(SlotId));
+
+        //The first key of each block is what the search tree branches on
+        std::vector<T> firstKeys;
+        for (size_t i = 0; i < keys.size(); i += FROZENBLOCKSIZE)
+        {
+            firstKeys.push_back(keys[i]);
+        }
+        std::vector<T> treeKeys(header.numBlocks + 1);
+        std::vector<std::uint32_t> treeBlocks(header.numBlocks + 1);
+        size_t next = 0;
+        eytzinger(firstKeys, treeKeys, treeBlocks, next, 1);
+
+        std::vector<PageId> pages(rids.size());
+        std::vector<SlotId> slots(rids.size());
+        for (size_t i = 0; i < rids.size(); i++)
+        {
+            pages[i] = rids[i].page_number;
+            slots[i] = rids[i].slot_number;
+        }
+
+        std::ofstream out(name.c_str(), std::ios::binary | std::ios::trunc);
+        out.write((const char *) &header, sizeof(header));
+        writePadding(out, header.treeKeyOffset);
+        writeKeys(out, treeKeys, header.keyWidth);
+        writePadding(out, header.treeBlockOffset);
+        out.write((const char *) treeBlocks.data(), treeBlocks.size() * sizeof(std::uint32_t));
+        writePadding(out, header.keyOffset);
+        writeKeys(out, keys, header.keyWidth);
+        writePadding(out, header.pageOffset);
+        out.write((const char *) pages.data(), pages.size() * sizeof(PageId));
+        writePadding(out, header.slotOffset);
+        out.write((const char *) slots.data(), slots.size() * sizeof(SlotId));
+        writePadding(out, header.fileSize);
+    }
+
+    template void FrozenIndex::write<int>(const std::string&, const std::string&, const int,
+                                          const std::vector<int>&, const std::vector<RecordId>&);
+    template void FrozenIndex::write<double>(const std::string&, const std::string&, const int,
+                                             const std::vector<double>&, const std::vector<RecordId>&);
+    template void FrozenIndex::write<StringKey>(const std::string&, const std::string&, const int,
+                                                const std::vector<StringKey>&, const std::vector<RecordId>&);
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::FrozenIndex -- Constructor
+    // -----------------------------------------------------------------------------
+
+    FrozenIndex::FrozenIndex(const std::string& name)
+    {
+        this->fileName = name;
+        this->scanExecuting = false;
+
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw FileNotFoundException(name);
+        }
+        struct stat st;
+        void * addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(FrozenIndexHeader))
+        {
+            addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            throw FileNotFoundException(name);
+        }
+
+        mapping = (const char *) addr;
+        header = (const FrozenIndexHeader *) mapping;
+        if (memcmp(header->magic, FROZENMAGIC, sizeof(header->magic)) != 0 || header->fileSize != (std::uint64_t) st.st_size)
+        {
+            munmap(addr, st.st_size);
+            throw BadIndexInfoException(name);
+        }
+        //The search tree is touched by every lookup, ask for it up front
+        madvise(addr, header->keyOffset, MADV_WILLNEED);
+
+        treeBlocks = (const std::uint32_t *) (mapping + header->treeBlockOffset);
+        pageArray = (const PageId *) (mapping + header->pageOffset);
+        slotArray = (const SlotId *) (mapping + header->slotOffset);
+    }
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::~FrozenIndex -- destructor
+    // -----------------------------------------------------------------------------
+
+    FrozenIndex::~FrozenIndex()
+    {
+        munmap((void *) mapping, header->fileSize);
+    }
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::lowerBound
+    // -----------------------------------------------------------------------------
+
+    std::uint64_t FrozenIndex::lowerBound(const unsigned char* key, const int keySize, const bool strict) const
+    {
+        const unsigned char * treeKeys = (const unsigned char *) (mapping + header->treeKeyOffset);
+        const unsigned char * keys = (const unsigned char *) (mapping + header->keyOffset);
+        const std::uint32_t width = header->keyWidth;
+        const std::uint64_t numBlocks = header->numBlocks;
+
+        //A STRING key longer than every key of the file follows the ones it starts with
+        bool longer = false;
+        for (int i = width; i < keySize; i++)
+        {
+            longer = longer || key[i] != 0;
+        }
+        //An entry that compares equal to key over width bytes precedes it when this is set
+        const bool tiePrecedes = strict || longer;
+
+        //Descend the search tree for the first block whose first key does not precede key.
+        //The prefetch pulls in the slots four levels further down.
+        std::uint64_t k = 1;
+        while (k <= numBlocks)
+        {
+            __builtin_prefetch(treeKeys + 16 * k * width);
+            int c = memcmp(treeKeys + k * width, key, width);
+            bool precedes = c < 0 || (c == 0 && tiePrecedes);
+            k = 2 * k + precedes;
+        }
+        //Undo the right turns taken after the last left turn
+        k >>= __builtin_ffsll(~k);
+        std::uint64_t block = k == 0 ? numBlocks : treeBlocks[k];
+        if (block == 0)
+        {
+            return 0;
+        }
+
+        //The answer is inside the previous block or right at the start of this one
+        std::uint64_t first = (block - 1) * FROZENBLOCKSIZE;
+        std::uint64_t len = std::min<std::uint64_t>(FROZENBLOCKSIZE, header->numEntries - first);
+        std::uint64_t base = first;
+        while (len > 1)
+        {
+            std::uint64_t half = len / 2;
+            int c = memcmp(keys + (base + half - 1) * width, key, width);
+            bool precedes = c < 0 || (c == 0 && tiePrecedes);
+            base += precedes ? half : 0;
+            len -= half;
+        }
+        int c = memcmp(keys + base * width, key, width);
+        bool precedes = c < 0 || (c == 0 && tiePrecedes);
+        return base + precedes;
+    }
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::startScan
+    // -----------------------------------------------------------------------------
+
+    const void FrozenIndex::startScan(const void* lowValParm,
+                                      const Operator lowOpParm,
+                                      const void* highValParm,
+                                      const Operator highOpParm)
+    {
+        if ((highOpParm != LT && highOpParm != LTE) || (lowOpParm != GT && lowOpParm != GTE))
+        {
+            throw BadOpcodesException();
+        }
+        if (scanExecuting)
+        {
+            endScan();
+        }
+
+        if (header->attrType == INTEGER)
+        {
+            startScanTyped<int>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+        else if (header->attrType == DOUBLE)
+        {
+            startScanTyped<double>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+        else
+        {
+            startScanTyped<StringKey>(lowValParm, lowOpParm, highValParm, highOpParm);
+        }
+    }
+
+    template <class T>
+    void FrozenIndex::startScanTyped(const void* lowValParm, const Operator lowOpParm,
+                                     const void* highValParm, const Operator highOpParm)
+    {
+        T low = keyFromPtr<T>(lowValParm);
+        T high = keyFromPtr<T>(highValParm);
+        if (high < low)
+        {
+            throw BadScanrangeException();
+        }
+
+        //Every type is searched the same way, on its normalized bytes
+        std::vector<unsigned char> lowBytes(normalizedSize<T>());
+        std::vector<unsigned char> highBytes(normalizedSize<T>());
+        normalizeKey(low, lowBytes.data());
+        normalizeKey(high, highBytes.data());
+        std::uint64_t first = lowerBound(lowBytes.data(), lowBytes.size(), lowOpParm == GT);
+        std::uint64_t last = lowerBound(highBytes.data(), highBytes.size(), highOpParm == LTE);
+        if (first >= last)
+        {
+            throw NoSuchKeyFoundException();
+        }
+        nextEntry = first;
+        endEntry = last;
+        scanExecuting = true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::scanNext
+    // -----------------------------------------------------------------------------
+
+    const void FrozenIndex::scanNext(RecordId& outRid)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        if (nextEntry >= endEntry)
+        {
+            throw IndexScanCompletedException();
+        }
+        outRid.page_number = pageArray[nextEntry];
+        outRid.slot_number = slotArray[nextEntry];
+        nextEntry++;
+    }
+
+    // -----------------------------------------------------------------------------
+    // FrozenIndex::endScan
+    // -----------------------------------------------------------------------------
+
+    const void FrozenIndex::endScan()
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        scanExecuting = false;
+    }
+
+}
@@ -0,0 +1,231 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "types.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of entries in a frozen leaf block. Every block contributes its first key to the search tree.
+ */
+const  int FROZENBLOCKSIZE = 16;
+
+/**
+ * @brief Alignment of every section of a frozen index file, one cache line.
+ */
+const  int FROZENALIGN = 64;
+
+/**
+ * @brief Header at the start of a frozen index file.
+ * A frozen index holds the entries of a BTreeIndex in key order with no free space:
+ * a key array, a page number array and a slot number array, each packed and cache line aligned.
+ * The first key of every FROZENBLOCKSIZE entries is copied into a search tree stored in
+ * Eytzinger (breadth first) order, together with the block number each of its slots stands for.
+*/
+struct FrozenIndexHeader{
+  /**
+   * Always "BDBFRZ2", checked on open.
+   */
+	char magic[8];
+
+  /**
+   * Name of base relation.
+   */
+	char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored in pages.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+	Datatype attrType;
+
+  /**
+   * Bytes taken by each key in the search tree and in the key array. Keys are stored normalized, see
+   * normalizeKey(), so that memcmp orders them whatever their type. The normalized size for INTEGER and DOUBLE,
+   * the length of the longest key for STRING, shorter keys being padded with '\0'.
+   */
+	std::uint32_t keyWidth;
+
+  /**
+   * Number of entries.
+   */
+	std::uint64_t numEntries;
+
+  /**
+   * Number of leaf blocks, also the number of keys in the search tree.
+   */
+	std::uint64_t numBlocks;
+
+  /**
+   * File offsets of the search tree keys (numBlocks + 1 slots, slot 0 unused), the block number
+   * of each search tree slot, the entry keys, the entry page numbers and the entry slot numbers.
+   */
+	std::uint64_t treeKeyOffset;
+	std::uint64_t treeBlockOffset;
+	std::uint64_t keyOffset;
+	std::uint64_t pageOffset;
+	std::uint64_t slotOffset;
+
+  /**
+   * Total size of the file in bytes.
+   */
+	std::uint64_t fileSize;
+};
+
+/**
+ * @brief FrozenIndex class. A read only snapshot of a BTreeIndex produced by BTreeIndex::freeze().
+ * The file is memory mapped on open and never goes through the buffer manager.
+ * Lookups walk the Eytzinger search tree without branching on the comparison, prefetching
+ * the cache line four levels down, then finish with a branch free search inside one leaf block.
+ * Keys of every type are compared the same way, with memcmp on their normalized bytes.
+ * Supports the same scan interface as BTreeIndex, one scan at a time.
+*/
+class FrozenIndex {
+
+ private:
+
+  /**
+   * Name of the frozen index file.
+   */
+	std::string	fileName;
+
+  /**
+   * Start of the mapping, which begins with the FrozenIndexHeader.
+   */
+	const char	*mapping;
+
+  /**
+   * Header of the mapped file.
+   */
+	const FrozenIndexHeader	*header;
+
+  /**
+   * Block number of each search tree slot.
+   */
+	const std::uint32_t	*treeBlocks;
+
+  /**
+   * Page and slot numbers of the entries.
+   */
+	const PageId	*pageArray;
+	const SlotId	*slotArray;
+
+
+	// MEMBERS SPECIFIC TO SCANNING
+
+  /**
+   * True if an index scan has been started.
+   */
+	bool		scanExecuting;
+
+  /**
+   * Index of the next entry to be returned.
+   */
+	std::uint64_t	nextEntry;
+
+  /**
+   * Index one past the last entry satisfying the scan.
+   */
+	std::uint64_t	endEntry;
+
+
+  /**
+   * Index of the first entry that does not precede key. With strict set that is the first
+   * entry greater than key, otherwise the first entry greater or equal.
+   * @param key			Normalized key, see normalizeKey()
+   * @param keySize	Bytes of key
+   */
+	std::uint64_t lowerBound(const unsigned char* key, const int keySize, const bool strict) const;
+
+	template <class T>
+	void startScanTyped(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+ public:
+
+  /**
+   * Writes a frozen index file from entries already sorted by key. T is int, double or StringKey
+   * and decides the attribute type recorded in the header.
+   *
+   * @param name						Name of the file to write, replaced if it exists
+   * @param relationName		Name of base relation
+   * @param attrByteOffset	Offset of the indexed attribute
+   * @param keys						Keys in ascending order
+   * @param rids						RecordIds, rids[i] belongs to keys[i]
+   */
+	template <class T>
+	static void write(const std::string& name, const std::string& relationName, const int attrByteOffset,
+						const std::vector<T>& keys, const std::vector<RecordId>& rids);
+
+  /**
+   * Opens and memory maps a frozen index file.
+   *
+   * @param name		Name of the frozen index file
+   * @throws  FileNotFoundException   If the file does not exist or cannot be mapped.
+   * @throws  BadIndexInfoException   If the file is not a frozen index.
+   */
+	FrozenIndex(const std::string& name);
+
+  /**
+   * Unmaps the file.
+   */
+	~FrozenIndex();
+
+  /**
+   * Datatype of the indexed attribute.
+   */
+	Datatype getAttrType() const { return header->attrType; }
+
+  /**
+   * Number of entries in the index.
+   */
+	std::uint64_t getNumEntries() const { return header->numEntries; }
+
+  /**
+   * Size of the frozen index file in bytes.
+   */
+	std::uint64_t getFileSize() const { return header->fileSize; }
+
+  /**
+	 * Begin a filtered scan of the index, see BTreeIndex::startScan().
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE)
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+	 * @throws  NoSuchKeyFoundException If there is no key in the index that satisfies the scan criteria.
+	**/
+	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  /**
+	 * Fetch the record id of the next index entry that matches the scan.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNext(RecordId& outRid);
+
+  /**
+	 * Terminate the current scan.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	**/
+	const void endScan();
+};
+
+}
@@ -0,0 +1,636 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <stdlib.h>
+#include "hash_index.h"
+#include "filescan.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/scan_not_initialized_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/end_of_file_exception.h"
+
+
+namespace badgerdb
+{
+    //Hashes that agree on these bits can never be told apart by splitting
+    static const std::uint32_t HASHDEPTHMASK = (1u << HASHMAXDEPTH) - 1;
+
+    static std::uint32_t mixHash(std::uint32_t h)
+    {
+        h ^= h >> 16;
+        h *= 0x85ebca6b;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::hashKey
+    // -----------------------------------------------------------------------------
+
+    std::uint32_t HashIndex::hashKey(const int key)
+    {
+        return mixHash((std::uint32_t) key);
+    }
+
+    std::uint32_t HashIndex::hashKey(const double key)
+    {
+        //0.0 and -0.0 compare equal so they must hash alike
+        double value = key == 0.0 ? 0.0 : key;
+        std::uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return mixHash((std::uint32_t) bits ^ mixHash((std::uint32_t) (bits >> 32)));
+    }
+
+    std::uint32_t HashIndex::hashKey(const StringKey& key)
+    {
+        //FNV-1a over the key bytes up to the first '\0'
+        std::uint32_t h = 2166136261u;
+        for (int i = 0; i < STRINGSIZE && key.data[i] != '\0'; i++)
+        {
+            h ^= (unsigned char) key.data[i];
+            h *= 16777619u;
+        }
+        return mixHash(h);
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::HashIndex -- Constructor
+    // -----------------------------------------------------------------------------
+
+    HashIndex::HashIndex(const std::string & relationName,
+                         std::string & outIndexName,
+                         BufMgr *bufMgrIn,
+                         const int attrByteOffset,
+                         const Datatype attrType)
+    {
+        this->bufMgr = bufMgrIn;
+        this->attributeType = attrType;
+        this->attrByteOffset = attrByteOffset;
+        this->headerPageNum = 1;
+        this->scanExecuting = false;
+        this->currentPageNum = Page::INVALID_NUMBER;
+        this->currentPageData = NULL;
+
+        if (attrType != INTEGER && attrType != DOUBLE && attrType != STRING)
+        {
+            throw BadIndexInfoException("Datatype must equal INTEGER(0) DOUBLE(1) STRING(2)");
+        }
+
+        std::ostringstream idxStr;
+        idxStr << relationName << '.' << attrByteOffset << ".hash";
+        outIndexName = idxStr.str();
+
+        //File does exist, check the meta page and load the directory
+        if (File::exists(outIndexName))
+        {
+            this->file = new BlobFile(outIndexName, false);
+            Page * page;
+            bufMgr->readPage(file, headerPageNum, page);
+            HashIndexMetaInfo * meta = (HashIndexMetaInfo *) page;
+            bool matches = strncmp(meta->relationName, relationName.c_str(), sizeof(meta->relationName)) == 0
+                && meta->attrByteOffset == attrByteOffset
+                && meta->attrType == attrType;
+            globalDepth = meta->globalDepth;
+            dirPages.assign(meta->dirPageNoArray, meta->dirPageNoArray + meta->numDirPages);
+            bufMgr->unPinPage(file, headerPageNum, false);
+            if (!matches)
+            {
+                bufMgr->flushFile(file);
+                delete this->file;
+                throw BadIndexInfoException(outIndexName);
+            }
+
+            directory.resize((size_t) 1 << globalDepth);
+            for (size_t i = 0; i < dirPages.size(); i++)
+            {
+                bufMgr->readPage(file, dirPages[i], page);
+                PageId * slots = (PageId *) page;
+                size_t first = i * HASHDIRARRAYSIZE;
+                size_t last = std::min(directory.size(), first + HASHDIRARRAYSIZE);
+                std::copy(slots, slots + (last - first), directory.begin() + first);
+                bufMgr->unPinPage(file, dirPages[i], false);
+            }
+            return;
+        }
+
+        //File does not exist, create it with a single empty bucket and build it from the relation
+        this->file = new BlobFile(outIndexName, true);
+
+        Page * metaPage;
+        allocBucket(headerPageNum, metaPage);
+        HashIndexMetaInfo * metaInfo = (HashIndexMetaInfo *) metaPage;
+        strncpy(metaInfo->relationName, relationName.c_str(), sizeof(metaInfo->relationName) - 1);
+        metaInfo->attrByteOffset = attrByteOffset;
+        metaInfo->attrType = attrType;
+        bufMgr->unPinPage(file, headerPageNum, true);
+
+        initBuckets();
+
+        FileScan scan(relationName, bufMgr);
+        RecordId scanID;
+        try
+        {
+            while (true)
+            {
+                scan.scanNext(scanID);
+                std::string recordStr = scan.getRecord();
+                insertEntry(recordStr.c_str() + attrByteOffset, scanID);
+            }
+        }
+        catch (EndOfFileException e)
+        {
+            // Index has completed
+        }
+        catch (BadIndexInfoException e)
+        {
+            //A key the index cannot hold, leave no partial index behind to be opened later
+            bufMgr->flushFile(file);
+            delete file;
+            File::remove(outIndexName);
+            throw;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::~HashIndex -- destructor
+    // -----------------------------------------------------------------------------
+
+    HashIndex::~HashIndex()
+    {
+        try
+        {
+            if (scanExecuting)
+            {
+                endScan();
+            }
+            bufMgr->flushFile(file);
+        }
+        catch (BadgerDbException e)
+        {
+
+        }
+        delete file;
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::allocBucket
+    // -----------------------------------------------------------------------------
+
+    void HashIndex::allocBucket(PageId& pageNo, Page*& page)
+    {
+        bufMgr->allocPage(file, pageNo, page);
+        memset((void *) page, 0, Page::SIZE);
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::initBuckets
+    // -----------------------------------------------------------------------------
+
+    void HashIndex::initBuckets()
+    {
+        PageId bucketId;
+        Page * bucketPage;
+        allocBucket(bucketId, bucketPage);
+        bufMgr->unPinPage(file, bucketId, true);
+
+        globalDepth = 0;
+        directory.assign(1, bucketId);
+        writeDirectory();
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::writeDirectory
+    // -----------------------------------------------------------------------------
+
+    void HashIndex::writeDirectory()
+    {
+        Page * page;
+        size_t needed = (directory.size() + HASHDIRARRAYSIZE - 1) / HASHDIRARRAYSIZE;
+        while (dirPages.size() < needed)
+        {
+            PageId pageNo;
+            allocBucket(pageNo, page);
+            bufMgr->unPinPage(file, pageNo, true);
+            dirPages.push_back(pageNo);
+        }
+
+        for (size_t i = 0; i < dirPages.size(); i++)
+        {
+            bufMgr->readPage(file, dirPages[i], page);
+            PageId * slots = (PageId *) page;
+            size_t first = i * HASHDIRARRAYSIZE;
+            size_t last = std::min(directory.size(), first + HASHDIRARRAYSIZE);
+            std::copy(directory.begin() + first, directory.begin() + last, slots);
+            bufMgr->unPinPage(file, dirPages[i], true);
+        }
+
+        bufMgr->readPage(file, headerPageNum, page);
+        HashIndexMetaInfo * meta = (HashIndexMetaInfo *) page;
+        meta->globalDepth = globalDepth;
+        meta->numDirPages = dirPages.size();
+        std::copy(dirPages.begin(), dirPages.end(), meta->dirPageNoArray);
+        bufMgr->unPinPage(file, headerPageNum, true);
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::doubleDirectory
+    // -----------------------------------------------------------------------------
+
+    void HashIndex::doubleDirectory()
+    {
+        //Slot i and i + 2^globalDepth agree on the low globalDepth bits, so they share a bucket
+        size_t oldSize = directory.size();
+        directory.resize(oldSize * 2);
+        std::copy(directory.begin(), directory.begin() + oldSize, directory.begin() + oldSize);
+        globalDepth++;
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::insertEntry
+    // -----------------------------------------------------------------------------
+
+    const void HashIndex::insertEntry(const void *key, const RecordId rid)
+    {
+        if (attributeType == INTEGER)
+        {
+            insertTyped<int>(keyFromPtr<int>(key), rid);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            insertTyped<double>(keyFromPtr<double>(key), rid);
+        }
+        else
+        {
+            insertTyped<StringKey>(keyFromPtr<StringKey>(key), rid);
+        }
+    }
+
+    template <class T>
+    void HashIndex::insertTyped(const T& key, const RecordId rid)
+    {
+        typedef typename BucketTraits<T>::Bucket Bucket;
+
+        std::uint32_t hash = hashKey(key);
+        while (true)
+        {
+            std::uint32_t dirIndex = hash & (((std::uint32_t) 1 << globalDepth) - 1);
+            PageId pageNo = directory[dirIndex];
+            Page * page;
+            bufMgr->readPage(file, pageNo, page);
+            Bucket * bucket = (Bucket *) page;
+
+            //room in the primary page
+            if (bucket->overflowPageNo == Page::INVALID_NUMBER && bucket->numEntries < BucketTraits<T>::BUCKETSIZE)
+            {
+                nodeKeys<T>(bucket)[bucket->numEntries] = key;
+                bucket->ridArray[bucket->numEntries] = rid;
+                bucket->numEntries++;
+                bufMgr->unPinPage(file, pageNo, true);
+                return;
+            }
+
+            //A bucket only overflows once all its keys hash alike, more of the same hash just chain on
+            bool sameHash = true;
+            T * keys = nodeKeys<T>(bucket);
+            for (int i = 0; i < bucket->numEntries && sameHash; i++)
+            {
+                sameHash = ((hashKey(keys[i]) ^ hash) & HASHDEPTHMASK) == 0;
+            }
+            bufMgr->unPinPage(file, pageNo, false);
+
+            if (sameHash || !splitBucket<T>(dirIndex))
+            {
+                insertOverflow<T>(pageNo, key, rid);
+                return;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::splitBucket
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    bool HashIndex::splitBucket(const std::uint32_t dirIndex)
+    {
+        typedef typename BucketTraits<T>::Bucket Bucket;
+        const int bucketSize = BucketTraits<T>::BUCKETSIZE;
+
+        PageId pageNo = directory[dirIndex];
+        Page * page;
+        bufMgr->readPage(file, pageNo, page);
+        Bucket * bucket = (Bucket *) page;
+        int depth = bucket->localDepth;
+        if (depth >= HASHMAXDEPTH)
+        {
+            bufMgr->unPinPage(file, pageNo, false);
+            return false;
+        }
+
+        //Pull every entry out of the bucket and its overflow chain, the chain pages are reused below
+        std::vector<T> allKeys;
+        std::vector<RecordId> allRids;
+        std::vector<PageId> sparePages;
+        PageId chainNo = bucket->overflowPageNo;
+        allKeys.insert(allKeys.end(), nodeKeys<T>(bucket), nodeKeys<T>(bucket) + bucket->numEntries);
+        allRids.insert(allRids.end(), bucket->ridArray, bucket->ridArray + bucket->numEntries);
+        while (chainNo != Page::INVALID_NUMBER)
+        {
+            Page * chainPage;
+            bufMgr->readPage(file, chainNo, chainPage);
+            Bucket * chain = (Bucket *) chainPage;
+            allKeys.insert(allKeys.end(), nodeKeys<T>(chain), nodeKeys<T>(chain) + chain->numEntries);
+            allRids.insert(allRids.end(), chain->ridArray, chain->ridArray + chain->numEntries);
+            sparePages.push_back(chainNo);
+            PageId next = chain->overflowPageNo;
+            bufMgr->unPinPage(file, chainNo, false);
+            chainNo = next;
+        }
+
+        if (depth == globalDepth)
+        {
+            doubleDirectory();
+        }
+
+        PageId newPageNo;
+        Page * newPage;
+        allocBucket(newPageNo, newPage);
+        Bucket * newBucket = (Bucket *) newPage;
+        bucket->localDepth = depth + 1;
+        bucket->numEntries = 0;
+        bucket->overflowPageNo = Page::INVALID_NUMBER;
+        newBucket->localDepth = depth + 1;
+
+        //Entries with hash bit depth set move to the new bucket, whatever does not fit is spilled
+        std::vector<T> spillKeys;
+        std::vector<RecordId> spillRids;
+        for (size_t i = 0; i < allKeys.size(); i++)
+        {
+            Bucket * target = bucket;
+            if ((hashKey(allKeys[i]) >> depth) & 1)
+            {
+                target = newBucket;
+            }
+            if (target->numEntries < bucketSize)
+            {
+                nodeKeys<T>(target)[target->numEntries] = allKeys[i];
+                target->ridArray[target->numEntries] = allRids[i];
+                target->numEntries++;
+            }
+            else
+            {
+                spillKeys.push_back(allKeys[i]);
+                spillRids.push_back(allRids[i]);
+            }
+        }
+        bufMgr->unPinPage(file, newPageNo, true);
+        bufMgr->unPinPage(file, pageNo, true);
+
+        for (size_t i = 0; i < directory.size(); i++)
+        {
+            if (directory[i] == pageNo && ((i >> depth) & 1))
+            {
+                directory[i] = newPageNo;
+            }
+        }
+        writeDirectory();
+
+        //Whatever did not fit goes back into the overflow chains, reusing the old chain pages first
+        for (size_t i = 0; i < spillKeys.size(); i++)
+        {
+            PageId target = ((hashKey(spillKeys[i]) >> depth) & 1) ? newPageNo : pageNo;
+            PageId tail = target;
+            Page * tailPage;
+            while (true)
+            {
+                bufMgr->readPage(file, tail, tailPage);
+                PageId next = ((Bucket *) tailPage)->overflowPageNo;
+                if (next == Page::INVALID_NUMBER)
+                {
+                    break;
+                }
+                bufMgr->unPinPage(file, tail, false);
+                tail = next;
+            }
+            Bucket * tailBucket = (Bucket *) tailPage;
+            if (tailBucket->numEntries == bucketSize)
+            {
+                PageId chainId;
+                Page * chainPage;
+                if (!sparePages.empty())
+                {
+                    chainId = sparePages.back();
+                    sparePages.pop_back();
+                    bufMgr->readPage(file, chainId, chainPage);
+                    memset((void *) chainPage, 0, Page::SIZE);
+                }
+                else
+                {
+                    allocBucket(chainId, chainPage);
+                }
+                tailBucket->overflowPageNo = chainId;
+                bufMgr->unPinPage(file, tail, true);
+                tail = chainId;
+                tailBucket = (Bucket *) chainPage;
+            }
+            nodeKeys<T>(tailBucket)[tailBucket->numEntries] = spillKeys[i];
+            tailBucket->ridArray[tailBucket->numEntries] = spillRids[i];
+            tailBucket->numEntries++;
+            bufMgr->unPinPage(file, tail, true);
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::insertOverflow
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void HashIndex::insertOverflow(const PageId pageNo, const T& key, const RecordId rid)
+    {
+        typedef typename BucketTraits<T>::Bucket Bucket;
+
+        //Walk to the last page of the chain, new entries are appended there
+        PageId tail = pageNo;
+        Page * page;
+        while (true)
+        {
+            bufMgr->readPage(file, tail, page);
+            PageId next = ((Bucket *) page)->overflowPageNo;
+            if (next == Page::INVALID_NUMBER)
+            {
+                break;
+            }
+            bufMgr->unPinPage(file, tail, false);
+            tail = next;
+        }
+
+        Bucket * bucket = (Bucket *) page;
+        if (bucket->numEntries == BucketTraits<T>::BUCKETSIZE)
+        {
+            PageId newPageNo;
+            Page * newPage;
+            allocBucket(newPageNo, newPage);
+            bucket->overflowPageNo = newPageNo;
+            bufMgr->unPinPage(file, tail, true);
+            tail = newPageNo;
+            bucket = (Bucket *) newPage;
+        }
+        nodeKeys<T>(bucket)[bucket->numEntries] = key;
+        bucket->ridArray[bucket->numEntries] = rid;
+        bucket->numEntries++;
+        bufMgr->unPinPage(file, tail, true);
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::startScan
+    // -----------------------------------------------------------------------------
+
+    const void HashIndex::startScan(const void* lowValParm,
+                                    const Operator lowOpParm,
+                                    const void* highValParm,
+                                    const Operator highOpParm)
+    {
+        if (lowOpParm != GTE || highOpParm != LTE)
+        {
+            throw BadOpcodesException();
+        }
+
+        if (scanExecuting)
+        {
+            endScan();
+        }
+
+        std::uint32_t hash;
+        if (attributeType == INTEGER)
+        {
+            scanValInt = keyFromPtr<int>(lowValParm);
+            if (scanValInt != keyFromPtr<int>(highValParm))
+            {
+                throw BadScanrangeException();
+            }
+            hash = hashKey(scanValInt);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            scanValDouble = keyFromPtr<double>(lowValParm);
+            if (scanValDouble != keyFromPtr<double>(highValParm))
+            {
+                throw BadScanrangeException();
+            }
+            hash = hashKey(scanValDouble);
+        }
+        else
+        {
+            scanValString = keyFromPtr<StringKey>(lowValParm);
+            if (scanValString != keyFromPtr<StringKey>(highValParm))
+            {
+                throw BadScanrangeException();
+            }
+            hash = hashKey(scanValString);
+        }
+
+        currentPageNum = directory[hash & (((std::uint32_t) 1 << globalDepth) - 1)];
+        bufMgr->readPage(file, currentPageNum, currentPageData);
+        nextEntry = 0;
+        scanExecuting = true;
+
+        //Position on the first match, or give up straight away if there is none
+        RecordId first;
+        try
+        {
+            scanNext(first);
+        }
+        catch (IndexScanCompletedException e)
+        {
+            endScan();
+            throw NoSuchKeyFoundException();
+        }
+        nextEntry--;
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::scanNext
+    // -----------------------------------------------------------------------------
+
+    const void HashIndex::scanNext(RecordId& outRid)
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        if (attributeType == INTEGER)
+        {
+            scanNextTyped<int>(scanValInt, outRid);
+        }
+        else if (attributeType == DOUBLE)
+        {
+            scanNextTyped<double>(scanValDouble, outRid);
+        }
+        else
+        {
+            scanNextTyped<StringKey>(scanValString, outRid);
+        }
+    }
+
+    template <class T>
+    void HashIndex::scanNextTyped(const T& key, RecordId& outRid)
+    {
+        typedef typename BucketTraits<T>::Bucket Bucket;
+
+        while (currentPageData != NULL)
+        {
+            Bucket * bucket = (Bucket *) currentPageData;
+            T * keys = nodeKeys<T>(bucket);
+            for (; nextEntry < bucket->numEntries; nextEntry++)
+            {
+                if (keys[nextEntry] == key)
+                {
+                    outRid = bucket->ridArray[nextEntry];
+                    nextEntry++;
+                    return;
+                }
+            }
+
+            //Bucket page used up, continue down the overflow chain
+            PageId next = bucket->overflowPageNo;
+            bufMgr->unPinPage(file, currentPageNum, false);
+            currentPageNum = next;
+            currentPageData = NULL;
+            nextEntry = 0;
+            if (next != Page::INVALID_NUMBER)
+            {
+                bufMgr->readPage(file, currentPageNum, currentPageData);
+            }
+        }
+        throw IndexScanCompletedException();
+    }
+
+    // -----------------------------------------------------------------------------
+    // HashIndex::endScan
+    // -----------------------------------------------------------------------------
+
+    const void HashIndex::endScan()
+    {
+        if (!scanExecuting)
+        {
+            throw ScanNotInitializedException();
+        }
+        scanExecuting = false;
+        if (currentPageData != NULL)
+        {
+            bufMgr->unPinPage(file, currentPageNum, false);
+        }
+        currentPageNum = Page::INVALID_NUMBER;
+        currentPageData = NULL;
+    }
+
+}
@@ -0,0 +1,420 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "string.h"
+#include <sstream>
+
+#include "types.h"
+#include "page.h"
+#include "file.h"
+#include "buffer.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Maximum global depth of the directory. The directory can then address 2^20 buckets.
+ */
+const  int HASHMAXDEPTH = 20;
+
+/**
+ * @brief Number of bucket page numbers held by one directory page.
+ */
+const  int HASHDIRARRAYSIZE = Page::SIZE / sizeof( PageId );
+
+/**
+ * @brief Number of directory pages the meta page can point at.
+ */
+const  int HASHMAXDIRPAGES = ( ( 1 << HASHMAXDEPTH ) + HASHDIRARRAYSIZE - 1 ) / HASHDIRARRAYSIZE;
+
+/**
+ * @brief Number of entry slots in a hash bucket for INTEGER key.
+ */
+//                                                  depth, count, overflow ptr             key               rid
+const  int INTARRAYBUCKETSIZE = ( Page::SIZE - 2 * sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
+
+/**
+ * @brief Number of entry slots in a hash bucket for DOUBLE key.
+ */
+//                                                     depth, count, overflow ptr               key               rid
+const  int DOUBLEARRAYBUCKETSIZE = ( Page::SIZE - 2 * sizeof( int ) - sizeof( PageId ) ) / ( sizeof( double ) + sizeof( RecordId ) );
+
+/**
+ * @brief Number of entry slots in a hash bucket for STRING key.
+ */
+//                                                     depth, count, overflow ptr           key                      rid
+const  int STRINGARRAYBUCKETSIZE = ( Page::SIZE - 2 * sizeof( int ) - sizeof( PageId ) ) / ( STRINGSIZE * sizeof(char) + sizeof( RecordId ) );
+
+/**
+ * @brief The meta page of a hash index file. Like IndexMetaInfo it is always the first page of the file.
+ * Besides the relation, attribute and type it stores the global depth of the directory and the pages
+ * the directory is spread over. The directory itself is an array of 2^globalDepth bucket page numbers.
+*/
+struct HashIndexMetaInfo{
+  /**
+   * Name of base relation.
+   */
+	char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored in pages.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+	Datatype attrType;
+
+  /**
+   * Number of hash bits used to index the directory.
+   */
+	int globalDepth;
+
+  /**
+   * Number of directory pages in use.
+   */
+	int numDirPages;
+
+  /**
+   * Page numbers of the directory pages, in directory order.
+   */
+	PageId dirPageNoArray[ HASHMAXDIRPAGES ];
+};
+
+/*
+Bucket pages are cast to the structures below. Entries are unsorted and packed from the left, numEntries of
+them are in use. localDepth is the number of hash bits shared by every key in the bucket; 2^(globalDepth - localDepth)
+directory slots point at it. A bucket that cannot be split any further, because all its keys hash alike, chains
+overflow pages through overflowPageNo.
+*/
+
+/**
+ * @brief Structure for all hash buckets when the key is of INTEGER type.
+*/
+struct HashBucketInt{
+  /**
+   * Number of hash bits shared by the keys in this bucket.
+   */
+	int localDepth;
+
+  /**
+   * Number of entries in use.
+   */
+	int numEntries;
+
+  /**
+   * Page number of the next overflow page of this bucket, 0 if none.
+   */
+	PageId overflowPageNo;
+
+  /**
+   * Stores keys.
+   */
+	int keyArray[ INTARRAYBUCKETSIZE ];
+
+  /**
+   * Stores RecordIds.
+   */
+	RecordId ridArray[ INTARRAYBUCKETSIZE ];
+};
+
+/**
+ * @brief Structure for all hash buckets when the key is of DOUBLE type.
+*/
+struct HashBucketDouble{
+  /**
+   * Number of hash bits shared by the keys in this bucket.
+   */
+	int localDepth;
+
+  /**
+   * Number of entries in use.
+   */
+	int numEntries;
+
+  /**
+   * Page number of the next overflow page of this bucket, 0 if none.
+   */
+	PageId overflowPageNo;
+
+  /**
+   * Stores keys.
+   */
+	double keyArray[ DOUBLEARRAYBUCKETSIZE ];
+
+  /**
+   * Stores RecordIds.
+   */
+	RecordId ridArray[ DOUBLEARRAYBUCKETSIZE ];
+};
+
+/**
+ * @brief Structure for all hash buckets when the key is of STRING type.
+*/
+struct HashBucketString{
+  /**
+   * Number of hash bits shared by the keys in this bucket.
+   */
+	int localDepth;
+
+  /**
+   * Number of entries in use.
+   */
+	int numEntries;
+
+  /**
+   * Page number of the next overflow page of this bucket, 0 if none.
+   */
+	PageId overflowPageNo;
+
+  /**
+   * Stores keys.
+   */
+	char keyArray[ STRINGARRAYBUCKETSIZE ][ STRINGSIZE ];
+
+  /**
+   * Stores RecordIds.
+   */
+	RecordId ridArray[ STRINGARRAYBUCKETSIZE ];
+};
+
+/**
+ * @brief Maps a key type to the bucket structure used for it.
+*/
+template <class T>
+struct BucketTraits;
+
+template <>
+struct BucketTraits<int>{
+	typedef HashBucketInt Bucket;
+	static const int BUCKETSIZE = INTARRAYBUCKETSIZE;
+};
+
+template <>
+struct BucketTraits<double>{
+	typedef HashBucketDouble Bucket;
+	static const int BUCKETSIZE = DOUBLEARRAYBUCKETSIZE;
+};
+
+template <>
+struct BucketTraits<StringKey>{
+	typedef HashBucketString Bucket;
+	static const int BUCKETSIZE = STRINGARRAYBUCKETSIZE;
+};
+
+/**
+ * @brief HashIndex class. It implements an extendible hash index on a single attribute of a
+ * relation, for equality lookups only. The directory is kept in memory while the index is open,
+ * so a lookup normally reads a single bucket page. This index supports only one scan at a time.
+*/
+class HashIndex {
+
+ private:
+
+  /**
+   * File object for the index file.
+   */
+	File		*file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+	BufMgr	*bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+	PageId	headerPageNum;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+	Datatype	attributeType;
+
+  /**
+   * Offset of attribute, over which index is built, inside records.
+   */
+	int 		attrByteOffset;
+
+  /**
+   * Number of hash bits used to index the directory.
+   */
+	int			globalDepth;
+
+  /**
+   * In memory copy of the directory, 2^globalDepth bucket page numbers.
+   */
+	std::vector<PageId>	directory;
+
+  /**
+   * Page numbers of the directory pages inside the index file.
+   */
+	std::vector<PageId>	dirPages;
+
+
+	// MEMBERS SPECIFIC TO SCANNING
+
+  /**
+   * True if an index scan has been started.
+   */
+	bool		scanExecuting;
+
+  /**
+   * Index of next entry to be looked at in current bucket page.
+   */
+	int			nextEntry;
+
+  /**
+   * Page number of current bucket page being scanned.
+   */
+	PageId	currentPageNum;
+
+  /**
+   * Current bucket page being scanned.
+   */
+	Page		*currentPageData;
+
+  /**
+   * INTEGER value being looked up.
+   */
+	int			scanValInt;
+
+  /**
+   * DOUBLE value being looked up.
+   */
+	double	scanValDouble;
+
+  /**
+   * STRING value being looked up.
+   */
+	StringKey	scanValString;
+
+
+  /**
+   * Hashes a key. Equal keys always hash alike, including 0.0 and -0.0.
+   */
+	static std::uint32_t hashKey(const int key);
+	static std::uint32_t hashKey(const double key);
+	static std::uint32_t hashKey(const StringKey& key);
+
+  /**
+   * Allocates a zeroed page in the index file. The page is returned pinned.
+   */
+	void allocBucket(PageId& pageNo, Page*& page);
+
+  /**
+   * Writes globalDepth and the directory back into the meta and directory pages.
+   */
+	void writeDirectory();
+
+  /**
+   * Doubles the directory, growing globalDepth by one.
+   */
+	void doubleDirectory();
+
+  /**
+   * Creates the empty index: global depth 0 and a single empty bucket.
+   */
+	void initBuckets();
+
+	template <class T>
+	void insertTyped(const T& key, const RecordId rid);
+
+  /**
+   * Splits the bucket the directory slot dirIndex points at on its next hash bit.
+   * Returns false if it cannot be split because all its keys hash alike or the
+   * directory is at its maximum depth.
+   */
+	template <class T>
+	bool splitBucket(const std::uint32_t dirIndex);
+
+  /**
+   * Appends entry to the overflow chain of bucket pageNo.
+   */
+	template <class T>
+	void insertOverflow(const PageId pageNo, const T& key, const RecordId rid);
+
+	template <class T>
+	void scanNextTyped(const T& key, RecordId& outRid);
+
+
+ public:
+
+  /**
+   * HashIndex Constructor.
+	 * Check to see if the corresponding index file exists. If so, open the file and load the directory.
+	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built
+   * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
+   * @throws  BadIndexInfoException     If a STRING value of the relation is longer than STRINGSIZE. No index file is left behind.
+   */
+	HashIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
+
+  /**
+   * HashIndex Destructor.
+	 * End any initialized scan, flush index file and close it. Does not throw.
+	 * */
+	~HashIndex();
+
+  /**
+	 * Insert a new entry using the pair <value,rid>.
+	 * Hash the key to its bucket. If the bucket is full it is split, doubling the directory first
+	 * if its local depth equals the global depth. A bucket that cannot be split gets an overflow page.
+   * @param key			Key to insert, pointer to integer/double/char string
+   * @param rid			Record ID of a record whose entry is getting inserted into the index.
+	**/
+	const void insertEntry(const void* key, const RecordId rid);
+
+  /**
+	 * Begin an equality scan of the index. Takes the same arguments as BTreeIndex::startScan()
+	 * but only closed ranges of a single value, ie. (v,GTE,v,LTE), can be answered by a hash index.
+	 * If another scan is already executing, that needs to be ended here.
+	 * The bucket holding the value is kept pinned until the scan ends.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator, must be GTE
+   * @param highVal	High value of range, must equal lowVal
+   * @param highOp	High operator, must be LTE
+   * @throws  BadOpcodesException If lowOp is not GTE or highOp is not LTE
+   * @throws  BadScanrangeException If lowVal != highVal
+	 * @throws  NoSuchKeyFoundException If there is no entry with the value.
+	**/
+	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  /**
+	 * Fetch the record id of the next index entry that matches the scan.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNext(RecordId& outRid);
+
+  /**
+	 * Terminate the current scan. Unpin any pinned pages. Reset scan specific variables.
+	 * @throws ScanNotInitializedException If no scan has been initialized.
+	**/
+	const void endScan();
+
+  /**
+   * Returns the number of hash bits currently used to index the directory.
+   */
+	int getGlobalDepth() const { return globalDepth; }
+};
+
+}
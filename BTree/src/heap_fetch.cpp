@@ -0,0 +1,108 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include "heap_fetch.h"
+#include "exceptions/index_scan_completed_exception.h"
+
+
+namespace badgerdb
+{
+    // -----------------------------------------------------------------------------
+    // BitmapHeapFetch::BitmapHeapFetch -- Constructor
+    // -----------------------------------------------------------------------------
+
+    BitmapHeapFetch::BitmapHeapFetch(const std::string& relationName, BufMgr* bufMgrIn)
+    {
+        this->file = new PageFile(relationName, false);
+        this->bufMgr = bufMgrIn;
+        this->nextRid = 0;
+        this->curPageNo = Page::INVALID_NUMBER;
+        this->curPage = NULL;
+    }
+
+    // -----------------------------------------------------------------------------
+    // BitmapHeapFetch::~BitmapHeapFetch -- destructor
+    // -----------------------------------------------------------------------------
+
+    BitmapHeapFetch::~BitmapHeapFetch()
+    {
+        releasePage();
+        //Drop the frames of this file so a later File object at the same address cannot see them
+        bufMgr->flushFile(file);
+        delete file;
+    }
+
+    void BitmapHeapFetch::releasePage()
+    {
+        if (curPage != NULL)
+        {
+            bufMgr->unPinPage(file, curPageNo, false);
+            curPage = NULL;
+            curPageNo = Page::INVALID_NUMBER;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // BitmapHeapFetch::fetch
+    // -----------------------------------------------------------------------------
+
+    const void BitmapHeapFetch::fetch(const std::vector<RecordId>& batch)
+    {
+        releasePage();
+        rids = batch;
+        std::sort(rids.begin(), rids.end(), ridBefore);
+        nextRid = 0;
+    }
+
+    int BitmapHeapFetch::fetchFromScan(BTreeIndex* index, const int batchSize)
+    {
+        releasePage();
+        rids.clear();
+        nextRid = 0;
+        RecordId rid;
+        try
+        {
+            while (rids.size() < (size_t) batchSize)
+            {
+                index->scanNext(rid);
+                rids.push_back(rid);
+            }
+        }
+        catch (IndexScanCompletedException e)
+        {
+        }
+        std::sort(rids.begin(), rids.end(), ridBefore);
+        return rids.size();
+    }
+
+    // -----------------------------------------------------------------------------
+    // BitmapHeapFetch::next
+    // -----------------------------------------------------------------------------
+
+    bool BitmapHeapFetch::next(RecordView& outView)
+    {
+        if (nextRid >= rids.size())
+        {
+            releasePage();
+            return false;
+        }
+        const RecordId& rid = rids[nextRid];
+        nextRid++;
+
+        //Pages come in ascending order, so each is read once per batch
+        if (curPage == NULL || curPageNo != rid.page_number)
+        {
+            releasePage();
+            bufMgr->readPage(file, rid.page_number, curPage);
+            curPageNo = rid.page_number;
+        }
+        outView.rid = rid;
+        outView.data = curPage->getRecordData(rid, outView.length);
+        return true;
+    }
+
+}
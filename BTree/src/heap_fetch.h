@@ -0,0 +1,100 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "types.h"
+#include "page.h"
+#include "file.h"
+#include "buffer.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Default number of RecordIds a BitmapHeapFetch takes from an index scan at a time.
+ */
+const  int HEAPFETCHBATCHSIZE = 4096;
+
+/**
+ * @brief A record returned by BitmapHeapFetch, in place on its page.
+*/
+struct RecordView{
+	RecordId rid;
+	const char* data;
+	std::uint16_t length;
+};
+
+/**
+ * @brief BitmapHeapFetch class. Reads the records of a batch of RecordIds, typically taken from an index scan,
+ * in (page_number, slot_number) order instead of the order of the index. Every page of the relation the batch
+ * touches is read once and kept pinned while its records are returned, so an index on a column whose order
+ * has nothing to do with the order of the relation no longer rereads the same pages over and over.
+*/
+class BitmapHeapFetch {
+
+ private:
+
+	PageFile	*file;
+	BufMgr	*bufMgr;
+
+  /**
+   * Current batch in (page_number, slot_number) order, and the next one to return.
+   */
+	std::vector<RecordId>	rids;
+	size_t	nextRid;
+
+  /**
+   * Page pinned for the records being returned, NULL if none.
+   */
+	PageId	curPageNo;
+	Page		*curPage;
+
+	void releasePage();
+
+ public:
+
+  /**
+   * Opens the relation.
+   * @param relationName	Name of the relation the RecordIds point into
+   * @param bufMgrIn		Buffer Manager Instance
+   */
+	BitmapHeapFetch(const std::string& relationName, BufMgr* bufMgrIn);
+
+  /**
+   * Unpins the current page and closes the relation.
+   */
+	~BitmapHeapFetch();
+
+  /**
+   * Starts returning the records of a new batch of RecordIds.
+   * @param batch	RecordIds, in any order
+   */
+	const void fetch(const std::vector<RecordId>& batch);
+
+  /**
+   * Starts returning the records of the next RecordIds of an index scan, which the caller has started and ends.
+   * @param index		Index being scanned
+   * @param batchSize	Most RecordIds to take
+   * @return the number of RecordIds taken, less than batchSize once the scan has completed
+   */
+	int fetchFromScan(BTreeIndex* index, const int batchSize = HEAPFETCHBATCHSIZE);
+
+  /**
+	 * Fetch the next record of the batch. Its bytes stay valid until the next call to next() or fetch().
+   * @param outView	Set to the RecordId and the bytes of the record
+   * @return false once every record of the batch has been returned
+	**/
+	bool next(RecordView& outView);
+};
+
+}
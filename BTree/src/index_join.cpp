@@ -0,0 +1,205 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include "index_join.h"
+#include "exceptions/end_of_file_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/bad_scan_param_exception.h"
+
+
+namespace badgerdb
+{
+    template <class T>
+    static T rawKey(const std::string& bytes)
+    {
+        T key;
+        memcpy((void *) &key, bytes.data(), sizeof(T));
+        return key;
+    }
+
+    template <class T>
+    static bool keyBefore(const IndexNestedLoopJoin::OuterEntry& a, const IndexNestedLoopJoin::OuterEntry& b)
+    {
+        return rawKey<T>(a.key) < rawKey<T>(b.key);
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexNestedLoopJoin::IndexNestedLoopJoin -- Constructor
+    // -----------------------------------------------------------------------------
+
+    IndexNestedLoopJoin::IndexNestedLoopJoin(const std::string& outerRelation, const int outerAttrOffset,
+                                             BTreeIndex* innerIndex, BufMgr* bufMgrIn, const int batchSize)
+    {
+        if (batchSize < 1)
+        {
+            throw BadScanParamException();
+        }
+        this->inner = innerIndex;
+        this->outerScan = new FileScan(outerRelation, bufMgrIn);
+        this->outerAttrOffset = outerAttrOffset;
+        this->batchSize = batchSize;
+        this->outerDone = false;
+        this->probing = false;
+        this->runStart = 0;
+        this->runEnd = 0;
+        this->runPos = 0;
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexNestedLoopJoin::~IndexNestedLoopJoin -- destructor
+    // -----------------------------------------------------------------------------
+
+    IndexNestedLoopJoin::~IndexNestedLoopJoin()
+    {
+        if (probing)
+        {
+            inner->endScan();
+        }
+        delete outerScan;
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexNestedLoopJoin::next
+    // -----------------------------------------------------------------------------
+
+    bool IndexNestedLoopJoin::next(RecordId& outOuterRid, RecordId& outInnerRid)
+    {
+        if (inner->getAttrType() == INTEGER)
+        {
+            return nextTyped<int>(outOuterRid, outInnerRid);
+        }
+        else if (inner->getAttrType() == DOUBLE)
+        {
+            return nextTyped<double>(outOuterRid, outInnerRid);
+        }
+        else
+        {
+            return nextTyped<StringKey>(outOuterRid, outInnerRid);
+        }
+    }
+
+    template <class T>
+    bool IndexNestedLoopJoin::nextTyped(RecordId& outOuterRid, RecordId& outInnerRid)
+    {
+        while (true)
+        {
+            //Pair the current inner entry with every outer entry of its key
+            if (runPos < runEnd)
+            {
+                outOuterRid = batch[runPos].rid;
+                outInnerRid = innerRid;
+                runPos++;
+                return true;
+            }
+            if (probing && nextInner<T>())
+            {
+                continue;
+            }
+            if (!loadBatch<T>())
+            {
+                return false;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexNestedLoopJoin::loadBatch
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    bool IndexNestedLoopJoin::loadBatch()
+    {
+        batch.clear();
+        while (!outerDone && batch.size() < (size_t) batchSize)
+        {
+            OuterEntry entry;
+            try
+            {
+                outerScan->scanNext(entry.rid);
+            }
+            catch (EndOfFileException e)
+            {
+                outerDone = true;
+                break;
+            }
+            std::string record = outerScan->getRecord();
+            T key = keyFromPtr<T>(record.c_str() + outerAttrOffset);
+            entry.key = std::string((const char *) &key, sizeof(T));
+            batch.push_back(entry);
+        }
+        if (batch.empty())
+        {
+            return false;
+        }
+
+        //Stable, so outer tuples with the same key keep the order of the relation
+        std::stable_sort(batch.begin(), batch.end(), keyBefore<T>);
+
+        //One point range per distinct key
+        std::vector<ScanRange> ranges;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (i == 0 || rawKey<T>(batch[i - 1].key) < rawKey<T>(batch[i].key))
+            {
+                ScanRange range;
+                range.lowVal = batch[i].key.data();
+                range.lowOp = GTE;
+                range.highVal = batch[i].key.data();
+                range.highOp = LTE;
+                ranges.push_back(range);
+            }
+        }
+        runStart = 0;
+        runEnd = 0;
+        runPos = 0;
+        try
+        {
+            inner->startMultiRangeScan(ranges.data(), ranges.size());
+            probing = true;
+        }
+        catch (NoSuchKeyFoundException e)
+        {
+            probing = false;
+        }
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexNestedLoopJoin::nextInner
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    bool IndexNestedLoopJoin::nextInner()
+    {
+        T key;
+        try
+        {
+            inner->scanNext(innerRid, &key);
+        }
+        catch (IndexScanCompletedException e)
+        {
+            inner->endScan();
+            probing = false;
+            return false;
+        }
+
+        //Inner entries come in key order, so the run only ever moves right
+        while (runStart < batch.size() && rawKey<T>(batch[runStart].key) < key)
+        {
+            runStart++;
+        }
+        runEnd = runStart;
+        while (runEnd < batch.size() && !(key < rawKey<T>(batch[runEnd].key)))
+        {
+            runEnd++;
+        }
+        runPos = runStart;
+        return true;
+    }
+
+}
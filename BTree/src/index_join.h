@@ -0,0 +1,118 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+#include "buffer.h"
+#include "filescan.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Default number of outer tuples an IndexNestedLoopJoin buffers and sorts before probing the index.
+ */
+const  int JOINBATCHSIZE = 4096;
+
+/**
+ * @brief IndexNestedLoopJoin class. Joins a relation, read with a FileScan, to a BTreeIndex on the join attribute.
+ * Outer tuples are read a batch at a time and sorted by their join key. The distinct keys of the batch are then
+ * probed with one multi-range scan of the index, so consecutive probes reuse the current leaf and the path above it
+ * and the leaves are visited left to right, instead of each probe descending from the root on its own.
+ * The join holds the scan of the inner index while it runs; the index must not be scanned or changed meanwhile.
+*/
+class IndexNestedLoopJoin {
+
+ public:
+
+  /**
+   * An outer tuple of the current batch, its key kept as raw bytes of the key type of the index.
+   */
+	struct OuterEntry {
+		std::string	key;
+		RecordId	rid;
+	};
+
+ private:
+
+	BTreeIndex	*inner;
+	FileScan	*outerScan;
+	int			outerAttrOffset;
+	int			batchSize;
+
+  /**
+   * True once the outer relation has been read to its end.
+   */
+	bool		outerDone;
+
+  /**
+   * True while the multi-range scan over the keys of the current batch is open.
+   */
+	bool		probing;
+
+  /**
+   * Current batch in key order.
+   */
+	std::vector<OuterEntry>	batch;
+
+  /**
+   * Inner entry returned last, and the outer entries of the batch with its key: [runStart, runEnd),
+   * runPos being the next one to pair with it.
+   */
+	RecordId	innerRid;
+	size_t	runStart;
+	size_t	runEnd;
+	size_t	runPos;
+
+  /**
+   * Reads and sorts the next batch and starts probing its keys. Returns false once the outer relation is exhausted.
+   */
+	template <class T>
+	bool loadBatch();
+
+  /**
+   * Fetches the next matching inner entry and finds the outer entries with its key. Returns false at the end of the batch.
+   */
+	template <class T>
+	bool nextInner();
+
+	template <class T>
+	bool nextTyped(RecordId& outOuterRid, RecordId& outInnerRid);
+
+ public:
+
+  /**
+   * Sets up the join. Nothing is read until the first call to next().
+   * @param outerRelation		Name of the outer relation
+   * @param outerAttrOffset	Offset of the join attribute inside the outer records, of the type the index is built on
+   * @param innerIndex			Index on the join attribute of the inner relation
+   * @param bufMgrIn				Buffer Manager Instance
+   * @param batchSize				Number of outer tuples sorted and probed together
+   */
+	IndexNestedLoopJoin(const std::string& outerRelation, const int outerAttrOffset, BTreeIndex* innerIndex,
+						BufMgr* bufMgrIn, const int batchSize = JOINBATCHSIZE);
+
+  /**
+   * Ends the scan of the inner index if it is still open.
+   */
+	~IndexNestedLoopJoin();
+
+  /**
+	 * Fetch the next pair of matching records. Pairs come batch by batch, in key order within a batch.
+   * @param outOuterRid	RecordId of the outer record
+   * @param outInnerRid	RecordId of the inner record with the same key
+   * @return false once every pair has been returned
+	**/
+	bool next(RecordId& outOuterRid, RecordId& outInnerRid);
+};
+
+}
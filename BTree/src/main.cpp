@@ -6,7 +6,19 @@
  */
 
 #include <vector>
+#include <algorithm>
+#include <climits>
+#include <fstream>
 #include "btree.h"
+#include "hash_index.h"
+#include "frozen_index.h"
+#include "parallel_scan.h"
+#include "index_join.h"
+#include "merge_join.h"
+#include "rid_merge.h"
+#include "heap_fetch.h"
+#include "clustered_index.h"
+#include "art_index.h"
 #include "page.h"
 #include "filescan.h"
 #include "page_iterator.h"
@@ -19,6 +31,9 @@
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/scan_not_initialized_exception.h"
 #include "exceptions/end_of_file_exception.h"
+#include "exceptions/bad_scan_param_exception.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/page_pinned_exception.h"
 
 #define checkPassFail(a, b) 																				\
 {																																		\
@@ -43,7 +58,7 @@ int testNum = 1;
 const std::string relationName = "relA";
 //If the relation size is changed then the second parameter 2 chechPassFail may need to be changed to number of record that are expected to be found during the scan, else tests will erroneously be reported to have failed.
 const int	relationSize = 5000;
-std::string intIndexName, doubleIndexName, stringIndexName;
+std::string intIndexName, doubleIndexName, stringIndexName, hashIndexName;
 
 // This is the structure for tuples in the base relation
 
@@ -73,7 +88,47 @@ void indexTests();
 void doubleTests();
 int doubleScan(BTreeIndex *index, double lowVal, Operator lowOp, double highVal, Operator highOp);
 void stringTests();
+void longStringTests();
 int stringScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int longKeyScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int frozenCount(FrozenIndex *frozen, const void *low, Operator lowOp, const void *high, Operator highOp);
+void hashTests();
+void frozenTests();
+void compactTests();
+void multiRangeTests();
+void distinctTests();
+void topKTests();
+void countTests();
+void postingTests();
+int postingScan(BTreeIndex *index, int val, ScanDirection direction, int &breaks);
+void histogramTests();
+void parallelTests();
+void joinTests();
+void mergeJoinTests();
+void ridMergeTests();
+void heapFetchTests();
+void compositeTests();
+int compositeScan(BTreeIndex *index, PageFile *file, const std::vector<KeyColumn> &columns, const void *const *lowVals, int numLow, Operator lowOp, const void *const *highVals, int numHigh, Operator highOp);
+int coveredScan(BTreeIndex *index, PageFile *file, int lowVal, int highVal);
+void clusteredTests();
+int clusteredScan(ClusteredIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+void artTests();
+void residentTests();
+int ridMergeCount(const IndexPredicate *predicates, int n, RidMergeOp op, int bitmapThreshold, const std::vector<bool> &qualifies);
+int mergeJoinCount(BTreeIndex *leftIndex, PageFile *leftFile, BTreeIndex *rightIndex, PageFile *rightFile);
+int joinCount(const std::string &outerName, PageFile *outerFile, BTreeIndex *index, int offset, int batchSize);
+int parallelScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, int numWorkers, bool ordered, int &numPartitions);
+bool estimateClose(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, int actual);
+int typedCount(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int rankScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, ScanDirection direction, int k, int &firstKey);
+int limitScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, ScanDirection direction, int limit, int &firstKey);
+int distinctScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int keyToInt(const char *key);
+void testedAttribute(Datatype &type, int &offset);
+int multiRangeScan(BTreeIndex *index, const int *lowVals, const Operator *lowOps, const int *highVals, const Operator *highOps, int n);
+template <class Index>
+int typedScan(Index *index, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int hashLookup(HashIndex *index, int val);
 void test1();
 void test2();
 void test3();
@@ -166,7 +221,7 @@ int main(int argc, char **argv)
 	test1();
 	test2();
 	test3();
-	//errorTests();
+	errorTests();
 
   return 1;
 }
@@ -397,6 +452,7 @@ void indexTests()
   else if(testNum == 3)
   {
     stringTests();
+    longStringTests();
 		try
 		{
 			File::remove(stringIndexName);
@@ -405,6 +461,33 @@ void indexTests()
   	{
   	}
   }
+
+  hashTests();
+	try
+	{
+		File::remove(hashIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+
+  frozenTests();
+  compactTests();
+  multiRangeTests();
+  distinctTests();
+  topKTests();
+  countTests();
+  postingTests();
+  histogramTests();
+  parallelTests();
+  joinTests();
+  mergeJoinTests();
+  ridMergeTests();
+  heapFetchTests();
+  compositeTests();
+  clusteredTests();
+  artTests();
+  residentTests();
 }
 
 // -----------------------------------------------------------------------------
@@ -424,6 +507,31 @@ void intTests()
 	checkPassFail(intScan(&index,0,GT,1,LT), 0)
 	checkPassFail(intScan(&index,300,GT,400,LT), 99)
 	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+
+	// keys close together are packed in fewer bytes than whole ints, so full leaves hold more of them
+	index.compact();
+	IndexStats stats;
+	index.collectStats(stats);
+	checkPassFail((stats.levels[0].maxEntries > (int)((Page::SIZE - 2 * sizeof(PageId)) / (sizeof(int) + sizeof(RecordId)))), true)
+
+	// keys far apart widen the packing of the leaves they land in
+	const int intMin = std::numeric_limits<int>::min();
+	const int intMax = std::numeric_limits<int>::max();
+	RecordId wideRid;
+	wideRid.page_number = 1;
+	wideRid.slot_number = 1;
+	for(int i = 0; i < 400; i++)
+	{
+		int wideKey = intMin + ((i * 7) % 400) * 10000000;
+		index.insertEntry(&wideKey, wideRid);
+	}
+	index.insertEntry(&intMax, wideRid);
+	index.verify();
+	checkPassFail(intScan(&index,intMin,GTE,-1,LTE), 215)
+	checkPassFail(intScan(&index,relationSize,GTE,intMax,LTE), 186)
+	checkPassFail(intScan(&index,intMax,GTE,intMax,LTE), 1)
+	checkPassFail(intScan(&index,intMin,GT,intMin + 10000000,LT), 0)
+	checkPassFail(intScan(&index,0,GTE,relationSize,LT), relationSize)
 }
 
 int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
@@ -582,6 +690,205 @@ void stringTests()
 	checkPassFail(stringScan(&index,0,GT,1,LT), 0)
 	checkPassFail(stringScan(&index,300,GT,400,LT), 99)
 	checkPassFail(stringScan(&index,3000,GTE,4000,LT), 1000)
+
+	// leaves hold short keys in fewer bytes than a fixed width slot
+	IndexStats stats;
+	index.collectStats(stats);
+	checkPassFail((stats.levels[0].maxEntries > (int)(Page::SIZE / (STRINGSIZE + sizeof(RecordId)))), true)
+
+	// keys differing only after a 36 byte common prefix are not cut short
+	RecordId longRid;
+	longRid.page_number = 1;
+	longRid.slot_number = 1;
+	for(int i = 0; i < 500; i++)
+	{
+		char longKey[100];
+		sprintf(longKey, "tenant-0000000042/region-eu/objects/%05d", (i * 7) % 500);
+		index.insertEntry(longKey, longRid);
+	}
+	index.verify();
+	checkPassFail(longKeyScan(&index,100,GTE,200,LT), 100)
+	checkPassFail(longKeyScan(&index,42,GTE,42,LTE), 1)
+	checkPassFail(longKeyScan(&index,42,GT,43,LT), 0)
+	checkPassFail(longKeyScan(&index,-1,GT,500,LT), 500)
+	checkPassFail(stringScan(&index,0,GTE,relationSize,LT), relationSize)
+
+	// a key of STRINGSIZE bytes is kept whole, a longer one is refused rather than cut short
+	char fullKey[STRINGSIZE + 2];
+	memset(fullKey, 'z', STRINGSIZE + 1);
+	fullKey[STRINGSIZE + 1] = '\0';
+	try
+	{
+		index.insertEntry(fullKey, longRid);
+		std::cout << "BadIndexInfoException Long Key Insert Test Failed." << std::endl;
+	}
+	catch(BadIndexInfoException e)
+	{
+		std::cout << "BadIndexInfoException Long Key Insert Test Passed." << std::endl;
+	}
+	try
+	{
+		index.startScan(fullKey, GTE, fullKey, LTE);
+		std::cout << "BadIndexInfoException Long Key Scan Test Failed." << std::endl;
+	}
+	catch(BadIndexInfoException e)
+	{
+		std::cout << "BadIndexInfoException Long Key Scan Test Passed." << std::endl;
+	}
+	fullKey[STRINGSIZE] = '\0';
+	index.insertEntry(fullKey, longRid);
+	fullKey[STRINGSIZE - 1] = 'y';
+	index.insertEntry(fullKey, longRid);
+	fullKey[STRINGSIZE - 1] = 'z';
+	index.startScan(fullKey, GTE, fullKey, LTE);
+	RecordId fullRid;
+	index.scanNext(fullRid);
+	try
+	{
+		index.scanNext(fullRid);
+		std::cout << "Full Length Key Test Failed." << std::endl;
+	}
+	catch(IndexScanCompletedException e)
+	{
+		std::cout << "Full Length Key Test Passed." << std::endl;
+	}
+	index.endScan();
+
+	// keys that differ early but run on for long leave short separators, so one root still holds every leaf
+	for(int i = 0; i < 20000; i++)
+	{
+		char longKey[100];
+		sprintf(longKey, "%05d/objects/tenant-0000000042/region-eu/archive", (i * 7) % 20000);
+		index.insertEntry(longKey, longRid);
+	}
+	index.verify();
+	index.collectStats(stats);
+	checkPassFail(stats.height, 2)
+	checkPassFail((stats.levels[1].maxEntries > (int)(Page::SIZE / (STRINGSIZE + sizeof(PageId)))), true)
+}
+
+// -----------------------------------------------------------------------------
+// longStringTests
+// -----------------------------------------------------------------------------
+
+void longStringTests()
+{
+  std::cout << "Build indexes over a STRING value longer than STRINGSIZE" << std::endl;
+	const std::string longName = "relLong";
+	{
+		PageFile longFile(longName, true);
+		PageId pageNo;
+		Page page = longFile.allocatePage(pageNo);
+		for(int k = 0; k < 20; k++)
+		{
+			RECORD record;
+			memset(&record, 0, sizeof(record));
+			sprintf(record.s, "%05d string record", k);
+			record.i = k;
+			record.d = (double)k;
+			std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+			if(k == 10)
+			{
+				// this value runs on past the end of the tuple
+				data.resize(offsetof(tuple,s));
+				data.append(STRINGSIZE + 16, 'x');
+				data.push_back('\0');
+			}
+			page.insertRecord(data);
+		}
+		longFile.writePage(pageNo, page);
+	}
+
+	// every build is refused and leaves no file, so a second build is refused the same way
+	for(int attempt = 0; attempt < 2; attempt++)
+	{
+		std::string btreeName, residentName, hashName, clusteredName;
+		bool refused = false;
+		try
+		{
+			BTreeIndex index(longName, btreeName, bufMgr, offsetof(tuple,s), STRING);
+		}
+		catch(BadIndexInfoException e)
+		{
+			refused = true;
+		}
+		checkPassFail((refused && !File::exists(btreeName)), true)
+
+		refused = false;
+		try
+		{
+			BTreeIndex index(longName, residentName, bufMgr, offsetof(tuple,s), STRING, true);
+		}
+		catch(BadIndexInfoException e)
+		{
+			refused = true;
+		}
+		checkPassFail((refused && !File::exists(residentName)), true)
+
+		refused = false;
+		try
+		{
+			HashIndex index(longName, hashName, bufMgr, offsetof(tuple,s), STRING);
+		}
+		catch(BadIndexInfoException e)
+		{
+			refused = true;
+		}
+		checkPassFail((refused && !File::exists(hashName)), true)
+
+		refused = false;
+		try
+		{
+			ClusteredIndex index(longName, clusteredName, bufMgr, offsetof(tuple,s), STRING);
+		}
+		catch(BadIndexInfoException e)
+		{
+			refused = true;
+		}
+		checkPassFail((refused && !File::exists(clusteredName)), true)
+	}
+
+	try
+	{
+		File::remove(longName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Counts the entries between two keys of the form tenant-0000000042/region-eu/objects/<val>
+int longKeyScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  char lowValStr[100];
+  sprintf(lowValStr,"tenant-0000000042/region-eu/objects/%05d",lowVal);
+  char highValStr[100];
+  sprintf(highValStr,"tenant-0000000042/region-eu/objects/%05d",highVal);
+
+	try
+	{
+  	index->startScan(lowValStr, lowOp, highValStr, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+  int numResults = 0;
+	try
+	{
+		while(1)
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+			numResults++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+  index->endScan();
+	return numResults;
 }
 
 int stringScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
@@ -649,6 +956,2401 @@ int stringScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Oper
 	return numResults;
 }
 
+// -----------------------------------------------------------------------------
+// hashTests
+// -----------------------------------------------------------------------------
+
+void hashTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Create an extendible hash index on the same field" << std::endl;
+	{
+		HashIndex index(relationName, hashIndexName, bufMgr, offset, type);
+
+		checkPassFail(hashLookup(&index,25), 1)
+		checkPassFail(hashLookup(&index,0), 1)
+		checkPassFail(hashLookup(&index,relationSize-1), 1)
+		checkPassFail(hashLookup(&index,relationSize), 0)
+		checkPassFail(hashLookup(&index,-3), 0)
+
+		// only single value ranges can be answered
+		int int2 = 2;
+		int int5 = 5;
+		if(type == INTEGER)
+		{
+			try
+			{
+				index.startScan(&int2, GT, &int2, LTE);
+				std::cout << "BadOpcodesException Hash Test Failed." << std::endl;
+			}
+			catch(BadOpcodesException e)
+			{
+				std::cout << "BadOpcodesException Hash Test Passed." << std::endl;
+			}
+			try
+			{
+				index.startScan(&int2, GTE, &int5, LTE);
+				std::cout << "BadScanrangeException Hash Test Failed." << std::endl;
+			}
+			catch(BadScanrangeException e)
+			{
+				std::cout << "BadScanrangeException Hash Test Passed." << std::endl;
+			}
+		}
+		std::cout << "Global depth: " << index.getGlobalDepth() << std::endl;
+	}
+
+	// reopen the index file and look every key up
+	HashIndex index(relationName, hashIndexName, bufMgr, offset, type);
+	int found = 0;
+	for(int i = 0; i < relationSize; i++)
+	{
+		found += hashLookup(&index, i);
+	}
+	checkPassFail(found, relationSize)
+}
+
+int hashLookup(HashIndex * index, int val)
+{
+	int intVal = val;
+	double doubleVal = val;
+	char stringVal[100];
+	sprintf(stringVal,"%05d string record",val);
+	const void * key = &intVal;
+	if(testNum == 2)
+	{
+		key = &doubleVal;
+	}
+	else if(testNum == 3)
+	{
+		key = stringVal;
+	}
+
+	int numResults = 0;
+	try
+	{
+		index->startScan(key, GTE, key, LTE);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// frozenTests
+// -----------------------------------------------------------------------------
+
+void frozenTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Freeze a B+ Tree index into a read only snapshot" << std::endl;
+	std::string indexName, frozenName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		index.freeze(frozenName);
+	}
+	std::ifstream indexFile(indexName.c_str(), std::ios::binary | std::ios::ate);
+	long indexSize = indexFile.tellg();
+	indexFile.close();
+
+	{
+		FrozenIndex frozen(frozenName);
+		std::cout << "Index file: " << indexSize << " bytes, frozen file: " << frozen.getFileSize() << " bytes" << std::endl;
+		checkPassFail((int)frozen.getNumEntries(), relationSize)
+		checkPassFail((frozen.getFileSize() < (std::uint64_t)indexSize), true)
+
+		checkPassFail(typedScan(&frozen,25,GT,40,LT), 14)
+		checkPassFail(typedScan(&frozen,20,GTE,35,LTE), 16)
+		checkPassFail(typedScan(&frozen,-3,GT,3,LT), 3)
+		checkPassFail(typedScan(&frozen,996,GT,1001,LT), 4)
+		checkPassFail(typedScan(&frozen,0,GT,1,LT), 0)
+		checkPassFail(typedScan(&frozen,300,GT,400,LT), 99)
+		checkPassFail(typedScan(&frozen,3000,GTE,4000,LT), 1000)
+		checkPassFail(typedScan(&frozen,0,GTE,relationSize,LT), relationSize)
+
+		// a key longer than every key of the file is not cut down to them
+		if(testNum == 3)
+		{
+			checkPassFail(frozenCount(&frozen, "00042 string record~", GTE, "00043 string record", LTE), 1)
+		}
+	}
+
+	// normalized keys keep negative numbers below positive ones
+	std::string signedName = "signedFrozen";
+	if(testNum != 3)
+	{
+		RecordId rid;
+		rid.page_number = 1;
+		rid.slot_number = 1;
+		std::vector<RecordId> rids(2000, rid);
+		std::vector<int> intKeys;
+		std::vector<double> doubleKeys;
+		for(int i = -1000; i < 1000; i++)
+		{
+			intKeys.push_back(i);
+			doubleKeys.push_back(i / 2.0);
+		}
+		if(testNum == 1)
+			FrozenIndex::write(signedName, relationName, offset, intKeys, rids);
+		else
+			FrozenIndex::write(signedName, relationName, offset, doubleKeys, rids);
+
+		FrozenIndex frozen(signedName);
+		int lowInt = -3, highInt = 3;
+		double lowDouble = -3, highDouble = 3;
+		const void * low = testNum == 1 ? (const void *) &lowInt : (const void *) &lowDouble;
+		const void * high = testNum == 1 ? (const void *) &highInt : (const void *) &highDouble;
+		checkPassFail(frozenCount(&frozen, low, GT, high, LT), (testNum == 1 ? 5 : 11))
+		lowInt = -1000, highInt = -999;
+		lowDouble = -500, highDouble = -499;
+		checkPassFail(frozenCount(&frozen, low, GTE, high, LTE), (testNum == 1 ? 2 : 3))
+		highInt = 1000;
+		highDouble = 500;
+		checkPassFail(frozenCount(&frozen, low, GTE, high, LT), 2000)
+		File::remove(signedName);
+	}
+
+	try
+	{
+		File::remove(indexName);
+		File::remove(frozenName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Counts the entries of a frozen index between two keys, without looking at the records
+int frozenCount(FrozenIndex * frozen, const void * low, Operator lowOp, const void * high, Operator highOp)
+{
+	try
+	{
+		frozen->startScan(low, lowOp, high, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	int numResults = 0;
+	try
+	{
+		RecordId scanRid;
+		while(1)
+		{
+			frozen->scanNext(scanRid);
+			numResults++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	frozen->endScan();
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// compactTests
+// -----------------------------------------------------------------------------
+
+void compactTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Compact a B+ Tree index" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		index.verify();
+		IndexStats before;
+		index.collectStats(before);
+		std::cout << before.toJson() << std::endl;
+		checkPassFail((int)before.numEntries, relationSize)
+		checkPassFail(before.numFreePages, 0)
+
+		// a scan started before compact keeps reading the old leaves
+		int lowVal = 300, highVal = 400;
+		double lowDouble = lowVal, highDouble = highVal;
+		char lowString[100], highString[100];
+		sprintf(lowString,"%05d string record",lowVal);
+		sprintf(highString,"%05d string record",highVal);
+		if(testNum == 1)
+			index.startScan(&lowVal, GT, &highVal, LT);
+		else if(testNum == 2)
+			index.startScan(&lowDouble, GT, &highDouble, LT);
+		else
+			index.startScan(lowString, GT, highString, LT);
+		RecordId scanRid;
+		int numResults = 0;
+		index.scanNext(scanRid);
+		numResults++;
+		index.compact();
+		try
+		{
+			while(1)
+			{
+				index.scanNext(scanRid);
+				numResults++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		index.endScan();
+		checkPassFail(numResults, 99)
+
+		IndexStats after;
+		index.collectStats(after);
+		std::cout << after.toJson() << std::endl;
+		checkPassFail((int)after.numEntries, relationSize)
+		checkPassFail(after.leafChainBreaks, 0)
+		checkPassFail(after.numFreePages, before.numLeafPages + before.numNonLeafPages)
+		checkPassFail((after.numLeafPages <= before.numLeafPages), true)
+		index.verify();
+
+		checkPassFail(typedScan(&index,25,GT,40,LT), 14)
+		checkPassFail(typedScan(&index,20,GTE,35,LTE), 16)
+		checkPassFail(typedScan(&index,-3,GT,3,LT), 3)
+		checkPassFail(typedScan(&index,996,GT,1001,LT), 4)
+		checkPassFail(typedScan(&index,0,GT,1,LT), 0)
+		checkPassFail(typedScan(&index,3000,GTE,4000,LT), 1000)
+
+		// insert every record a second time, the splits take their pages from the free list
+		FileScan scan(relationName, bufMgr);
+		try
+		{
+			while(1)
+			{
+				scan.scanNext(scanRid);
+				std::string recordStr = scan.getRecord();
+				index.insertEntry(recordStr.c_str() + offset, scanRid);
+			}
+		}
+		catch(EndOfFileException e)
+		{
+		}
+	}
+
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		checkPassFail(typedScan(&index,25,GT,40,LT), 28)
+		checkPassFail(typedScan(&index,3000,GTE,4000,LT), 2000)
+		index.compact();
+		checkPassFail(typedScan(&index,-3,GT,3,LT), 6)
+		checkPassFail(typedScan(&index,996,GT,1001,LT), 8)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), 2 * relationSize)
+		index.verify();
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// multiRangeTests
+// -----------------------------------------------------------------------------
+
+void multiRangeTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Multi-range and IN-list scans" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+
+		// IN (4999, 25, 3, 3000, 25, 5000, -7, 1000), 25 twice and two values missing
+		int inVals[] = {4999, 25, 3, 3000, 25, 5000, -7, 1000};
+		Operator inLowOps[] = {GTE, GTE, GTE, GTE, GTE, GTE, GTE, GTE};
+		Operator inHighOps[] = {LTE, LTE, LTE, LTE, LTE, LTE, LTE, LTE};
+		checkPassFail(multiRangeScan(&index, inVals, inLowOps, inVals, inHighOps, 8), 5)
+
+		// (25,40) and [20,35] overlap, (300,400) is apart, [40,40] touches (25,40)
+		int lowVals[] = {300, 25, 20, 40};
+		Operator lowOps[] = {GT, GT, GTE, GTE};
+		int highVals[] = {400, 40, 35, 40};
+		Operator highOps[] = {LT, LT, LTE, LTE};
+		checkPassFail(multiRangeScan(&index, lowVals, lowOps, highVals, highOps, 4), 120)
+
+		// (5,5) holds nothing, and nothing lies beyond relationSize
+		int emptyLows[] = {5, relationSize};
+		Operator emptyLowOps[] = {GT, GTE};
+		int emptyHighs[] = {5, relationSize + 10};
+		Operator emptyHighOps[] = {LT, LTE};
+		checkPassFail(multiRangeScan(&index, emptyLows, emptyLowOps, emptyHighs, emptyHighOps, 2), 0)
+
+		// every key as its own IN-list value, visiting every leaf once
+		std::vector<int> allVals(relationSize);
+		std::vector<Operator> allLowOps(relationSize, GTE);
+		std::vector<Operator> allHighOps(relationSize, LTE);
+		for(int i = 0; i < relationSize; i++)
+		{
+			allVals[i] = relationSize - 1 - i;
+		}
+		checkPassFail(multiRangeScan(&index, allVals.data(), allLowOps.data(), allVals.data(), allHighOps.data(), relationSize), relationSize)
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// distinctTests
+// -----------------------------------------------------------------------------
+
+void distinctTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Distinct keys with nextDistinctKey" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+
+		// 3000 more entries for 42 span several leaves, 700 more for the first and the last key
+		int dupVals[] = {42, 0, relationSize - 1};
+		int dupCounts[] = {3000, 700, 700};
+		for(int d = 0; d < 3; d++)
+		{
+			int val = dupVals[d];
+			double valDouble = val;
+			char valString[100];
+			sprintf(valString,"%05d string record",val);
+			const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+			RecordId rid;
+			index.startScan(key, GTE, key, LTE);
+			index.scanNext(rid);
+			index.endScan();
+			for(int i = 0; i < dupCounts[d]; i++)
+			{
+				index.insertEntry(key, rid);
+			}
+		}
+		index.verify();
+
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 3001)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize + 4400)
+		checkPassFail(distinctScan(&index,0,GTE,relationSize,LT), relationSize)
+		checkPassFail(distinctScan(&index,40,GT,45,LTE), 5)
+		checkPassFail(distinctScan(&index,42,GTE,42,LTE), 1)
+		checkPassFail(distinctScan(&index,4990,GTE,relationSize,LT), relationSize - 4990)
+		int firstKey;
+		checkPassFail(limitScan(&index,42,GTE,42,LTE,BACKWARD,0,firstKey), 3001)
+		checkPassFail(limitScan(&index,41,GTE,43,LT,BACKWARD,0,firstKey), 3002)
+		checkPassFail(firstKey, 42)
+		checkPassFail(limitScan(&index,0,GTE,relationSize,LT,BACKWARD,0,firstKey), relationSize + 4400)
+
+		// scanNext reads on inside a group, nextDistinctKey leaves it
+		int lowVal = 41, highVal = 43;
+		double lowDouble = lowVal, highDouble = highVal;
+		char lowString[100], highString[100];
+		sprintf(lowString,"%05d string record",lowVal);
+		sprintf(highString,"%05d string record",highVal);
+		if(testNum == 1)
+			index.startScan(&lowVal, GTE, &highVal, LTE);
+		else if(testNum == 2)
+			index.startScan(&lowDouble, GTE, &highDouble, LTE);
+		else
+			index.startScan(lowString, GTE, highString, LTE);
+		RecordId rid;
+		char key[STRINGSIZE + sizeof(double)];
+		index.nextDistinctKey(rid, key);
+		checkPassFail(keyToInt(key), 41)
+		index.nextDistinctKey(rid, key);
+		checkPassFail(keyToInt(key), 42)
+		for(int i = 0; i < 10; i++)
+		{
+			index.scanNext(rid);
+		}
+		index.nextDistinctKey(rid, key);
+		checkPassFail(keyToInt(key), 43)
+		bool completed = false;
+		try
+		{
+			index.nextDistinctKey(rid, key);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			completed = true;
+		}
+		checkPassFail(completed, true)
+		index.endScan();
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// topKTests
+// -----------------------------------------------------------------------------
+
+void topKTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Descending and limited scans" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		index.verify();
+		int firstKey;
+
+		// newest 50
+		checkPassFail(limitScan(&index,0,GTE,relationSize,LT,BACKWARD,50,firstKey), 50)
+		checkPassFail(firstKey, relationSize - 1)
+		// oldest 10
+		checkPassFail(limitScan(&index,0,GTE,relationSize,LT,FORWARD,10,firstKey), 10)
+		checkPassFail(firstKey, 0)
+
+		checkPassFail(limitScan(&index,25,GT,40,LT,BACKWARD,0,firstKey), 14)
+		checkPassFail(firstKey, 39)
+		checkPassFail(limitScan(&index,20,GTE,35,LTE,BACKWARD,100,firstKey), 16)
+		checkPassFail(firstKey, 35)
+		checkPassFail(limitScan(&index,-3,GT,3,LT,BACKWARD,2,firstKey), 2)
+		checkPassFail(firstKey, 2)
+		checkPassFail(limitScan(&index,0,GT,1,LT,BACKWARD,0,firstKey), 0)
+		checkPassFail(limitScan(&index,3000,GTE,4000,LT,BACKWARD,0,firstKey), 1000)
+		checkPassFail(limitScan(&index,0,GTE,relationSize,LT,BACKWARD,0,firstKey), relationSize)
+
+		// nextDistinctKey only runs forward
+		int lowVal = 0, highVal = 10;
+		double lowDouble = lowVal, highDouble = highVal;
+		char lowString[100], highString[100];
+		sprintf(lowString,"%05d string record",lowVal);
+		sprintf(highString,"%05d string record",highVal);
+		if(testNum == 1)
+			index.startScan(&lowVal, GTE, &highVal, LTE, BACKWARD, 0);
+		else if(testNum == 2)
+			index.startScan(&lowDouble, GTE, &highDouble, LTE, BACKWARD, 0);
+		else
+			index.startScan(lowString, GTE, highString, LTE, BACKWARD, 0);
+		bool thrown = false;
+		try
+		{
+			RecordId rid;
+			index.nextDistinctKey(rid, NULL);
+		}
+		catch(BadScanParamException e)
+		{
+			thrown = true;
+		}
+		checkPassFail(thrown, true)
+		index.endScan();
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+int limitScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, ScanDirection direction, int limit, int &firstKey)
+{
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	try
+	{
+		if(testNum == 1)
+			index->startScan(&lowVal, lowOp, &highVal, highOp, direction, limit);
+		else if(testNum == 2)
+			index->startScan(&lowDouble, lowOp, &highDouble, highOp, direction, limit);
+		else
+			index->startScan(lowString, lowOp, highString, highOp, direction, limit);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+	int numResults = 0;
+	int lastKey = 0;
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+			Page *curPage;
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+			if(numResults == 0)
+			{
+				firstKey = myRec.i;
+			}
+			else if((direction == FORWARD && myRec.i < lastKey) || (direction == BACKWARD && myRec.i > lastKey))
+			{
+				std::cout << "Scan returned " << myRec.i << " after " << lastKey << std::endl;
+				return -1;
+			}
+			lastKey = myRec.i;
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// countTests
+// -----------------------------------------------------------------------------
+
+void countTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Range counts and seekToRank" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		checkPassFail(typedCount(&index,25,GT,40,LT), -1)
+		index.enableCounts();
+		index.verify();
+
+		checkPassFail(typedCount(&index,25,GT,40,LT), 14)
+		checkPassFail(typedCount(&index,20,GTE,35,LTE), 16)
+		checkPassFail(typedCount(&index,-3,GT,3,LT), 3)
+		checkPassFail(typedCount(&index,996,GT,1001,LT), 4)
+		checkPassFail(typedCount(&index,0,GT,1,LT), 0)
+		checkPassFail(typedCount(&index,300,GT,400,LT), 99)
+		checkPassFail(typedCount(&index,3000,GTE,4000,LT), 1000)
+		checkPassFail(typedCount(&index,0,GTE,relationSize,LT), relationSize)
+
+		int firstKey;
+		checkPassFail(rankScan(&index,0,GTE,relationSize,LT,FORWARD,100,firstKey), relationSize - 100)
+		checkPassFail(firstKey, 100)
+		checkPassFail(rankScan(&index,25,GT,40,LT,FORWARD,3,firstKey), 11)
+		checkPassFail(firstKey, 29)
+		checkPassFail(rankScan(&index,25,GT,40,LT,FORWARD,20,firstKey), 0)
+		checkPassFail(rankScan(&index,25,GT,40,LT,BACKWARD,3,firstKey), 11)
+		checkPassFail(firstKey, 36)
+		checkPassFail(rankScan(&index,25,GT,40,LT,BACKWARD,14,firstKey), 0)
+		checkPassFail(rankScan(&index,0,GTE,relationSize,LT,BACKWARD,relationSize - 1,firstKey), 1)
+		checkPassFail(firstKey, 0)
+
+		// 3000 more entries for 42, the counts follow the inserts and the splits they cause
+		int val = 42;
+		double valDouble = val;
+		char valString[100];
+		sprintf(valString,"%05d string record",val);
+		const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+		RecordId rid;
+		index.startScan(key, GTE, key, LTE);
+		index.scanNext(rid);
+		index.endScan();
+		for(int i = 0; i < 3000; i++)
+		{
+			index.insertEntry(key, rid);
+		}
+		index.verify();
+		checkPassFail(typedCount(&index,42,GTE,42,LTE), 3001)
+		checkPassFail(typedCount(&index,40,GTE,45,LT), 3005)
+		checkPassFail(typedCount(&index,42,GT,45,LT), 2)
+		checkPassFail(rankScan(&index,42,GTE,42,LTE,FORWARD,2000,firstKey), 1001)
+		checkPassFail(rankScan(&index,40,GTE,45,LT,FORWARD,3003,firstKey), 2)
+		checkPassFail(firstKey, 43)
+		checkPassFail(rankScan(&index,40,GTE,45,LT,BACKWARD,3003,firstKey), 2)
+		checkPassFail(firstKey, 41)
+	}
+
+	{
+		// the counts are kept across a reopen and rebuilt by compact
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		checkPassFail(typedCount(&index,0,GTE,relationSize,LT), relationSize + 3000)
+		index.compact();
+		index.verify();
+		checkPassFail(typedCount(&index,42,GTE,42,LTE), 3001)
+		checkPassFail(typedCount(&index,3000,GTE,4000,LT), 1000)
+		int firstKey;
+		checkPassFail(rankScan(&index,0,GTE,relationSize,LT,FORWARD,3100,firstKey), relationSize - 100)
+		checkPassFail(firstKey, 100)
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// postingTests
+// -----------------------------------------------------------------------------
+
+void postingTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Posting lists for duplicate keys" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		IndexStats before;
+		index.collectStats(before);
+		checkPassFail(before.numPostingLists, 0)
+
+		// 12000 more entries for 42, two in three in RecordId order and the rest backwards
+		int val = 42;
+		double valDouble = val;
+		char valString[100];
+		sprintf(valString,"%05d string record",val);
+		const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+		for(int pass = 0; pass < 2; pass++)
+		{
+			for(int j = 0; j < 12000; j++)
+			{
+				int i = pass == 0 ? j : 11999 - j;
+				if((i % 3 == 0) != (pass == 1))
+				{
+					continue;
+				}
+				RecordId rid;
+				rid.page_number = 1000 + i / 40;
+				rid.slot_number = 1 + i % 40;
+				index.insertEntry(key, rid);
+			}
+		}
+		index.verify();
+
+		IndexStats stats;
+		index.collectStats(stats);
+		checkPassFail((int)stats.numEntries, relationSize + 12000)
+		checkPassFail((stats.numPostingLists >= 1), true)
+		checkPassFail((stats.numPostingPages >= 2 && stats.numPostingPages <= 12), true)
+		checkPassFail((stats.numLeafPages <= before.numLeafPages + 1), true)
+
+		// duplicates left as plain entries before the list was made come in insert order, the list in RecordId order
+		int breaks;
+		checkPassFail(postingScan(&index,42,FORWARD,breaks), 12001)
+		checkPassFail((breaks <= 1), true)
+		checkPassFail(postingScan(&index,42,BACKWARD,breaks), 12001)
+		checkPassFail((breaks <= 1), true)
+		checkPassFail(postingScan(&index,43,FORWARD,breaks), 1)
+		checkPassFail(distinctScan(&index,40,GT,45,LTE), 5)
+	}
+
+	{
+		// the lists survive a reopen and compact
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		index.compact();
+		index.verify();
+		int breaks;
+		checkPassFail(postingScan(&index,42,FORWARD,breaks), 12001)
+		checkPassFail((breaks <= 1), true)
+		IndexStats stats;
+		index.collectStats(stats);
+		checkPassFail((int)stats.numEntries, relationSize + 12000)
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Counts the entries of val, and in breaks the RecordIds that do not follow (page_number, slot_number) order in the direction of the scan
+int postingScan(BTreeIndex * index, int val, ScanDirection direction, int &breaks)
+{
+	double valDouble = val;
+	char valString[100];
+	sprintf(valString,"%05d string record",val);
+	const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+	try
+	{
+		index->startScan(key, GTE, key, LTE, direction, 0);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+	int numResults = 0;
+	RecordId last;
+	breaks = 0;
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+			if(numResults > 0 && (direction == FORWARD ? ridBefore(scanRid, last) : ridBefore(last, scanRid)))
+			{
+				breaks++;
+			}
+			last = scanRid;
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// histogramTests
+// -----------------------------------------------------------------------------
+
+void histogramTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Key histogram and range estimates" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		KeyHistogram histogram;
+		index.getKeyHistogram(histogram);
+		IndexStats stats;
+		index.collectStats(stats);
+		checkPassFail((int)histogram.numEntries, relationSize)
+		checkPassFail(histogram.height, stats.height)
+		checkPassFail((histogram.minKey == stats.minKey), true)
+		checkPassFail((histogram.maxKey == stats.maxKey), true)
+		checkPassFail((histogram.bucketKeys.size() > 1 && histogram.bucketKeys.size() <= (size_t)HISTOGRAMBUCKETS), true)
+		std::uint64_t total = 0;
+		for(size_t i = 0; i < histogram.bucketCounts.size(); i++)
+		{
+			total += histogram.bucketCounts[i];
+		}
+		checkPassFail((int)total, relationSize)
+
+		checkPassFail(estimateClose(&index,25,GT,40,LT,14), true)
+		checkPassFail(estimateClose(&index,-3,GT,3,LT,3), true)
+		checkPassFail(estimateClose(&index,3000,GTE,4000,LT,1000), true)
+		checkPassFail(estimateClose(&index,0,GTE,relationSize,LT,relationSize), true)
+		checkPassFail(estimateClose(&index,6000,GT,7000,LT,0), true)
+
+		// 3000 more entries for 42 make its bucket lopsided, the next splits rebuild the histogram
+		int val = 42;
+		double valDouble = val;
+		char valString[100];
+		sprintf(valString,"%05d string record",val);
+		const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+		RecordId rid;
+		index.startScan(key, GTE, key, LTE);
+		index.scanNext(rid);
+		index.endScan();
+		for(int i = 0; i < 3000; i++)
+		{
+			index.insertEntry(key, rid);
+		}
+		checkPassFail(estimateClose(&index,42,GTE,42,LTE,3001), true)
+		checkPassFail(estimateClose(&index,3000,GTE,4000,LT,1000), true)
+	}
+
+	{
+		// the statistics survive a reopen and compact
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		KeyHistogram histogram;
+		index.getKeyHistogram(histogram);
+		checkPassFail((int)histogram.numEntries, relationSize + 3000)
+		index.compact();
+		index.getKeyHistogram(histogram);
+		IndexStats stats;
+		index.collectStats(stats);
+		checkPassFail(histogram.height, stats.height)
+		checkPassFail((int)histogram.numEntries, relationSize + 3000)
+		checkPassFail(estimateClose(&index,3000,GTE,4000,LT,1000), true)
+		checkPassFail(estimateClose(&index,0,GTE,relationSize,LT,relationSize + 3000), true)
+
+		// with counts kept the estimate is exact
+		index.enableCounts();
+		int lowVal = 25, highVal = 40;
+		double lowDouble = lowVal, highDouble = highVal;
+		char lowString[100], highString[100];
+		sprintf(lowString,"%05d string record",lowVal);
+		sprintf(highString,"%05d string record",highVal);
+		double estimate;
+		if(testNum == 1)
+			estimate = index.estimateRange(&lowVal, GT, &highVal, LT);
+		else if(testNum == 2)
+			estimate = index.estimateRange(&lowDouble, GT, &highDouble, LT);
+		else
+			estimate = index.estimateRange(lowString, GT, highString, LT);
+		checkPassFail((int)estimate, 14)
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// parallelTests
+// -----------------------------------------------------------------------------
+
+void parallelTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Parallel index scans" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+		int numPartitions;
+		checkPassFail(parallelScan(&index,0,GTE,relationSize,LT,1,true,numPartitions), relationSize)
+		checkPassFail(numPartitions, 1)
+		checkPassFail(parallelScan(&index,0,GTE,relationSize,LT,4,true,numPartitions), relationSize)
+		checkPassFail(numPartitions, 4)
+		checkPassFail(parallelScan(&index,0,GTE,relationSize,LT,4,false,numPartitions), relationSize)
+		checkPassFail(parallelScan(&index,25,GT,40,LT,4,true,numPartitions), 14)
+		checkPassFail(parallelScan(&index,20,GTE,35,LTE,4,true,numPartitions), 16)
+		checkPassFail(parallelScan(&index,-3,GT,3,LT,4,true,numPartitions), 3)
+		checkPassFail(parallelScan(&index,0,GT,1,LT,4,true,numPartitions), 0)
+		checkPassFail(parallelScan(&index,3000,GTE,4000,LT,3,false,numPartitions), 1000)
+		checkPassFail(parallelScan(&index,1000,GT,4000,LTE,8,true,numPartitions), 3000)
+
+		// 3000 more entries for 42, a cut at 42 must keep all of them on one side
+		int val = 42;
+		double valDouble = val;
+		char valString[100];
+		sprintf(valString,"%05d string record",val);
+		const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+		RecordId rid;
+		index.startScan(key, GTE, key, LTE);
+		index.scanNext(rid);
+
+		// the index cannot be flushed while a scan holds a page
+		bool thrown = false;
+		try
+		{
+			ParallelIndexScan scan(&index, key, GTE, key, LTE, 2);
+		}
+		catch(PagePinnedException e)
+		{
+			thrown = true;
+		}
+		checkPassFail(thrown, true)
+		index.endScan();
+
+		for(int i = 0; i < 3000; i++)
+		{
+			index.insertEntry(key, rid);
+		}
+		checkPassFail(parallelScan(&index,42,GTE,42,LTE,4,true,numPartitions), 3001)
+		checkPassFail(parallelScan(&index,0,GTE,100,LT,8,true,numPartitions), 3100)
+		checkPassFail(parallelScan(&index,0,GTE,relationSize,LT,8,false,numPartitions), relationSize + 3000)
+
+		// stopping early leaves nothing behind
+		{
+			ParallelIndexScan scan(&index, key, GTE, key, LTE, 4);
+			std::vector<RecordId> batch;
+			scan.nextBatch(batch);
+		}
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 3001)
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Reads the partitions one after the other when ordered, otherwise each on its own, and checks that
+// every partition comes back in key order. Returns -1 if one does not.
+int parallelScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, int numWorkers, bool ordered, int &numPartitions)
+{
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	const void *low = testNum == 1 ? (const void *)&lowVal : testNum == 2 ? (const void *)&lowDouble : (const void *)lowString;
+	const void *high = testNum == 1 ? (const void *)&highVal : testNum == 2 ? (const void *)&highDouble : (const void *)highString;
+
+	ParallelIndexScan scan(index, low, lowOp, high, highOp, numWorkers);
+	numPartitions = scan.getNumPartitions();
+	int numResults = 0;
+	for(int p = 0; p < (ordered ? 1 : numPartitions); p++)
+	{
+		int lastKey = -1;
+		std::vector<RecordId> batch;
+		while(ordered ? scan.nextBatch(batch) : scan.nextBatch(p, batch))
+		{
+			for(size_t i = 0; i < batch.size(); i++)
+			{
+				Page *curPage;
+				bufMgr->readPage(file1, batch[i].page_number, curPage);
+				RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(batch[i]).data()));
+				bufMgr->unPinPage(file1, batch[i].page_number, false);
+				if(myRec.i < lastKey)
+				{
+					std::cout << "Parallel scan returned " << myRec.i << " after " << lastKey << std::endl;
+					return -1;
+				}
+				lastKey = myRec.i;
+				numResults++;
+			}
+		}
+	}
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// joinTests
+// -----------------------------------------------------------------------------
+
+void joinTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Index nested loop join" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offset, type);
+
+		// every record of the relation joins with itself
+		checkPassFail(joinCount(relationName, file1, &index, offset, JOINBATCHSIZE), relationSize)
+		checkPassFail(joinCount(relationName, file1, &index, offset, 1), relationSize)
+		checkPassFail(joinCount(relationName, file1, &index, offset, 333), relationSize)
+
+		// three more index entries for 42
+		int val = 42;
+		double valDouble = val;
+		char valString[100];
+		sprintf(valString,"%05d string record",val);
+		const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+		RecordId rid;
+		index.startScan(key, GTE, key, LTE);
+		index.scanNext(rid);
+		index.endScan();
+		for(int i = 0; i < 3; i++)
+		{
+			index.insertEntry(key, rid);
+		}
+		checkPassFail(joinCount(relationName, file1, &index, offset, 100), relationSize + 3)
+
+		// an outer relation with a duplicate key and a key missing from the index
+		const std::string outerName = "relB";
+		{
+			PageFile outerFile(outerName, true);
+			PageId pageNo;
+			Page page = outerFile.allocatePage(pageNo);
+			int keys[] = {42, 7, 42, 9999, relationSize - 1};
+			for(int k = 0; k < 5; k++)
+			{
+				RECORD record;
+				memset(&record, 0, sizeof(record));
+				sprintf(record.s, "%05d string record", keys[k]);
+				record.i = keys[k];
+				record.d = (double)keys[k];
+				page.insertRecord(std::string(reinterpret_cast<char*>(&record), sizeof(record)));
+			}
+			outerFile.writePage(pageNo, page);
+		}
+		{
+			PageFile outerFile = PageFile::open(outerName);
+			checkPassFail(joinCount(outerName, &outerFile, &index, offset, JOINBATCHSIZE), 10)
+			checkPassFail(joinCount(outerName, &outerFile, &index, offset, 2), 10)
+			bufMgr->flushFile(&outerFile);
+		}
+		File::remove(outerName);
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Returns the number of pairs, or -1 if a pair joins records with different keys
+int joinCount(const std::string &outerName, PageFile *outerFile, BTreeIndex * index, int offset, int batchSize)
+{
+	IndexNestedLoopJoin join(outerName, offset, index, bufMgr, batchSize);
+	RecordId outerRid, innerRid;
+	int numResults = 0;
+	while(join.next(outerRid, innerRid))
+	{
+		Page *curPage;
+		bufMgr->readPage(outerFile, outerRid.page_number, curPage);
+		RECORD outerRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(outerRid).data()));
+		bufMgr->unPinPage(outerFile, outerRid.page_number, false);
+		bufMgr->readPage(file1, innerRid.page_number, curPage);
+		RECORD innerRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(innerRid).data()));
+		bufMgr->unPinPage(file1, innerRid.page_number, false);
+		if(outerRec.i != innerRec.i)
+		{
+			std::cout << "Join paired " << outerRec.i << " with " << innerRec.i << std::endl;
+			return -1;
+		}
+		numResults++;
+	}
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// mergeJoinTests
+// -----------------------------------------------------------------------------
+
+void mergeJoinTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Merge join" << std::endl;
+	// right relation: every third key from the middle of relA on past its end, and 42 twice
+	const std::string rightName = "relB";
+	int expected = 0;
+	{
+		std::vector<int> keys;
+		for(int k = relationSize / 2; k < relationSize + 300; k += 3)
+		{
+			keys.push_back(k);
+		}
+		keys.push_back(42);
+		keys.push_back(42);
+		PageFile rightFile(rightName, true);
+		PageId pageNo;
+		Page page = rightFile.allocatePage(pageNo);
+		for(size_t k = 0; k < keys.size(); k++)
+		{
+			RECORD record;
+			memset(&record, 0, sizeof(record));
+			sprintf(record.s, "%05d string record", keys[k]);
+			record.i = keys[k];
+			record.d = (double)keys[k];
+			std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+			try
+			{
+				page.insertRecord(data);
+			}
+			catch(InsufficientSpaceException e)
+			{
+				rightFile.writePage(pageNo, page);
+				page = rightFile.allocatePage(pageNo);
+				page.insertRecord(data);
+			}
+			if(keys[k] < relationSize)
+			{
+				expected++;
+			}
+		}
+		rightFile.writePage(pageNo, page);
+	}
+
+	std::string leftIndexName;
+	std::string rightIndexName;
+	{
+		BTreeIndex leftIndex(relationName, leftIndexName, bufMgr, offset, type);
+		BTreeIndex rightIndex(rightName, rightIndexName, bufMgr, offset, type);
+		PageFile rightFile = PageFile::open(rightName);
+
+		checkPassFail(mergeJoinCount(&leftIndex, file1, &rightIndex, &rightFile), expected)
+		checkPassFail(mergeJoinCount(&rightIndex, &rightFile, &leftIndex, file1), expected)
+		checkPassFail(mergeJoinCount(&leftIndex, file1, &leftIndex, file1), relationSize)
+
+		// three more left entries for 42: a run of four meets a run of two
+		int val = 42;
+		double valDouble = val;
+		char valString[100];
+		sprintf(valString,"%05d string record",val);
+		const void *key = testNum == 1 ? (const void *)&val : testNum == 2 ? (const void *)&valDouble : (const void *)valString;
+		RecordId rid;
+		leftIndex.startScan(key, GTE, key, LTE);
+		leftIndex.scanNext(rid);
+		leftIndex.endScan();
+		for(int i = 0; i < 3; i++)
+		{
+			leftIndex.insertEntry(key, rid);
+		}
+		checkPassFail(mergeJoinCount(&leftIndex, file1, &rightIndex, &rightFile), expected + 6)
+		checkPassFail(mergeJoinCount(&leftIndex, file1, &leftIndex, file1), relationSize + 15)
+
+		// every leaf is unpinned once the join is done
+		{
+			MergeJoin join(&leftIndex, &rightIndex);
+			RecordId leftRid, rightRid;
+			join.next(leftRid, rightRid);
+		}
+		bool pinned = false;
+		try
+		{
+			leftIndex.flush();
+			rightIndex.flush();
+		}
+		catch(PagePinnedException e)
+		{
+			pinned = true;
+		}
+		checkPassFail(pinned, false)
+		bufMgr->flushFile(&rightFile);
+	}
+
+	try
+	{
+		File::remove(leftIndexName);
+		File::remove(rightIndexName);
+		File::remove(rightName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Returns the number of pairs, or -1 if a pair joins records with different keys
+int mergeJoinCount(BTreeIndex *leftIndex, PageFile *leftFile, BTreeIndex *rightIndex, PageFile *rightFile)
+{
+	MergeJoin join(leftIndex, rightIndex);
+	RecordId leftRid, rightRid;
+	int numResults = 0;
+	while(join.next(leftRid, rightRid))
+	{
+		Page *curPage;
+		bufMgr->readPage(leftFile, leftRid.page_number, curPage);
+		RECORD leftRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(leftRid).data()));
+		bufMgr->unPinPage(leftFile, leftRid.page_number, false);
+		bufMgr->readPage(rightFile, rightRid.page_number, curPage);
+		RECORD rightRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(rightRid).data()));
+		bufMgr->unPinPage(rightFile, rightRid.page_number, false);
+		if(leftRec.i != rightRec.i)
+		{
+			std::cout << "Merge join paired " << leftRec.i << " with " << rightRec.i << std::endl;
+			return -1;
+		}
+		numResults++;
+	}
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// ridMergeTests
+// -----------------------------------------------------------------------------
+
+void ridMergeTests()
+{
+  std::cout << "Index intersection and union" << std::endl;
+	std::string intIndexName, doubleIndexName, stringIndexName;
+	{
+		BTreeIndex intIndex(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		BTreeIndex doubleIndex(relationName, doubleIndexName, bufMgr, offsetof(tuple,d), DOUBLE);
+		BTreeIndex stringIndex(relationName, stringIndexName, bufMgr, offsetof(tuple,s), STRING);
+
+		// i in [100,2000), d in [1500,3000], s in ["04000","04100"), i in [relationSize+10,relationSize+20]
+		int intLow = 100, intHigh = 2000;
+		double doubleLow = 1500, doubleHigh = 3000;
+		char stringLow[100], stringHigh[100];
+		strcpy(stringLow, "04000");
+		strcpy(stringHigh, "04100");
+		int missingLow = relationSize + 10, missingHigh = relationSize + 20;
+		IndexPredicate predicates[4] = {
+			{&intIndex, &intLow, GTE, &intHigh, LT},
+			{&doubleIndex, &doubleLow, GTE, &doubleHigh, LTE},
+			{&stringIndex, stringLow, GTE, stringHigh, LT},
+			{&intIndex, &missingLow, GTE, &missingHigh, LTE}
+		};
+		IndexPredicate missingFirst[2] = {predicates[3], predicates[0]};
+
+		std::vector<bool> both(relationSize), either(relationSize), any(relationSize), none(relationSize);
+		for(int i = 0; i < relationSize; i++)
+		{
+			bool a = i >= 100 && i < 2000;
+			bool b = i >= 1500 && i <= 3000;
+			bool c = i >= 4000 && i < 4100;
+			both[i] = a && b;
+			either[i] = a || b;
+			any[i] = a || b || c;
+		}
+
+		int thresholds[2] = {1 << 30, 0};
+		for(int t = 0; t < 2; t++)
+		{
+			checkPassFail(ridMergeCount(predicates, 2, RID_INTERSECT, thresholds[t], both), 500)
+			checkPassFail(ridMergeCount(predicates, 2, RID_UNION, thresholds[t], either), 2901)
+			checkPassFail(ridMergeCount(predicates, 3, RID_UNION, thresholds[t], any), 3001)
+			checkPassFail(ridMergeCount(predicates, 3, RID_INTERSECT, thresholds[t], none), 0)
+			checkPassFail(ridMergeCount(missingFirst, 2, RID_INTERSECT, thresholds[t], none), 0)
+			checkPassFail(ridMergeCount(missingFirst, 2, RID_UNION, thresholds[t], either), 1900)
+			checkPassFail(ridMergeCount(predicates, 1, RID_INTERSECT, thresholds[t], either), 1900)
+		}
+
+		IndexRidMerge sorted(predicates, 2, RID_UNION);
+		checkPassFail(sorted.usedBitmap(), false)
+		IndexRidMerge bitmap(predicates, 2, RID_UNION, 1000);
+		checkPassFail(bitmap.usedBitmap(), true)
+	}
+
+	try
+	{
+		File::remove(intIndexName);
+		File::remove(doubleIndexName);
+		File::remove(stringIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// Returns the number of RecordIds, or -1 if one is out of order or its record does not qualify
+int ridMergeCount(const IndexPredicate *predicates, int n, RidMergeOp op, int bitmapThreshold, const std::vector<bool> &qualifies)
+{
+	IndexRidMerge merge(predicates, n, op, bitmapThreshold);
+	RecordId rid, lastRid;
+	int numResults = 0;
+	while(merge.next(rid))
+	{
+		if(numResults > 0 && (rid.page_number < lastRid.page_number ||
+			(rid.page_number == lastRid.page_number && rid.slot_number <= lastRid.slot_number)))
+		{
+			std::cout << "RecordIds out of order" << std::endl;
+			return -1;
+		}
+		Page *curPage;
+		bufMgr->readPage(file1, rid.page_number, curPage);
+		RECORD record = *(reinterpret_cast<const RECORD*>(curPage->getRecord(rid).data()));
+		bufMgr->unPinPage(file1, rid.page_number, false);
+		if(!qualifies[record.i])
+		{
+			std::cout << "Record " << record.i << " does not qualify" << std::endl;
+			return -1;
+		}
+		lastRid = rid;
+		numResults++;
+	}
+	if((size_t)numResults != merge.getNumRids())
+	{
+		return -1;
+	}
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// heapFetchTests
+// -----------------------------------------------------------------------------
+
+void heapFetchTests()
+{
+  std::cout << "Page ordered heap fetch" << std::endl;
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER);
+		BitmapHeapFetch heapFetch(relationName, bufMgr);
+		RecordView view;
+
+		// every record of [1000,3000) once, pages ascending within each batch of 300
+		int low = 1000, high = 3000;
+		std::vector<bool> seen(relationSize, false);
+		int numResults = 0;
+		bool inOrder = true;
+		bool inRange = true;
+		index.startScan(&low, GTE, &high, LT);
+		int taken;
+		do
+		{
+			taken = heapFetch.fetchFromScan(&index, 300);
+			PageId lastPage = 0;
+			while(heapFetch.next(view))
+			{
+				RECORD record;
+				memcpy(&record, view.data, sizeof(record));
+				if(view.length != sizeof(RECORD) || record.i < low || record.i >= high || seen[record.i])
+				{
+					inRange = false;
+					break;
+				}
+				if(view.rid.page_number < lastPage)
+				{
+					inOrder = false;
+				}
+				lastPage = view.rid.page_number;
+				seen[record.i] = true;
+				numResults++;
+			}
+		}
+		while(taken == 300);
+		index.endScan();
+		checkPassFail(numResults, high - low)
+		checkPassFail(inRange, true)
+		checkPassFail(inOrder, true)
+
+		// a batch given in reverse comes back in page order with the same records
+		std::vector<RecordId> batch;
+		int key = 10;
+		index.startScan(&key, GTE, &key, LTE);
+		RecordId rid;
+		index.scanNext(rid);
+		index.endScan();
+		RecordId lastRid = rid;
+		FileScan scan(relationName, bufMgr);
+		for(int i = 0; i < 50; i++)
+		{
+			scan.scanNext(rid);
+			batch.push_back(rid);
+		}
+		batch.push_back(lastRid);
+		std::reverse(batch.begin(), batch.end());
+		heapFetch.fetch(batch);
+		numResults = 0;
+		bool found = false;
+		while(heapFetch.next(view))
+		{
+			RECORD record;
+			memcpy(&record, view.data, sizeof(record));
+			found = found || (view.rid == lastRid && record.i == key);
+			numResults++;
+		}
+		checkPassFail(numResults, 51)
+		checkPassFail(found, true)
+
+		// a new batch replaces one only partly returned
+		heapFetch.fetch(batch);
+		heapFetch.next(view);
+		heapFetch.fetch(std::vector<RecordId>());
+		checkPassFail(heapFetch.next(view), false)
+	}
+
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// compositeTests
+// -----------------------------------------------------------------------------
+
+void compositeTests()
+{
+  std::cout << "Composite keys" << std::endl;
+	// tenant i from -5 to 4, timestamp d, and a short string s in an order of its own
+	const std::string compositeName = "relC";
+	{
+		PageFile compositeFile(compositeName, true);
+		PageId pageNo;
+		Page page = compositeFile.allocatePage(pageNo);
+		for(int n = 0; n < 2000; n++)
+		{
+			RECORD record;
+			memset(&record, 0, sizeof(record));
+			sprintf(record.s, "t%d", n % 12);
+			record.i = n % 10 - 5;
+			record.d = (double)n;
+			std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+			try
+			{
+				page.insertRecord(data);
+			}
+			catch(InsufficientSpaceException e)
+			{
+				compositeFile.writePage(pageNo, page);
+				page = compositeFile.allocatePage(pageNo);
+				page.insertRecord(data);
+			}
+		}
+		compositeFile.writePage(pageNo, page);
+	}
+
+	std::vector<KeyColumn> tenantTime(2);
+	tenantTime[0].attrByteOffset = offsetof(tuple,i);
+	tenantTime[0].attrType = INTEGER;
+	tenantTime[1].attrByteOffset = offsetof(tuple,d);
+	tenantTime[1].attrType = DOUBLE;
+	std::vector<KeyColumn> nameTenant(2);
+	nameTenant[0].attrByteOffset = offsetof(tuple,s);
+	nameTenant[0].attrType = STRING;
+	nameTenant[1].attrByteOffset = offsetof(tuple,i);
+	nameTenant[1].attrType = INTEGER;
+
+	std::string tenantTimeName, nameTenantName;
+	{
+		PageFile compositeFile = PageFile::open(compositeName);
+		BTreeIndex index(compositeName, tenantTimeName, bufMgr, tenantTime);
+		int tenant = 2, lowTenant = -5, highTenant = -4, otherTenant = 3;
+		double t500 = 500, t999 = 999, t507 = 507, t997 = 997;
+		const void *tenantOnly[] = {&tenant};
+		const void *from500[] = {&tenant, &t500};
+		const void *to999[] = {&tenant, &t999};
+		const void *to507[] = {&tenant, &t507};
+		const void *after997[] = {&tenant, &t997};
+		const void *low[] = {&lowTenant};
+		const void *high[] = {&highTenant};
+		const void *other[] = {&otherTenant};
+
+		// a prefix of the columns fixed, then bounds on the next one
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, tenantOnly, 1, GTE, tenantOnly, 1, LTE), 200)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, from500, 2, GTE, to999, 2, LTE), 50)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, from500, 2, GT, tenantOnly, 1, LTE), 150)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, tenantOnly, 1, GTE, to507, 2, LT), 50)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, after997, 2, GT, tenantOnly, 1, LTE), 100)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, tenantOnly, 1, GT, tenantOnly, 1, LTE), 0)
+		// negative tenants, open sides
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, low, 1, GTE, high, 1, LTE), 400)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, other, 1, GT, NULL, 0, LT), 200)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, NULL, 0, GTE, high, 1, LT), 200)
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, NULL, 0, GT, NULL, 0, LTE), 2000)
+
+		// a key built from every column goes in like any other
+		int tenantOf500 = 500 % 10 - 5;
+		const void *record500[] = {&tenantOf500, &t500};
+		RecordId rid;
+		index.startCompositeScan(record500, 2, GTE, record500, 2, LTE);
+		index.scanNext(rid);
+		index.endScan();
+		index.insertEntry(index.compositeKey(record500, 2).c_str(), rid);
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, record500, 2, GTE, record500, 2, LTE), 2)
+		bufMgr->flushFile(&compositeFile);
+	}
+	{
+		// the columns are kept in the meta page
+		PageFile compositeFile = PageFile::open(compositeName);
+		BTreeIndex index(compositeName, tenantTimeName, bufMgr, tenantTime);
+		checkPassFail(compositeScan(&index, &compositeFile, tenantTime, NULL, 0, GTE, NULL, 0, LTE), 2001)
+		bufMgr->flushFile(&compositeFile);
+	}
+	std::vector<KeyColumn> otherTypes = tenantTime;
+	otherTypes[1].attrType = INTEGER;
+	try
+	{
+		BTreeIndex index(compositeName, tenantTimeName, bufMgr, otherTypes);
+		std::cout << "BadIndexInfoException Test for composite columns Failed." << std::endl;
+	}
+	catch(BadIndexInfoException e)
+	{
+		std::cout << "BadIndexInfoException Test for composite columns Passed." << std::endl;
+	}
+	{
+		// a string column sorts before the longer strings it starts
+		PageFile compositeFile = PageFile::open(compositeName);
+		BTreeIndex index(compositeName, nameTenantName, bufMgr, nameTenant);
+		char t1[] = "t1", t2[] = "t2";
+		int zero = 0, four = 4;
+		const void *name1[] = {t1};
+		const void *name2[] = {t2};
+		const void *name1Zero[] = {t1, &zero};
+		const void *name1Four[] = {t1, &four};
+		checkPassFail(compositeScan(&index, &compositeFile, nameTenant, name1, 1, GTE, name1, 1, LTE), 167)
+		checkPassFail(compositeScan(&index, &compositeFile, nameTenant, name1Zero, 2, GTE, name1Four, 2, LTE), 99)
+		checkPassFail(compositeScan(&index, &compositeFile, nameTenant, name1, 1, GTE, name2, 1, LT), 499)
+		bufMgr->flushFile(&compositeFile);
+	}
+
+	// columns read back from their encoding
+	{
+		int ints[] = {INT_MIN, -1, 0, 1, INT_MAX};
+		double doubles[] = {-1e300, -0.5, 0.0, 1.0 / 3, 1e300};
+		bool roundTrip = true;
+		for(int n = 0; n < 5; n++)
+		{
+			unsigned char encoded[2 * STRINGSIZE + 1];
+			int intOut;
+			double doubleOut;
+			int length = encodeKeyColumn(&ints[n], INTEGER, encoded);
+			roundTrip = roundTrip && decodeKeyColumn(encoded, INTEGER, &intOut) == length && intOut == ints[n];
+			length = encodeKeyColumn(&doubles[n], DOUBLE, encoded);
+			roundTrip = roundTrip && decodeKeyColumn(encoded, DOUBLE, &doubleOut) == length && doubleOut == doubles[n];
+		}
+		char highBytes[] = "a\xfc\xfd\xfe\xffz";
+		char stringOut[STRINGSIZE];
+		unsigned char encoded[2 * STRINGSIZE + 1];
+		int length = encodeKeyColumn(highBytes, STRING, encoded);
+		roundTrip = roundTrip && decodeKeyColumn(encoded, STRING, stringOut) == length && strcmp(stringOut, highBytes) == 0;
+		checkPassFail(roundTrip, true)
+	}
+
+	// a covering index on the tenant returns the timestamp and the string from its entries
+	std::vector<KeyColumn> tenant(tenantTime.begin(), tenantTime.begin() + 1);
+	std::vector<KeyColumn> timeName(2);
+	timeName[0] = tenantTime[1];
+	timeName[1] = nameTenant[0];
+	std::string coveringName;
+	{
+		PageFile compositeFile = PageFile::open(compositeName);
+		BTreeIndex index(compositeName, coveringName, bufMgr, tenant, timeName);
+		checkPassFail(coveredScan(&index, &compositeFile, 2, 2), 200)
+		checkPassFail(coveredScan(&index, &compositeFile, -5, -1), 1000)
+		// the include columns are not part of the key
+		int two = 2;
+		double t500 = 500;
+		const void *twoAt500[] = {&two, &t500};
+		try
+		{
+			index.startCompositeScan(twoAt500, 2, GTE, twoAt500, 2, LTE);
+			std::cout << "BadScanParamException Test for include columns Failed." << std::endl;
+		}
+		catch(BadScanParamException e)
+		{
+			std::cout << "BadScanParamException Test for include columns Passed." << std::endl;
+		}
+		bufMgr->flushFile(&compositeFile);
+	}
+	{
+		PageFile compositeFile = PageFile::open(compositeName);
+		BTreeIndex index(compositeName, coveringName, bufMgr, tenant, timeName);
+		checkPassFail(coveredScan(&index, &compositeFile, 4, 4), 200)
+		bufMgr->flushFile(&compositeFile);
+	}
+	try
+	{
+		std::vector<KeyColumn> otherIncludes = timeName;
+		otherIncludes[1].attrType = INTEGER;
+		BTreeIndex index(compositeName, coveringName, bufMgr, tenant, otherIncludes);
+		std::cout << "BadIndexInfoException Test for include columns Failed." << std::endl;
+	}
+	catch(BadIndexInfoException e)
+	{
+		std::cout << "BadIndexInfoException Test for include columns Passed." << std::endl;
+	}
+
+	File::remove(tenantTimeName);
+	File::remove(nameTenantName);
+	File::remove(coveringName);
+	File::remove(compositeName);
+}
+
+// Returns the number of entries of the tenants lowVal to highVal of a covering index on (i) including (d, s), or -1
+// if the columns of an entry differ from those of its record
+int coveredScan(BTreeIndex * index, PageFile * file, int lowVal, int highVal)
+{
+	const void *low[] = {&lowVal};
+	const void *high[] = {&highVal};
+	try
+	{
+		index->startCompositeScan(low, 1, GTE, high, 1, LTE);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	int numResults = 0;
+	RecordId rid;
+	while(1)
+	{
+		RECORD covered;
+		memset(&covered, 0, sizeof(covered));
+		try
+		{
+			index->scanNextCovered(rid, &covered);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		Page *curPage;
+		bufMgr->readPage(file, rid.page_number, curPage);
+		std::string recordStr = curPage->getRecord(rid);
+		bufMgr->unPinPage(file, rid.page_number, false);
+		const RECORD *record = reinterpret_cast<const RECORD*>(recordStr.c_str());
+		if(covered.i != record->i || covered.d != record->d || strcmp(covered.s, record->s) != 0)
+		{
+			index->endScan();
+			return -1;
+		}
+		numResults++;
+	}
+	index->endScan();
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// clusteredTests
+// -----------------------------------------------------------------------------
+
+void clusteredTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Create a clustered index holding the records on the same field" << std::endl;
+	std::string clusteredIndexName;
+	{
+		ClusteredIndex index(relationName, clusteredIndexName, bufMgr, offset, type);
+
+		checkPassFail(clusteredScan(&index,25,GT,40,LT), 14)
+		checkPassFail(clusteredScan(&index,20,GTE,35,LTE), 16)
+		checkPassFail(clusteredScan(&index,-3,GT,3,LT), 3)
+		checkPassFail(clusteredScan(&index,996,GT,1001,LT), 4)
+		checkPassFail(clusteredScan(&index,0,GT,1,LT), 0)
+		checkPassFail(clusteredScan(&index,300,GT,400,LT), 99)
+		checkPassFail(clusteredScan(&index,3000,GTE,4000,LT), 1000)
+		checkPassFail(clusteredScan(&index,0,GTE,relationSize,LT), relationSize)
+		checkPassFail((int)index.getNumRecords(), relationSize)
+
+		// equal keys spread over several leaves
+		RECORD record;
+		memset(&record, 0, sizeof(record));
+		record.i = 42;
+		record.d = 42;
+		sprintf(record.s, "%05d string record", 42);
+		std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+		for(int n = 0; n < 300; n++)
+		{
+			index.insertRecord(data);
+		}
+		checkPassFail(clusteredScan(&index,42,GTE,42,LTE), 301)
+		checkPassFail(clusteredScan(&index,41,GT,43,LT), 301)
+		checkPassFail(clusteredScan(&index,42,GT,44,LTE), 2)
+		checkPassFail(clusteredScan(&index,40,GTE,42,LT), 2)
+
+		int int2 = 2;
+		int int5 = 5;
+		if(type == INTEGER)
+		{
+			try
+			{
+				index.startScan(&int2, LTE, &int5, LTE);
+				std::cout << "BadOpcodesException Clustered Test Failed." << std::endl;
+			}
+			catch(BadOpcodesException e)
+			{
+				std::cout << "BadOpcodesException Clustered Test Passed." << std::endl;
+			}
+			try
+			{
+				index.startScan(&int5, GTE, &int2, LTE);
+				std::cout << "BadScanrangeException Clustered Test Failed." << std::endl;
+			}
+			catch(BadScanrangeException e)
+			{
+				std::cout << "BadScanrangeException Clustered Test Passed." << std::endl;
+			}
+		}
+	}
+
+	// reopen the index file, the inserted records are kept
+	{
+		ClusteredIndex index(relationName, clusteredIndexName, bufMgr, offset, type);
+		checkPassFail(clusteredScan(&index,0,GTE,relationSize,LT), relationSize + 300)
+	}
+	File::remove(clusteredIndexName);
+
+	// a record filling a whole relation page has no room in a leaf beside its link to the next leaf
+	const std::string wideName = "relWide";
+	{
+		PageFile wideFile(wideName, true);
+		PageId pageNo;
+		Page page = wideFile.allocatePage(pageNo);
+		for(int k = 0; k < 20; k++)
+		{
+			RECORD record;
+			memset(&record, 0, sizeof(record));
+			sprintf(record.s, "%05d string record", k);
+			record.i = k;
+			record.d = (double)k;
+			page.insertRecord(std::string(reinterpret_cast<char*>(&record), sizeof(record)));
+		}
+		wideFile.writePage(pageNo, page);
+
+		page = wideFile.allocatePage(pageNo);
+		RECORD record;
+		memset(&record, 0, sizeof(record));
+		sprintf(record.s, "%05d string record", 20);
+		record.i = 20;
+		record.d = 20;
+		std::string data(reinterpret_cast<char*>(&record), sizeof(record));
+		data.resize(page.getFreeSpace() - sizeof(PageSlot), '\0');
+		page.insertRecord(data);
+		wideFile.writePage(pageNo, page);
+	}
+
+	// the build is refused and leaves no file, so a second build is refused the same way
+	for(int attempt = 0; attempt < 2; attempt++)
+	{
+		std::string wideIndexName;
+		bool refused = false;
+		try
+		{
+			ClusteredIndex index(wideName, wideIndexName, bufMgr, offset, type);
+		}
+		catch(InsufficientSpaceException e)
+		{
+			refused = true;
+		}
+		checkPassFail((refused && !File::exists(wideIndexName)), true)
+	}
+	File::remove(wideName);
+}
+
+// -----------------------------------------------------------------------------
+// artTests
+// -----------------------------------------------------------------------------
+
+void artTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Create an in-memory adaptive radix tree on the same field" << std::endl;
+	std::string artIndexName;
+	int extra = 0;
+	{
+		ArtIndex index(relationName, artIndexName, bufMgr, offset, type);
+
+		checkPassFail(typedScan(&index,25,GT,40,LT), 14)
+		checkPassFail(typedScan(&index,20,GTE,35,LTE), 16)
+		checkPassFail(typedScan(&index,-3,GT,3,LT), 3)
+		checkPassFail(typedScan(&index,996,GT,1001,LT), 4)
+		checkPassFail(typedScan(&index,0,GT,1,LT), 0)
+		checkPassFail(typedScan(&index,300,GT,400,LT), 99)
+		checkPassFail(typedScan(&index,3000,GTE,4000,LT), 1000)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize)
+		checkPassFail((int)index.getNumKeys(), relationSize)
+
+		// equal keys share a leaf, in insertion order
+		int int42 = 42;
+		double double42 = 42;
+		char string42[STRINGSIZE];
+		memset(string42, 0, sizeof(string42));
+		sprintf(string42, "%05d string record", 42);
+		const void * key42 = type == INTEGER ? (const void *) &int42 : type == DOUBLE ? (const void *) &double42 : (const void *) string42;
+		RecordId rid42;
+		index.startScan(key42, GTE, key42, LTE);
+		index.scanNext(rid42);
+		index.endScan();
+		for(int n = 0; n < 300; n++)
+		{
+			index.insertEntry(key42, rid42);
+		}
+		extra = 300;
+
+		// keys splitting a leaf past the bytes a node keeps of its prefix, both sorting before key 42
+		if(type == STRING)
+		{
+			char nearKey[STRINGSIZE];
+			memset(nearKey, 0, sizeof(nearKey));
+			sprintf(nearKey, "00042 string recorc");
+			index.insertEntry(nearKey, rid42);
+			sprintf(nearKey, "00042 string rXcord");
+			index.insertEntry(nearKey, rid42);
+			extra += 2;
+			checkPassFail((int)index.getNumKeys(), relationSize + 2)
+		}
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 301)
+		checkPassFail(typedScan(&index,41,GT,43,LT), 1 + extra)
+		checkPassFail(typedScan(&index,42,GT,44,LTE), 2)
+		checkPassFail(typedScan(&index,40,GTE,42,LT), 2 + extra - 300)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize + extra)
+
+		int int2 = 2;
+		int int5 = 5;
+		if(type == INTEGER)
+		{
+			try
+			{
+				index.startScan(&int2, LTE, &int5, LTE);
+				std::cout << "BadOpcodesException ART Test Failed." << std::endl;
+			}
+			catch(BadOpcodesException e)
+			{
+				std::cout << "BadOpcodesException ART Test Passed." << std::endl;
+			}
+			try
+			{
+				index.startScan(&int5, GTE, &int2, LTE);
+				std::cout << "BadScanrangeException ART Test Failed." << std::endl;
+			}
+			catch(BadScanrangeException e)
+			{
+				std::cout << "BadScanrangeException ART Test Passed." << std::endl;
+			}
+			try
+			{
+				RecordId rid;
+				index.scanNext(rid);
+				std::cout << "ScanNotInitializedException ART Test Failed." << std::endl;
+			}
+			catch(ScanNotInitializedException e)
+			{
+				std::cout << "ScanNotInitializedException ART Test Passed." << std::endl;
+			}
+		}
+		index.snapshot();
+	}
+
+	// reload the snapshot, the inserted entries are kept
+	{
+		ArtIndex index(relationName, artIndexName, bufMgr, offset, type);
+		checkPassFail((int)index.getNumEntries(), relationSize + extra)
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 301)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize + extra)
+	}
+	if(type == INTEGER)
+	{
+		try
+		{
+			ArtIndex index(relationName, artIndexName, bufMgr, offset, DOUBLE);
+			std::cout << "BadIndexInfoException ART Test Failed." << std::endl;
+		}
+		catch(BadIndexInfoException e)
+		{
+			std::cout << "BadIndexInfoException ART Test Passed." << std::endl;
+		}
+	}
+	File::remove(artIndexName);
+}
+
+// -----------------------------------------------------------------------------
+// residentTests
+// -----------------------------------------------------------------------------
+
+void residentTests()
+{
+	Datatype type;
+	int offset;
+	testedAttribute(type, offset);
+
+  std::cout << "Create a memory resident B+ Tree index on the same field" << std::endl;
+	std::string residentIndexName;
+	{
+		BTreeIndex index(relationName, residentIndexName, bufMgr, offset, type, true);
+		checkPassFail(index.isResident(), true)
+
+		checkPassFail(typedScan(&index,25,GT,40,LT), 14)
+		checkPassFail(typedScan(&index,20,GTE,35,LTE), 16)
+		checkPassFail(typedScan(&index,-3,GT,3,LT), 3)
+		checkPassFail(typedScan(&index,996,GT,1001,LT), 4)
+		checkPassFail(typedScan(&index,0,GT,1,LT), 0)
+		checkPassFail(typedScan(&index,300,GT,400,LT), 99)
+		checkPassFail(typedScan(&index,3000,GTE,4000,LT), 1000)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize)
+
+		// nodes are not read through the buffer pool
+		int int0 = 0, intMax = relationSize;
+		double double0 = 0, doubleMax = relationSize;
+		char string0[STRINGSIZE], stringMax[STRINGSIZE];
+		sprintf(string0, "%05d string record", 0);
+		sprintf(stringMax, "%05d string record", relationSize);
+		const void * low = type == INTEGER ? (const void *) &int0 : type == DOUBLE ? (const void *) &double0 : (const void *) string0;
+		const void * high = type == INTEGER ? (const void *) &intMax : type == DOUBLE ? (const void *) &doubleMax : (const void *) stringMax;
+		bufMgr->clearBufStats();
+		index.startScan(low, GTE, high, LT);
+		int found = 0;
+		try
+		{
+			RecordId rid;
+			while(1)
+			{
+				index.scanNext(rid);
+				found++;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+		}
+		index.endScan();
+		checkPassFail(found, relationSize)
+		checkPassFail(bufMgr->getBufStats().accesses, 0)
+
+		// entries inserted after the build are written by the checkpoint
+		RecordId rid42;
+		int int42 = 42;
+		double double42 = 42;
+		char string42[STRINGSIZE];
+		memset(string42, 0, sizeof(string42));
+		sprintf(string42, "%05d string record", 42);
+		const void * key42 = type == INTEGER ? (const void *) &int42 : type == DOUBLE ? (const void *) &double42 : (const void *) string42;
+		index.startScan(key42, GTE, key42, LTE);
+		index.scanNext(rid42);
+		index.endScan();
+		for(int n = 0; n < 300; n++)
+		{
+			index.insertEntry(key42, rid42);
+		}
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 301)
+		index.flush();
+	}
+
+	// the file has the format of any index file
+	{
+		BTreeIndex index(relationName, residentIndexName, bufMgr, offset, type);
+		checkPassFail(index.isResident(), false)
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 301)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize + 300)
+	}
+
+	// and is read back in one go
+	{
+		BTreeIndex index(relationName, residentIndexName, bufMgr, offset, type, true);
+		checkPassFail(typedScan(&index,42,GTE,42,LTE), 301)
+		checkPassFail(typedScan(&index,0,GTE,relationSize,LT), relationSize + 300)
+		checkPassFail(typedScan(&index,3000,GTE,4000,LT), 1000)
+	}
+	File::remove(residentIndexName);
+}
+
+// Returns the number of records of a clustered scan, or -1 if one is out of key order or not the record of its key
+int clusteredScan(ClusteredIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+	int lowInt = lowVal, highInt = highVal;
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	const void * low = &lowInt;
+	const void * high = &highInt;
+	if(testNum == 2)
+	{
+		low = &lowDouble;
+		high = &highDouble;
+	}
+	else if(testNum == 3)
+	{
+		low = lowString;
+		high = highString;
+	}
+
+	try
+	{
+		index->startScan(low, lowOp, high, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	int numResults = 0;
+	int lastKey = INT_MIN;
+	RecordView view;
+	while(1)
+	{
+		try
+		{
+			index->scanNext(view);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		const RECORD *record = reinterpret_cast<const RECORD*>(view.data);
+		char expected[STRINGSIZE];
+		sprintf(expected, "%05d string record", record->i);
+		if(view.length != sizeof(RECORD) || record->i < lastKey || record->d != record->i || strcmp(record->s, expected) != 0)
+		{
+			index->endScan();
+			return -1;
+		}
+		lastKey = record->i;
+		numResults++;
+	}
+	index->endScan();
+	return numResults;
+}
+
+// Returns the number of entries of a composite scan, or -1 if one is out of key order
+int compositeScan(BTreeIndex * index, PageFile * file, const std::vector<KeyColumn> &columns, const void *const *lowVals, int numLow, Operator lowOp, const void *const *highVals, int numHigh, Operator highOp)
+{
+	try
+	{
+		index->startCompositeScan(lowVals, numLow, lowOp, highVals, numHigh, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	int numResults = 0;
+	std::string lastKey;
+	RecordId rid;
+	while(1)
+	{
+		try
+		{
+			index->scanNext(rid);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		Page *curPage;
+		bufMgr->readPage(file, rid.page_number, curPage);
+		std::string record = curPage->getRecord(rid);
+		bufMgr->unPinPage(file, rid.page_number, false);
+		const void *values[MAXKEYCOLUMNS];
+		for(size_t c = 0; c < columns.size(); c++)
+		{
+			values[c] = record.c_str() + columns[c].attrByteOffset;
+		}
+		std::string key = index->compositeKey(values, columns.size());
+		if(key < lastKey)
+		{
+			index->endScan();
+			return -1;
+		}
+		lastKey = key;
+		numResults++;
+	}
+	index->endScan();
+	return numResults;
+}
+
+// Within a quarter of the actual count, give or take a few dozen entries
+bool estimateClose(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, int actual)
+{
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	double estimate;
+	if(testNum == 1)
+		estimate = index->estimateRange(&lowVal, lowOp, &highVal, highOp);
+	else if(testNum == 2)
+		estimate = index->estimateRange(&lowDouble, lowOp, &highDouble, highOp);
+	else
+		estimate = index->estimateRange(lowString, lowOp, highString, highOp);
+	return std::abs(estimate - actual) <= actual / 4.0 + 50;
+}
+
+// Returns -1 if the index does not keep counts
+int typedCount(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	try
+	{
+		if(testNum == 1)
+			return index->countRange(&lowVal, lowOp, &highVal, highOp);
+		else if(testNum == 2)
+			return index->countRange(&lowDouble, lowOp, &highDouble, highOp);
+		else
+			return index->countRange(lowString, lowOp, highString, highOp);
+	}
+	catch(BadIndexInfoException e)
+	{
+		return -1;
+	}
+}
+
+int rankScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp, ScanDirection direction, int k, int &firstKey)
+{
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	try
+	{
+		if(testNum == 1)
+			index->startScan(&lowVal, lowOp, &highVal, highOp, direction, 0);
+		else if(testNum == 2)
+			index->startScan(&lowDouble, lowOp, &highDouble, highOp, direction, 0);
+		else
+			index->startScan(lowString, lowOp, highString, highOp, direction, 0);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	index->seekToRank(k);
+
+	int numResults = 0;
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+			if(numResults == 0)
+			{
+				Page *curPage;
+				bufMgr->readPage(file1, scanRid.page_number, curPage);
+				RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+				bufMgr->unPinPage(file1, scanRid.page_number, false);
+				firstKey = myRec.i;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
+// Picks the tuple field and key type the current test number indexes
+void testedAttribute(Datatype &type, int &offset)
+{
+	type = INTEGER;
+	offset = offsetof(tuple,i);
+	if(testNum == 2)
+	{
+		type = DOUBLE;
+		offset = offsetof(tuple,d);
+	}
+	else if(testNum == 3)
+	{
+		type = STRING;
+		offset = offsetof(tuple,s);
+	}
+}
+
+// Converts a key copied out by nextDistinctKey to the record number it was made from
+int keyToInt(const char *key)
+{
+	if(testNum == 1)
+		return *(const int *)key;
+	if(testNum == 2)
+		return (int)*(const double *)key;
+	return atoi(std::string(key, 5).c_str());
+}
+
+int distinctScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	try
+	{
+		if(testNum == 1)
+			index->startScan(&lowVal, lowOp, &highVal, highOp);
+		else if(testNum == 2)
+			index->startScan(&lowDouble, lowOp, &highDouble, highOp);
+		else
+			index->startScan(lowString, lowOp, highString, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+	int numResults = 0;
+	int lastKey = -1;
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			char key[STRINGSIZE + sizeof(double)];
+			index->nextDistinctKey(scanRid, key);
+			if(keyToInt(key) <= lastKey)
+			{
+				std::cout << "nextDistinctKey returned " << keyToInt(key) << " after " << lastKey << std::endl;
+				return -1;
+			}
+			lastKey = keyToInt(key);
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
+int multiRangeScan(BTreeIndex * index, const int *lowVals, const Operator *lowOps, const int *highVals, const Operator *highOps, int n)
+{
+	std::vector<int> lowInts(lowVals, lowVals + n), highInts(highVals, highVals + n);
+	std::vector<double> lowDoubles(lowVals, lowVals + n), highDoubles(highVals, highVals + n);
+	std::vector<std::string> lowStrings(n), highStrings(n);
+	std::vector<ScanRange> ranges(n);
+	for(int i = 0; i < n; i++)
+	{
+		char buf[100];
+		sprintf(buf,"%05d string record",lowVals[i]);
+		lowStrings[i] = buf;
+		sprintf(buf,"%05d string record",highVals[i]);
+		highStrings[i] = buf;
+
+		ranges[i].lowOp = lowOps[i];
+		ranges[i].highOp = highOps[i];
+		if(testNum == 1)
+		{
+			ranges[i].lowVal = &lowInts[i];
+			ranges[i].highVal = &highInts[i];
+		}
+		else if(testNum == 2)
+		{
+			ranges[i].lowVal = &lowDoubles[i];
+			ranges[i].highVal = &highDoubles[i];
+		}
+		else
+		{
+			ranges[i].lowVal = lowStrings[i].c_str();
+			ranges[i].highVal = highStrings[i].c_str();
+		}
+	}
+
+	try
+	{
+		index->startMultiRangeScan(ranges.data(), n);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+	int numResults = 0;
+	int lastKey = -1;
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+			Page *curPage;
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+			if(myRec.i <= lastKey)
+			{
+				std::cout << "Multi-range scan returned " << myRec.i << " after " << lastKey << std::endl;
+				return -1;
+			}
+			lastKey = myRec.i;
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
+template <class Index>
+int typedScan(Index * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+	int lowInt = lowVal, highInt = highVal;
+	double lowDouble = lowVal, highDouble = highVal;
+	char lowString[100], highString[100];
+	sprintf(lowString,"%05d string record",lowVal);
+	sprintf(highString,"%05d string record",highVal);
+	const void * low = &lowInt;
+	const void * high = &highInt;
+	if(testNum == 2)
+	{
+		low = &lowDouble;
+		high = &highDouble;
+	}
+	else if(testNum == 3)
+	{
+		low = lowString;
+		high = highString;
+	}
+
+	int numResults = 0;
+	try
+	{
+		index->startScan(low, lowOp, high, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+
+	while(1)
+	{
+		try
+		{
+			RecordId scanRid;
+			index->scanNext(scanRid);
+			Page *curPage;
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+			if(myRec.i < lowVal || myRec.i > highVal)
+			{
+				std::cout << "Scan returned record " << myRec.i << " outside of the range" << std::endl;
+				return -1;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+		numResults++;
+	}
+	index->endScan();
+
+	return numResults;
+}
+
 // -----------------------------------------------------------------------------
 // errorTests
 // -----------------------------------------------------------------------------
@@ -0,0 +1,384 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include "merge_join.h"
+#include "exceptions/bad_index_info_exception.h"
+
+
+namespace badgerdb
+{
+    //Asks the operating system to read one page of a BlobFile ahead
+    static void prefetchNode(const int fd, const PageId pageNo)
+    {
+        if (fd >= 0)
+        {
+            off_t position = sizeof(FileHeader) + (off_t) (pageNo - 1) * Page::SIZE;
+            posix_fadvise(fd, position, Page::SIZE, POSIX_FADV_WILLNEED);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::MergeJoin -- Constructor
+    // -----------------------------------------------------------------------------
+
+    MergeJoin::MergeJoin(BTreeIndex* leftIndex, BTreeIndex* rightIndex)
+    {
+        if (leftIndex->getAttrType() != rightIndex->getAttrType())
+        {
+            throw BadIndexInfoException("merge join of indexes with different key types");
+        }
+        this->attrType = leftIndex->getAttrType();
+        this->runPos = 0;
+        this->leftPos = 0;
+        this->pairing = false;
+
+        openCursor(left, leftIndex);
+        openCursor(right, rightIndex);
+        if (attrType == INTEGER)
+        {
+            startCursor<int>(left);
+            startCursor<int>(right);
+        }
+        else if (attrType == DOUBLE)
+        {
+            startCursor<double>(left);
+            startCursor<double>(right);
+        }
+        else
+        {
+            startCursor<StringKey>(left);
+            startCursor<StringKey>(right);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::~MergeJoin -- destructor
+    // -----------------------------------------------------------------------------
+
+    MergeJoin::~MergeJoin()
+    {
+        closeCursor(left);
+        closeCursor(right);
+    }
+
+    void MergeJoin::openCursor(Cursor& cursor, BTreeIndex* index)
+    {
+        //The file of a resident index is only current after a checkpoint
+        if (index->isResident())
+        {
+            index->flush();
+        }
+        cursor.file = index->getFile();
+        cursor.bufMgr = index->getBufMgr();
+        cursor.rootPageNo = index->getRootPageNo();
+        cursor.fd = open(index->getFileName().c_str(), O_RDONLY);
+        cursor.leafPageNo = Page::INVALID_NUMBER;
+        cursor.leafPage = NULL;
+        cursor.count = 0;
+        cursor.pos = 0;
+        cursor.valid = true;
+        cursor.hinted = 0;
+    }
+
+    void MergeJoin::closeCursor(Cursor& cursor)
+    {
+        if (cursor.leafPage != NULL)
+        {
+            cursor.bufMgr->unPinPage(cursor.file, cursor.leafPageNo, false);
+            cursor.leafPage = NULL;
+        }
+        if (cursor.fd >= 0)
+        {
+            close(cursor.fd);
+            cursor.fd = -1;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::startCursor
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void MergeJoin::startCursor(Cursor& cursor)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        //Leftmost path, keeping the children of the last non-leaf as the leaves to read ahead
+        PageId pageNo = cursor.rootPageNo;
+        bool leafLevel = false;
+        while (!leafLevel)
+        {
+            Page * page;
+            cursor.bufMgr->readPage(cursor.file, pageNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            PageId child = childPage(node, 0);
+            leafLevel = node->level == 1;
+            if (leafLevel)
+            {
+                int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+                cursor.ahead.clear();
+                appendChildren(node, 0, count + 1, cursor.ahead);
+            }
+            cursor.bufMgr->unPinPage(cursor.file, pageNo, false);
+            pageNo = child;
+        }
+        enterLeaf<T>(cursor, pageNo);
+        settle<T>(cursor);
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::enterLeaf
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void MergeJoin::enterLeaf(Cursor& cursor, const PageId pageNo)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        if (cursor.leafPage != NULL)
+        {
+            cursor.bufMgr->unPinPage(cursor.file, cursor.leafPageNo, false);
+            cursor.leafPage = NULL;
+        }
+        cursor.bufMgr->readPage(cursor.file, pageNo, cursor.leafPage);
+        cursor.leafPageNo = pageNo;
+        Leaf * leaf = (Leaf *) cursor.leafPage;
+        cursor.count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+        cursor.pos = 0;
+
+        if (!cursor.ahead.empty() && cursor.ahead.front() == pageNo)
+        {
+            cursor.ahead.pop_front();
+            if (cursor.hinted > 0)
+            {
+                cursor.hinted--;
+            }
+        }
+        else
+        {
+            //Past the children of the last parent, or the chain left it: look the next parent up
+            cursor.ahead.clear();
+            cursor.hinted = 0;
+            if (cursor.count > 0)
+            {
+                findAhead<T>(cursor, pageNo, leafKey(leaf, 0));
+            }
+        }
+        while (cursor.hinted < cursor.ahead.size() && cursor.hinted < (size_t) MERGEPREFETCHDEPTH)
+        {
+            prefetchNode(cursor.fd, cursor.ahead[cursor.hinted]);
+            cursor.hinted++;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::findAhead
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void MergeJoin::findAhead(Cursor& cursor, const PageId pageNo, const T& key)
+    {
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        PageId nodeNo = cursor.rootPageNo;
+        bool leafLevel = false;
+        while (!leafLevel)
+        {
+            Page * page;
+            cursor.bufMgr->readPage(cursor.file, nodeNo, page);
+            NonLeaf * node = (NonLeaf *) page;
+            int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+            int i = nonLeafLowerBound(node, count, key);
+            PageId child = childPage(node, i);
+            leafLevel = node->level == 1;
+            if (leafLevel)
+            {
+                //A run of duplicates may put the leaf further right than the descent
+                for (int j = i; j <= count; j++)
+                {
+                    if (childPage(node, j) == pageNo)
+                    {
+                        cursor.ahead.clear();
+                        appendChildren(node, j + 1, count + 1, cursor.ahead);
+                        break;
+                    }
+                }
+            }
+            cursor.bufMgr->unPinPage(cursor.file, nodeNo, false);
+            nodeNo = child;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::settle
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void MergeJoin::settle(Cursor& cursor)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+
+        while (cursor.valid && cursor.pos >= cursor.count)
+        {
+            PageId sibling = ((Leaf *) cursor.leafPage)->rightSibPageNo;
+            if (sibling == Page::INVALID_NUMBER)
+            {
+                cursor.bufMgr->unPinPage(cursor.file, cursor.leafPageNo, false);
+                cursor.leafPage = NULL;
+                cursor.valid = false;
+            }
+            else
+            {
+                enterLeaf<T>(cursor, sibling);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::step
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void MergeJoin::step(Cursor& cursor)
+    {
+        cursor.pos++;
+        settle<T>(cursor);
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::seek
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void MergeJoin::seek(Cursor& cursor, const T& key)
+    {
+        while (cursor.valid)
+        {
+            typename NodeTraits<T>::Leaf * leaf = (typename NodeTraits<T>::Leaf *) cursor.leafPage;
+
+            //Skip the whole leaf if even its last key is too small
+            if (leafKey(leaf, cursor.count - 1) < key)
+            {
+                cursor.pos = cursor.count;
+                settle<T>(cursor);
+                continue;
+            }
+            cursor.pos = leafLowerBound(leaf, cursor.pos, cursor.count, key);
+            return;
+        }
+    }
+
+    template <class T>
+    void MergeJoin::appendEntryRids(Cursor& cursor, std::vector<RecordId>& rids)
+    {
+        RecordId rid = leafRid((typename NodeTraits<T>::Leaf *) cursor.leafPage, cursor.pos);
+        if (!isPostingRid(rid))
+        {
+            rids.push_back(rid);
+            return;
+        }
+        std::vector<RecordId> postings;
+        readPosting(cursor.bufMgr, cursor.file, rid.page_number, postings);
+        rids.insert(rids.end(), postings.begin(), postings.end());
+    }
+
+    template <class T>
+    T MergeJoin::currentKey(const Cursor& cursor) const
+    {
+        return leafKey((typename NodeTraits<T>::Leaf *) cursor.leafPage, cursor.pos);
+    }
+
+    // -----------------------------------------------------------------------------
+    // MergeJoin::next
+    // -----------------------------------------------------------------------------
+
+    bool MergeJoin::next(RecordId& outLeftRid, RecordId& outRightRid)
+    {
+        if (attrType == INTEGER)
+        {
+            return nextTyped<int>(outLeftRid, outRightRid);
+        }
+        else if (attrType == DOUBLE)
+        {
+            return nextTyped<double>(outLeftRid, outRightRid);
+        }
+        else
+        {
+            return nextTyped<StringKey>(outLeftRid, outRightRid);
+        }
+    }
+
+    template <class T>
+    bool MergeJoin::nextTyped(RecordId& outLeftRid, RecordId& outRightRid)
+    {
+        while (true)
+        {
+            //Pair the RecordIds of the current left entry with the run of right entries of its key
+            if (pairing)
+            {
+                if (runPos < rightRun.size())
+                {
+                    outLeftRid = leftRids[leftPos];
+                    outRightRid = rightRun[runPos];
+                    runPos++;
+                    return true;
+                }
+                runPos = 0;
+                leftPos++;
+                if (leftPos < leftRids.size())
+                {
+                    continue;
+                }
+                step<T>(left);
+                T key;
+                memcpy((void *) &key, runKey.data(), sizeof(T));
+                if (left.valid && currentKey<T>(left) == key)
+                {
+                    leftRids.clear();
+                    appendEntryRids<T>(left, leftRids);
+                    leftPos = 0;
+                    continue;
+                }
+                pairing = false;
+            }
+            if (!left.valid || !right.valid)
+            {
+                return false;
+            }
+
+            T leftKey = currentKey<T>(left);
+            T rightKey = currentKey<T>(right);
+            if (leftKey < rightKey)
+            {
+                seek<T>(left, rightKey);
+                continue;
+            }
+            if (rightKey < leftKey)
+            {
+                seek<T>(right, leftKey);
+                continue;
+            }
+
+            //Equal keys: buffer the right run, which may cross leaves, and replay it for each left entry
+            rightRun.clear();
+            while (right.valid && currentKey<T>(right) == leftKey)
+            {
+                appendEntryRids<T>(right, rightRun);
+                step<T>(right);
+            }
+            runKey = std::string((const char *) &leftKey, sizeof(T));
+            leftRids.clear();
+            appendEntryRids<T>(left, leftRids);
+            leftPos = 0;
+            runPos = 0;
+            pairing = true;
+        }
+    }
+
+}
@@ -0,0 +1,166 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "types.h"
+#include "page.h"
+#include "file.h"
+#include "buffer.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of leaves a MergeJoin asks the operating system to read ahead of each of its cursors.
+ */
+const  int MERGEPREFETCHDEPTH = 8;
+
+/**
+ * @brief MergeJoin class. Equi-joins two BTreeIndexes on the same key type by walking their leaf chains in lockstep.
+ * Each side has a cursor of its own that pins one leaf at a time and moves on through rightSibPageNo, so the
+ * join is a single pass over the leaves of both indexes. A side that is behind skips ahead with a binary search
+ * inside its leaf, and past the whole leaf if its last key is still too small.
+ * The cursors know the leaves that follow from the parent of their current leaf and ask the operating system
+ * to read the next MERGEPREFETCHDEPTH of them, so the buffer manager finds them in the page cache.
+ * Neither index may be changed while the join runs. Both may be the same index.
+*/
+class MergeJoin {
+
+ private:
+
+  /**
+   * Position in the leaf chain of one index.
+   */
+	struct Cursor {
+		File		*file;
+		BufMgr	*bufMgr;
+		PageId	rootPageNo;
+
+	  /**
+	   * Descriptor of the index file used for the read-ahead hints, -1 if it could not be opened.
+	   */
+		int			fd;
+
+	  /**
+	   * Pinned leaf, its number of entries and the current entry. valid is false once the chain is exhausted.
+	   */
+		PageId	leafPageNo;
+		Page		*leafPage;
+		int			count;
+		int			pos;
+		bool		valid;
+
+	  /**
+	   * Leaves known to follow the current one, from its parent, in chain order. The first hinted of them
+	   * have been handed to the operating system to read ahead.
+	   */
+		std::deque<PageId>	ahead;
+		size_t	hinted;
+	};
+
+	Cursor	left;
+	Cursor	right;
+	Datatype	attrType;
+
+  /**
+   * RecordIds of the right entries with the current key, and the next one to pair with the current left RecordId.
+   * pairing is true while left entries with that key remain to be paired.
+   */
+	std::vector<RecordId>	rightRun;
+	size_t	runPos;
+
+  /**
+   * RecordIds of the current left entry, more than one if it holds a posting list, and the one being paired.
+   */
+	std::vector<RecordId>	leftRids;
+	size_t	leftPos;
+	bool		pairing;
+	std::string	runKey;
+
+	void openCursor(Cursor& cursor, BTreeIndex* index);
+	void closeCursor(Cursor& cursor);
+
+  /**
+   * Positions the cursor on the first entry of the leftmost leaf.
+   */
+	template <class T>
+	void startCursor(Cursor& cursor);
+
+  /**
+   * Pins pageNo, unpinning the previous leaf, and refreshes the read-ahead of the leaves after it.
+   */
+	template <class T>
+	void enterLeaf(Cursor& cursor, const PageId pageNo);
+
+  /**
+   * Finds the leaves following pageNo in its parent by descending with key, the first key of the leaf.
+   */
+	template <class T>
+	void findAhead(Cursor& cursor, const PageId pageNo, const T& key);
+
+  /**
+   * Follows rightSibPageNo while the cursor is past the end of its leaf.
+   */
+	template <class T>
+	void settle(Cursor& cursor);
+
+  /**
+   * Moves to the next entry.
+   */
+	template <class T>
+	void step(Cursor& cursor);
+
+  /**
+   * Moves to the first entry whose key is not less than key.
+   */
+	template <class T>
+	void seek(Cursor& cursor, const T& key);
+
+  /**
+   * Appends the RecordIds of the current entry to rids.
+   */
+	template <class T>
+	void appendEntryRids(Cursor& cursor, std::vector<RecordId>& rids);
+
+	template <class T>
+	T currentKey(const Cursor& cursor) const;
+
+	template <class T>
+	bool nextTyped(RecordId& outLeftRid, RecordId& outRightRid);
+
+ public:
+
+  /**
+   * Opens a cursor on the first leaf of each index.
+   * @param leftIndex		Index on the join attribute of the left relation
+   * @param rightIndex	Index on the join attribute of the right relation
+   * @throws  BadIndexInfoException If the indexes have keys of different types
+   */
+	MergeJoin(BTreeIndex* leftIndex, BTreeIndex* rightIndex);
+
+  /**
+   * Unpins the leaves still held by the cursors.
+   */
+	~MergeJoin();
+
+  /**
+	 * Fetch the next pair of matching records, in key order.
+	 * For a key held by several entries on both sides every left entry is paired with every right one.
+   * @param outLeftRid	RecordId from the left index
+   * @param outRightRid	RecordId from the right index with the same key
+   * @return false once every pair has been returned
+	**/
+	bool next(RecordId& outLeftRid, RecordId& outRightRid);
+};
+
+}
@@ -151,6 +151,18 @@ class Page {
    */
   std::string getRecord(const RecordId& record_id) const;
 
+  /**
+   * Returns the record with the given ID in place, without copying it.  The
+   * bytes stay valid as long as the page is pinned and not changed.
+   *
+   * @see getRecord
+   * @param record_id  ID of the record to return.
+   * @param length     Set to the length of the record.
+   * @return  Pointer to the first byte of the record.
+   */
+  const char* getRecordData(const RecordId& record_id,
+                            std::uint16_t& length) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
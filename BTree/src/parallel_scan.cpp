@@ -0,0 +1,289 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "parallel_scan.h"
+#include "file.h"
+#include "exceptions/bad_index_structure_exception.h"
+
+
+namespace badgerdb
+{
+    //Reads one page of a BlobFile, which keeps its pages right after the file header
+    static bool readNode(const int fd, const PageId pageNo, void* buffer)
+    {
+        off_t position = sizeof(FileHeader) + (off_t) (pageNo - 1) * Page::SIZE;
+        return pread(fd, buffer, Page::SIZE, position) == (ssize_t) Page::SIZE;
+    }
+
+    //Appends the RecordIds of the posting list starting at headPageNo to rids. Returns the page that could not be read, if any.
+    static PageId readPostingPages(const int fd, const PageId headPageNo, std::vector<RecordId>& rids)
+    {
+        std::uint64_t buffer[Page::SIZE / sizeof(std::uint64_t)];
+        PageId pageNo = headPageNo;
+        while (pageNo != Page::INVALID_NUMBER)
+        {
+            if (!readNode(fd, pageNo, buffer))
+            {
+                return pageNo;
+            }
+            postingDecode((PostingPage *) buffer, rids);
+            pageNo = ((PostingPage *) buffer)->nextPageNo;
+        }
+        return Page::INVALID_NUMBER;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ParallelIndexScan::ParallelIndexScan -- Constructor
+    // -----------------------------------------------------------------------------
+
+    ParallelIndexScan::ParallelIndexScan(BTreeIndex* index, const void* lowValParm, const Operator lowOpParm,
+                                         const void* highValParm, const Operator highOpParm, const int numWorkers)
+    {
+        std::vector<ScanBounds> bounds;
+        index->partitionRange(lowValParm, lowOpParm, highValParm, highOpParm, numWorkers, bounds);
+        index->flush();
+
+        this->fileName = index->getFileName();
+        this->rootPageNo = index->getRootPageNo();
+        this->attrType = index->getAttrType();
+        this->nextPartition = 0;
+        this->cancelled = false;
+
+        partitions.resize(bounds.size());
+        for (size_t p = 0; p < bounds.size(); p++)
+        {
+            partitions[p].bounds = bounds[p];
+            partitions[p].done = false;
+        }
+        //the destructor does not run if this throws, so stop the threads already started here
+        try
+        {
+            workers.reserve(partitions.size());
+            for (size_t p = 0; p < partitions.size(); p++)
+            {
+                if (attrType == INTEGER)
+                {
+                    workers.push_back(std::thread(&ParallelIndexScan::scanPartition<int>, this, p));
+                }
+                else if (attrType == DOUBLE)
+                {
+                    workers.push_back(std::thread(&ParallelIndexScan::scanPartition<double>, this, p));
+                }
+                else
+                {
+                    workers.push_back(std::thread(&ParallelIndexScan::scanPartition<StringKey>, this, p));
+                }
+            }
+        }
+        catch (...)
+        {
+            stopWorkers();
+            throw;
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // ParallelIndexScan::~ParallelIndexScan -- destructor
+    // -----------------------------------------------------------------------------
+
+    ParallelIndexScan::~ParallelIndexScan()
+    {
+        stopWorkers();
+    }
+
+    // -----------------------------------------------------------------------------
+    // ParallelIndexScan::stopWorkers
+    // -----------------------------------------------------------------------------
+
+    void ParallelIndexScan::stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            cancelled = true;
+        }
+        spaceFree.notify_all();
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            workers[i].join();
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // ParallelIndexScan::scanPartition
+    // -----------------------------------------------------------------------------
+
+    template <class T>
+    void ParallelIndexScan::scanPartition(const size_t p)
+    {
+        typedef typename NodeTraits<T>::Leaf Leaf;
+        typedef typename NodeTraits<T>::NonLeaf NonLeaf;
+
+        const ScanBounds& bounds = partitions[p].bounds;
+        T low;
+        T high;
+        memcpy((void *) &low, bounds.lowKey.data(), sizeof(T));
+        memcpy((void *) &high, bounds.highKey.data(), sizeof(T));
+        bool strict = bounds.lowOp == GT;
+
+        std::uint64_t buffer[Page::SIZE / sizeof(std::uint64_t)];
+        std::vector<RecordId> batch;
+        std::string error;
+        PageId pageNo = rootPageNo;
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            error = "cannot open " + fileName;
+        }
+
+        //Descend to the leaf holding the first entry of the partition
+        bool isLeaf = false;
+        while (error.empty() && !isLeaf)
+        {
+            if (!readNode(fd, pageNo, buffer))
+            {
+                break;
+            }
+            NonLeaf * node = (NonLeaf *) buffer;
+            int count = nonLeafKeyCount(node, NodeTraits<T>::NONLEAFSIZE);
+            int i = strict ? nonLeafUpperBound(node, count, low) : nonLeafLowerBound(node, count, low);
+            pageNo = childPage(node, i);
+            isLeaf = node->level == 1;
+        }
+
+        //Walk the leaf chain until the high bound
+        bool first = true;
+        while (error.empty() && isLeaf && pageNo != Page::INVALID_NUMBER)
+        {
+            if (!readNode(fd, pageNo, buffer))
+            {
+                break;
+            }
+            Leaf * leaf = (Leaf *) buffer;
+            int count = leafEntryCount(leaf, NodeTraits<T>::LEAFSIZE);
+            int i = 0;
+            if (first)
+            {
+                i = strict ? leafUpperBound(leaf, 0, count, low) : leafLowerBound(leaf, 0, count, low);
+                first = false;
+            }
+            for (; i < count; i++)
+            {
+                T key = leafKey(leaf, i);
+                if (bounds.highOp == LTE ? key > high : !(key < high))
+                {
+                    pageNo = Page::INVALID_NUMBER;
+                    break;
+                }
+                RecordId rid = leafRid(leaf, i);
+                PageId unread = Page::INVALID_NUMBER;
+                if (isPostingRid(rid))
+                {
+                    unread = readPostingPages(fd, rid.page_number, batch);
+                }
+                else
+                {
+                    batch.push_back(rid);
+                }
+                if (unread != Page::INVALID_NUMBER)
+                {
+                    std::ostringstream out;
+                    out << "posting page " << unread << " of " << fileName << " could not be read";
+                    error = out.str();
+                    break;
+                }
+                if (batch.size() >= (size_t) PARALLELBATCHSIZE && !deliver(p, batch))
+                {
+                    close(fd);
+                    return;
+                }
+            }
+            if (pageNo != Page::INVALID_NUMBER)
+            {
+                pageNo = leaf->rightSibPageNo;
+            }
+        }
+        if (error.empty() && pageNo != Page::INVALID_NUMBER)
+        {
+            std::ostringstream out;
+            out << "page " << pageNo << " of " << fileName << " could not be read";
+            error = out.str();
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        if (error.empty() && !batch.empty() && !deliver(p, batch))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        partitions[p].error = error;
+        partitions[p].done = true;
+        batchReady.notify_all();
+    }
+
+    bool ParallelIndexScan::deliver(const size_t p, std::vector<RecordId>& batch)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!cancelled && partitions[p].batches.size() >= (size_t) PARALLELQUEUEDEPTH)
+        {
+            spaceFree.wait(guard);
+        }
+        if (cancelled)
+        {
+            return false;
+        }
+        partitions[p].batches.push_back(std::vector<RecordId>());
+        partitions[p].batches.back().swap(batch);
+        batchReady.notify_all();
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------
+    // ParallelIndexScan::nextBatch
+    // -----------------------------------------------------------------------------
+
+    bool ParallelIndexScan::nextBatch(std::vector<RecordId>& outBatch)
+    {
+        while (nextPartition < partitions.size())
+        {
+            if (nextBatch(nextPartition, outBatch))
+            {
+                return true;
+            }
+            nextPartition++;
+        }
+        return false;
+    }
+
+    bool ParallelIndexScan::nextBatch(const int partition, std::vector<RecordId>& outBatch)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        Partition& part = partitions[partition];
+        while (part.batches.empty() && !part.done)
+        {
+            batchReady.wait(guard);
+        }
+        if (!part.batches.empty())
+        {
+            outBatch.swap(part.batches.front());
+            part.batches.pop_front();
+            spaceFree.notify_all();
+            return true;
+        }
+        if (!part.error.empty())
+        {
+            throw BadIndexStructureException(part.error);
+        }
+        return false;
+    }
+
+}
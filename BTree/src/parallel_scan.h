@@ -0,0 +1,147 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "types.h"
+#include "page.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of RecordIds a worker of a ParallelIndexScan hands over at a time.
+ */
+const  int PARALLELBATCHSIZE = 1024;
+
+/**
+ * @brief Number of batches a worker of a ParallelIndexScan may have waiting before it stops to let the consumer catch up.
+ */
+const  int PARALLELQUEUEDEPTH = 8;
+
+/**
+ * @brief ParallelIndexScan class. Scans a range of a BTreeIndex with several threads.
+ * The range is split with BTreeIndex::partitionRange() and every sub-range is scanned by a thread of its own.
+ * The buffer manager is not thread safe, so the index is flushed to its file when the scan starts and the
+ * threads read the nodes straight from the file, each through a file descriptor of its own. The index must
+ * not be changed while the scan is running.
+ * Each thread hands its RecordIds over in batches through a queue of its own. The consumer either reads the
+ * queues one after the other, which returns the entries in key order, or reads any one of them on its own.
+*/
+class ParallelIndexScan {
+
+ private:
+
+  /**
+   * One sub-range of the scan and the batches its thread has found so far.
+   */
+	struct Partition {
+		ScanBounds	bounds;
+		std::deque< std::vector<RecordId> >	batches;
+		bool		done;
+		std::string	error;
+	};
+
+  /**
+   * Name of the index file, its root page and the type of its keys.
+   */
+	std::string	fileName;
+	PageId	rootPageNo;
+	Datatype	attrType;
+
+	std::vector<Partition>	partitions;
+	std::vector<std::thread>	workers;
+
+  /**
+   * Partition read by the ordered nextBatch().
+   */
+	size_t	nextPartition;
+
+  /**
+   * Set by the destructor to make the threads give up.
+   */
+	bool		cancelled;
+
+  /**
+   * Guards partitions and cancelled. Threads wait on spaceFree for the consumer, the consumer waits on batchReady.
+   */
+	std::mutex	lock;
+	std::condition_variable	batchReady;
+	std::condition_variable	spaceFree;
+
+  /**
+   * Body of the thread scanning partitions[p].
+   */
+	template <class T>
+	void scanPartition(const size_t p);
+
+  /**
+   * Hands a batch to the consumer, waiting while the queue is full. Returns false if the scan was cancelled.
+   */
+	bool deliver(const size_t p, std::vector<RecordId>& batch);
+
+  /**
+   * Cancels the scan and joins every thread started so far.
+   */
+	void stopWorkers();
+
+ public:
+
+  /**
+   * Splits the range into numWorkers sub-ranges and starts a thread for each.
+   * @param index			Index to scan, flushed to its file before the threads start
+   * @param lowVal		Low value of range, pointer to integer / double / char string
+   * @param lowOp			Low operator (GT/GTE)
+   * @param highVal		High value of range, pointer to integer / double / char string
+   * @param highOp		High operator (LT/LTE)
+   * @param numWorkers	Number of threads, fewer are started if the range covers too few leaves
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values
+   * @throws  BadScanrangeException If lowVal > highval
+   * @throws  BadScanParamException If numWorkers is less than 1
+   * @throws  PagePinnedException If a scan of the index is running.
+   */
+	ParallelIndexScan(BTreeIndex* index, const void* lowVal, const Operator lowOp,
+						const void* highVal, const Operator highOp, const int numWorkers);
+
+  /**
+   * Stops the threads and waits for them to finish.
+   */
+	~ParallelIndexScan();
+
+  /**
+   * Number of sub-ranges, and so of threads.
+   */
+	int getNumPartitions() const { return partitions.size(); }
+
+  /**
+	 * Fetch the next batch of RecordIds in key order, reading the partitions one after the other.
+   * @param outBatch	Replaced with the next batch
+   * @return false once every entry of the range has been returned
+	 * @throws BadIndexStructureException If a thread could not read a page of the index file.
+	**/
+	bool nextBatch(std::vector<RecordId>& outBatch);
+
+  /**
+	 * Fetch the next batch of RecordIds of one partition, in key order within the partition.
+	 * Lets a consumer per partition read the scan without waiting on the others.
+   * @param partition	Partition to read, from 0 to getNumPartitions() - 1
+   * @param outBatch	Replaced with the next batch
+   * @return false once every entry of the partition has been returned
+	 * @throws BadIndexStructureException If the thread could not read a page of the index file.
+	**/
+	bool nextBatch(const int partition, std::vector<RecordId>& outBatch);
+};
+
+}
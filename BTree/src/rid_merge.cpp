@@ -0,0 +1,198 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+#include <algorithm>
+#include <iterator>
+#include "rid_merge.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/bad_scan_param_exception.h"
+
+
+namespace badgerdb
+{
+    // -----------------------------------------------------------------------------
+    // IndexRidMerge::IndexRidMerge -- Constructor
+    // -----------------------------------------------------------------------------
+
+    IndexRidMerge::IndexRidMerge(const IndexPredicate* predicates, const int n, const RidMergeOp op,
+                                 const int bitmapThreshold)
+    {
+        if (n < 1)
+        {
+            throw BadScanParamException();
+        }
+        this->nextRid = 0;
+        this->bitmapUsed = false;
+
+        //An intersection starts with the predicate expected to match the fewest records
+        std::vector< std::pair<double, int> > order;
+        for (int i = 0; i < n; i++)
+        {
+            const IndexPredicate& p = predicates[i];
+            double estimate = op == RID_INTERSECT
+                ? p.index->estimateRange(p.lowVal, p.lowOp, p.highVal, p.highOp) : 0;
+            order.push_back(std::make_pair(estimate, i));
+        }
+        std::stable_sort(order.begin(), order.end());
+
+        std::vector< std::vector<RecordId> > inputs(n);
+        size_t total = 0;
+        for (int i = 0; i < n; i++)
+        {
+            std::vector<RecordId>& input = inputs[i];
+            collect(predicates[order[i].second], input);
+            total += input.size();
+            if (op == RID_INTERSECT && input.empty())
+            {
+                return;
+            }
+        }
+
+        if (total >= (size_t) bitmapThreshold)
+        {
+            mergeBitmaps(inputs, op);
+        }
+        else
+        {
+            mergeSorted(inputs, op);
+        }
+    }
+
+    void IndexRidMerge::collect(const IndexPredicate& predicate, std::vector<RecordId>& outRids)
+    {
+        try
+        {
+            predicate.index->startScan(predicate.lowVal, predicate.lowOp, predicate.highVal, predicate.highOp);
+        }
+        catch (NoSuchKeyFoundException e)
+        {
+            return;
+        }
+        RecordId rid;
+        try
+        {
+            while (true)
+            {
+                predicate.index->scanNext(rid);
+                outRids.push_back(rid);
+            }
+        }
+        catch (IndexScanCompletedException e)
+        {
+        }
+        predicate.index->endScan();
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexRidMerge::mergeSorted
+    // -----------------------------------------------------------------------------
+
+    void IndexRidMerge::mergeSorted(std::vector< std::vector<RecordId> >& inputs, const RidMergeOp op)
+    {
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            std::sort(inputs[i].begin(), inputs[i].end(), ridBefore);
+            inputs[i].erase(std::unique(inputs[i].begin(), inputs[i].end()), inputs[i].end());
+        }
+        rids.swap(inputs[0]);
+        std::vector<RecordId> merged;
+        for (size_t i = 1; i < inputs.size(); i++)
+        {
+            merged.clear();
+            if (op == RID_INTERSECT)
+            {
+                std::set_intersection(rids.begin(), rids.end(), inputs[i].begin(), inputs[i].end(),
+                                      std::back_inserter(merged), ridBefore);
+            }
+            else
+            {
+                std::set_union(rids.begin(), rids.end(), inputs[i].begin(), inputs[i].end(),
+                               std::back_inserter(merged), ridBefore);
+            }
+            rids.swap(merged);
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexRidMerge::mergeBitmaps
+    // -----------------------------------------------------------------------------
+
+    void IndexRidMerge::mergeBitmaps(std::vector< std::vector<RecordId> >& inputs, const RidMergeOp op)
+    {
+        bitmapUsed = true;
+
+        //Bit page_number * stride + slot_number stands for a record
+        PageId maxPage = 0;
+        SlotId maxSlot = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            for (size_t j = 0; j < inputs[i].size(); j++)
+            {
+                maxPage = std::max(maxPage, inputs[i][j].page_number);
+                maxSlot = std::max(maxSlot, inputs[i][j].slot_number);
+            }
+        }
+        std::uint64_t stride = (std::uint64_t) maxSlot + 1;
+        size_t numWords = (size_t) (((std::uint64_t) maxPage + 1) * stride / 64 + 1);
+
+        std::vector<std::uint64_t> result(numWords, 0);
+        std::vector<std::uint64_t> bitmap(numWords);
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            std::vector<std::uint64_t>& target = i == 0 ? result : bitmap;
+            if (i > 0)
+            {
+                std::fill(bitmap.begin(), bitmap.end(), 0);
+            }
+            for (size_t j = 0; j < inputs[i].size(); j++)
+            {
+                std::uint64_t bit = inputs[i][j].page_number * stride + inputs[i][j].slot_number;
+                target[bit / 64] |= (std::uint64_t) 1 << (bit % 64);
+            }
+            std::vector<RecordId>().swap(inputs[i]);
+            if (i == 0)
+            {
+                continue;
+            }
+            for (size_t w = 0; w < numWords; w++)
+            {
+                result[w] = op == RID_INTERSECT ? result[w] & bitmap[w] : result[w] | bitmap[w];
+            }
+        }
+
+        //Set bits in increasing order are records in (page_number, slot_number) order
+        for (size_t w = 0; w < numWords; w++)
+        {
+            std::uint64_t word = result[w];
+            while (word != 0)
+            {
+                std::uint64_t bit = (std::uint64_t) w * 64 + __builtin_ctzll(word);
+                RecordId rid;
+                rid.page_number = (PageId) (bit / stride);
+                rid.slot_number = (SlotId) (bit % stride);
+                rids.push_back(rid);
+                word &= word - 1;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------
+    // IndexRidMerge::next
+    // -----------------------------------------------------------------------------
+
+    bool IndexRidMerge::next(RecordId& outRid)
+    {
+        if (nextRid >= rids.size())
+        {
+            return false;
+        }
+        outRid = rids[nextRid];
+        nextRid++;
+        return true;
+    }
+
+}
@@ -0,0 +1,110 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "types.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of collected RecordIds from which an IndexRidMerge combines bitmaps instead of sorted lists.
+ */
+const  int RIDBITMAPTHRESHOLD = 4096;
+
+/**
+ * @brief How an IndexRidMerge combines the RecordIds of its predicates.
+ */
+enum RidMergeOp
+{
+	RID_INTERSECT,
+	RID_UNION
+};
+
+/**
+ * @brief One range predicate answered by an index, as for BTreeIndex::startScan().
+*/
+struct IndexPredicate{
+	BTreeIndex* index;
+	const void* lowVal;
+	Operator lowOp;
+	const void* highVal;
+	Operator highOp;
+};
+
+/**
+ * @brief IndexRidMerge class. Combines the RecordIds matching range predicates on several indexes of one relation,
+ * so the relation is only read for the records that satisfy all of them (intersection) or any of them (union).
+ * The RecordIds of every predicate are collected with a scan of its index. Small sets are sorted by
+ * (page_number, slot_number) and merged; from RIDBITMAPTHRESHOLD RecordIds on they are set in one bitmap
+ * per predicate, a bit per slot of every page, and the bitmaps are combined a word at a time.
+ * For an intersection the predicates are scanned from the most selective on, going by
+ * BTreeIndex::estimateRange(), and the remaining scans are skipped once the result is empty.
+ * The result comes back in (page_number, slot_number) order, so the pages of the relation are read once each.
+*/
+class IndexRidMerge {
+
+ private:
+
+	std::vector<RecordId>	rids;
+	size_t	nextRid;
+	bool		bitmapUsed;
+
+  /**
+   * Appends the RecordIds matching the predicate.
+   */
+	void collect(const IndexPredicate& predicate, std::vector<RecordId>& outRids);
+
+  /**
+   * Combines the inputs, sorted and without duplicates, into rids.
+   */
+	void mergeSorted(std::vector< std::vector<RecordId> >& inputs, const RidMergeOp op);
+
+  /**
+   * Combines the inputs as bitmaps into rids.
+   */
+	void mergeBitmaps(std::vector< std::vector<RecordId> >& inputs, const RidMergeOp op);
+
+ public:
+
+  /**
+   * Scans the indexes and combines their RecordIds.
+   * @param predicates	Predicates, on indexes of the same relation. The indexes must not be scanned meanwhile.
+   * @param n				Number of predicates
+   * @param op				RID_INTERSECT or RID_UNION
+   * @param bitmapThreshold	Number of collected RecordIds from which bitmaps are used
+   * @throws  BadScanParamException If n is less than 1
+   * @throws  BadOpcodesException If an operator is not one of its expected values
+   * @throws  BadScanrangeException If a low value is greater than its high value
+   */
+	IndexRidMerge(const IndexPredicate* predicates, const int n, const RidMergeOp op,
+					const int bitmapThreshold = RIDBITMAPTHRESHOLD);
+
+  /**
+	 * Fetch the next qualifying RecordId, in (page_number, slot_number) order.
+   * @param outRid	RecordId of the record
+   * @return false once every RecordId has been returned
+	**/
+	bool next(RecordId& outRid);
+
+  /**
+   * Number of qualifying RecordIds.
+   */
+	size_t getNumRids() const { return rids.size(); }
+
+  /**
+   * True if the RecordIds were combined as bitmaps.
+   */
+	bool usedBitmap() const { return bitmapUsed; }
+};
+
+}